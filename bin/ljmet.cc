@@ -4,12 +4,18 @@
 // Gena Kukartsev, March 2012
 //
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "TCanvas.h"
 #include "TFile.h"
+#include "TFileMerger.h"
 #include "TH1.h"
 #include "TH2.h"
 #include "TLegend.h"
@@ -25,6 +31,7 @@
 #include "LJMet/Com/interface/BaseEventSelector.h"
 #include "LJMet/Com/interface/LjmetEventContent.h"
 #include "LJMet/Com/interface/LjmetFactory.h"
+#include "LJMet/Com/interface/RunLumiSummary.h"
 #include "Math/GenVector/Cartesian2D.h"
 #include "PhysicsTools/FWLite/interface/TFileService.h"
 #include "PhysicsTools/SelectorUtils/interface/strbitset.h"
@@ -37,6 +44,14 @@
 bool JsonContainsEvent (const std::vector< edm::LuminosityBlockRange > &jsonVec,
                         const edm::EventBase &event);
 
+std::string WorkerOutputName (std::string const & outputName, int workerId);
+
+int CompressionSettings (std::string const & algorithm, int level);
+
+bool WriteCutFlow (int fd, std::vector<int> const & counts);
+
+bool ReadCutFlow (int fd, std::vector<int> & counts);
+
 
 
 ///////////////////////////
@@ -115,34 +130,8 @@ int main (int argc, char* argv[]) {
     //std::cout << std::endl;
     
     
-    // TFileService for saving the output ROOT tree
-    std::cout << legend << "setting up TFileService" << std::endl;
-    fwlite::TFileService fs = fwlite::TFileService( _outputName+".root" );
-    
-    
-    // output tree
-    std::cout << legend << "Creating output tree" << std::endl;
-    std::string const _treename = outputs.getParameter<std::string>("treeName");
-    TTree * _tree = fs.make<TTree>(_treename.c_str(), _treename.c_str(), 64000000);
-    
-    
-    // book histograms
-    TFileDirectory theDir = fs.mkdir( "histos" );
-    std::cout << legend << "booking histograms" << std::endl;
-    std::map<std::string, TH1*> hists;
-    hists["nevents"] = theDir.make<TH1I>( "nevents",
-                                         "nevents",
-                                         1, 0, 2 ) ;
-    // hists["nInteractions"] = theDir.make<TH1D>( "hist_nInteractions",
-    //					 "nInteractions",
-    //					 400, 0, 400 ) ;
-    // hists["nTrueInteractions"] = theDir.make<TH1D>( "hist_nTrueInteractions",
-    //						 "nTrueInteractions",
-    //						 400, 0, 400 ) ;
-    
     // internal LJMet event content
     LjmetEventContent ec(mPar);
-    ec.SetTree(_tree);
     
     // maps for branches
     // each entry will create and fill a branch
@@ -185,6 +174,7 @@ int main (int argc, char* argv[]) {
     
     // send config parameters to calculators
     factory->SetAllCalcConfig(mPar);
+    factory->SetAllCalcEventContent(&ec);
     
     
     
@@ -193,23 +183,223 @@ int main (int argc, char* argv[]) {
     
     
     
-    // create histograms
-    std::map<std::string,std::map<std::string,LjmetEventContent::HistMetadata> > & mh = ec.GetHistMap();
-    std::map<std::string,std::map<std::string,LjmetEventContent::HistMetadata> >::iterator iMod;
-    std::map<std::string,LjmetEventContent::HistMetadata>::iterator iHist;
-    for (iMod=mh.begin();iMod!=mh.end();++iMod){
+    //=============================================================>
+    //
+    // multi-process mode: fork workers after all BeginJob() setup,
+    // so that config, JEC, PDF sets and pileup tables are shared
+    // copy-on-write; each worker processes a contiguous slice of
+    // entries and writes a partial output, merged by the parent.
+    // Only the forking thread survives in the workers, so calculators
+    // must not start threads in BeginJob(): start them at the first
+    // event, as HitFitCalc does with its fit workers
+    //
+    int nWorkers = 1;
+    if (ljmetParams.exists("nWorkers")) nWorkers = ljmetParams.getParameter<int>("nWorkers");
+    int workerId = -1;        // -1: parent or single-process mode
+    int cutFlowPipe = -1;     // worker end of the cut flow pipe
+    Long64_t firstEntry = 0;
+    Long64_t lastEntry = 0;
+    std::vector<pid_t> vWorkerPid;
+    std::vector<int> vWorkerPipe;
+    
+    if (nWorkers > 1){
+        
+        // split the requested entry range into contiguous slices,
+        // same skipEvents/nEvents semantics as the single-process loop
+        Long64_t _nEntries = 0;
+        {
+            fwlite::ChainEvent _ev ( inputs.getParameter<std::vector<std::string> > ("fileNames") );
+            _nEntries = _ev.size();
+        }
+        Long64_t _begin = std::min<Long64_t>(std::max(nEventsToSkip, 0), _nEntries);
+        Long64_t _end = _nEntries;
+        if (maxEvents >= 0) _end = std::max(_begin, std::min<Long64_t>(maxEvents, _nEntries));
+        
+        std::cout << legend << "forking " << nWorkers << " workers for entries ["
+        << _begin << ", " << _end << ")" << std::endl;
+        std::cout.flush();
+        _logfile.flush();
+        
+        for (int i = 0; i != nWorkers; ++i){
+            int _fd[2];
+            if (pipe(_fd) != 0){
+                std::cout << legend << "cannot create pipe for worker " << i << std::endl;
+                std::exit(-1);
+            }
+            
+            pid_t _pid = fork();
+            if (_pid < 0){
+                std::cout << legend << "cannot fork worker " << i << std::endl;
+                std::exit(-1);
+            }
+            else if (_pid == 0){
+                // worker
+                close(_fd[0]);
+                for (std::vector<int>::const_iterator _p = vWorkerPipe.begin(); _p != vWorkerPipe.end(); ++_p) close(*_p);
+                vWorkerPipe.clear();
+                vWorkerPid.clear();
+                workerId = i;
+                cutFlowPipe = _fd[1];
+                firstEntry = _begin + (_end-_begin)*i/nWorkers;
+                lastEntry = _begin + (_end-_begin)*(i+1)/nWorkers;
+                break;
+            }
+            
+            // parent
+            close(_fd[1]);
+            vWorkerPid.push_back(_pid);
+            vWorkerPipe.push_back(_fd[0]);
+        }
+        
+        
+        if (workerId < 0){
+            
+            // parent: collect cut flows, wait for workers and merge outputs
+            bool _failed = false;
+            for (int i = 0; i != nWorkers; ++i){
+                std::vector<int> _counts;
+                if ( ReadCutFlow(vWorkerPipe[i], _counts) ) theSelector->AddCutFlowCounts(_counts);
+                else{
+                    std::cout << legend << "no cut flow received from worker " << i << std::endl;
+                    _failed = true;
+                }
+                close(vWorkerPipe[i]);
+            }
+            for (int i = 0; i != nWorkers; ++i){
+                int _status = 0;
+                waitpid(vWorkerPid[i], &_status, 0);
+                if ( !WIFEXITED(_status) || WEXITSTATUS(_status) != 0 ){
+                    std::cout << legend << "worker " << i << " failed" << std::endl;
+                    _failed = true;
+                }
+            }
+            
+            // the parent processed no events: its EndJob() only releases what
+            // BeginJob() set up, each worker ends the job for its own slice
+            factory->EndJobAllCalc();
+            theSelector->EndJob();
+            
+            if (_failed){
+                std::cout << legend << "not merging partial outputs" << std::endl;
+                _logfile.close();
+                return -1;
+            }
+            
+            std::cout << legend << "merging partial outputs into " << _outputName << ".root" << std::endl;
+            TFileMerger _merger(false);
+            _merger.OutputFile( (_outputName+".root").c_str() );
+            for (int i = 0; i != nWorkers; ++i){
+                _merger.AddFile( WorkerOutputName(_outputName, i).c_str() );
+            }
+            if ( !_merger.Merge() ){
+                std::cout << legend << "merging failed, partial outputs kept" << std::endl;
+                _logfile.close();
+                return -1;
+            }
+            for (int i = 0; i != nWorkers; ++i){
+                gSystem->Unlink( WorkerOutputName(_outputName, i).c_str() );
+            }
+            
+            // one summary entry per luminosity section, not per worker
+            {
+                TFile _merged( (_outputName+".root").c_str(), "UPDATE" );
+                if (_merged.IsOpen()) RunLumiSummary::Combine(&_merged);
+                else std::cout << legend << "cannot reopen " << _outputName << ".root to sum the run/lumi summary" << std::endl;
+            }
+            
+            std::cout << legend << "Selection" << std::endl;
+            theSelector->print(std::cout);
+            theSelector->print(_logfile);
+            _logfile.close();
+            
+            delete theSelector;
+            
+            return 0;
+        }
+        
+        legend = "[" + std::string(argv[0]) + ", worker " + std::to_string(workerId) + "]: ";
+    }
+    
+    
+    // TFileService for saving the output ROOT tree
+    std::cout << legend << "setting up TFileService" << std::endl;
+    std::string _outputFile = _outputName+".root";
+    if (workerId >= 0) _outputFile = WorkerOutputName(_outputName, workerId);
+    fwlite::TFileService fs = fwlite::TFileService( _outputFile );
+    
+    
+    // output compression, must be set before the tree branches exist
+    if (outputs.exists("compressionAlgorithm")){
+        std::string const _algo = outputs.getParameter<std::string>("compressionAlgorithm");
+        int _level = 1;
+        if (outputs.exists("compressionLevel")) _level = outputs.getParameter<int>("compressionLevel");
+        int const _settings = CompressionSettings(_algo, _level);
+        if (_settings < 0){
+            std::cout << legend << "unknown compression algorithm " << _algo << ", using default" << std::endl;
+        }
+        else{
+            std::cout << legend << "output compression " << _algo << ", level " << _level << std::endl;
+            fs.file().SetCompressionSettings(_settings);
+        }
+    }
+    
+    
+    // output tree
+    std::cout << legend << "Creating output tree" << std::endl;
+    std::string const _treename = outputs.getParameter<std::string>("treeName");
+    TTree * _tree = fs.make<TTree>(_treename.c_str(), _treename.c_str(), 64000000);
+    
+    // clustering: positive values are numbers of entries, negative are bytes
+    if (outputs.exists("autoFlush")) _tree->SetAutoFlush(outputs.getParameter<int>("autoFlush"));
+    if (outputs.exists("autoSave")) _tree->SetAutoSave(outputs.getParameter<int>("autoSave"));
+    
+    ec.SetTree(_tree);
+    
+    
+    // book histograms
+    TFileDirectory theDir = fs.mkdir( "histos" );
+    std::cout << legend << "booking histograms" << std::endl;
+    std::map<std::string, TH1*> hists;
+    hists["nevents"] = theDir.make<TH1I>( "nevents",
+                                         "nevents",
+                                         1, 0, 2 ) ;
+    // hists["nInteractions"] = theDir.make<TH1D>( "hist_nInteractions",
+    //					 "nInteractions",
+    //					 400, 0, 400 ) ;
+    // hists["nTrueInteractions"] = theDir.make<TH1D>( "hist_nTrueInteractions",
+    //						 "nTrueInteractions",
+    //						 400, 0, 400 ) ;
+    
+    
+    // create histograms, one directory per module
+    std::map<std::string, TFileDirectory> _histDirs;
+    for (int iHist = 0; iHist != ec.GetNHistograms(); ++iHist){
         
-        TFileDirectory _dir = fs.mkdir( iMod->first.c_str() );
+        LjmetEventContent::HistMetadata & _hist = ec.GetHistogram(iHist);
+        std::map<std::string, TFileDirectory>::iterator _dir = _histDirs.find(_hist.GetModule());
+        if (_dir == _histDirs.end()){
+            _dir = _histDirs.insert( std::make_pair(_hist.GetModule(), fs.mkdir( _hist.GetModule().c_str() )) ).first;
+        }
         
-        for (iHist=iMod->second.begin();iHist!=iMod->second.end();++iHist){
-            std::cout << legend
-            << "Creating " << iMod->first << "/"
-            << iHist->second.GetName() << std::endl;
-            iHist->second.SetHist( _dir.make<TH1F>(iHist->second.GetName().c_str(),
-                                                   iHist->second.GetName().c_str(),
-                                                   iHist->second.GetNBins(),
-                                                   iHist->second.GetXMin(),
-                                                   iHist->second.GetXMax() ) );
+        std::cout << legend
+        << "Creating " << _hist.GetModule() << "/"
+        << _hist.GetName() << std::endl;
+        if (_hist.Is2D()){
+            _hist.SetHist( _dir->second.make<TH2F>(_hist.GetName().c_str(),
+                                                   _hist.GetName().c_str(),
+                                                   _hist.GetNBins(),
+                                                   _hist.GetXMin(),
+                                                   _hist.GetXMax(),
+                                                   _hist.GetNBinsY(),
+                                                   _hist.GetYMin(),
+                                                   _hist.GetYMax() ) );
+        }
+        else{
+            _hist.SetHist( _dir->second.make<TH1F>(_hist.GetName().c_str(),
+                                                   _hist.GetName().c_str(),
+                                                   _hist.GetNBins(),
+                                                   _hist.GetXMin(),
+                                                   _hist.GetXMax() ) );
         }
     }
     
@@ -222,6 +412,32 @@ int main (int argc, char* argv[]) {
     theSelector->SetMc(isMc);
     if (isMc) std::cout << legend << "Using MC truth info" << std::endl;
     
+    
+    // event counts, generator weight sums and cut flow per
+    // luminosity section, written as a tree at the end of the job
+    bool doRunLumiSummary = false;
+    if (ljmetParams.exists("runLumiSummary")) doRunLumiSummary = ljmetParams.getParameter<bool>("runLumiSummary");
+    edm::InputTag _genInfoSrc("generator");
+    edm::InputTag _lheSrc("externalLHEProducer");
+    if (ljmetParams.exists("genInfoSrc")) _genInfoSrc = ljmetParams.getParameter<edm::InputTag>("genInfoSrc");
+    if (ljmetParams.exists("lheSrc")) _lheSrc = ljmetParams.getParameter<edm::InputTag>("lheSrc");
+    edm::InputTag _lheRunInfoSrc = _lheSrc;
+    // the genWeightRatios of GenWeightCalc need the GenWeightLayouts tree
+    // to be read, and their sums over all processed events are only
+    // kept by the summary: the calculator turns it on, with its inputs
+    if (isMc && !doRunLumiSummary && factory->HasCalculator("GenWeightCalc")){
+        std::cout << legend << "GenWeightCalc is run, writing the run/lumi summary" << std::endl;
+        doRunLumiSummary = true;
+        std::map<std::string, edm::ParameterSet const>::const_iterator _genWeightPar = mPar.find("GenWeightCalc");
+        if (_genWeightPar != mPar.end()){
+            edm::ParameterSet const & _genWeightParams = _genWeightPar->second;
+            _genInfoSrc = _genWeightParams.getUntrackedParameter<edm::InputTag>("genInfoSrc", _genInfoSrc);
+            _lheSrc = _genWeightParams.getUntrackedParameter<edm::InputTag>("lheSrc", _lheSrc);
+            _lheRunInfoSrc = _genWeightParams.getUntrackedParameter<edm::InputTag>("lheRunInfoSrc", _lheSrc);
+        }
+    }
+    RunLumiSummary runLumiSummary(_genInfoSrc, _lheSrc, _lheRunInfoSrc);
+    
     //=============================================================>
     //
     // JSON file processing
@@ -252,21 +468,27 @@ int main (int argc, char* argv[]) {
     // event loop
     //
     std::cout << legend << "Begin loop over events" << std::endl;
-    int nev = 0;
+    
+    // a worker processes entries [firstEntry, lastEntry) of the chain
+    Long64_t const _skip = (workerId < 0) ? nEventsToSkip : firstEntry;
+    Long64_t const _max = (workerId < 0) ? maxEvents : lastEntry;
+    bool const _emptySlice = (workerId >= 0) && (firstEntry >= lastEntry);
+    
+    Long64_t nev = 0;
     bool firstEvent = true;
     for (ev.toBegin();
-         !ev.atEnd() && nev!=maxEvents;
+         !_emptySlice && !ev.atEnd() && nev!=_max;
          ++ev, ++nev, firstEvent=false) {
         
         // skip specified number of events
-        if (firstEvent && nEventsToSkip != 0){
-            if (nEventsToSkip < ev.size()){
-                std::cout << "Skipping " << nEventsToSkip << "events..." << std::endl;
-                ev.to(nEventsToSkip);
-                nev += nEventsToSkip;
+        if (firstEvent && _skip != 0){
+            if (_skip < ev.size()){
+                std::cout << "Skipping " << _skip << "events..." << std::endl;
+                ev.to(_skip);
+                nev += _skip;
             }
             else{
-                std::cout << legend << "Cannot skip " << nEventsToSkip << "events, it is more than I have: " << ev.size() << std::endl;
+                std::cout << legend << "Cannot skip " << _skip << "events, it is more than I have: " << ev.size() << std::endl;
             }
         }
         
@@ -304,6 +526,11 @@ int main (int argc, char* argv[]) {
         
         
         
+        // normalisation bookkeeping, before the cut flow counts the event
+        if (doRunLumiSummary) runLumiSummary.AddEvent(event, theSelector);
+        
+        
+        
         // event selection
         pat::strbitset ret = theSelector->getBitTemplate();
         bool passed = (*theSelector)( event, ret );
@@ -343,18 +570,33 @@ int main (int argc, char* argv[]) {
     } // end loop over events
     
     
+    // write out events still queued for the output tree
+    ec.Finish();
+    
+    
     std::cout << legend << "Selection" << std::endl;
     theSelector->print(std::cout);
-    theSelector->print(_logfile);
+    
+    
+    // workers report the cut flow to the parent, which owns the log file
+    if (workerId < 0) theSelector->print(_logfile);
+    else{
+        WriteCutFlow(cutFlowPipe, theSelector->GetCutFlowCounts());
+        close(cutFlowPipe);
+    }
     
     
     _logfile.close();
     
     
     
-    // Run EndJob() for calculators
+    // Run EndJob() for calculators; summary objects they
+    // create go to the top directory of the output file
+    fs.file().cd();
     factory->EndJobAllCalc();
     
+    if (doRunLumiSummary) runLumiSummary.Write(theSelector);
+    
     
     
     // EndJob() for the selector
@@ -364,6 +606,16 @@ int main (int argc, char* argv[]) {
     
     delete theSelector;
     
+    
+    // a worker must not return into the parent's exit path
+    // (atexit handlers, ROOT cleanup); write the output and leave
+    if (workerId >= 0){
+        fs.file().Write();
+        fs.file().Close();
+        std::cout.flush();
+        _exit(0);
+    }
+    
     return 0;
 }
 
@@ -393,3 +645,93 @@ bool JsonContainsEvent (const std::vector< edm::LuminosityBlockRange > &jsonVec,
     
     return jsonVec.end() != iter;
 }
+
+
+
+std::string WorkerOutputName (std::string const & outputName, int workerId)
+{
+    //
+    // name of the partial output file written by a worker
+    //
+    
+    return outputName + "_worker" + std::to_string(workerId) + ".root";
+}
+
+
+
+int CompressionSettings (std::string const & algorithm, int level)
+{
+    //
+    // ROOT compression settings, 100*algorithm+level,
+    // or -1 for an unknown algorithm. Numbering follows
+    // ROOT::ECompressionAlgorithm; LZ4 and ZSTD need a ROOT
+    // version that provides them
+    //
+    
+    int _algo = -1;
+    if (algorithm == "ZLIB") _algo = 1;
+    else if (algorithm == "LZMA") _algo = 2;
+    else if (algorithm == "LZ4") _algo = 4;
+    else if (algorithm == "ZSTD") _algo = 5;
+    
+    if (_algo < 0) return -1;
+    
+    return 100*_algo + std::max(0, std::min(level, 9));
+}
+
+
+
+bool WriteCutFlow (int fd, std::vector<int> const & counts)
+{
+    //
+    // send the selector cut flow counts from a worker to the parent:
+    // number of cuts followed by the counts
+    //
+    
+    std::vector<int> _buf;
+    _buf.push_back(counts.size());
+    _buf.insert(_buf.end(), counts.begin(), counts.end());
+    
+    char const * _p = reinterpret_cast<char const *>(&_buf[0]);
+    size_t _left = _buf.size()*sizeof(int);
+    while (_left > 0){
+        ssize_t _n = write(fd, _p, _left);
+        if (_n <= 0) return false;
+        _p += _n;
+        _left -= _n;
+    }
+    
+    return true;
+}
+
+
+
+bool ReadCutFlow (int fd, std::vector<int> & counts)
+{
+    //
+    // receive the cut flow counts sent by WriteCutFlow()
+    //
+    
+    int _size = 0;
+    std::vector<int> _buf(1);
+    for (int _pass = 0; _pass != 2; ++_pass){
+        char * _p = reinterpret_cast<char *>(&_buf[0]);
+        size_t _left = _buf.size()*sizeof(int);
+        while (_left > 0){
+            ssize_t _n = read(fd, _p, _left);
+            if (_n <= 0) return false;
+            _p += _n;
+            _left -= _n;
+        }
+        if (_pass == 0){
+            _size = _buf[0];
+            if (_size <= 0) break;
+            _buf.resize(_size);
+        }
+    }
+    
+    counts.clear();
+    if (_size > 0) counts = _buf;
+    
+    return true;
+}
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <vector>
 
+#include "LJMet/Com/interface/EventArena.h"
 #include "FWCore/ParameterSet/interface/ProcessDesc.h"
 #include "FWCore/PythonParameterSet/interface/PythonProcessDesc.h"
 
@@ -36,20 +37,39 @@ public:
     virtual int ProduceEvent(edm::EventBase const & event, BaseEventSelector * selector) { return 0; }
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector) { return 0; }
     virtual int EndJob() { return 0; }
+    /// False if the calculator only sets its own output values and may be
+    /// switched off when none of them is requested; calculators that set
+    /// selector or other shared state keep the default and always run
+    virtual bool HasSideEffects() const { return true; }
     
     std::string mName;
     std::string mLegend;
     
     // LJMET event content setters
-    /// Declare a new histogram to be created for the module
-    void SetHistogram(std::string name, int nbins, double low, double high);
+    /// Declare a new histogram to be created for the module, returns its handle
+    int SetHistogram(std::string name, int nbins, double low, double high);
+    int SetHistogram(std::string name, int nbinsx, double xlow, double xhigh, int nbinsy, double ylow, double yhigh);
+    /// Values for the histogram, any number per event; by handle or by name
+    void FillHist(int handle, double value, double weight = 1.0);
+    void FillHist2D(int handle, double x, double y, double weight = 1.0);
+    void FillHistN(int handle, size_t n, double const * values, double const * weights = 0);
     void SetHistValue(std::string name, double value);
     void SetValue(std::string name, bool value);
     void SetValue(std::string name, int value);
     void SetValue(std::string name, double value);
-    void SetValue(std::string name, std::vector<bool> value);
-    void SetValue(std::string name, std::vector<int> value);
-    void SetValue(std::string name, std::vector<double> value);
+    void SetValue(std::string name, std::vector<bool> const & value);
+    void SetValue(std::string name, std::vector<int> const & value);
+    void SetValue(std::string name, std::vector<short> const & value);
+    void SetValue(std::string name, std::vector<double> const & value);
+    void SetValue(std::string name, ArenaVector<bool> const & value);
+    void SetValue(std::string name, ArenaVector<int> const & value);
+    void SetValue(std::string name, ArenaVector<short> const & value);
+    void SetValue(std::string name, ArenaVector<double> const & value);
+    /// Scratch memory released after the event is filled, for AnalyzeEvent() locals
+    EventArena & GetArena();
+    /// Is the output branch name_<calculator> requested in the config?
+    /// Calculators can skip computing values nobody asked for
+    bool IsRequested(std::string name);
     
 protected:
     edm::ParameterSet mPset;
@@ -60,7 +80,14 @@ private:
     void setName(std::string name) { mName = name; }
     void SetEventContent(LjmetEventContent * pEc) { mpEc = pEc; }
     void SetPSet(edm::ParameterSet pset) { mPset = pset; }
+    /// True once the calculator has set values, none of which were requested
+    bool HasNoRequestedOutput() const { return mNValues > 0 && mNRequestedValues == 0 && mNHistograms == 0; }
     LjmetEventContent * mpEc;
+    
+    // output bookkeeping, used to switch off calculators with no requested output
+    int mNValues;
+    int mNRequestedValues;
+    int mNHistograms;
 };
 
 #endif
\ No newline at end of file
@@ -17,6 +17,10 @@
 
 #include "FWCore/Framework/interface/Event.h"
 #include "LJMet/Com/interface/LjmetEventContent.h"
+#include "LJMet/Com/interface/GenEventIndex.h"
+#include "LJMet/Com/interface/GenWeightReader.h"
+#include "LJMet/Com/interface/LabelIndexCache.h"
+#include "LJMet/Com/interface/NeutrinoSolver.h"
 
 #include "DataFormats/Math/interface/deltaR.h"
 #include "DataFormats/RecoCandidate/interface/RecoCandidate.h"
@@ -30,6 +34,8 @@
 #include "LJMet/Com/interface/BtagHardcodedConditions.h"
 #include "CondFormats/JetMETObjects/interface/JetCorrectionUncertainty.h"
 #include "CondFormats/JetMETObjects/interface/FactorizedJetCorrector.h"
+#include "LJMet/Com/interface/CompiledJetCorrector.h"
+#include "LJMet/Com/interface/ConditionsCache.h"
 
 //#include "TROOT.h"
 //#include "TVector3.h"
@@ -70,14 +76,39 @@ public:
     std::vector<unsigned int> const & GetSelectedTriggers() const { return mvSelTriggers; }
     std::vector<edm::Ptr<reco::Vertex>> const & GetSelectedPVs() const { return mvSelPVs; }
     double const & GetTestValue() const { return mTestValue; }
+    /// Genealogy tables of the gen particles, built on first use in the event and
+    /// shared by all calculators. Packed gen particles are linked if packedTag is given
+    GenEventIndex const & GetGenEventIndex(edm::EventBase const & event,
+                                           edm::InputTag const & prunedTag,
+                                           edm::InputTag const & packedTag = edm::InputTag());
+    /// Generator and LHE weights of the event, read on first use and shared by all calculators
+    GenWeightReader const & GetGenWeights(edm::EventBase const & event,
+                                          edm::InputTag const & genInfoTag = edm::InputTag("generator"),
+                                          edm::InputTag const & lheTag = edm::InputTag("externalLHEProducer"),
+                                          edm::InputTag const & lheRunInfoTag = edm::InputTag("externalLHEProducer"));
+    /// Parsed conditions payloads shared between jobs through conditionsCacheDir
+    ConditionsCache const & GetConditionsCache() const { return mConditions; }
+    /// Neutrino pz solutions cached for the event, shared by all calculators
+    NeutrinoSolver & GetNeutrinoSolver() { return mNuSolver; }
+    /// Cut flow counts in cut order, used to combine selectors run in separate processes
+    std::vector<int> GetCutFlowCounts() const;
+    std::vector<std::string> GetCutFlowNames() const;
+    void AddCutFlowCounts(std::vector<int> const & counts);
     void SetMc(bool isMc) { mbIsMc = isMc; }
     bool IsMc() { return mbIsMc; }
     
     // LJMET event content setters
     void Init( void );
     void SetEventContent(LjmetEventContent * pEc) { mpEc = pEc; }
-    /// Declare a new histogram to be created for the module
-    void SetHistogram(std::string name, int nbins, double low, double high) { mpEc->SetHistogram(mName, name, nbins, low, high); }
+    /// Scratch memory released after the event is filled, for per-event locals
+    EventArena & GetArena() { return mpEc->GetArena(); }
+    /// Declare a new histogram to be created for the module, returns its handle
+    int SetHistogram(std::string name, int nbins, double low, double high) { return mpEc->SetHistogram(mName, name, nbins, low, high); }
+    int SetHistogram(std::string name, int nbinsx, double xlow, double xhigh, int nbinsy, double ylow, double yhigh) { return mpEc->SetHistogram(mName, name, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh); }
+    /// Values for the histogram, any number per event; by handle or by name
+    void FillHist(int handle, double value, double weight = 1.0) { mpEc->FillHist(handle, value, weight); }
+    void FillHist2D(int handle, double x, double y, double weight = 1.0) { mpEc->FillHist2D(handle, x, y, weight); }
+    void FillHistN(int handle, size_t n, double const * values, double const * weights = 0) { mpEc->FillHistN(handle, n, values, weights); }
     void SetHistValue(std::string name, double value) { mpEc->SetHistValue(mName, name, value); }
     void SetTestValue(double & test) { mTestValue = test; }
     
@@ -85,7 +116,10 @@ public:
     void SetCorrJetsWithBTags(std::vector<std::pair<TLorentzVector, bool>> & jets) { mvCorrJetsWithBTags = jets; }
     
     bool isJetTagged(const pat::Jet &jet, edm::EventBase const & event, bool applySF = true);
+    /// Corrected jet, computed on the first call for the jet in the event
     TLorentzVector correctJet(const pat::Jet & jet, edm::EventBase const & event, bool doAK8Corr = false);
+    /// Correct all jets of the collection at once, with the new JES factors evaluated together
+    void CorrectJets(std::vector<pat::Jet> const & jets, edm::EventBase const & event, bool doAK8Corr = false);
     TLorentzVector correctMet(const pat::MET & met, edm::EventBase const & event);
     
 protected:
@@ -120,23 +154,47 @@ protected:
     bool mbIsMc;
     
 private:
-    int mNCorrJets;
     int mNBtagSfCorrJets;
+    int mHistJesCorrection;
+    int mHistMetCorrection;
+    int mHistNBtagSfCorrections;
     double bTagCut;
+    LabelIndexCache mBtagLabels;
+    int mBtaggerSlot;
     BTagSFUtil mBtagSfUtil;
     BtagHardcodedConditions mBtagCond;
     JetCorrectionUncertainty *jecUnc;
     FactorizedJetCorrector *JetCorrector;
     FactorizedJetCorrector *JetCorrectorAK8;
+    CompiledJetCorrector *mpCompiledJEC;
+    CompiledJetCorrector *mpCompiledJECAK8;
+    bool mbValidateCompiledJEC;
+    int mNJecMismatch;
+    std::vector<float> mvJecIn;
+    std::vector<double> mvJecCorr;
+    std::map<std::pair<pat::Jet const *, bool>, TLorentzVector> mCorrJets;
     LjmetEventContent * mpEc;
+    GenEventIndex mGenIndex;
+    edm::InputTag mGenIndexTag;
+    edm::InputTag mGenIndexPackedTag;
+    GenWeightReader mGenWeights;
+    NeutrinoSolver mNuSolver;
+    ConditionsCache mConditions;
+    
+    /// New JES factor of one jet, compiled if possible, compared to FactorizedJetCorrector with validateCompiledJEC
+    double jesCorrection(const pat::Jet & jet, double pt_raw, double rho, bool doAK8Corr = false);
+    /// Jet with the given JES factor, JER smearing and JES uncertainty applied
+    TLorentzVector applyJetCorrections(const pat::Jet & jet, double correction);
+    /// Keep the corrected jet for the event and histogram its correction
+    TLorentzVector const & keepCorrectedJet(const pat::Jet & jet, bool doAK8Corr, TLorentzVector const & jetP4);
     
     /// Private init method to be called by LjmetFactory when registering the selector
     void init() { mLegend = "[" + mName + "]: "; std::cout << mLegend << "registering " << mName << std::endl; }
     void setName(std::string name) { mName = name; }
     /// Do what any event selector must do before event gets checked
-    void BeginEvent(edm::EventBase const & event, LjmetEventContent & ec) { mNCorrJets = 0; mNBtagSfCorrJets = 0; }
+    void BeginEvent(edm::EventBase const & event, LjmetEventContent & ec) { mNBtagSfCorrJets = 0; mCorrJets.clear(); mGenIndex.Clear(); mGenWeights.Clear(); mNuSolver.Clear(); }
     /// Do what any event selector must do after event processing is done, but before event content gets saved to file
-    void EndEvent(edm::EventBase const & event, LjmetEventContent & ec) { SetHistValue("nBtagSfCorrections", mNBtagSfCorrJets); }
+    void EndEvent(edm::EventBase const & event, LjmetEventContent & ec) { FillHist(mHistNBtagSfCorrections, mNBtagSfCorrJets); }
 };
 
 #endif
@@ -0,0 +1,131 @@
+#ifndef LJMet_Com_interface_CompiledJetCorrector_h
+#define LJMet_Com_interface_CompiledJetCorrector_h
+
+/*
+ Jet energy corrections from a list of JetCorrectorParameters levels,
+ evaluated as FactorizedJetCorrector does but without ROOT formulas.
+
+ Every level is turned once into flat bin and parameter tables. Its
+ formula string is compiled either to a hand-written function, for
+ the usual L1FastJet/L2Relative/constant forms, or to a small stack
+ program of native operations; levels with a formula that does not
+ compile fall back to SimpleJetCorrector. The operations are done in
+ the same order and precision as the formula, so the corrections are
+ identical to FactorizedJetCorrector::getCorrection(), except that
+ pow(a,2) is always a*a, as the compiler emits it for the kernels.
+
+ Only JetEta, JetPt, JetA and Rho are supported as variables; with
+ anything else IsValid() is false and FactorizedJetCorrector has to
+ be used instead.
+ */
+
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+
+class JetCorrectorParameters;
+class SimpleJetCorrector;
+
+
+
+class CompiledJetCorrector {
+    //
+    // factorized jet corrections with compiled levels
+    //
+
+
+public:
+
+    /// Levels in the order they are applied, as for FactorizedJetCorrector
+    explicit CompiledJetCorrector(std::vector<JetCorrectorParameters> const & levels);
+    ~CompiledJetCorrector();
+
+    bool IsValid() const { return mValid; }
+    size_t GetNLevels() const { return mvLevel.size(); }
+    /// Levels evaluated natively, the others go through SimpleJetCorrector
+    size_t GetNCompiledLevels() const;
+    /// Why the corrector is not valid, empty if it is
+    std::string const & GetError() const { return mError; }
+
+    /// Total correction of one jet, from the uncorrected pt
+    float GetCorrection(float eta, float pt, float area, float rho) const;
+
+    /// Corrections of n jets of one event, level by level
+    void GetCorrections(size_t n, float const * eta, float const * pt, float const * area,
+                        float rho, float * corrections) const;
+
+
+
+    class Formula {
+        //
+        // compiled formula of x, y, z, t and parameters [i]
+        //
+
+    public:
+
+        Formula(): mKernel(0), mMaxDepth(0){}
+
+        /// false if the formula uses something not supported
+        bool Compile(std::string const & formula);
+        bool IsKernel() const { return mKernel != 0; }
+        /// Highest parameter index used, -1 if none
+        int MaxParameter() const;
+
+        double Eval(double const * x, double const * par) const;
+
+
+        struct Op {
+            int code;
+            int arg;
+            double value;
+        };
+
+        typedef double (*Kernel)(double const * x, double const * par);
+
+
+    private:
+
+        Kernel mKernel;
+        std::vector<Op> mvOp;
+        int mMaxDepth;
+    };
+
+
+
+private:
+
+    CompiledJetCorrector(CompiledJetCorrector const &);             // no copies
+    CompiledJetCorrector & operator=(CompiledJetCorrector const &);
+
+    enum Variable { kJetEta, kJetPt, kJetA, kRho };
+
+    struct Level {
+        std::vector<int> vBinVar;       // Variable of each bin variable
+        std::vector<int> vParVar;       // Variable of each formula variable
+        size_t nBins;
+        bool sorted;                    // one bin variable, ordered bins that do not overlap
+        std::vector<float> vXMin;       // nBins x nBinVar
+        std::vector<float> vXMax;
+        std::vector<float> vRange;      // nBins x (min, max) of each formula variable
+        std::vector<size_t> vParStart;  // start of each bin in vPar, size nBins+1
+        std::vector<double> vPar;       // formula parameters
+        Formula formula;
+        bool compiled;
+        SimpleJetCorrector * pGeneric;
+    };
+
+    int findBin(Level const & level, float const * x) const;
+    float evalLevel(Level const & level, float const * vars) const;
+
+    std::vector<Level> mvLevel;
+    bool mValid;
+    std::string mError;
+};
+
+
+
+#endif
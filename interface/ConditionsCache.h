@@ -0,0 +1,139 @@
+#ifndef LJMet_Com_interface_ConditionsCache_h
+#define LJMet_Com_interface_ConditionsCache_h
+
+/*
+ Binary cache of parsed conditions payloads: JEC text files, the
+ bad laser calibration event list and pileup histograms.
+
+ The first job that needs a payload parses the source as before
+ and writes the result to <directory>/<file name>-<key hash>.ljc,
+ with a versioned header, the size and modification time of the
+ source and a checksum of the payload, computed once when the
+ file is written. Later jobs map the file read-only, so jobs on
+ the same node share its pages, and only parse the source again
+ if its size or modification time changed or the header does not
+ check out. The payload checksum is compared only with
+ SetVerifyChecksums(true) (event_selector.verifyConditionsCache).
+ Files are written under a temporary name and renamed, so
+ concurrent jobs never see a partial file.
+
+ With an empty directory nothing is cached and every payload is
+ parsed from its source.
+ */
+
+
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+
+class JetCorrectorParameters;
+class TH1D;
+
+
+
+class ConditionsCache {
+    //
+    // versioned, checksummed binary files of parsed conditions
+    //
+
+
+public:
+
+    /// Bumped whenever the header or any payload layout changes
+    static unsigned const kFormatVersion = 1;
+
+    enum Kind { kJetCorrectorParameters = 1, kEventList = 2, kHistogram = 3 };
+
+
+
+    class Mapping {
+        //
+        // read-only payload of a cache file, unmapped with the last copy
+        //
+
+    public:
+
+        Mapping(){}
+
+        bool IsValid() const { return mpRegion != 0; }
+        char const * GetData() const;
+        size_t GetSize() const;
+
+    private:
+
+        friend class ConditionsCache;
+        struct Region;
+        std::shared_ptr<Region> mpRegion;
+    };
+
+
+
+    class EventList {
+        //
+        // sorted run:lumi:event list, searched in place in the payload
+        //
+
+    public:
+
+        struct Entry {
+            int run;
+            int lumi;
+            int event;
+        };
+
+        EventList(): mpBegin(0), mpEnd(0){}
+
+        bool Contains(int run, int lumi, int event) const;
+        size_t GetSize() const { return mpEnd - mpBegin; }
+
+    private:
+
+        friend class ConditionsCache;
+        Mapping mMapping;
+        Entry const * mpBegin;
+        Entry const * mpEnd;
+    };
+
+
+
+    ConditionsCache(): mbVerify(false){}
+    ~ConditionsCache(){}
+
+    /// Where cache files are kept, created if needed; empty disables the cache
+    void SetDirectory(std::string const & directory);
+    std::string const & GetDirectory() const { return mDirectory; }
+    bool IsEnabled() const { return !mDirectory.empty(); }
+    /// Compare the payload checksum of every file opened, off by default
+    void SetVerifyChecksums(bool verify){ mbVerify = verify; }
+
+    /// As JetCorrectorParameters(file, section)
+    JetCorrectorParameters GetJetCorrectorParameters(std::string const & file, std::string const & section = "") const;
+
+    /// Lines of run:lumi:event from a text file
+    EventList GetEventList(std::string const & file) const;
+
+    /// Copy of a 1D histogram in a ROOT file, not attached to any directory, 0 if missing
+    TH1D * GetHistogram(std::string const & file, std::string const & name) const;
+
+    /// Payload stored for the source file and tag, invalid if absent or out of date
+    Mapping Open(std::string const & source, std::string const & tag, Kind kind) const;
+    /// Store a payload for the source file and tag, false if it could not be written
+    bool Store(std::string const & source, std::string const & tag, Kind kind, std::vector<char> const & payload) const;
+
+
+
+private:
+
+    std::string cachePath(std::string const & source, std::string const & tag, Kind kind) const;
+
+    std::string mDirectory;
+    bool mbVerify;
+};
+
+
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef LJMet_Com_interface_EtaPhiIndex_h
+#define LJMet_Com_interface_EtaPhiIndex_h
+
+/*
+ Per-event eta-phi binned index of a collection, for deltaR matching
+ without scanning the whole collection for every object.
+ Build it once per collection per event, then run nearest-neighbour
+ and cone queries. Phi wraps around, objects beyond the eta range
+ go to the edge cells.
+
+ Entries are identified by a key, normally the position of the
+ object in its source collection.
+ */
+
+
+
+#include <cmath>
+#include <vector>
+
+
+
+class EtaPhiIndex {
+    //
+    // eta-phi grid with contiguous per-cell entry lists
+    //
+
+
+public:
+
+    /// cellSize should be close to the typical query cone size
+    EtaPhiIndex(double cellSize = 0.4, double maxEta = 5.0);
+    ~EtaPhiIndex(){}
+
+    /// Remove all entries, keeping the allocated memory
+    void Clear();
+
+    /// Add an entry, the index must be rebuilt with Build() before queries
+    void Add(double eta, double phi, int key);
+
+    /// Sort the added entries into the grid
+    void Build();
+
+    /// Index all objects of a collection (anything with eta() and phi()),
+    /// keyed by their position in the collection
+    template <class Collection>
+    void Build(Collection const & collection);
+
+    /// Index only the objects passing the selection
+    template <class Collection, class Predicate>
+    void Build(Collection const & collection, Predicate accept);
+
+    size_t Size() const { return mvEntry.size(); }
+    bool   IsBuilt() const { return mBuilt; }
+
+    /// Key of the closest entry with deltaR <= maxDR, -1 if none.
+    /// The distance is returned in dR if given
+    int Nearest(double eta, double phi, double maxDR, double * dR = 0) const;
+
+    /// Closest entry among those whose key passes accept(key)
+    template <class Predicate>
+    int Nearest(double eta, double phi, double maxDR, Predicate accept, double * dR = 0) const;
+
+    /// Keys of all entries with deltaR <= coneDR, in index order
+    void WithinCone(double eta, double phi, double coneDR, std::vector<int> & keys) const;
+
+    /// Call visit(key, dR2) for every entry with deltaR <= coneDR, in cell order.
+    /// Avoids the key list when the caller only accumulates
+    template <class Visitor>
+    void ForEachInCone(double eta, double phi, double coneDR, Visitor & visit) const;
+
+    static double DeltaPhi(double phi1, double phi2);
+    static double DeltaR2(double eta1, double phi1, double eta2, double phi2);
+
+
+
+private:
+
+    struct Entry {
+        double eta;
+        double phi;
+        int    key;
+    };
+
+    int etaCell(double eta) const;
+    int phiCell(double phi) const;
+
+    /// Visit the cells overlapping the square of half-size dR around (eta, phi)
+    template <class Visitor>
+    void visitCells(double eta, double phi, double dR, Visitor & visit) const;
+
+    double mMaxEta;
+    int    mNEta;
+    int    mNPhi;
+    double mEtaWidth;
+    double mPhiWidth;
+    bool   mBuilt;
+
+    std::vector<Entry> mvPending;   // entries added since the last Build()
+    std::vector<Entry> mvEntry;     // entries sorted by cell
+    std::vector<int>   mvCellStart; // first entry of each cell, size nCells+1
+};
+
+
+
+template <class Collection>
+void EtaPhiIndex::Build(Collection const & collection){
+    Clear();
+    int _key = 0;
+    for (typename Collection::const_iterator it = collection.begin(); it != collection.end(); ++it, ++_key){
+        Add(it->eta(), it->phi(), _key);
+    }
+    Build();
+}
+
+
+
+template <class Collection, class Predicate>
+void EtaPhiIndex::Build(Collection const & collection, Predicate accept){
+    Clear();
+    int _key = 0;
+    for (typename Collection::const_iterator it = collection.begin(); it != collection.end(); ++it, ++_key){
+        if (accept(*it)) Add(it->eta(), it->phi(), _key);
+    }
+    Build();
+}
+
+
+
+template <class Visitor>
+void EtaPhiIndex::visitCells(double eta, double phi, double dR, Visitor & visit) const{
+    int const _etaLow = etaCell(eta - dR);
+    int const _etaHigh = etaCell(eta + dR);
+
+    // phi cells, wrapping around; the whole ring at most once
+    int _phiLow = static_cast<int>(std::floor((DeltaPhi(phi, 0.0) - dR + M_PI)/mPhiWidth));
+    int _nPhi = static_cast<int>(std::floor((DeltaPhi(phi, 0.0) + dR + M_PI)/mPhiWidth)) - _phiLow + 1;
+    if (_nPhi > mNPhi) _nPhi = mNPhi;
+
+    for (int _ie = _etaLow; _ie <= _etaHigh; ++_ie){
+        for (int _ip = 0; _ip != _nPhi; ++_ip){
+            int _cell = _phiLow + _ip;
+            _cell = ((_cell % mNPhi) + mNPhi) % mNPhi;
+            _cell += _ie*mNPhi;
+            for (int i = mvCellStart[_cell]; i != mvCellStart[_cell+1]; ++i){
+                visit(mvEntry[i]);
+            }
+        }
+    }
+}
+
+
+
+template <class Visitor>
+void EtaPhiIndex::ForEachInCone(double eta, double phi, double coneDR, Visitor & visit) const{
+
+    struct InCone {
+        double eta, phi, cone2;
+        Visitor & visit;
+        InCone(double e, double p, double c2, Visitor & v): eta(e), phi(p), cone2(c2), visit(v){}
+        void operator()(Entry const & entry){
+            double const _dr2 = DeltaR2(eta, phi, entry.eta, entry.phi);
+            if (_dr2 <= cone2) visit(entry.key, _dr2);
+        }
+    } _inCone(eta, phi, coneDR*coneDR, visit);
+
+    visitCells(eta, phi, coneDR, _inCone);
+}
+
+
+
+template <class Predicate>
+int EtaPhiIndex::Nearest(double eta, double phi, double maxDR, Predicate accept, double * dR) const{
+
+    struct Closest {
+        double eta, phi, best2;
+        int key;
+        Predicate & accept;
+        Closest(double e, double p, double m2, Predicate & a): eta(e), phi(p), best2(m2), key(-1), accept(a){}
+        void operator()(Entry const & entry){
+            double const _dr2 = DeltaR2(eta, phi, entry.eta, entry.phi);
+            if (_dr2 > best2) return;
+            if (key >= 0 && _dr2 == best2 && entry.key > key) return; // ties: lowest key, as a linear scan
+            if (!accept(entry.key)) return;
+            best2 = _dr2;
+            key = entry.key;
+        }
+    } _closest(eta, phi, maxDR*maxDR, accept);
+
+    visitCells(eta, phi, maxDR, _closest);
+
+    if (dR) *dR = (_closest.key >= 0) ? std::sqrt(_closest.best2) : -1.0;
+
+    return _closest.key;
+}
+
+
+
+inline
+double EtaPhiIndex::DeltaPhi(double phi1, double phi2){
+    double _dphi = phi1 - phi2;
+    while (_dphi > M_PI) _dphi -= 2.0*M_PI;
+    while (_dphi <= -M_PI) _dphi += 2.0*M_PI;
+    return _dphi;
+}
+
+
+
+inline
+double EtaPhiIndex::DeltaR2(double eta1, double phi1, double eta2, double phi2){
+    double const _deta = eta1 - eta2;
+    double const _dphi = DeltaPhi(phi1, phi2);
+    return _deta*_deta + _dphi*_dphi;
+}
+
+
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef LJMet_Com_interface_EventArena_h
+#define LJMet_Com_interface_EventArena_h
+
+/*
+ Event-scoped monotonic memory for scratch containers of the
+ selector and calculators. Allocations only move a pointer and
+ everything is released at once when the event content has been
+ filled. The memory is kept for the next event.
+
+ Small requests are rounded up to a power of two. A buffer given
+ back by a growing container goes to a free list of its size and
+ is handed out again by the next request of that size, so
+ push_back regrowth does not leave dead blocks behind.
+
+ Containers using it must not outlive the event, so only
+ AnalyzeEvent() locals should be ArenaVectors, never members.
+ */
+
+
+
+#include <cstddef>
+#include <vector>
+
+
+
+class EventArena {
+    //
+    // monotonic block allocator, reset once per event
+    //
+
+
+public:
+
+    explicit EventArena(size_t blockSize = 1 << 20);
+    ~EventArena();
+
+    void * Allocate(size_t bytes, size_t alignment);
+    /// Give back memory from Allocate() with the same bytes and alignment
+    void Deallocate(void * p, size_t bytes, size_t alignment);
+
+    /// Release everything allocated since the last reset. If the
+    /// event needed more than one block they are merged into one
+    void Reset();
+
+    size_t GetBytesUsed() const { return mUsed; }
+    size_t GetCapacity() const;
+
+
+
+private:
+
+    EventArena(EventArena const &);             // no copies
+    EventArena & operator=(EventArena const &);
+
+    struct Block {
+        char * data;
+        size_t size;
+    };
+
+    struct FreeNode {
+        FreeNode * next;
+    };
+
+    // size classes 2^kMinClass .. 2^kMaxClass bytes, larger requests are not recycled
+    static const int kMinClass = 4;
+    static const int kMaxClass = 20;
+    static const size_t kClassAlignment = 16;
+
+    /// Size class of a request, -1 if it is not recycled
+    static int sizeClass(size_t bytes, size_t alignment);
+    void * allocateBytes(size_t bytes, size_t alignment);
+    void addBlock(size_t minSize);
+
+    std::vector<Block> mvBlock;
+    size_t mCurrent;   // block being filled
+    size_t mOffset;    // first free byte in the current block
+    size_t mUsed;      // bytes handed out since the last reset
+    FreeNode * mFree[kMaxClass+1];   // given back buffers, per size class
+};
+
+
+
+template <class T>
+class ArenaAllocator {
+    //
+    // standard allocator on an EventArena
+    //
+
+
+public:
+
+    typedef T value_type;
+
+    ArenaAllocator(EventArena & arena): mpArena(&arena){}
+    template <class U>
+    ArenaAllocator(ArenaAllocator<U> const & other): mpArena(other.GetArena()){}
+
+    T * allocate(size_t n){ return static_cast<T *>(mpArena->Allocate(n*sizeof(T), alignof(T))); }
+    void deallocate(T * p, size_t n){ mpArena->Deallocate(p, n*sizeof(T), alignof(T)); }
+
+    EventArena * GetArena() const { return mpArena; }
+
+
+
+private:
+
+    EventArena * mpArena;
+};
+
+
+
+template <class T, class U>
+inline bool operator==(ArenaAllocator<T> const & a, ArenaAllocator<U> const & b){ return a.GetArena() == b.GetArena(); }
+
+template <class T, class U>
+inline bool operator!=(ArenaAllocator<T> const & a, ArenaAllocator<U> const & b){ return a.GetArena() != b.GetArena(); }
+
+
+
+/// Vector on the event arena: ArenaVector<double> v(GetArena());
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+
+
+inline
+int EventArena::sizeClass(size_t bytes, size_t alignment){
+    if (alignment > kClassAlignment || bytes > (size_t(1) << kMaxClass)) return -1;
+    int _class = kMinClass;
+    while ((size_t(1) << _class) < bytes) ++_class;
+    return _class;
+}
+
+
+
+inline
+void * EventArena::Allocate(size_t bytes, size_t alignment){
+    int const _class = sizeClass(bytes, alignment);
+    if (_class < 0) return allocateBytes(bytes, alignment);
+    if (mFree[_class]){
+        FreeNode * _node = mFree[_class];
+        mFree[_class] = _node->next;
+        return _node;
+    }
+    return allocateBytes(size_t(1) << _class, kClassAlignment);
+}
+
+
+
+inline
+void EventArena::Deallocate(void * p, size_t bytes, size_t alignment){
+    int const _class = sizeClass(bytes, alignment);
+    if (_class < 0 || !p) return;
+    FreeNode * _node = static_cast<FreeNode *>(p);
+    _node->next = mFree[_class];
+    mFree[_class] = _node;
+}
+
+
+
+inline
+void * EventArena::allocateBytes(size_t bytes, size_t alignment){
+    size_t _start = (mOffset + alignment - 1) & ~(alignment - 1);
+    if (_start + bytes > mvBlock[mCurrent].size){
+        addBlock(bytes + alignment);
+        _start = (mOffset + alignment - 1) & ~(alignment - 1);
+    }
+    char * _p = mvBlock[mCurrent].data + _start;
+    mUsed += _start + bytes - mOffset;
+    mOffset = _start + bytes;
+    return _p;
+}
+
+
+
+#endif
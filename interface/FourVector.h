@@ -0,0 +1,275 @@
+#ifndef LJMet_Com_interface_FourVector_h
+#define LJMet_Com_interface_FourVector_h
+
+/*
+ Plain value-type Lorentz vector (px, py, pz, E) for kinematics in
+ combinatorial loops: trivially copyable, no virtual functions, all
+ inline. Accessors follow the TLorentzVector names, so it converts
+ to and from TLorentzVector, TMBLorentzVector and reco::Candidate
+ without depending on any of them.
+
+ The batch functions work on plain arrays and are written so that
+ the compiler can vectorize them.
+ */
+
+
+
+#include <cmath>
+#include <cstddef>
+
+
+
+class FourVector {
+    //
+    // (px, py, pz, E), with the usual derived quantities
+    //
+
+
+public:
+
+    FourVector(): mPx(0.0), mPy(0.0), mPz(0.0), mE(0.0){}
+    FourVector(double px, double py, double pz, double e): mPx(px), mPy(py), mPz(pz), mE(e){}
+
+    static FourVector FromPtEtaPhiM(double pt, double eta, double phi, double m);
+    static FourVector FromPtEtaPhiE(double pt, double eta, double phi, double e);
+
+    /// From anything with Px(), Py(), Pz() and E(): TLorentzVector, TMBLorentzVector
+    template <class LorentzVector>
+    static FourVector FromLorentz(LorentzVector const & v){ return FourVector(v.Px(), v.Py(), v.Pz(), v.E()); }
+
+    /// From anything with px(), py(), pz() and energy(): reco::Candidate and PAT objects
+    template <class Candidate>
+    static FourVector FromCandidate(Candidate const & c){ return FourVector(c.px(), c.py(), c.pz(), c.energy()); }
+
+    /// To any type constructible from (px, py, pz, E), e.g. TLorentzVector
+    template <class LorentzVector>
+    LorentzVector ToLorentz() const { return LorentzVector(mPx, mPy, mPz, mE); }
+
+    double Px() const { return mPx; }
+    double Py() const { return mPy; }
+    double Pz() const { return mPz; }
+    double E()  const { return mE; }
+    double Energy() const { return mE; }
+
+    void SetPxPyPzE(double px, double py, double pz, double e){ mPx = px; mPy = py; mPz = pz; mE = e; }
+
+    double Pt2() const { return mPx*mPx + mPy*mPy; }
+    double Pt()  const { return std::sqrt(Pt2()); }
+    double P2()  const { return Pt2() + mPz*mPz; }
+    double P()   const { return std::sqrt(P2()); }
+    /// Invariant mass squared and mass, negative m2 gives -sqrt(-m2) as in TLorentzVector
+    double M2()  const { return mE*mE - P2(); }
+    double M()   const { double const _m2 = M2(); return _m2 < 0.0 ? -std::sqrt(-_m2) : std::sqrt(_m2); }
+    double Mt()  const { double const _mt2 = mE*mE - mPz*mPz; return _mt2 < 0.0 ? -std::sqrt(-_mt2) : std::sqrt(_mt2); }
+    double Phi() const { return (mPx == 0.0 && mPy == 0.0) ? 0.0 : std::atan2(mPy, mPx); }
+    double Theta() const { return (mPx == 0.0 && mPy == 0.0 && mPz == 0.0) ? 0.0 : std::atan2(Pt(), mPz); }
+    double Eta() const;
+    double Rapidity() const { return 0.5*std::log((mE + mPz)/(mE - mPz)); }
+
+    /// Velocity of the rest frame, p/E
+    void BoostVector(double & bx, double & by, double & bz) const { bx = mPx/mE; by = mPy/mE; bz = mPz/mE; }
+    /// Boost by the velocity (bx, by, bz), as TLorentzVector::Boost
+    FourVector Boosted(double bx, double by, double bz) const;
+    /// This vector in the rest frame of frame
+    FourVector InRestFrameOf(FourVector const & frame) const { return Boosted(-frame.mPx/frame.mE, -frame.mPy/frame.mE, -frame.mPz/frame.mE); }
+
+    double Dot(FourVector const & o) const { return mE*o.mE - mPx*o.mPx - mPy*o.mPy - mPz*o.mPz; }
+    double Dot3(FourVector const & o) const { return mPx*o.mPx + mPy*o.mPy + mPz*o.mPz; }
+    /// Cosine of the angle between the momenta, 1 if one of them is zero
+    double CosAngle(FourVector const & o) const;
+    double Angle(FourVector const & o) const { return std::acos(CosAngle(o)); }
+
+    FourVector & operator+=(FourVector const & o){ mPx += o.mPx; mPy += o.mPy; mPz += o.mPz; mE += o.mE; return *this; }
+    FourVector & operator-=(FourVector const & o){ mPx -= o.mPx; mPy -= o.mPy; mPz -= o.mPz; mE -= o.mE; return *this; }
+    FourVector & operator*=(double a){ mPx *= a; mPy *= a; mPz *= a; mE *= a; return *this; }
+
+    bool operator==(FourVector const & o) const { return mPx == o.mPx && mPy == o.mPy && mPz == o.mPz && mE == o.mE; }
+    bool operator!=(FourVector const & o) const { return !(*this == o); }
+
+
+
+private:
+
+    double mPx;
+    double mPy;
+    double mPz;
+    double mE;
+};
+
+
+
+class LorentzBoost {
+    //
+    // a boost with gamma and (gamma-1)/beta^2 computed once,
+    // for applying the same boost to many vectors
+    //
+
+
+public:
+
+    LorentzBoost(): mBx(0.0), mBy(0.0), mBz(0.0), mGamma(1.0), mGamma2(0.0){}
+    /// Boost by the velocity (bx, by, bz), as FourVector::Boosted
+    LorentzBoost(double bx, double by, double bz);
+
+    /// The boost taking vectors into the rest frame of frame
+    static LorentzBoost ToRestFrameOf(FourVector const & frame){ return LorentzBoost(-frame.Px()/frame.E(), -frame.Py()/frame.E(), -frame.Pz()/frame.E()); }
+
+    FourVector operator()(FourVector const & v) const;
+
+
+
+private:
+
+    double mBx;
+    double mBy;
+    double mBz;
+    double mGamma;
+    double mGamma2;
+};
+
+
+
+inline FourVector operator+(FourVector a, FourVector const & b){ return a += b; }
+inline FourVector operator-(FourVector a, FourVector const & b){ return a -= b; }
+inline FourVector operator*(FourVector a, double s){ return a *= s; }
+inline FourVector operator*(double s, FourVector a){ return a *= s; }
+
+
+
+namespace fourvector {
+
+    /// Phi difference in (-pi, pi]
+    inline double DeltaPhi(double phi1, double phi2){
+        double _dphi = phi1 - phi2;
+        while (_dphi > M_PI) _dphi -= 2.0*M_PI;
+        while (_dphi <= -M_PI) _dphi += 2.0*M_PI;
+        return _dphi;
+    }
+
+    inline double DeltaR2(double eta1, double phi1, double eta2, double phi2){
+        double const _deta = eta1 - eta2;
+        double const _dphi = DeltaPhi(phi1, phi2);
+        return _deta*_deta + _dphi*_dphi;
+    }
+
+    inline double DeltaR(FourVector const & a, FourVector const & b){
+        return std::sqrt(DeltaR2(a.Eta(), a.Phi(), b.Eta(), b.Phi()));
+    }
+
+    inline double InvariantMass(FourVector const & a, FourVector const & b){ return (a + b).M(); }
+
+    inline double InvariantMass(FourVector const & a, FourVector const & b, FourVector const & c){ return (a + b + c).M(); }
+
+    /// out[i] = in[i] boosted by (bx, by, bz)
+    void BoostAll(FourVector const * in, FourVector * out, size_t n, double bx, double by, double bz);
+
+    /// out[i] = invariant mass of a[i] + b[i]
+    void PairMassAll(FourVector const * a, FourVector const * b, double * out, size_t n);
+
+    /// out[i] = deltaR^2 of (eta, phi) to (etas[i], phis[i])
+    void DeltaR2All(double eta, double phi, double const * etas, double const * phis, double * out, size_t n);
+}
+
+
+
+inline
+FourVector FourVector::FromPtEtaPhiM(double pt, double eta, double phi, double m){
+    double const _px = pt*std::cos(phi);
+    double const _py = pt*std::sin(phi);
+    double const _pz = pt*std::sinh(eta);
+    return FourVector(_px, _py, _pz, std::sqrt(pt*pt + _pz*_pz + m*m));
+}
+
+
+
+inline
+FourVector FourVector::FromPtEtaPhiE(double pt, double eta, double phi, double e){
+    return FourVector(pt*std::cos(phi), pt*std::sin(phi), pt*std::sinh(eta), e);
+}
+
+
+
+inline
+double FourVector::Eta() const{
+    // same conventions as TVector3::PseudoRapidity for pt = 0
+    double const _p = P();
+    double const _cosTheta = _p == 0.0 ? 1.0 : mPz/_p;
+    if (_cosTheta*_cosTheta < 1.0) return -0.5*std::log((1.0 - _cosTheta)/(1.0 + _cosTheta));
+    if (mPz == 0.0) return 0.0;
+    return mPz > 0.0 ? 10e10 : -10e10;
+}
+
+
+
+inline
+LorentzBoost::LorentzBoost(double bx, double by, double bz):
+mBx(bx),
+mBy(by),
+mBz(bz){
+    double const _b2 = bx*bx + by*by + bz*bz;
+    mGamma = 1.0/std::sqrt(1.0 - _b2);
+    mGamma2 = _b2 > 0.0 ? (mGamma - 1.0)/_b2 : 0.0;
+}
+
+
+
+inline
+FourVector LorentzBoost::operator()(FourVector const & v) const{
+    double const _bp = mBx*v.Px() + mBy*v.Py() + mBz*v.Pz();
+    double const _coef = mGamma2*_bp + mGamma*v.E();
+    return FourVector(v.Px() + _coef*mBx, v.Py() + _coef*mBy, v.Pz() + _coef*mBz, mGamma*(v.E() + _bp));
+}
+
+
+
+inline
+FourVector FourVector::Boosted(double bx, double by, double bz) const{
+    return LorentzBoost(bx, by, bz)(*this);
+}
+
+
+
+inline
+double FourVector::CosAngle(FourVector const & o) const{
+    double const _norm2 = P2()*o.P2();
+    if (_norm2 <= 0.0) return 1.0;
+    double const _cos = Dot3(o)/std::sqrt(_norm2);
+    return _cos > 1.0 ? 1.0 : (_cos < -1.0 ? -1.0 : _cos);
+}
+
+
+
+namespace fourvector {
+
+    inline
+    void BoostAll(FourVector const * in, FourVector * out, size_t n, double bx, double by, double bz){
+        LorentzBoost const _boost(bx, by, bz);
+        for (size_t i = 0; i != n; ++i) out[i] = _boost(in[i]);
+    }
+
+    inline
+    void PairMassAll(FourVector const * a, FourVector const * b, double * out, size_t n){
+        for (size_t i = 0; i != n; ++i){
+            double const _e  = a[i].E()  + b[i].E();
+            double const _px = a[i].Px() + b[i].Px();
+            double const _py = a[i].Py() + b[i].Py();
+            double const _pz = a[i].Pz() + b[i].Pz();
+            double const _m2 = _e*_e - _px*_px - _py*_py - _pz*_pz;
+            out[i] = _m2 < 0.0 ? -std::sqrt(-_m2) : std::sqrt(_m2);
+        }
+    }
+
+    inline
+    void DeltaR2All(double eta, double phi, double const * etas, double const * phis, double * out, size_t n){
+        for (size_t i = 0; i != n; ++i){
+            double const _deta = eta - etas[i];
+            double _dphi = std::fabs(phi - phis[i]);
+            _dphi = _dphi > M_PI ? 2.0*M_PI - _dphi : _dphi;   // inputs in [-pi, pi]
+            out[i] = _deta*_deta + _dphi*_dphi;
+        }
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef LJMet_Com_interface_GenEventIndex_h
+#define LJMet_Com_interface_GenEventIndex_h
+
+/*
+ Event-scoped genealogy tables for the generator particles,
+ built in one pass so that MC-truth code does not rescan the
+ collection for mothers, copies or decay chains.
+
+ Indices refer to positions in the pruned gen particle collection.
+ Packed gen particles, if given, are linked to their pruned mother.
+ */
+
+
+
+#include <vector>
+#include <unordered_map>
+
+#include "DataFormats/Candidate/interface/Candidate.h"
+#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+#include "DataFormats/PatCandidates/interface/PackedGenParticle.h"
+
+
+
+class GenEventIndex {
+    //
+    // parent/child index arrays, copy resolution and
+    // top quark decay classification
+    //
+
+
+public:
+
+    enum TopDecay {
+        kUnknown     = 0,
+        kHadronic    = 1,
+        kElectron    = 2,
+        kMuon        = 3,
+        kTau         = 4
+    };
+
+    struct TopChain {
+        int top;      // last copy of the top
+        int b;        // b quark from the top decay, -1 if not found
+        int w;        // last copy of the W, -1 if not found
+        int wDau1;    // W decay products, the charged lepton first
+        int wDau2;    // for leptonic decays
+        TopDecay decay;
+    };
+
+    GenEventIndex();
+    ~GenEventIndex(){}
+
+    /// Build all tables; packed may be null
+    void Build(reco::GenParticleCollection const & pruned,
+               std::vector<pat::PackedGenParticle> const * packed = 0);
+    void Clear();
+
+    bool IsBuilt() const { return mpPruned != 0; }
+    reco::GenParticleCollection const * GetCollection() const { return mpPruned; }
+    size_t Size() const { return mvMotherStart.empty() ? 0 : mvMotherStart.size()-1; }
+
+    /// Index of a candidate in the pruned collection, -1 if it is not there
+    int Index(reco::Candidate const * cand) const;
+
+    int NMothers(int i) const { return mvMotherStart[i+1] - mvMotherStart[i]; }
+    int NDaughters(int i) const { return mvDaughterStart[i+1] - mvDaughterStart[i]; }
+    /// Index of the k-th mother/daughter, -1 if it is not in the collection
+    int Mother(int i, int k = 0) const { return k < NMothers(i) ? mvMother[mvMotherStart[i]+k] : -1; }
+    int Daughter(int i, int k) const { return k < NDaughters(i) ? mvDaughter[mvDaughterStart[i]+k] : -1; }
+
+    /// First/last copy of a particle along the chain of same-pdgId mothers/daughters
+    int FirstCopy(int i) const { return mvFirstCopy[i]; }
+    int LastCopy(int i) const { return mvLastCopy[i]; }
+
+    /// Ancestors following the first mother, closest first, at most maxDepth
+    void Ancestors(int i, int maxDepth, std::vector<int> & ancestors) const;
+
+    /// Top quark decay chains, one per last-copy top
+    std::vector<TopChain> const & GetTopChains() const { return mvTopChain; }
+
+    /// Pruned mother of a packed gen particle, -1 if none
+    int PackedMother(int iPacked) const { return mvPackedMother[iPacked]; }
+
+
+
+private:
+
+    int sameIdDaughter(int i) const;
+    int sameIdMother(int i) const;
+    void classifyTop(int top);
+
+    reco::GenParticleCollection const * mpPruned;
+
+    std::unordered_map<reco::Candidate const *, int> mIndex;
+
+    std::vector<int> mvMotherStart;
+    std::vector<int> mvMother;
+    std::vector<int> mvDaughterStart;
+    std::vector<int> mvDaughter;
+    std::vector<int> mvFirstCopy;
+    std::vector<int> mvLastCopy;
+    std::vector<TopChain> mvTopChain;
+    std::vector<int> mvPackedMother;
+};
+
+
+
+inline
+int GenEventIndex::Index(reco::Candidate const * cand) const{
+    std::unordered_map<reco::Candidate const *, int>::const_iterator it = mIndex.find(cand);
+    return it == mIndex.end() ? -1 : it->second;
+}
+
+
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef LJMet_Com_interface_GenWeightReader_h
+#define LJMet_Com_interface_GenWeightReader_h
+
+/*
+ Generator weights stored in the input: the nominal weight of
+ GenEventInfoProduct and the LHE weights as ratios to the LHE
+ nominal weight, instead of evaluating PDF sets again.
+
+ The weight ids are mapped to scale and PDF groups once per
+ input file and run, from the <initrwgt> block of the LHE run
+ header. Ids missing from the header fall back to the usual
+ numbering: 1001-1009 scale, 2001 and above PDF.
+ Samples without LHE weights give the further weights of
+ GenEventInfoProduct, as ratios to its first weight.
+ */
+
+
+
+#include <string>
+#include <vector>
+
+#include "FWCore/Utilities/interface/InputTag.h"
+
+
+
+namespace edm {
+    class EventBase;
+}
+
+
+
+class GenWeightReader {
+    //
+    // generator weights of the event and their layout
+    //
+
+
+public:
+
+    enum Group {
+        kOther = 0,
+        kScale = 1,
+        kPdf   = 2
+    };
+
+    struct Layout {
+        unsigned key;                       // hash of the ids, the same in every job
+        std::vector<std::string> vId;       // weight ids in the order of the ratios
+        std::vector<int> vGroup;            // Group of each weight
+        std::vector<std::string> vGroupName;// weightgroup of each weight in the header
+    };
+
+    GenWeightReader();
+    ~GenWeightReader(){}
+
+    /// Read the weights of the event; the layout is rebuilt for a new file or run
+    void Read(edm::EventBase const & event,
+              edm::InputTag const & genInfoTag,
+              edm::InputTag const & lheTag,
+              edm::InputTag const & lheRunInfoTag);
+    void Clear() { mbRead = false; }
+
+    bool IsRead() const { return mbRead; }
+    bool IsReadFrom(edm::InputTag const & genInfoTag, edm::InputTag const & lheTag) const {
+        return mbRead && mGenInfoTag == genInfoTag && mLheTag == lheTag;
+    }
+
+    /// GenEventInfoProduct::weight(), 1 if there is none
+    double GetNominal() const { return mNominal; }
+    /// Weights divided by the LHE nominal weight
+    std::vector<double> const & GetRatios() const { return mvRatio; }
+    /// Ids and groups of the ratios
+    Layout const & GetLayout() const { return mLayout; }
+
+
+
+private:
+
+    void buildLayout(edm::EventBase const & event, edm::InputTag const & lheRunInfoTag,
+                     std::vector<std::string> const & ids);
+
+    bool mbRead;
+    edm::InputTag mGenInfoTag;
+    edm::InputTag mLheTag;
+    double mNominal;
+    std::vector<double> mvRatio;
+
+    // layout of the current file and run
+    Layout mLayout;
+    std::string mLayoutFile;
+    unsigned mLayoutRun;
+    std::vector<std::string> mvId;     // ids of the current event, reused
+};
+
+
+
+#endif
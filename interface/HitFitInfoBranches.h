@@ -2,6 +2,11 @@
 #define HITFITINFOBRANCHES_H
 
 #include <TTree.h>
+#include "DataFormats/PatCandidates/interface/Electron.h"
+#include "DataFormats/PatCandidates/interface/Muon.h"
+#include "DataFormats/PatCandidates/interface/Jet.h"
+#include "DataFormats/PatCandidates/interface/MET.h"
+#include "TopQuarkAnalysis/TopHitFit/interface/RunHitFit.h"
 
 static const unsigned int kMIN_HITFIT_JET=4;
 static const unsigned int kMAX_HITFIT_JET=5;
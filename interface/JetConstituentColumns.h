@@ -0,0 +1,206 @@
+#ifndef LJMet_Com_interface_JetConstituentColumns_h
+#define LJMet_Com_interface_JetConstituentColumns_h
+
+/*
+ Compact storage of jet constituents as jagged columns.
+
+ The constituents of all jets of an event are stored one after the
+ other; an offsets column with one entry per jet plus one gives the
+ range of each jet. Every constituent is kept relative to its jet:
+
+   deta   = eta - eta(jet)          16 bits in [-kMaxDelta, kMaxDelta]
+   dphi   = phi - phi(jet)          16 bits in [-kMaxDelta, kMaxDelta]
+   logpt  = log(pt/pt(jet))         16 bits in [kMinLogPt, kMaxLogPt]
+   type   = particle class times charge, see Type
+
+ Values outside the ranges are stored at the nearest edge. The energy
+ is recomputed from pt, eta and the nominal mass of the type.
+
+ Header only, with no CMSSW dependencies, so the reader can be used in
+ ROOT macros on the ntuple.
+ */
+
+
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+#include "LJMet/Com/interface/FourVector.h"
+
+
+
+namespace jetconstituents {
+
+    /// Particle classes; stored with the sign of the charge
+    enum Type {
+        kOther          = 0,
+        kHFHadron       = 1,
+        kHFEm           = 2,
+        kElectron       = 3,
+        kMuon           = 4,
+        kPhoton         = 5,
+        kChargedHadron  = 6,
+        kNeutralHadron  = 7
+    };
+
+    double const kMaxDelta = 2.0;
+    double const kMinLogPt = -20.0;
+    double const kMaxLogPt = 2.0;
+
+    /// value in [min, max] to one of 65536 steps
+    inline short Quantize(double value, double min, double max){
+        double const _step = (value - min)/(max - min)*65535.0;
+        if (!(_step > 0.0)) return -32768;
+        if (_step >= 65535.0) return 32767;
+        return static_cast<short>(static_cast<long>(_step + 0.5) - 32768);
+    }
+
+    inline double Dequantize(short q, double min, double max){
+        return min + (static_cast<double>(q) + 32768.0)/65535.0*(max - min);
+    }
+
+    /// Signed Type of a PF candidate pdgId and charge
+    inline short TypeFromPdgId(int pdgId, int charge){
+        int _type = kOther;
+        switch (std::abs(pdgId)){
+        case 1:   _type = kHFHadron; break;
+        case 2:   _type = kHFEm; break;
+        case 11:  _type = kElectron; break;
+        case 13:  _type = kMuon; break;
+        case 22:  _type = kPhoton; break;
+        case 211: _type = kChargedHadron; break;
+        case 130: _type = kNeutralHadron; break;
+        }
+        return static_cast<short>(charge < 0 ? -_type : _type);
+    }
+
+    /// PF pdgId of a signed Type, 0 for kOther
+    inline int PdgIdFromType(short type){
+        int const _charge = type < 0 ? -1 : 1;
+        switch (std::abs(type)){
+        case kHFHadron:      return 1;
+        case kHFEm:          return 2;
+        case kElectron:      return -11*_charge;
+        case kMuon:          return -13*_charge;
+        case kPhoton:        return 22;
+        case kChargedHadron: return 211*_charge;
+        case kNeutralHadron: return 130;
+        }
+        return 0;
+    }
+
+    inline int ChargeFromType(short type){ return type < 0 ? -1 : ((type == kElectron || type == kMuon || type == kChargedHadron) ? 1 : 0); }
+
+    /// Mass used for the energy of a Type, as the PF candidates
+    inline double MassFromType(short type){
+        switch (std::abs(type)){
+        case kElectron:      return 0.000511;
+        case kMuon:          return 0.105658;
+        case kChargedHadron: return 0.139570;
+        }
+        return 0.0;
+    }
+
+
+
+    class Writer {
+        //
+        // appends the constituents of one jet after the other
+        // to caller-owned columns, any vector-like containers
+        //
+
+
+    public:
+
+        Writer(double jetPt, double jetEta, double jetPhi):
+        mJetEta(jetEta),
+        mJetPhi(jetPhi),
+        mLogJetPt(std::log(jetPt)){}
+
+        template <class ShortColumn>
+        void Add(double pt, double eta, double phi, int pdgId, int charge,
+                 ShortColumn & deta, ShortColumn & dphi, ShortColumn & logpt, ShortColumn & type) const{
+            deta.push_back(Quantize(eta - mJetEta, -kMaxDelta, kMaxDelta));
+            dphi.push_back(Quantize(fourvector::DeltaPhi(phi, mJetPhi), -kMaxDelta, kMaxDelta));
+            logpt.push_back(Quantize(pt > 0.0 ? std::log(pt) - mLogJetPt : kMinLogPt, kMinLogPt, kMaxLogPt));
+            type.push_back(TypeFromPdgId(pdgId, charge));
+        }
+
+
+    private:
+
+        double mJetEta;
+        double mJetPhi;
+        double mLogJetPt;
+    };
+
+
+
+    struct Constituent {
+        double pt;
+        double eta;
+        double phi;
+        double energy;
+        int pdgId;
+        int charge;
+    };
+
+
+
+    class Reader {
+        //
+        // unpacks the columns of one event as read from the tree
+        //
+
+
+    public:
+
+        Reader(std::vector<int> const & offsets,
+               std::vector<short> const & deta, std::vector<short> const & dphi,
+               std::vector<short> const & logpt, std::vector<short> const & type):
+        mOffsets(offsets),
+        mDEta(deta),
+        mDPhi(dphi),
+        mLogPt(logpt),
+        mType(type){}
+
+        size_t GetNJets() const { return mOffsets.empty() ? 0 : mOffsets.size() - 1; }
+        size_t GetNConstituents(size_t jet) const { return mOffsets[jet+1] - mOffsets[jet]; }
+
+        /// Constituent i of a jet, given the stored jet pt, eta and phi
+        Constituent Get(size_t jet, size_t i, double jetPt, double jetEta, double jetPhi) const{
+            size_t const _k = mOffsets[jet] + i;
+            Constituent _c;
+            _c.pt = jetPt*std::exp(Dequantize(mLogPt[_k], kMinLogPt, kMaxLogPt));
+            _c.eta = jetEta + Dequantize(mDEta[_k], -kMaxDelta, kMaxDelta);
+            _c.phi = fourvector::DeltaPhi(jetPhi + Dequantize(mDPhi[_k], -kMaxDelta, kMaxDelta), 0.0);
+            _c.pdgId = PdgIdFromType(mType[_k]);
+            _c.charge = ChargeFromType(mType[_k]);
+            _c.energy = FourVector::FromPtEtaPhiM(_c.pt, _c.eta, _c.phi, MassFromType(mType[_k])).E();
+            return _c;
+        }
+
+        /// All constituents of a jet as four-vectors, appended to p4s
+        void GetP4s(size_t jet, double jetPt, double jetEta, double jetPhi, std::vector<FourVector> & p4s) const{
+            for (size_t i = 0; i != GetNConstituents(jet); ++i){
+                Constituent const _c = Get(jet, i, jetPt, jetEta, jetPhi);
+                p4s.push_back(FourVector::FromPtEtaPhiE(_c.pt, _c.eta, _c.phi, _c.energy));
+            }
+        }
+
+
+    private:
+
+        std::vector<int> const & mOffsets;
+        std::vector<short> const & mDEta;
+        std::vector<short> const & mDPhi;
+        std::vector<short> const & mLogPt;
+        std::vector<short> const & mType;
+    };
+}
+
+
+
+#endif
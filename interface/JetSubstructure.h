@@ -0,0 +1,94 @@
+#ifndef LJMet_Com_interface_JetSubstructure_h
+#define LJMet_Com_interface_JetSubstructure_h
+
+/*
+ Jet substructure computed from the jet constituents: N-subjettiness
+ tau1..3, soft drop and pruned masses, and the energy correlation
+ ratios C2 and D2 of the soft drop groomed jet.
+
+ The constituents are added one by one and Compute() runs everything
+ on them. Constituent and pair buffers and the N-jettiness finder are
+ kept between jets, so one object serves all the jets of a job.
+ */
+
+
+
+#include <cstddef>
+#include <vector>
+
+#include "fastjet/PseudoJet.hh"
+
+
+
+class Njettiness;
+
+
+
+class JetSubstructure {
+    //
+    // substructure of one jet at a time, with reused workspaces
+    //
+
+
+public:
+
+    struct Result {
+        double tau1;
+        double tau2;
+        double tau3;
+        double softDropMass;
+        double prunedMass;
+        double ecfC2;           // e3/e2^2 of the soft drop jet
+        double ecfD2;           // e3/e2^3 of the soft drop jet
+        int nSoftDrop;          // constituents left after soft drop
+    };
+
+    JetSubstructure();
+    ~JetSubstructure();
+
+    /// N-subjettiness with one-pass kt axes
+    void SetNsubjettiness(double beta, double R0);
+    /// Soft drop condition z > zcut*(dR/R0)^beta on the C/A declustering
+    void SetSoftDrop(double beta, double zcut, double R0);
+    /// C/A pruning with Rcut = rcutFactor*2m/pt
+    void SetPruning(double zcut, double rcutFactor);
+    /// Angular exponent of the energy correlation functions
+    void SetEcfBeta(double beta){ mEcfBeta = beta; }
+
+    /// Start a new jet
+    void Clear(){ mvParticle.clear(); }
+    void AddConstituent(double px, double py, double pz, double e){ mvParticle.push_back(fastjet::PseudoJet(px, py, pz, e)); }
+    size_t GetNConstituents() const { return mvParticle.size(); }
+
+    /// Substructure of the constituents added since Clear()
+    Result const & Compute();
+
+
+
+private:
+
+    JetSubstructure(JetSubstructure const &);             // no copies
+    JetSubstructure & operator=(JetSubstructure const &);
+
+    void computeEcf(std::vector<fastjet::PseudoJet> const & particles);
+
+    Njettiness * mpNjettiness;
+
+    double mSoftDropBeta;
+    double mSoftDropZcut;
+    double mSoftDropR0;
+    double mPruningZcut;
+    double mPruningRcutFactor;
+    double mEcfBeta;
+
+    // workspaces, kept between jets
+    std::vector<fastjet::PseudoJet> mvParticle;
+    std::vector<double> mvPt;
+    std::vector<double> mvPair;     // pt_i pt_j dR_ij^beta, and dR^beta for the triplets
+
+    Result mResult;
+};
+
+
+
+#endif
@@ -6,7 +6,7 @@
 #include <string>
 #include <vector>
 #include "FWCore/Framework/interface/Event.h"
-#include "LJMet/Com/interface/TMBLorentzVector.h"
+#include "LJMet/Com/interface/FourVector.h"
 #include "TVectorD.h"
 #include "TLorentzVector.h"
 #include "LJMet/Com/interface/METzCalculator.h"
@@ -30,12 +30,13 @@ public:
     _mtOK(        false){};
     
     //LJetsTopoVarsNew(std::vector<TLorentzVector> & jets,
-    LJetsTopoVarsNew(const std::vector<std::pair<TLorentzVector,bool> > jets,
-                     TLorentzVector & lepton,
-                     TLorentzVector & met,
+    LJetsTopoVarsNew(const std::vector<std::pair<TLorentzVector,bool> > & jets,
+                     FourVector const & lepton,
+                     FourVector const & met,
                      bool isMuon,
                      bool bestTop,
-                     double wmass = 80.398)
+                     double wmass = 80.398,
+                     NeutrinoSolver * nuSolver = 0)
     :m_isMuon(isMuon),
     WMassPdg(wmass),
     _ht(          std::vector<double>(22, 0.) ),
@@ -47,6 +48,7 @@ public:
     _mt(          std::vector<double>( 2, 0.) ),
     _mtOK(        false){
         
+        fzCalculator.SetSolver(nuSolver);
         setEvent(jets, lepton, met, isMuon, bestTop);
         
     };
@@ -57,14 +59,16 @@ public:
     // 4 leading jets momenta. Note that if fewer than 4 jets are supplied,
     // some variables are not well-defined. Every effort is made to process
     // such situations correctly. Still, the user should use caution.
+    // The jets come as the selector keeps them, everything is stored
+    // and computed as FourVector.
     //int setEvent(std::vector<TLorentzVector> & jets,
-    int setEvent(const std::vector<std::pair<TLorentzVector,bool> > jets,
-                 TLorentzVector & lepton,
-                 TLorentzVector & met,
+    int setEvent(const std::vector<std::pair<TLorentzVector,bool> > & jets,
+                 FourVector const & lepton,
+                 FourVector const & met,
                  bool isMuon,
                  bool bestTop);
     
-    int setEventMetFixed(TLorentzVector&,TLorentzVector&, TLorentzVector&, TLorentzVector&, TLorentzVector&, TLorentzVector&,double min_dr_jet_lepton=-0.01);
+    int setEventMetFixed(FourVector const &, FourVector const &, FourVector const &, FourVector const &, FourVector const &, FourVector const &, double min_dr_jet_lepton=-0.01);
     
     
     double aplanarity() const;
@@ -153,7 +157,7 @@ public:
     TVectorD getEigen() {if(!_evtTopoOK) calcEvtTopo(); return eigenval;}
     
     // Neutrino
-    TMBLorentzVector GetNeutrino() {return _neutrino;}
+    FourVector GetNeutrino() {return _neutrino;}
     
     // From W' analysis
     double dphiLepJ1() ;
@@ -172,6 +176,9 @@ public:
     double Cos_LightjetJetLepton_BestTop();
     double Cos_LightjetJetLepton_BTagTop();
     double Cos_BestJetLepton_BestTop();
+    /// Cos_BestJetLepton_BestTop, Cos_LightjetJetLepton_BestTop and
+    /// Cos_LightjetJetLepton_BTagTop, in this order, from one batch of boosts
+    void Cos_JetLepton_Tops(double * cosines);
     
     double SecBestTop();//new
     double SecBestBTagTop();//new
@@ -207,66 +214,66 @@ public:
         return _BestTop_JetIndex;
     }
     //
-    void SetBestTop(TMBLorentzVector BestTop) {
+    void SetBestTop(FourVector BestTop) {
         _BestTop = BestTop;
     }
-    TMBLorentzVector  GetBestTop() {
+    FourVector  GetBestTop() {
         return _BestTop;
     }
     //
-    void SetBTagTop(TMBLorentzVector BTagTop) {
+    void SetBTagTop(FourVector BTagTop) {
         _TopLeadingBTaggedJet = BTagTop;
     }
-    TMBLorentzVector  GetBTagTop() {
+    FourVector  GetBTagTop() {
         return _TopLeadingBTaggedJet;
     }
-    void SetSecBTagTop(TMBLorentzVector SecBTagTop) {
+    void SetSecBTagTop(FourVector SecBTagTop) {
         _TopSecLeadingBTaggedJet = SecBTagTop;
     }
-    TMBLorentzVector  GetSecBTagTop() {
+    FourVector  GetSecBTagTop() {
         return _TopSecLeadingBTaggedJet;
     }
     //
-    void SetGoodJetsMinusBestJet(std::vector<TMBLorentzVector> GoodJetsMinusBestJet) {
+    void SetGoodJetsMinusBestJet(std::vector<FourVector> GoodJetsMinusBestJet) {
         _GoodJetsMinusBestJet = GoodJetsMinusBestJet;
     }
-    std::vector<TMBLorentzVector> GetGoodJetsMinusBestJet() {
+    std::vector<FourVector> GetGoodJetsMinusBestJet() {
         return _GoodJetsMinusBestJet;
     }
     
-    void SetLeptonMETxy(std::vector<TMBLorentzVector> LeptonMETxy) {
+    void SetLeptonMETxy(std::vector<FourVector> LeptonMETxy) {
         _LeptonMETxy = LeptonMETxy;
     }
     
-    std::vector<TMBLorentzVector> GetLeptonMETxy() {
+    std::vector<FourVector> GetLeptonMETxy() {
         return _LeptonMETxy;
     }
     
     //
-    void SetGoodJetsMinusLeadingBTaggedJet(std::vector<TMBLorentzVector> GoodJetsMinusLeadingBTaggedJet) {
+    void SetGoodJetsMinusLeadingBTaggedJet(std::vector<FourVector> GoodJetsMinusLeadingBTaggedJet) {
         _GoodJetsMinusLeadingBTaggedJet = GoodJetsMinusLeadingBTaggedJet;
     }
-    std::vector<TMBLorentzVector> GetGoodJetsMinusLeadingBTaggedJet() {
+    std::vector<FourVector> GetGoodJetsMinusLeadingBTaggedJet() {
         return _GoodJetsMinusLeadingBTaggedJet;
     }
     
     
 private:
-    std::vector<TMBLorentzVector> m_jets;
-    TMBLorentzVector m_met;
-    TMBLorentzVector m_lepton;
-    TMBLorentzVector _neutrino;
-    TMBLorentzVector _otherneutrino;
+    std::vector<FourVector> m_jets;
+    FourVector m_met;
+    FourVector m_lepton;
+    FourVector _neutrino;
+    FourVector _otherneutrino;
     
     int nJets;
     
     unsigned int _BestTop_JetIndex; // index of the jet that gives best top mass
-    std::vector<TMBLorentzVector> _GoodJetsMinusBestJet;
-    std::vector<TMBLorentzVector> _LeptonMETxy;
-    TMBLorentzVector _BestTop;
-    TMBLorentzVector _TopLeadingBTaggedJet;
-    TMBLorentzVector _TopSecLeadingBTaggedJet;
-    std::vector<TMBLorentzVector> _GoodJetsMinusLeadingBTaggedJet;
+    std::vector<FourVector> _GoodJetsMinusBestJet;
+    std::vector<FourVector> _LeptonMETxy;
+    FourVector _BestTop;
+    FourVector _TopLeadingBTaggedJet;
+    FourVector _TopSecLeadingBTaggedJet;
+    std::vector<FourVector> _GoodJetsMinusLeadingBTaggedJet;
     int number_of_jets ;
     int number_of_tagged_jets ;
     int number_of_untagged_jets ;
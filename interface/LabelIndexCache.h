@@ -0,0 +1,141 @@
+#ifndef LJMet_Com_interface_LabelIndexCache_h
+#define LJMet_Com_interface_LabelIndexCache_h
+
+/*
+ Resolves labelled values of PAT objects (b-tag discriminators,
+ tau IDs) to positions in the object's (label, value) list once,
+ instead of searching the list by name for every object.
+
+ The positions are checked against each object with one label
+ comparison and resolved again by name whenever the layout
+ differs, e.g. after switching to an input file produced with
+ a different configuration. A label missing from the list is
+ remembered as absent for that layout, not searched for again.
+
+ User float labels are kept apart: PAT has no positional accessor
+ for them, so they are never part of the resolved layout.
+ */
+
+
+
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+class LabelIndexCache {
+    //
+    // label -> position cache for (label, value) lists
+    //
+
+
+public:
+
+    typedef std::vector<std::pair<std::string, float> > LabelledValues;
+
+    LabelIndexCache(): mLayoutSize(0), mbResolved(false){}
+    ~LabelIndexCache(){}
+
+    /// Register a discriminator label, returns its slot number
+    int Add(std::string const & label);
+    /// Register a user float label, returns its slot number for UserFloat()
+    int AddUserFloat(std::string const & label);
+
+    std::string const & GetLabel(int slot) const { return mvLabel[slot]; }
+
+    /// Value stored under the label of the slot, missing if absent
+    float Get(LabelledValues const & values, int slot, float missing) const;
+
+    /// Discriminator of a pat::Jet, as pat::Jet::bDiscriminator()
+    template <class Jet>
+    float BDiscriminator(Jet const & jet, int slot) const { return Get(jet.getPairDiscri(), slot, -1000.0); }
+
+    /// User floats have no positional accessor in PAT, so these stay
+    /// name lookups, but without building a temporary key string
+    template <class PatObject>
+    float UserFloat(PatObject const & object, int slot) const { return object.userFloat(mvUserFloatLabel[slot]); }
+
+
+
+private:
+
+    void resolve(LabelledValues const & values) const;
+    bool sameLayout(LabelledValues const & values) const;
+
+    std::vector<std::string> mvLabel;
+    std::vector<std::string> mvUserFloatLabel;
+    mutable std::vector<int> mvIndex;   // position of each label, -1 if not present
+    mutable size_t mLayoutSize;         // size of the list the positions were resolved on
+    mutable std::string mFirstLabel;    // and its first and last labels
+    mutable std::string mLastLabel;
+    mutable bool mbResolved;
+};
+
+
+
+inline
+int LabelIndexCache::Add(std::string const & label){
+    for (size_t i = 0; i != mvLabel.size(); ++i){
+        if (mvLabel[i] == label) return i;
+    }
+    mvLabel.push_back(label);
+    mvIndex.push_back(-1);
+    mbResolved = false;
+    return mvLabel.size()-1;
+}
+
+
+
+inline
+int LabelIndexCache::AddUserFloat(std::string const & label){
+    for (size_t i = 0; i != mvUserFloatLabel.size(); ++i){
+        if (mvUserFloatLabel[i] == label) return i;
+    }
+    mvUserFloatLabel.push_back(label);
+    return mvUserFloatLabel.size()-1;
+}
+
+
+
+inline
+float LabelIndexCache::Get(LabelledValues const & values, int slot, float missing) const{
+    int _index = mvIndex[slot];
+    // a present label checks itself, an absent one the ends of the list
+    bool const _valid = mbResolved && values.size() == mLayoutSize &&
+        (_index >= 0 ? values[_index].first == mvLabel[slot] : sameLayout(values));
+    if (!_valid){
+        resolve(values);
+        _index = mvIndex[slot];
+    }
+    return _index >= 0 ? values[_index].second : missing;
+}
+
+
+
+inline
+void LabelIndexCache::resolve(LabelledValues const & values) const{
+    for (size_t s = 0; s != mvLabel.size(); ++s){
+        mvIndex[s] = -1;
+        // an empty label means the default (first) entry, as in pat::Jet
+        if (mvLabel[s].empty() && !values.empty()) mvIndex[s] = 0;
+        for (size_t i = 0; mvIndex[s] < 0 && i != values.size(); ++i){
+            if (values[i].first == mvLabel[s]) mvIndex[s] = i;
+        }
+    }
+    mLayoutSize = values.size();
+    mFirstLabel = values.empty() ? std::string() : values.front().first;
+    mLastLabel = values.empty() ? std::string() : values.back().first;
+    mbResolved = true;
+}
+
+
+
+inline
+bool LabelIndexCache::sameLayout(LabelledValues const & values) const{
+    return values.empty() || (values.front().first == mFirstLabel && values.back().first == mLastLabel);
+}
+
+
+
+#endif
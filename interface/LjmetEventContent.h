@@ -13,8 +13,13 @@
 #include <vector>
 #include <map>
 #include <limits>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "TTree.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "LJMet/Com/interface/EventArena.h"
 
 
 
@@ -28,42 +33,152 @@ public:
     
     class HistMetadata{
         //
-        // container for histogram basic info and current value
-        // to be held in event content and filled into hist
+        // histogram basic info and the values set in the current
+        // event, filled into the histogram at the end of the event
         //
         
     public:
-        HistMetadata(std::string name,
+        HistMetadata(std::string module,
+                     std::string name,
                      int nbins,
                      double xmin,
-                     double xmax):
+                     double xmax,
+                     int nbinsy = 0,
+                     double ymin = 0.0,
+                     double ymax = 0.0):
+        mModule(module),
         mName(name),
         mNBins(nbins),
         mXMin(xmin),
         mXMax(xmax),
+        mNBinsY(nbinsy),
+        mYMin(ymin),
+        mYMax(ymax),
         mpHist(0),
-        mValue(std::numeric_limits<double>::max()){}
+        mbMismatchReported(false){}
         
         ~HistMetadata(){}
+        std::string GetModule(){return mModule;}
         std::string GetName(){return mName;}
         int         GetNBins(){return mNBins;}
         double      GetXMin(){return mXMin;}
         double      GetXMax(){return mXMax;}
+        bool        Is2D(){return mNBinsY > 0;}
+        int         GetNBinsY(){return mNBinsY;}
+        double      GetYMin(){return mYMin;}
+        double      GetYMax(){return mYMax;}
         TH1 *       GetHist(){return mpHist;}
-        double      GetValue(){return mValue;}
         
         void        SetHist(TH1 * pHist){mpHist=pHist;}
-        void        SetValue(double value){mValue=value;}
         
         
     private:
+        friend class LjmetEventContent;
         HistMetadata(){}
+        std::string mModule;
         std::string mName;
         int         mNBins;
         double      mXMin;
         double      mXMax;
+        int         mNBinsY;    // 0 for 1D
+        double      mYMin;
+        double      mYMax;
         TH1 *       mpHist;
-        double      mValue;
+        bool        mbMismatchReported;
+        
+        // values of the current event
+        std::vector<double> mvX;
+        std::vector<double> mvY;
+        std::vector<double> mvW;
+    };
+    
+    
+    class BranchBuffer{
+        //
+        // one set of branch values, keyed by branch name;
+        // with the asynchronous writer there is a front buffer
+        // filled by SetValue() and a back buffer the tree
+        // branches point to
+        //
+        
+    public:
+        std::map<std::string,bool> mBoolBranch;
+        std::map<std::string,int> mIntBranch;
+        std::map<std::string,double> mDoubleBranch;
+        std::map<std::string,std::vector<bool> > mVectorBoolBranch;
+        std::map<std::string,std::vector<int> > mVectorIntBranch;
+        std::map<std::string,std::vector<short> > mVectorShortBranch;
+        std::map<std::string,std::vector<double> > mVectorDoubleBranch;
+    };
+    
+    
+    class SlotTable{
+        //
+        // addresses of the values of a BranchBuffer, one slot per
+        // branch of the tree in branch order, taken once at the
+        // first entry so that events are copied without key lookups
+        //
+        
+    public:
+        std::vector<bool *> mvBool;
+        std::vector<int *> mvInt;
+        std::vector<double *> mvDouble;
+        std::vector<std::vector<bool> *> mvVectorBool;
+        std::vector<std::vector<int> *> mvVectorInt;
+        std::vector<std::vector<short> *> mvVectorShort;
+        std::vector<std::vector<double> *> mvVectorDouble;
+        
+        void Build(BranchBuffer & buffer);
+    };
+    
+    
+    class EventSlots{
+        //
+        // the values of one queued event, by slot; recycled, so
+        // the vectors keep their capacity from event to event
+        //
+        
+    public:
+        std::vector<char> mvBool;
+        std::vector<int> mvInt;
+        std::vector<double> mvDouble;
+        std::vector<std::vector<bool> > mvVectorBool;
+        std::vector<std::vector<int> > mvVectorInt;
+        std::vector<std::vector<short> > mvVectorShort;
+        std::vector<std::vector<double> > mvVectorDouble;
+        
+        /// Copy the values the table points to
+        void Gather(SlotTable const & table);
+        /// Copy the values to where the table points
+        void Scatter(SlotTable const & table) const;
+    };
+    
+    
+    class StoragePolicy{
+        //
+        // on-disk precision of floating point branches matching
+        // a glob pattern; values are always set as double
+        //
+        
+    public:
+        enum Type {kDouble, kFloat, kTruncated, kQuantized};
+        
+        StoragePolicy(): mType(kDouble), mMin(0.0), mMax(0.0), mNBits(0){}
+        StoragePolicy(edm::ParameterSet const & pset);
+        
+        /// Stored value: float, mantissa truncated to mNBits bits,
+        /// or quantised to 2^mNBits steps in [mMin, mMax]
+        float Round(double value) const;
+        
+        /// Float16_t leaf range "[min,max,nbits]" for scalars that ROOT
+        /// packs on write, empty if the policy needs a full float
+        std::string Float16Range() const;
+        
+        std::string mPattern;
+        Type        mType;
+        double      mMin;
+        double      mMax;
+        int         mNBits;
     };
     
     
@@ -73,48 +188,152 @@ public:
     LjmetEventContent(const LjmetEventContent &); // stop default
     
     void SetTree(TTree * tree);
-    void SetHistogram(std::string modname, std::string histname,
-                      int nbins, double low, double high);
+    /// Declare a histogram, returns its handle; the existing handle if already declared
+    int SetHistogram(std::string modname, std::string histname,
+                     int nbins, double low, double high);
+    int SetHistogram(std::string modname, std::string histname,
+                     int nbinsx, double xlow, double xhigh,
+                     int nbinsy, double ylow, double yhigh);
+    
+    /// True if the branch passes the included_branches/excluded_branches
+    /// glob patterns of the ljmet config. Values of other branches are dropped
+    bool IsBranchRequested(std::string const & key);
     
-    void SetValue(std::string key, bool value);
-    void SetValue(std::string key, int value);
-    void SetValue(std::string key, double value);
-    void SetValue(std::string key, std::vector<bool> value);
-    void SetValue(std::string key, std::vector<int> value);
-    void SetValue(std::string key, std::vector<double> value);
+    /// Store the value if its branch is requested, false if it was dropped
+    bool SetValue(std::string key, bool value);
+    bool SetValue(std::string key, int value);
+    bool SetValue(std::string key, double value);
+    bool SetValue(std::string key, std::vector<bool> const & value);
+    bool SetValue(std::string key, std::vector<int> const & value);
+    bool SetValue(std::string key, std::vector<short> const & value);
+    bool SetValue(std::string key, std::vector<double> const & value);
+    bool SetValue(std::string key, ArenaVector<bool> const & value);
+    bool SetValue(std::string key, ArenaVector<int> const & value);
+    bool SetValue(std::string key, ArenaVector<short> const & value);
+    bool SetValue(std::string key, ArenaVector<double> const & value);
     
-    // histograms: mDoubleHist[module][histname]
+    /// Scratch memory for the current event, released after Fill()
+    /// and at the start of every event
+    EventArena & GetArena() { return mArena; }
+    
+    // histograms, indexed by handle in declaration order
     // actual histograms get created by TFileService in the main application
     // based on info in this container
-    std::map<std::string,std::map<std::string,HistMetadata> > & GetHistMap(){return mDoubleHist;}
+    int GetNHistograms() const {return mvHist.size();}
+    HistMetadata & GetHistogram(int handle){return mvHist[handle];}
+    /// Handle of a declared histogram, -1 if there is none
+    int GetHistHandle(std::string const & modname, std::string const & histname) const;
+    
+    /// Add a value for the histogram; any number per event, filled when the event is.
+    /// Negative handles are ignored, as are 1D fills of a 2D histogram and vice versa
+    void FillHist(int handle, double value, double weight = 1.0);
+    void FillHist2D(int handle, double x, double y, double weight = 1.0);
+    void FillHistN(int handle, size_t n, double const * values, double const * weights = 0);
+    /// As FillHist(), looked up by name
     void SetHistValue(std::string modname, std::string histname, double value);
+    /// Drop the histogram values of an event that is not filled
+    void ClearHistValues();
     
     void Fill();
     
+    /// Write out all pending events and stop the writer thread, if any.
+    /// Must be called before the output file is closed
+    void Finish();
+    
     
     
 private:
     
-    int createBranches();
+    int createBranches(BranchBuffer & buffer);
+    
+    // basket optimisation after the first entries
+    void afterTreeFill();
+    
+    // reduced precision storage
+    StoragePolicy const & getStoragePolicy(std::string const & name) const;
+    void roundReducedPrecision();
+    
+    // asynchronous output
+    void startWriter();
+    void pushEvent();
+    void writerLoop();
     
     std::string mName;
     std::string mLegend;
     
     TTree * mpTree;
     
-    std::map<std::string,bool> mBoolBranch;
-    std::map<std::string,int> mIntBranch;
-    std::map<std::string,double> mDoubleBranch;
-    std::map<std::string,std::vector<bool> > mVectorBoolBranch;
-    std::map<std::string,std::vector<int> > mVectorIntBranch;
-    std::map<std::string,std::vector<double> > mVectorDoubleBranch;
+    // values set by the current event
+    BranchBuffer mBuffer;
     
-    // mDoubleHist[module][histname]=value
-    std::map<std::string,std::map<std::string,HistMetadata> > mDoubleHist;
+    EventArena mArena;
+    
+    // histograms by handle, "module/name" -> handle, and the
+    // handles with values in the current event
+    std::vector<HistMetadata> mvHist;
+    std::map<std::string,int> mHistHandle;
+    std::vector<int> mvFilledHist;
+    
+    int addHistogram(HistMetadata const & hist);
+    /// False for a negative handle or a histogram of the other dimension
+    bool acceptHistFill(int handle, bool is2D);
+    void fillHistograms();
     
     bool mFirstEntry;
     
     int mVerbosity;
+    
+    // output branch selection: glob patterns and cached decisions
+    std::vector<std::string> mvIncludedBranches;
+    std::vector<std::string> mvExcludedBranches;
+    std::map<std::string,bool> mRequested;
+    
+    // output tuning: basket sizes by branch type, and automatic
+    // basket re-optimisation after mOptimizeAfter entries
+    int mScalarBasketSize;
+    int mVectorBasketSize;
+    Long64_t mOptimizeAfter;
+    Long64_t mOptimizeMemory;
+    
+    // reduced precision storage: first matching policy applies,
+    // the tree points to float copies of the affected branches.
+    // Truncated and quantised scalars are Float16_t leaves packed
+    // by ROOT, vectors are rounded here and stored as Double32_t
+    std::vector<StoragePolicy> mvStoragePolicy;
+    StoragePolicy mDefaultPolicy;
+    std::map<std::string,float> mFloatBranch;
+    std::map<std::string,Float16_t> mFloat16Branch;
+    std::map<std::string,std::vector<float> > mVectorFloatBranch;
+    std::map<std::string,std::vector<Double32_t> > mVectorDouble32Branch;
+    std::map<std::string,std::vector<Double32_t> *> mVectorDouble32Address;
+    std::vector<std::pair<double const *, float *> > mvReducedBranch;
+    std::vector<std::pair<double const *, Float16_t *> > mvFloat16Branch;
+    std::vector<std::pair<std::vector<double> const *, std::vector<float> *> > mvReducedVectorBranch;
+    std::vector<std::pair<std::vector<double> const *, std::vector<Double32_t> *> > mvDouble32VectorBranch;
+    std::vector<StoragePolicy const *> mvReducedPolicy;
+    std::vector<StoragePolicy const *> mvReducedVectorPolicy;
+    std::vector<StoragePolicy const *> mvDouble32VectorPolicy;
+    
+    // asynchronous output: TTree::Fill() runs on a writer thread,
+    // the event loop blocks only when more than mMaxWriteLag
+    // events are waiting to be written. ROOT::EnableThreadSafety()
+    // is called when asyncWrite is read. While mAsyncWrite is set
+    // the writer owns the output tree and its file: nothing else
+    // may fill, write, cd into or close them between the first
+    // Fill() and Finish(), which stops the writer
+    bool mAsyncWrite;
+    int mMaxWriteLag;
+    BranchBuffer mWriteBuffer;
+    SlotTable mFrontSlots;
+    SlotTable mWriteSlots;
+    std::deque<EventSlots *> mvPending;
+    std::vector<EventSlots *> mvFree;
+    std::thread mWriter;
+    std::mutex mWriteMutex;
+    std::condition_variable mPendingCond;
+    std::condition_variable mSpaceCond;
+    bool mStopWriter;
+    int mWriteErrors;
 };
 
 #endif
@@ -11,6 +11,7 @@
 
 #include <iostream>
 #include <map>
+#include <set>
 #include "LJMet/Com/interface/BaseCalc.h"
 #include "LJMet/Com/interface/BaseEventSelector.h"
 #include "LJMet/Com/interface/LjmetEventContent.h"
@@ -36,6 +37,9 @@ class LjmetFactory {
 
   BaseEventSelector * GetEventSelector(std::string name);
 
+  // registered and not excluded
+  bool HasCalculator(std::string name) const { return mpCalculators.find(name) != mpCalculators.end(); }
+
   void RunAllCalculators(edm::EventBase const & event, 
 			 BaseEventSelector * selector,
 			 LjmetEventContent & ec);
@@ -47,6 +51,9 @@ class LjmetFactory {
 
   void SetExcludedCalcs( std::vector<std::string> vExcl );
 
+  // make the event content available to calculators before BeginJob()
+  void SetAllCalcEventContent( LjmetEventContent * pEc );
+
   void BeginJobAllCalc();
   void EndJobAllCalc();
 
@@ -68,6 +75,11 @@ class LjmetFactory {
   BaseEventSelector * theSelector;
 
   std::vector<std::string> mvExcludedCalcs;
+
+  // calculators none of whose outputs are requested,
+  // found after their first AnalyzeEvent()
+  std::set<std::string> mIdleCalcs;
+  bool mFirstAnalyze;
     
   static LjmetFactory * instance;
 };
@@ -10,7 +10,8 @@
 
  ________________________________________________________________**/
 #include<iostream>
-#include "TLorentzVector.h"
+#include "LJMet/Com/interface/FourVector.h"
+#include "LJMet/Com/interface/NeutrinoSolver.h"
 
 class METzCalculator {
 
@@ -20,13 +21,15 @@ class METzCalculator {
   //METzCalculator(const edm::ParameterSEt& iConf);
   /// destructor
   virtual ~METzCalculator();
-  /// Set MET
-  void SetMET(TLorentzVector MET) {
-    MET_ = MET;
+  /// Set MET, from TLorentzVector, TMBLorentzVector or FourVector
+  template <class LorentzVector>
+  void SetMET(LorentzVector const & MET) {
+    MET_ = FourVector::FromLorentz(MET);
   }
   /// Set Muon
-  void SetLepton(TLorentzVector lepton) {
-    lepton_ = lepton;
+  template <class LorentzVector>
+  void SetLepton(LorentzVector const & lepton) {
+    lepton_ = FourVector::FromLorentz(lepton);
   }
   /// Set lepton type. The default (set in the constructor) is "muon"
   /// to be compatible with earlier code.
@@ -37,6 +40,10 @@ class METzCalculator {
     if(leptonName == "tau")       leptonMass_ = 1.77682;
   }
 
+  /// Share an event-level solver cache instead of the own one (null: own)
+  void SetSolver(NeutrinoSolver * solver) { sharedSolver_ = solver; }
+  NeutrinoSolver & GetSolver() { return sharedSolver_ ? *sharedSolver_ : solver_; }
+
   /// Calculate MEz
   /// options to choose roots from quadratic equation:
   /// type = 0 (defalut): if real roots, pick the one nearest to
@@ -64,12 +71,14 @@ class METzCalculator {
  private:
    
   bool isComplex_;
-  TLorentzVector lepton_;
-  TLorentzVector MET_;
+  FourVector lepton_;
+  FourVector MET_;
   double otherSol_;
   double leptonMass_;
   double newPtneutrino1_;
   double newPtneutrino2_;
+  NeutrinoSolver solver_;
+  NeutrinoSolver * sharedSolver_;
 };
 
 #endif
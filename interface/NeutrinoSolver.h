@@ -0,0 +1,109 @@
+#ifndef LJMet_Com_interface_NeutrinoSolver_h
+#define LJMet_Com_interface_NeutrinoSolver_h
+
+/*
+ Neutrino pz from the W mass constraint, solved once per
+ (lepton, MET) pair and cached for the event.
+
+ Every solution holds both roots of the quadratic, the rescaled
+ neutrino pt for complex roots, and the transverse-mass constrained
+ solution with the MET rescaled when mT > mW. Calculators pick
+ the root they want from it, so the choices are made on the same
+ numbers everywhere.
+ */
+
+
+
+#include <cstddef>
+#include <vector>
+
+#include "LJMet/Com/interface/FourVector.h"
+
+
+
+class NeutrinoSolver {
+    //
+    // event cache of neutrino pz solutions
+    //
+
+
+public:
+
+    class Solution {
+        //
+        // all the neutrino solutions for one lepton and MET
+        //
+
+
+    public:
+
+        /// Root choices, as in METzCalculator::Calculate
+        enum Choice {
+            kDefault       = 0,   // closest to the lepton pz, most central if above 300 GeV
+            kClosest       = 1,   // closest to the lepton pz
+            kCentral       = 2,   // smallest |pz|
+            kMaxCosine     = 3    // largest cosine of the lepton in the W frame
+        };
+
+        void Solve(FourVector const & lepton, FourVector const & met, double leptonMass, double wMass);
+        bool Matches(FourVector const & lepton, FourVector const & met, double leptonMass, double wMass) const{
+            return mLepton == lepton && mMet == met && mLeptonMass == leptonMass && mWMass == wMass;
+        }
+
+        /// Discriminant of the quadratic is negative
+        bool IsComplex() const { return mIsComplex; }
+        /// Roots with +sqrt and -sqrt; the real part for both if complex
+        double GetPz(int i) const { return mPz[i]; }
+        /// Neutrino pt for which the discriminant vanishes, the one
+        /// closer to the MET first; -1 if the roots are real
+        double GetPtRescaled(int i) const { return mPtRescaled[i]; }
+
+        /// The root picked by a Choice; other is set to the other root
+        double Choose(int choice, double & other) const;
+
+        /// Massless-lepton solution with mT(lepton, MET) <= mW, the MET
+        /// being rescaled if needed. The root with smaller |pz| first
+        FourVector GetConstrained(int i) const { return FourVector(mConstrainedPx, mConstrainedPy, mConstrainedPz[i], mConstrainedE); }
+
+
+
+    private:
+
+        FourVector mLepton;
+        FourVector mMet;
+        double mLeptonMass;
+        double mWMass;
+
+        bool mIsComplex;
+        double mPz[2];
+        double mPtRescaled[2];
+
+        double mConstrainedPx;
+        double mConstrainedPy;
+        double mConstrainedE;
+        double mConstrainedPz[2];
+    };
+
+
+
+    explicit NeutrinoSolver(size_t cacheSize = 8);
+    ~NeutrinoSolver(){}
+
+    /// Solutions for this lepton and MET, computed on the first request
+    Solution const & Solve(FourVector const & lepton, FourVector const & met, double leptonMass = 0.0, double wMass = 80.4);
+
+    /// Forget the cached solutions, once per event
+    void Clear(){ mvSolution.clear(); mNext = 0; }
+
+
+
+private:
+
+    std::vector<Solution> mvSolution;
+    size_t mCacheSize;
+    size_t mNext;       // entry to overwrite when the cache is full
+};
+
+
+
+#endif
@@ -1,6 +1,13 @@
 //  Njettiness Package
 //  Version 0.4.1 (January 22, 2012)
 //  Questions/Comments?  jthaler@jthaler.net
+//
+//  Local changes: the axes minimization runs on a structure-of-arrays
+//  copy of the inputs (NsubWorkspace) and draws its noise from a seeded
+//  counter-based generator (CounterRng) instead of rand(). The scalar
+//  UpdateAxes() is kept as the reference implementation and can be
+//  selected with Njettiness::setScalarUpdate(); test/testNjettiness.cc
+//  compares the two.
 
 // Copyright (c) 2011-12, Jesse Thaler, Ken Van Tilburg, and Christopher K.
 // Vermilion
@@ -96,6 +103,56 @@ public:
    void reset(double my_rap, double my_phi, double my_weight, double my_mom) {_rap=my_rap; _phi=my_phi; _weight=my_weight; _mom=my_mom;}
 };
 
+// Counter-based random numbers: the value depends only on the seed and
+// the counter, so the noise of a minimization pass is reproducible
+// whatever the thread or the number of earlier calls (splitmix64 finalizer)
+class CounterRng {
+private:
+   unsigned long long _seed;
+
+public:
+   CounterRng(unsigned long long myseed = 0) : _seed(myseed) {}
+   unsigned long long seed() const {return _seed;}
+   void set_seed(unsigned long long myseed) {_seed = myseed;}
+   // uniform in [0,1)
+   double uniform(unsigned long long counter) const {
+      unsigned long long z = _seed + (counter + 1) * 0x9E3779B97F4A7C15ULL;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      z ^= z >> 31;
+      return (double)(z >> 11) * (1.0/9007199254740992.0);
+   }
+};
+
+// Inputs and per-axis sums of the minimization as contiguous arrays,
+// kept between calls to avoid reallocation
+class NsubWorkspace {
+public:
+   // one entry per input
+   std::vector<double> rap, phi, pt, px, py, pz;
+   std::vector<double> best;    // squared distance to the closest axis
+   std::vector<double> weight;  // angular weight of the update step
+   std::vector<int> assign;     // closest axis, -1 beyond Rcutoff
+   // one entry per axis
+   std::vector<double> sum_rap, sum_phi, sum_weight, sum_px, sum_py, sum_pz;
+
+   void setInputs(const std::vector<fastjet::PseudoJet> & inputJets) {
+      unsigned n = inputJets.size();
+      rap.resize(n); phi.resize(n); pt.resize(n);
+      px.resize(n); py.resize(n); pz.resize(n);
+      best.resize(n); weight.resize(n); assign.resize(n);
+      for (unsigned i = 0; i < n; i++) {
+         rap[i] = inputJets[i].rap();
+         phi[i] = inputJets[i].phi();
+         pt[i] = inputJets[i].perp();
+         px[i] = inputJets[i].px();
+         py[i] = inputJets[i].py();
+         pz[i] = inputJets[i].pz();
+      }
+   }
+   unsigned size() const {return rap.size();}
+};
+
 ///////
 //
 // Functions for minimization.
@@ -252,6 +309,94 @@ std::vector<LightLikeAxis> UpdateAxes(const std::vector <LightLikeAxis> & old_ax
 }
 
 
+// Same update as UpdateAxes() on the arrays of a workspace filled by
+// setInputs(). The distances to all axes are computed one axis at a time
+// over contiguous inputs; the sums are accumulated in input order, so the
+// result is bitwise equal to UpdateAxes(). No limit on the number of axes.
+inline void UpdateAxesSoA(const std::vector <LightLikeAxis> & old_axes, std::vector <LightLikeAxis> & new_axes,
+                          NsubWorkspace & ws, NsubParameters paraNsub, double precision) {
+   const int N = old_axes.size();
+   const unsigned n = ws.size();
+   const double beta = paraNsub.beta();
+   const double Rcutoff2 = sq(paraNsub.Rcutoff());
+   const double precision2 = sq(precision);
+
+   double * const best = n ? &ws.best[0] : 0;
+   int * const assign = n ? &ws.assign[0] : 0;
+   const double * const rap = n ? &ws.rap[0] : 0;
+   const double * const phi = n ? &ws.phi[0] : 0;
+
+   /////////////// Assignment Step //////////////////////////////////////////////////////////
+   for (unsigned i = 0; i < n; i++) {best[i] = 1000000.0; assign[i] = -1;}
+   for (int k = 0; k < N; k++) {
+      const double axis_rap = old_axes[k].rap();
+      const double axis_phi = old_axes[k].phi();
+      for (unsigned i = 0; i < n; i++) {
+         double distRap = rap[i] - axis_rap;
+         double distPhi = std::fabs(phi[i] - axis_phi);
+         distPhi = (distPhi > M_PI) ? 2.0*M_PI - distPhi : distPhi;
+         double thisDist = sq(distRap) + sq(distPhi);
+         bool closer = thisDist < best[i];
+         best[i] = closer ? thisDist : best[i];
+         assign[i] = closer ? k : assign[i];
+      }
+   }
+   for (unsigned i = 0; i < n; i++) {
+      if (best[i] > Rcutoff2) assign[i] = -1;
+   }
+
+   //////////////// Update Step /////////////////////////////////////////////////////////////
+   // angular weights, from the distance to the assigned axis found above
+   double * const weight = n ? &ws.weight[0] : 0;
+   if (beta == 1.0) {
+      for (unsigned i = 0; i < n; i++) weight[i] = 1.0/std::sqrt(precision2 + best[i]);
+   } else if (beta == 2.0) {
+      for (unsigned i = 0; i < n; i++) weight[i] = 1.0;
+   } else if (beta == 0.0) {
+      for (unsigned i = 0; i < n; i++) weight[i] = 1.0/(precision2 + best[i]);
+   } else {
+      for (unsigned i = 0; i < n; i++) weight[i] = std::pow(precision2 + best[i], (0.5*beta-1.0));
+   }
+
+   ws.sum_rap.assign(N, 0.0); ws.sum_phi.assign(N, 0.0); ws.sum_weight.assign(N, 0.0);
+   ws.sum_px.assign(N, 0.0); ws.sum_py.assign(N, 0.0); ws.sum_pz.assign(N, 0.0);
+   for (unsigned i = 0; i < n; i++) {
+      int k = assign[i];
+      if (k == -1) {continue;}
+      double pt_i = ws.pt[i];
+      double phi_i = phi[i];
+      ws.sum_rap[k] += pt_i * rap[i] * weight[i];
+      double distPhi = phi_i - old_axes[k].phi();
+      if (std::fabs(distPhi) <= M_PI) {
+         ws.sum_phi[k] += pt_i * phi_i * weight[i];
+      } else if (distPhi > M_PI) {
+         ws.sum_phi[k] += pt_i * (-2*M_PI + phi_i) * weight[i];
+      } else if (distPhi < -M_PI) {
+         ws.sum_phi[k] += pt_i * (+2*M_PI + phi_i) * weight[i];
+      }
+      ws.sum_weight[k] += pt_i * weight[i];
+      ws.sum_px[k] += ws.px[i];
+      ws.sum_py[k] += ws.py[i];
+      ws.sum_pz[k] += ws.pz[i];
+   }
+
+   // normalize sums
+   new_axes.resize(N);
+   for (int k = 0; k < N; k++) {
+      if (ws.sum_weight[k] == 0) {
+         // no particles were closest to this axis!  Return to old axis instead of (0,0,0,0)
+         new_axes[k] = old_axes[k];
+      } else {
+         double new_phi = ws.sum_phi[k] / ws.sum_weight[k];
+         new_axes[k].reset( ws.sum_rap[k] / ws.sum_weight[k],
+                            std::fmod(new_phi + 2*M_PI, 2*M_PI),
+                            ws.sum_weight[k],
+                            std::sqrt(sq(ws.sum_px[k]) + sq(ws.sum_py[k]) + sq(ws.sum_pz[k])) );
+      }
+   }
+}
+
+
 // Go from internal LightLikeAxis to PseudoJet
 // TODO:  Make part of LightLikeAxis class.
 std::vector<fastjet::PseudoJet> ConvertToPseudoJet(const std::vector <LightLikeAxis>& axes) {
@@ -329,13 +474,18 @@ std::vector<fastjet::PseudoJet> GetAntiKTAxes(int n_jets, double R0, const std::
 }
 
 
-// Get minimization axes
-std::vector<fastjet::PseudoJet> GetMinimumAxes(const std::vector <fastjet::PseudoJet> & seedAxes, const std::vector <fastjet::PseudoJet> & inputJets, KmeansParameters para, 
-                                          NsubParameters paraNsub) {
+// Get minimization axes.
+// Pass l > 0 starts from the seeds shifted by noise number (l*n_jets + k)*2 + {0,1}
+// of rng, so the result depends only on the inputs and the seed.
+// scalarUpdate steps with the reference UpdateAxes() instead of UpdateAxesSoA().
+inline std::vector<fastjet::PseudoJet> GetMinimumAxes(const std::vector <fastjet::PseudoJet> & seedAxes, const std::vector <fastjet::PseudoJet> & inputJets, KmeansParameters para,
+                                          NsubParameters paraNsub, NsubWorkspace & ws, const CounterRng & rng,
+                                          bool scalarUpdate = false) {
    int n_jets = seedAxes.size();
    double noise = 0, tau = 10000.0, tau_tmp, cmp;
    std::vector< LightLikeAxis > new_axes(n_jets, LightLikeAxis(0,0,0,0)), old_axes(n_jets, LightLikeAxis(0,0,0,0));
    std::vector<fastjet::PseudoJet> tmp_min_axes, min_axes;
+   if (para.n_iterations() > 0 && !scalarUpdate) ws.setInputs(inputJets);
    for (int l = 0; l < para.n_iterations(); l++) { // Do minimization procedure multiple times
       // Add noise to guess for the axes
       for (int k = 0; k < n_jets; k++) {
@@ -343,21 +493,26 @@ std::vector<fastjet::PseudoJet> GetMinimumAxes(const std::vector <fastjet::Pseud
             old_axes[k].set_rap( seedAxes[k].rap() + noise );
             old_axes[k].set_phi( seedAxes[k].phi() + noise );
          } else {
-            noise = ((double)rand()/(double)RAND_MAX) * para.noise_range() * 2 - para.noise_range();
+            unsigned long long counter = ((unsigned long long)l * n_jets + k) * 2;
+            noise = rng.uniform(counter) * para.noise_range() * 2 - para.noise_range();
             old_axes[k].set_rap( seedAxes[k].rap() + noise );
-            noise = ((double)rand()/(double)RAND_MAX) * para.noise_range() * 2 - para.noise_range();
+            noise = rng.uniform(counter + 1) * para.noise_range() * 2 - para.noise_range();
             old_axes[k].set_phi( seedAxes[k].phi() + noise );
          }
       }
       cmp = 100.0; int h = 0;
       while (cmp > para.precision() && h < para.halt()) { // Keep updating axes until near-convergence or too many update steps
          cmp = 0.0; h++;
-         new_axes = UpdateAxes(old_axes, inputJets, paraNsub, para.precision()); // Update axes
+         if (scalarUpdate) {
+            new_axes = UpdateAxes(old_axes, inputJets, paraNsub, para.precision()); // Update axes
+         } else {
+            UpdateAxesSoA(old_axes, new_axes, ws, paraNsub, para.precision()); // Update axes
+         }
          for (int k = 0; k < n_jets; k++) {
             cmp += Distance(new_axes[k].rap(),new_axes[k].phi(),old_axes[k].rap(),old_axes[k].phi());
          }
          cmp = cmp / ((double) n_jets);
-         old_axes = new_axes;
+         old_axes.swap(new_axes);
       }
       tmp_min_axes = ConvertToPseudoJet(old_axes); // Convert axes directions into four-std::vectors
       tau_tmp = TauValue(inputJets, tmp_min_axes,paraNsub); 
@@ -366,6 +521,13 @@ std::vector<fastjet::PseudoJet> GetMinimumAxes(const std::vector <fastjet::Pseud
    return min_axes;
 }
 
+// Same with a temporary workspace and seed 0
+inline std::vector<fastjet::PseudoJet> GetMinimumAxes(const std::vector <fastjet::PseudoJet> & seedAxes, const std::vector <fastjet::PseudoJet> & inputJets, KmeansParameters para,
+                                          NsubParameters paraNsub) {
+   NsubWorkspace ws;
+   return GetMinimumAxes(seedAxes, inputJets, para, paraNsub, ws, CounterRng());
+}
+
 ///////
 //
 // Main Njettiness Class
@@ -392,6 +554,10 @@ private:
    KmeansParameters _paraKmeans;  //Parameters for Minimization Procedure (set by NsubAxesMode automatically, but can change manually if desired)
 
    std::vector<fastjet::PseudoJet> _currentAxes;
+
+   NsubWorkspace _workspace;  // reused by the minimization, so one object per thread
+   CounterRng _rng;           // noise of the min_axes passes
+   bool _scalarUpdate;        // minimize with UpdateAxes() instead of UpdateAxesSoA()
    
    void establishAxes(unsigned n_jets, const std::vector <fastjet::PseudoJet> & inputs);
    
@@ -400,6 +566,10 @@ public:
    
    void setParaKmeans(KmeansParameters newPara) {_paraKmeans = newPara;}
    void setParaNsub(NsubParameters newPara) {_paraNsub = newPara;}
+   // seed of the min_axes noise; the axes are reproducible for a given seed
+   void setSeed(unsigned long long seed) {_rng.set_seed(seed);}
+   // use the scalar reference update (at most 20 axes) in the minimization
+   void setScalarUpdate(bool scalar) {_scalarUpdate = scalar;}
    
    // setAxes for Manual mode
    void setAxes(std::vector<fastjet::PseudoJet> myAxes) {
@@ -447,19 +617,19 @@ void Njettiness::establishAxes(unsigned int n_jets, const std::vector <fastjet::
       case onepass_kt_axes:
       case min_axes:
          _currentAxes = GetKTAxes(n_jets,inputs);
-         _currentAxes = GetMinimumAxes(_currentAxes, inputs, _paraKmeans, _paraNsub);
+         _currentAxes = GetMinimumAxes(_currentAxes, inputs, _paraKmeans, _paraNsub, _workspace, _rng, _scalarUpdate);
          break;
       case onepass_ca_axes:
          _currentAxes = GetCAAxes(n_jets,inputs);
-         _currentAxes = GetMinimumAxes(_currentAxes, inputs, _paraKmeans, _paraNsub);
+         _currentAxes = GetMinimumAxes(_currentAxes, inputs, _paraKmeans, _paraNsub, _workspace, _rng, _scalarUpdate);
          break;
       case onepass_antikt_0p2_axes:
          _currentAxes = GetAntiKTAxes(n_jets,0.2,inputs);
-         _currentAxes = GetMinimumAxes(_currentAxes, inputs, _paraKmeans, _paraNsub);
+         _currentAxes = GetMinimumAxes(_currentAxes, inputs, _paraKmeans, _paraNsub, _workspace, _rng, _scalarUpdate);
          break;
       case onepass_manual_axes:
          assert(_currentAxes.size() == n_jets);
-         _currentAxes = GetMinimumAxes(_currentAxes, inputs, _paraKmeans, _paraNsub);
+         _currentAxes = GetMinimumAxes(_currentAxes, inputs, _paraKmeans, _paraNsub, _workspace, _rng, _scalarUpdate);
          break;
       case manual_axes:
          assert(_currentAxes.size() == n_jets);
@@ -471,7 +641,7 @@ void Njettiness::establishAxes(unsigned int n_jets, const std::vector <fastjet::
 }
 
 //Constructor sets KmeansParameters from NsubAxesMode input
-Njettiness::Njettiness(AxesMode axes, NsubParameters paraNsub) : _axes(axes), _paraNsub(paraNsub), _paraKmeans() {
+Njettiness::Njettiness(AxesMode axes, NsubParameters paraNsub) : _axes(axes), _paraNsub(paraNsub), _paraKmeans(), _scalarUpdate(false) {
    switch (_axes) {
       case kt_axes:
       case ca_axes:
@@ -0,0 +1,129 @@
+#ifndef LJMet_Com_interface_ObjectColumns_h
+#define LJMet_Com_interface_ObjectColumns_h
+
+/*
+ Column (structure-of-arrays) storage of object variables, and
+ object selections made of simple cut expressions evaluated one
+ column at a time.
+
+ A cut expression reads "<variable> <op> <value>", with op one of
+ < <= > >= == !=, e.g. "pt > 30" or "abseta < 2.1". A selection
+ is the AND of its expressions.
+
+ Each variable is loaded once per event into a contiguous column,
+ the cuts then run as plain loops over the columns, writing a
+ pass mask that is turned into a list of object indices.
+ */
+
+
+
+#include <string>
+#include <vector>
+
+
+
+class ObjectColumns {
+    //
+    // named columns of doubles, one entry per object
+    //
+
+
+public:
+
+    typedef std::vector<double> Column;
+
+    ObjectColumns(): mSize(0){}
+    ~ObjectColumns(){}
+
+    /// Register a column, returns its number; registering twice is harmless
+    int AddColumn(std::string const & name);
+
+    /// Column number, -1 if not registered
+    int FindColumn(std::string const & name) const;
+
+    size_t NColumns() const { return mvName.size(); }
+    std::string const & GetName(int column) const { return mvName[column]; }
+
+    /// Resize all columns for n objects, keeping the allocated memory
+    void Resize(size_t n);
+    size_t Size() const { return mSize; }
+
+    Column & Get(int column) { return mvColumn[column]; }
+    Column const & Get(int column) const { return mvColumn[column]; }
+
+
+
+private:
+
+    size_t mSize;
+    std::vector<std::string> mvName;
+    std::vector<Column> mvColumn;
+};
+
+
+
+class ColumnCut {
+    //
+    // one parsed "<variable> <op> <value>" expression
+    //
+
+
+public:
+
+    enum Op { kLess, kLessEqual, kGreater, kGreaterEqual, kEqual, kNotEqual };
+
+    /// Parse the expression, registering its variable in columns.
+    /// Returns false if the expression is malformed
+    bool Parse(std::string const & expression, ObjectColumns & columns);
+
+    /// mask[i] &= (column[i] op value)
+    void Apply(ObjectColumns const & columns, std::vector<char> & mask) const;
+
+    int GetColumn() const { return mColumn; }
+
+
+
+private:
+
+    int mColumn;
+    Op mOp;
+    double mValue;
+};
+
+
+
+class ColumnSelection {
+    //
+    // AND of column cuts
+    //
+
+
+public:
+
+    ColumnSelection(){}
+    ~ColumnSelection(){}
+
+    /// Parse all expressions; a malformed expression is reported and
+    /// returned in bad, and the selection is left unchanged
+    bool Configure(std::vector<std::string> const & expressions, ObjectColumns & columns, std::string & bad);
+
+    bool IsEmpty() const { return mvCut.empty(); }
+
+    /// Pass mask of all objects; if seed is given, only objects
+    /// passing the seed mask can pass
+    void Evaluate(ObjectColumns const & columns, std::vector<char> & mask, std::vector<char> const * seed = 0) const;
+
+    /// Indices of the objects passing the selection
+    void Select(ObjectColumns const & columns, std::vector<int> & indices, std::vector<char> const * seed = 0) const;
+
+
+
+private:
+
+    std::vector<ColumnCut> mvCut;
+    mutable std::vector<char> mvMask;
+};
+
+
+
+#endif
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <string>
 #include "TH1F.h"
+#include "LJMet/Com/interface/ConditionsCache.h"
 
  
 using namespace std;
@@ -26,6 +27,7 @@ class PUWeighting {
      void setPUHisto(const TH1D * thehistData, const TH1F * thehistMC);
      void setPUHisto(const TH1D * thehistData);
      void setPUHisto(const string filename);
+     void setPUHisto(const string filename, ConditionsCache const & cache);
      void setUseOutOfTimePU(bool useoot);
      bool getUseOutOfTimePU();
      void weightOOT_init();
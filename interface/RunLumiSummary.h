@@ -0,0 +1,117 @@
+#ifndef LJMet_Com_interface_RunLumiSummary_h
+#define LJMet_Com_interface_RunLumiSummary_h
+
+/*
+ Normalisation bookkeeping per run and luminosity section, so that
+ the number of processed events and their weight sums need not be
+ taken from another pass over the input. This is the only place
+ the weights of all processed events are summed; sums per run are
+ the sums of its entries.
+
+ Every event that reaches the selection is counted, with its
+ generator weight and the weights stored for its variations (see
+ GenWeightReader). The cut flow counts added by the selector are
+ taken when the luminosity section changes and at the end.
+ Write() makes three trees in the current directory:
+
+   RunLumiSummary    one entry per run, luminosity section and
+                     weight layout
+   RunLumiCutNames   one entry, the names of the cutFlow counts
+   GenWeightLayouts  one entry per layout: the ids, groups (0 other,
+                     1 scale, 2 PDF) and group names of sumWeights
+
+ Outputs of several workers, merged with TFileMerger, hold one
+ entry per worker for a luminosity section; Combine() adds up the
+ entries with the same run, lumi and layout and keeps one entry of
+ the cut names and of each layout.
+ */
+
+
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Rtypes.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+#include "LJMet/Com/interface/GenWeightReader.h"
+
+
+
+class BaseEventSelector;
+class TDirectory;
+
+namespace edm {
+    class EventBase;
+}
+
+
+
+class RunLumiSummary {
+    //
+    // event counts, weight sums and cut flow per luminosity section
+    //
+
+
+public:
+
+    RunLumiSummary(edm::InputTag const & genInfoTag,
+                   edm::InputTag const & lheTag,
+                   edm::InputTag const & lheRunInfoTag);
+    ~RunLumiSummary(){}
+
+    /// Count the event, before the selector runs on it
+    void AddEvent(edm::EventBase const & event, BaseEventSelector * selector);
+
+    /// Tree of all sums in the current directory, if any event was counted
+    void Write(BaseEventSelector * selector);
+
+    /// Replace the trees of merged outputs in the directory by their sums
+    static void Combine(TDirectory * dir);
+
+
+
+private:
+
+    struct Key {
+        unsigned run;
+        unsigned lumi;
+        unsigned layout;
+        bool operator<(Key const & other) const {
+            if (run != other.run) return run < other.run;
+            if (lumi != other.lumi) return lumi < other.lumi;
+            return layout < other.layout;
+        }
+        bool operator!=(Key const & other) const { return run != other.run || lumi != other.lumi || layout != other.layout; }
+    };
+
+    struct Sums {
+        Long64_t nEvents;
+        double sumGenWeight;
+        double sumGenWeight2;
+        std::vector<double> vSumWeights;
+        std::vector<Long64_t> vCutFlow;
+    };
+
+    /// Cut flow counts since the last call go to the current entry
+    void flushCutFlow(BaseEventSelector * selector);
+
+    /// The three trees in the current directory
+    static void writeTrees(std::vector<std::string> const & cutNames,
+                           std::map<Key, Sums> const & sums,
+                           std::map<unsigned, GenWeightReader::Layout> const & layouts);
+
+    edm::InputTag mGenInfoTag;
+    edm::InputTag mLheTag;
+    edm::InputTag mLheRunInfoTag;
+
+    std::map<unsigned, GenWeightReader::Layout> mLayouts;
+    std::map<Key, Sums> mSums;
+    Key mLastKey;
+    Sums * mpLastSums;
+    std::vector<int> mvLastCounts;
+};
+
+
+
+#endif
@@ -16,6 +16,7 @@
 //#include "cafe/Event.hpp"
 //#include "tmb_tree/TMBLorentzVector.hpp"
 #include "LJMet/Com/interface/TMBLorentzVector.h"
+#include "LJMet/Com/interface/FourVector.h"
 
 namespace top_cafe {
   
@@ -38,7 +39,22 @@ namespace top_cafe {
 		return true;
 	} // isValid
 
+	inline bool isValid(const FourVector & object) {
+	    return !(object.Px()==0&&object.Py()==0&&object.Pz()==0&&object.M()==0);
+	} // isValid
+
 	double CosAngle(const TMBLorentzVector &object1, const TMBLorentzVector & object2, const TMBLorentzVector &frame1 = TMBLorentzVector (0.,0.,0.,0.), const TMBLorentzVector &frame2 = TMBLorentzVector (0.,0.,0.,0.));
+	double CosAngle(const FourVector &object1, const FourVector &object2, const FourVector &frame1 = FourVector(), const FourVector &frame2 = FourVector());
+
+	/// Batch versions for loops over jet assignments, same results as CosAngle
+	/// with one frame. Each frame boost is set up once and shared by both objects.
+	/// cosines[i] = CosAngle(object1[i], object2[i], frame[i])
+	void CosAngles(const FourVector *object1, const FourVector *object2, const FourVector *frame, size_t n, double *cosines);
+	/// cosines[i] = CosAngle(object1[i], object2, frame), object2 is boosted only once
+	void CosAngles(const FourVector *object1, const FourVector &object2, const FourVector &frame, size_t n, double *cosines);
+	/// Helicity angles, cosines[i] = CosAngle(daughter[i], parent[i], parent[i]):
+	/// daughter in the parent rest frame against the parent flight direction
+	void HelicityCosines(const FourVector *daughter, const FourVector *parent, size_t n, double *cosines);
     
     private:
     
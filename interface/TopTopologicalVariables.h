@@ -8,6 +8,7 @@
  *                     (Instantiate using as argument: vector<TMBLorentzVector> 
  *                      of all objects for which you want any variable 
  *                      to be calculated)  
+ *                      The objects are kept as FourVector (px, py, pz, E).
  *
  * Last modified : Amnon Harel, 06 Mar 2006 (const correctness, cache eigenvalues)
  * Comments      : 
@@ -19,13 +20,15 @@
 #define TopTopologicalVariables_HPP_
 
 #include <vector>
-#include "LJMet/Com/interface/TMBLorentzVector.h"
+#include "TVectorD.h"
+#include "LJMet/Com/interface/FourVector.h"
 
     class TopTopologicalVariables {
 	/**
 	   Contains generic methods for calculating topological variables
            Constructor takes most containers (vector, list, Collection, etc.)
-           of any object derived from TMBLorentzVector
+           of TMBLorentzVector, TLorentzVector or anything else with
+           Px(), Py(), Pz() and E()
 	*/
     public:
     
@@ -34,7 +37,9 @@
 	TopTopologicalVariables(const Container& objects) 
 	  : _pv (0)
         {
-            copy(objects.begin(), objects.end(), back_inserter(_myobjects));
+            _myobjects.reserve(objects.size());
+            for (typename Container::const_iterator i = objects.begin(); i != objects.end(); ++i)
+              _myobjects.push_back(FourVector::FromLorentz(*i));
         }
 	~TopTopologicalVariables();
         TopTopologicalVariables& operator= (const TopTopologicalVariables& that);
@@ -76,8 +81,8 @@
 
     private:
 
-        typedef std::vector<TMBLorentzVector>::const_iterator Iterator;
-	std::vector<TMBLorentzVector> _myobjects;
+        typedef std::vector<FourVector>::const_iterator Iterator;
+	std::vector<FourVector> _myobjects;
     
         mutable TVectorD *_pv; // internal representation: can change even for a const object
         void ensurePV() const; // will calculate the eigen values (_pv) if it hasn't been done yet
@@ -17,6 +17,7 @@
 
 
 #include "LJMet/Com/interface/TMBLorentzVector.h"
+#include "LJMet/Com/interface/FourVector.h"
 
 namespace top_cafe {
   
@@ -36,6 +37,12 @@ namespace top_cafe {
 	void boost_new(TVector3 boostvect, const TMBLorentzVector &myobject, TMBLorentzVector &myBoostedObject);
 	void boost_new(double bx, double by, double bz, const TMBLorentzVector &myobject, TMBLorentzVector &myBoostedObject);
 	double PtRel(const TMBLorentzVector muon, const TMBLorentzVector jet);
+
+	// value-type versions for loops, same results
+	void boost_new(double bx, double by, double bz, const FourVector &myobject, FourVector &myBoostedObject);
+	// n objects with one boost set up, see fourvector::BoostAll
+	void boost_new(double bx, double by, double bz, const FourVector *myobjects, FourVector *myBoostedObjects, size_t n);
+	double PtRel(const FourVector &muon, const FourVector &jet);
     }; // class TopUtils{
   
 } // namespace top_cafe {
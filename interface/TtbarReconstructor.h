@@ -0,0 +1,108 @@
+#ifndef LJMet_Com_interface_TtbarReconstructor_h
+#define LJMet_Com_interface_TtbarReconstructor_h
+
+/*
+ Lepton+jets ttbar reconstruction: finds the assignments of jets
+ and neutrino solutions to (W_had -> j j, t_had -> W_had b,
+ t_lep -> l nu b) with the lowest mass chi2.
+
+ The assignments are enumerated branch-and-bound: the hadronic W
+ pairs are ordered by their chi2 term and the leptonic side terms
+ are computed once, so partial sums that cannot beat the current
+ K-th best are dropped before the remaining jets are tried.
+ */
+
+
+
+#include <cstddef>
+#include <vector>
+
+#include "LJMet/Com/interface/FourVector.h"
+
+
+
+class TtbarReconstructor {
+    //
+    // pruned search over jet and neutrino assignments
+    //
+
+
+public:
+
+    /// Which jets may be used where: light for the hadronic W, b for the tops
+    enum Role {
+        kLight = 1,
+        kB     = 2,
+        kAny   = 3
+    };
+
+    struct Hypothesis {
+        int jet1;      // hadronic W jets, jet1 < jet2
+        int jet2;
+        int bHad;
+        int bLep;
+        int neutrino;  // index into the neutrino solutions
+        double chi2;
+    };
+
+    TtbarReconstructor();
+    ~TtbarReconstructor(){}
+
+    void SetMasses(double mW, double mTop){ mMw = mW; mMtop = mTop; }
+    /// Resolutions of the chi2 terms; a term with zero resolution is not used
+    void SetResolutions(double sigWhad, double sigThad, double sigTlep, double sigWlep = 0.0);
+    /// Hypotheses with a larger chi2 are never kept, which also bounds each mass term
+    void SetMaxChi2(double maxChi2){ mMaxChi2 = maxChi2; }
+    /// Number of best hypotheses to keep
+    void SetTopK(size_t k){ mTopK = k > 0 ? k : 1; }
+
+    /// Find the best hypotheses. roles[i] is a Role for jets[i]
+    void Reconstruct(FourVector const & lepton,
+                     FourVector const * neutrinos, size_t nNeutrinos,
+                     FourVector const * jets, int const * roles, size_t nJets);
+
+    /// Hypotheses from the last Reconstruct, best first
+    std::vector<Hypothesis> const & GetHypotheses() const { return mvBest; }
+    Hypothesis const * GetBest() const { return mvBest.empty() ? 0 : &mvBest[0]; }
+
+    /// Full hypotheses evaluated in the last Reconstruct, for monitoring the pruning
+    size_t GetNEvaluated() const { return mNEvaluated; }
+
+
+
+private:
+
+    struct WPair {
+        int jet1;
+        int jet2;
+        double chi2;
+        FourVector p4;
+        bool operator<(WPair const & o) const { return chi2 < o.chi2; }
+    };
+
+    double term(FourVector const & p4, double mass, double sigma) const;
+    void insert(Hypothesis const & h);
+    double bound() const { return mvBest.size() < mTopK ? mMaxChi2 : mvBest.back().chi2; }
+
+    double mMw;
+    double mMtop;
+    double mSigWhad;
+    double mSigThad;
+    double mSigTlep;
+    double mSigWlep;
+    double mMaxChi2;
+    size_t mTopK;
+
+    // scratch, kept between events
+    std::vector<int> mvLight;
+    std::vector<int> mvB;
+    std::vector<WPair> mvPair;
+    std::vector<double> mvLep;    // Wlep + tlep terms, [neutrino][b]
+
+    std::vector<Hypothesis> mvBest;
+    size_t mNEvaluated;
+};
+
+
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef LJMet_Com_interface_WeightEngine_h
+#define LJMet_Com_interface_WeightEngine_h
+
+/*
+ Event weights from several sources in one place. Every source is a
+ WeightProvider that returns its nominal weight and a fixed list of
+ variations. Each provider is evaluated once per event, into one row
+ of the weight matrix, and the products for all requested
+ combinations of variations are then formed in one pass over a
+ precomputed table of matrix positions.
+
+ Combination 0 is always the product of the nominal weights. Further
+ combinations name the variation of some providers, e.g.
+ "pileup:2012ABCD,topPt:none", the providers not named being nominal.
+ */
+
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+
+class BaseEventSelector;
+
+namespace edm {
+    class EventBase;
+}
+
+
+
+class WeightProvider {
+    //
+    // one source of event weights
+    //
+
+
+public:
+
+    virtual ~WeightProvider(){}
+
+    /// Variations besides the nominal weight, fixed once registered
+    virtual size_t GetNVariations() const = 0;
+    virtual std::string GetVariationName(size_t i) const = 0;
+
+    /// Nominal weight in weights[0], variation i in weights[i+1]
+    virtual void Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights) = 0;
+};
+
+
+
+class WeightLookup {
+    //
+    // bin contents of a 1D histogram in a flat table, found as TAxis::FindFixBin
+    //
+
+
+public:
+
+    WeightLookup(): mNBins(0), mLow(0.0), mHigh(0.0){}
+
+    /// Equal bins between low and high, values with underflow and overflow
+    WeightLookup(int nBins, double low, double high, std::vector<double> const & values);
+    /// Bins given by nBins+1 edges, values with underflow and overflow
+    WeightLookup(std::vector<double> const & edges, std::vector<double> const & values);
+
+    int FindBin(double x) const;
+    double operator()(double x) const { return mvValue.empty() ? 0.0 : mvValue[FindBin(x)]; }
+
+private:
+
+    int mNBins;
+    double mLow;
+    double mHigh;
+    std::vector<double> mvEdge;    // empty for equal bins
+    std::vector<double> mvValue;
+};
+
+
+
+class WeightEngine {
+    //
+    // weight matrix of all providers and products of its rows
+    //
+
+
+public:
+
+    WeightEngine(){}
+    ~WeightEngine(){}
+
+    /// Providers are evaluated in the order registered, and are not owned
+    void Register(std::string const & name, WeightProvider * provider);
+
+    /// Every variation of every provider, the others nominal
+    void AddSingleVariations();
+    /// Comma separated provider:variation list, false if a name is unknown
+    bool AddCombination(std::string const & spec);
+
+    size_t GetNProviders() const { return mvProvider.size(); }
+    size_t GetNCombinations() const { return mvCombinationName.size(); }
+    std::string const & GetCombinationName(size_t i) const { return mvCombinationName[i]; }
+    /// Errors found by AddCombination
+    std::string const & GetError() const { return mError; }
+    /// Layout of the matrix and of the combinations, for the log
+    std::string Describe() const;
+
+    /// Evaluate all providers and all combinations for the event
+    void Evaluate(edm::EventBase const & event, BaseEventSelector * selector);
+
+    /// Rows of all providers, nominal then variations, one after the other
+    std::vector<double> const & GetMatrix() const { return mvMatrix; }
+    /// Products for the combinations, nominal first
+    std::vector<double> const & GetCombinations() const { return mvCombination; }
+    double GetNominal() const { return mvCombination.empty() ? 1.0 : mvCombination[0]; }
+
+
+
+private:
+
+    struct Provider {
+        std::string name;
+        WeightProvider * provider;
+        size_t row;             // first matrix entry
+        std::vector<std::string> vVariation;
+    };
+
+    void addCombination(std::string const & name, std::vector<size_t> const & columns);
+
+    std::vector<Provider> mvProvider;
+    std::vector<std::string> mvCombinationName;
+    std::vector<size_t> mvColumn;       // combinations x providers matrix positions
+    std::vector<double> mvMatrix;
+    std::vector<double> mvCombination;
+    std::string mError;
+};
+
+
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef LJMet_Com_interface_WorkerPool_h
+#define LJMet_Com_interface_WorkerPool_h
+
+/*
+ Fixed set of threads for running independent tasks of one event
+ in parallel. The calling thread works as worker 0, so a pool of
+ one worker starts no threads and runs everything inline.
+
+ Run() hands out the tasks one at a time and returns when all of
+ them are done. The worker index passed to the task lets callers
+ keep one workspace per worker and reuse it between tasks without
+ locking. Tasks must not throw.
+ */
+
+
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+class WorkerPool {
+    //
+    // blocking parallel loop over task indices
+    //
+
+
+public:
+
+    /// task(i, worker) with the task index and worker in [0, GetNWorkers())
+    typedef std::function<void(size_t, size_t)> Task;
+
+    explicit WorkerPool(size_t nWorkers = 1);
+    ~WorkerPool();
+
+    size_t GetNWorkers() const { return mvThread.size() + 1; }
+
+    /// Run task(i, worker) for i in [0, nTasks), returns when all are done
+    void Run(size_t nTasks, Task const & task);
+
+
+
+private:
+
+    WorkerPool(WorkerPool const &);             // no copies
+    WorkerPool & operator=(WorkerPool const &);
+
+    void workerLoop(size_t worker);
+    void work(size_t worker);
+
+    std::vector<std::thread> mvThread;
+    std::mutex mMutex;
+    std::condition_variable mStartCond;
+    std::condition_variable mDoneCond;
+
+    Task const * mpTask;
+    size_t mNTasks;
+    std::atomic<size_t> mNext;     // next task to hand out
+    unsigned long mGeneration;     // incremented by every Run
+    size_t mNBusy;                 // threads still working on this Run
+    bool mStop;
+};
+
+
+
+#endif
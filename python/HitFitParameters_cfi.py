@@ -3,7 +3,7 @@ import FWCore.ParameterSet.Config as cms
 defaultHitFitParameters = cms.PSet(
     isData                   = cms.bool(False),  # is sample data?
     hitFitLepId              = cms.int32(13),      # which lepton, 13 - muon or  11 - electron? # maybe this should be done automatically?
-    hitfitDebug              = cms.untracked.bool(False),
+    hitfitDebug              = cms.untracked.bool(False),     # fit summary of every event
     hitfitDefault            = cms.untracked.FileInPath("TopQuarkAnalysis/TopHitFit/data/setting/RunHitFitConfiguration.txt"),
     hitfitElectronResolution = cms.untracked.FileInPath("TopQuarkAnalysis/TopHitFit/data/resolution/tqafElectronResolution.txt"),
     hitfitElectronObjRes     = cms.untracked.bool(False),
@@ -20,10 +20,14 @@ defaultHitFitParameters = cms.PSet(
     hitfitLepWMass           = cms.untracked.double(80.4),
     hitfitHadWMass           = cms.untracked.double(80.4),
     hitfitTopMass            = cms.untracked.double(0.0),
-    hitfitNuSolution         = cms.untracked.int32(2),
+    hitfitNuSolution         = cms.untracked.int32(2),       # 0 smaller |pz|, 1 larger |pz|, 2 both
     hitfitMinLeptonPt        = cms.untracked.double(15.0),
     hitfitMinJetPt           = cms.untracked.double(15.0),
     hitfitMinMET             = cms.untracked.double(0.0),
     hitfitUseNLeadJets       = cms.untracked.bool(False),
-    hitfitMaxNJet            = cms.untracked.uint32(5)
+    hitfitMaxNJet            = cms.untracked.uint32(5),
+    hitfitBTagPruning        = cms.untracked.bool(True),     # tagged jets take the b slots
+    hitfitPruneWMassWindow   = cms.untracked.double(50.0),   # unfitted mass windows before fitting, 0 disables
+    hitfitPruneTopMassWindow = cms.untracked.double(100.0),
+    hitfitNThreads           = cms.untracked.uint32(1)
     )
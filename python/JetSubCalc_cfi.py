@@ -15,5 +15,23 @@ JetSubCalc = cms.PSet(
                       slimmedJetColl     = cms.InputTag("slimmedJets"),
                       slimmedJetsAK8Coll = cms.InputTag("slimmedJetsAK8"),
                       bDiscriminant      = cms.string("pfCombinedSecondaryVertexBJetTags"),
-                      tagInfo            = cms.string("caTop")
+                      tagInfo            = cms.string("caTop"),
+                      # constituents as offsets and jet-relative 16-bit columns,
+                      # read back with jetconstituents::Reader
+                      compactDaughters   = cms.bool(False),
+                      # AK8 N-subjettiness, soft drop and pruned masses, C2/D2 and
+                      # subjet b-tags recomputed from the constituents
+                      computeSubstructure = cms.bool(False),
+                      nsubBeta           = cms.untracked.double(1.0),
+                      nsubR0             = cms.untracked.double(0.8),
+                      softDropBeta       = cms.untracked.double(0.0),
+                      softDropZcut       = cms.untracked.double(0.1),
+                      softDropR0         = cms.untracked.double(0.8),
+                      pruningZcut        = cms.untracked.double(0.1),
+                      pruningRcutFactor  = cms.untracked.double(0.5),
+                      ecfBeta            = cms.untracked.double(1.0),
+                      subjetLabel        = cms.untracked.string("SoftDrop"),
+                      subjetCSVL         = cms.untracked.double(0.244),
+                      subjetCSVM         = cms.untracked.double(0.679),
+                      subjetCSVT         = cms.untracked.double(0.898)
                       )
\ No newline at end of file
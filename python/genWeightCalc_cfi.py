@@ -0,0 +1,13 @@
+import FWCore.ParameterSet.Config as cms
+
+GenWeightCalc = cms.PSet(
+                         genInfoSrc    = cms.untracked.InputTag("generator"),
+                         lheSrc        = cms.untracked.InputTag("externalLHEProducer"),
+                         lheRunInfoSrc = cms.untracked.InputTag("externalLHEProducer")
+                         # weight sums of all processed events and the layouts: written by the
+                         # run/lumi summary, which is turned on for MC when this calculator runs
+                         # compact storage of the ratios, in the outputs PSet:
+                         # branchPrecision = cms.VPSet(
+                         #     cms.PSet(pattern = cms.string('genWeightRatios_GenWeightCalc'), storage = cms.string('truncated'), nbits = cms.int32(10)),
+                         # ),
+                         )
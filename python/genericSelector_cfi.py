@@ -0,0 +1,62 @@
+import FWCore.ParameterSet.Config as cms
+
+# Event selector made of cut expressions, selection = 'GenericSelector'.
+# Needs pvSelector and pfJetIDSelector in the process as well.
+#
+# Each cut reads "<variable> <op> <value>", op one of < <= > >= == !=,
+# and a selection is the AND of its cuts. Available variables:
+#
+# muons:     pt eta abseta phi energy charge hasTracks isGlobal isTracker
+#            isPF isLoose isTight normChi2 nValidMuonHits nMatchedStations
+#            nValidPixelHits nTrackerLayers dxy dz relIso
+# electrons: pt eta abseta phi energy charge scEta absSCEta hasGsfTrack
+#            dEtaIn dPhiIn sigmaIEtaIEta hOverE ooEmooP dxy dz missingHits
+#            passConversionVeto relIso
+# jets:      pt eta abseta phi energy corrPt passId bDiscriminator
+#            nConstituents chargedHadronFraction neutralHadronFraction
+#            chargedEmFraction neutralEmFraction chargedMultiplicity
+#            minLeptonDR (to the nearest tight lepton)
+#
+# dxy and dz are taken with respect to the first primary vertex,
+# bDiscriminator is the one of btagOP. Multiplicity and MET cuts
+# are applied only if present. The values below reproduce the
+# DileptonSelector defaults.
+
+event_selector = cms.PSet(
+
+    selection = cms.string('GenericSelector'),
+
+    isMc         = cms.bool(True),
+    btagOP       = cms.string('CSVM'),
+
+    trigger_cut  = cms.bool(False),
+    dump_trigger = cms.bool(False),
+    trigger_path = cms.vstring(),
+
+    pv_cut       = cms.bool(True),
+
+    muon_tight     = cms.vstring('hasTracks == 1', 'pt > 20', 'abseta < 2.4'),
+    muon_loose     = cms.vstring(),
+    electron_tight = cms.vstring('hasGsfTrack == 1', 'pt > 20', 'abseta < 2.5'),
+    electron_loose = cms.vstring(),
+    jet_all        = cms.vstring('passId == 1'),
+    jet_selected   = cms.vstring('pt > 30', 'abseta < 2.4'),
+
+    min_lepton   = cms.int32(2),
+    min_jet      = cms.int32(0),
+
+    # useCompiledJEC evaluates the doNewJEC levels natively instead of
+    # through the FactorizedJetCorrector formulas, falling back to it
+    # for formulas it does not know; validateCompiledJEC evaluates both,
+    # uses FactorizedJetCorrector and prints the first mismatches
+    doNewJEC            = cms.bool(False),
+    useCompiledJEC      = cms.bool(False),
+    validateCompiledJEC = cms.bool(False),
+
+    trigger_collection  = cms.InputTag('TriggerResults::HLT'),
+    pv_collection       = cms.InputTag('offlineSlimmedPrimaryVertices'),
+    jet_collection      = cms.InputTag('slimmedJets'),
+    muon_collection     = cms.InputTag('slimmedMuons'),
+    electron_collection = cms.InputTag('slimmedElectrons'),
+    met_collection      = cms.InputTag('slimmedMETs')
+    )
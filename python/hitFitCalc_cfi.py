@@ -0,0 +1,5 @@
+import FWCore.ParameterSet.Config as cms
+
+from LJMet.Com.HitFitParameters_cfi import defaultHitFitParameters
+
+HitFitCalc = defaultHitFitParameters.clone( )
@@ -0,0 +1,16 @@
+import FWCore.ParameterSet.Config as cms
+
+IsolationCalc = cms.PSet(
+                         packedPFCands    = cms.InputTag("packedPFCandidates"),
+                         rhoSrc           = cms.InputTag("fixedGridRhoFastjetAll"),
+                         # mini-isolation cone miniIsoKt/pt, kept in [min, max]
+                         miniIsoKt        = cms.untracked.double(10.0),
+                         miniIsoMinCone   = cms.untracked.double(0.05),
+                         miniIsoMaxCone   = cms.untracked.double(0.2),
+                         # fixed cones, branches named after the cone: elRelIsoDB03, ...
+                         isoCones         = cms.untracked.vdouble(0.3, 0.4),
+                         muEAEtaBins      = cms.untracked.vdouble(0.0, 0.8, 1.3, 2.0, 2.2, 2.5),
+                         muEffectiveAreas = cms.untracked.vdouble(0.0735, 0.0619, 0.0465, 0.0433, 0.0577),
+                         elEAEtaBins      = cms.untracked.vdouble(0.0, 1.0, 1.479, 2.0, 2.2, 2.3, 2.4, 2.5),
+                         elEffectiveAreas = cms.untracked.vdouble(0.1752, 0.1862, 0.1411, 0.1534, 0.1903, 0.2243, 0.2687)
+                         )
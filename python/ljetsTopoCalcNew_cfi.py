@@ -2,5 +2,7 @@ import FWCore.ParameterSet.Config as cms
 
 LjetsTopoCalcNew = cms.PSet(
     useBestTop     = cms.bool(False),
-    debug          = cms.bool(False)
+    debug          = cms.bool(False),
+    # compare the batched Cos_*Top angles to the one-at-a-time ones, mismatches printed
+    validateBatchAngles = cms.bool(False)
 )
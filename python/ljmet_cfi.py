@@ -4,5 +4,18 @@ ljmet = cms.PSet(
                  isMc      = cms.bool(True),
                  verbosity = cms.int32(0),
                  runs                 = cms.vint32([]),
-                 excluded_calculators = cms.vstring()
+                 excluded_calculators = cms.vstring(),
+                 # output branch selection, glob patterns on full branch names;
+                 # empty included_branches keeps everything not excluded
+                 included_branches    = cms.vstring(),
+                 excluded_branches    = cms.vstring(),
+                 # number of forked worker processes, 1 runs in-process
+                 nWorkers  = cms.int32(1),
+                 # per-lumi event counts, generator weight sums and cut flow
+                 # in the RunLumiSummary tree of the output file; reads the
+                 # generator and LHE weights of every processed event;
+                 # always on for MC when GenWeightCalc runs
+                 runLumiSummary = cms.bool(False),
+                 genInfoSrc     = cms.InputTag("generator"),
+                 lheSrc         = cms.InputTag("externalLHEProducer")
                  )
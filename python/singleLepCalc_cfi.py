@@ -5,6 +5,7 @@ singleLepCalc = cms.PSet(
                          isMc              = cms.bool(True),
                          pvCollection = cms.InputTag("offlineSlimmedPrimaryVertices"),
                          genParticles = cms.InputTag("prunedGenParticles"),
+                         genPackedParticles = cms.InputTag("packedGenParticles"),
 			 triggerCollection = cms.InputTag("TriggerResults::HLT"),
 			 triggerSummary = cms.InputTag("selectedPatTrigger"),
                          keepFullMChistory = cms.bool(True),
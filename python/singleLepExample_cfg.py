@@ -114,6 +114,9 @@ process.event_selector = cms.PSet(
     JERup                    = cms.bool(False),
     JERdown                  = cms.bool(False),
     JEC_txtfile = cms.string('CMSSW_BASE/src/LJMet/singletPrime/JEC/Summer13_V5_DATA_UncertaintySources_AK5PF.txt'),
+    # native evaluation of the JEC levels, validateCompiledJEC compares it to FactorizedJetCorrector
+    useCompiledJEC           = cms.bool(False),
+    validateCompiledJEC      = cms.bool(False),
     trigger_collection       = cms.InputTag('TriggerResults::HLT'),
     pv_collection            = cms.InputTag('offlineSlimmedPrimaryVertices'),
     jet_collection           = cms.InputTag('slimmedJets'),
@@ -165,6 +168,32 @@ if (not process.ljmet.isMc==cms.bool(True)):
 process.outputs = cms.PSet (
     outputName = cms.string('ljmet_tree'),
     treeName   = cms.string('ljmet'),
+    # fill the output tree on a separate writer thread, the event loop
+    # waits only if more than asyncMaxLag events are pending; nothing
+    # else may write to the output file while the writer runs
+    asyncWrite  = cms.bool(False),
+    asyncMaxLag = cms.int32(16),
+    # output tuning: compression ZLIB, LZMA, LZ4 or ZSTD with level 1-9,
+    # basket sizes in bytes per branch type, autoFlush in entries (>0)
+    # or bytes (<0), basket re-optimisation after the first N entries
+    #compressionAlgorithm  = cms.string('LZ4'),
+    #compressionLevel      = cms.int32(4),
+    #scalarBasketSize      = cms.int32(32000),
+    #vectorBasketSize      = cms.int32(64000),
+    #autoFlush             = cms.int32(-30000000),
+    #optimizeBasketsAfter  = cms.int32(1000),
+    #optimizeBasketsMemory = cms.int32(30000000),
+    # on-disk precision of double branches, first matching pattern wins:
+    # double, float, truncated (nbits mantissa bits) or quantized
+    # (2^nbits steps in [min, max]); values are still set as double.
+    # Truncated and quantized scalars are Float16_t leaves packed by ROOT
+    # (truncated up to 14 bits, above that a rounded float), vectors are
+    # rounded and stored as vector<Double32_t>
+    #branchPrecision = cms.VPSet(
+    #    cms.PSet(pattern = cms.string('theJetDaughter*_JetSubCalc'), storage = cms.string('truncated'), nbits = cms.int32(10)),
+    #    cms.PSet(pattern = cms.string('*Phi*'), storage = cms.string('quantized'), min = cms.double(-3.1416), max = cms.double(3.1416), nbits = cms.int32(16)),
+    #    cms.PSet(pattern = cms.string('*_JetSubCalc'), storage = cms.string('float')),
+    #),
 )
 
 
@@ -114,6 +114,10 @@ process.event_selector = cms.PSet(
     JERup                    = cms.bool(False),
     JERdown                  = cms.bool(False),
     JEC_txtfile = cms.string(relBase+'/src/LJMet/singletPrime/JEC/Summer13_V5_DATA_UncertaintySources_AK5PF.txt'),
+    # parsed JEC payloads and event lists shared by the jobs of a node, empty to disable
+    conditionsCacheDir       = cms.string(''),
+    # compare the checksum of every cached payload on open, not only its source size and mtime
+    verifyConditionsCache    = cms.bool(False),
     trigger_collection       = cms.InputTag('TriggerResults::HLT'),
     pv_collection            = cms.InputTag('offlineSlimmedPrimaryVertices'),
     jet_collection           = cms.InputTag('slimmedJets'),
@@ -1,3 +1,6 @@
 import FWCore.ParameterSet.Config as cms
 
-StopCalc = cms.PSet( )
+StopCalc = cms.PSet(
+    # ttbar hypotheses kept per event for the hyp* angle branches, best first
+    nHypotheses = cms.int32(5)
+)
@@ -0,0 +1,30 @@
+import FWCore.ParameterSet.Config as cms
+
+WeightCalc = cms.PSet(
+                      # evaluated in this order: pileup, topPt, bFrag, bSemiLep, bTag
+                      weightProviders    = cms.untracked.vstring('pileup'),
+                      # nominal, then every variation of one provider with the others nominal
+                      singleVariations   = cms.untracked.bool(True),
+                      # further products, e.g. 'pileup:2012ABCD,bTag:bcUp'
+                      weightCombinations = cms.untracked.vstring(),
+                      # pileup: first scenario is nominal
+                      puInfoSrc          = cms.untracked.InputTag("addPileupInfo"),
+                      puScenarios        = cms.untracked.vstring('Oct2012', '2012ABC', '2012ABC735', '2012ABCD', '2012ABCD735'),
+                      # topPt: exp(topPtA - topPtB*pt) per top
+                      genParticles       = cms.untracked.InputTag("genParticles"),
+                      topStatus          = cms.untracked.int32(3),
+                      topPtA             = cms.untracked.double(0.148),
+                      topPtB             = cms.untracked.double(0.00129),
+                      # bFrag
+                      genJets            = cms.untracked.InputTag("selectedPatJetsPFlow", "genJets"),
+                      fragSourceFile     = cms.string('/src/LJMet/Dilepton/data/TopUtils_data_MC_BJES_TuneZ2star.root'),
+                      fragTargetFile     = cms.string('/src/LJMet/Dilepton/data/TopUtils_data_MC_BJES_TuneZ2star_rbLEP.root'),
+                      fragVariationFiles = cms.untracked.vstring(),
+                      # bSemiLep
+                      nuDecayFractionSource     = cms.untracked.double(0.25),
+                      nuDecayFractionTarget     = cms.untracked.double(0.239),
+                      nuDecayFractionVariations = cms.untracked.vdouble(),
+                      # bTag: for selections that count tags on the raw discriminator,
+                      # without flipping tags by the scale factors
+                      btagOP             = cms.untracked.string('CSVM')
+                      )
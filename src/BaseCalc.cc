@@ -3,13 +3,39 @@
 
 BaseCalc::BaseCalc():
 mName(""),
-mLegend("")
+mLegend(""),
+mpEc(0),
+mNValues(0),
+mNRequestedValues(0),
+mNHistograms(0)
 {
 }
 
-void BaseCalc::SetHistogram(std::string name, int nbins, double low, double high)
+int BaseCalc::SetHistogram(std::string name, int nbins, double low, double high)
 {
-    mpEc->SetHistogram(mName, name, nbins, low, high);
+    ++mNHistograms;
+    return mpEc->SetHistogram(mName, name, nbins, low, high);
+}
+
+int BaseCalc::SetHistogram(std::string name, int nbinsx, double xlow, double xhigh, int nbinsy, double ylow, double yhigh)
+{
+    ++mNHistograms;
+    return mpEc->SetHistogram(mName, name, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh);
+}
+
+void BaseCalc::FillHist(int handle, double value, double weight)
+{
+    mpEc->FillHist(handle, value, weight);
+}
+
+void BaseCalc::FillHist2D(int handle, double x, double y, double weight)
+{
+    mpEc->FillHist2D(handle, x, y, weight);
+}
+
+void BaseCalc::FillHistN(int handle, size_t n, double const * values, double const * weights)
+{
+    mpEc->FillHistN(handle, n, values, weights);
 }
 
 void BaseCalc::SetHistValue(std::string name, double value)
@@ -20,37 +46,88 @@ void BaseCalc::SetHistValue(std::string name, double value)
 void BaseCalc::SetValue(std::string name, bool value)
 {
     std::string _name = name + "_" + mName;
-    mpEc->SetValue(_name, value);
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
 }
 
 void BaseCalc::SetValue(std::string name, int value)
 {
     std::string _name = name + "_" + mName;
-    mpEc->SetValue(_name, value);
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
 }
 
 void BaseCalc::SetValue(std::string name, double value)
 {
     std::string _name = name + "_" + mName;
-    mpEc->SetValue(_name, value);
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
+}
+
+void BaseCalc::SetValue(std::string name, std::vector<bool> const & value)
+{
+    std::string _name = name + "_" + mName;
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
+}
+
+void BaseCalc::SetValue(std::string name, ArenaVector<bool> const & value)
+{
+    std::string _name = name + "_" + mName;
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
+}
+
+void BaseCalc::SetValue(std::string name, std::vector<int> const & value)
+{
+    std::string _name = name + "_" + mName;
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
 }
 
-void BaseCalc::SetValue(std::string name, std::vector<bool> value)
+void BaseCalc::SetValue(std::string name, ArenaVector<int> const & value)
 {
     std::string _name = name + "_" + mName;
-    mpEc->SetValue(_name, value);
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
 }
 
-void BaseCalc::SetValue(std::string name, std::vector<int> value)
+void BaseCalc::SetValue(std::string name, std::vector<short> const & value)
 {
     std::string _name = name + "_" + mName;
-    mpEc->SetValue(_name, value);
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
 }
 
-void BaseCalc::SetValue(std::string name, std::vector<double> value)
+void BaseCalc::SetValue(std::string name, ArenaVector<short> const & value)
 {
     std::string _name = name + "_" + mName;
-    mpEc->SetValue(_name, value);
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
+}
+
+void BaseCalc::SetValue(std::string name, std::vector<double> const & value)
+{
+    std::string _name = name + "_" + mName;
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
+}
+
+void BaseCalc::SetValue(std::string name, ArenaVector<double> const & value)
+{
+    std::string _name = name + "_" + mName;
+    ++mNValues;
+    if (mpEc->SetValue(_name, value)) ++mNRequestedValues;
+}
+
+EventArena & BaseCalc::GetArena()
+{
+    return mpEc->GetArena();
+}
+
+bool BaseCalc::IsRequested(std::string name)
+{
+    return mpEc->IsBranchRequested(name + "_" + mName);
 }
 
 void BaseCalc::init()
@@ -7,7 +7,14 @@
 
 BaseEventSelector::BaseEventSelector():
 mName(""),
-mLegend("")
+mLegend(""),
+mHistJesCorrection(-1),
+mHistMetCorrection(-1),
+mHistNBtagSfCorrections(-1),
+mpCompiledJEC(0),
+mpCompiledJECAK8(0),
+mbValidateCompiledJEC(false),
+mNJecMismatch(0)
 {
 }
 
@@ -113,6 +120,14 @@ void BaseEventSelector::BeginJob(std::map<std::string, edm::ParameterSet const >
         }
         if (par[_key].exists("doNewJEC")) mbPar["doNewJEC"] = par[_key].getParameter<bool> ("doNewJEC");
         else mbPar["doNewJEC"] = false;
+        if (par[_key].exists("useCompiledJEC")) mbPar["useCompiledJEC"] = par[_key].getParameter<bool> ("useCompiledJEC");
+        else mbPar["useCompiledJEC"] = false;
+        if (par[_key].exists("validateCompiledJEC")) mbPar["validateCompiledJEC"] = par[_key].getParameter<bool> ("validateCompiledJEC");
+        else mbPar["validateCompiledJEC"] = false;
+        if (par[_key].exists("conditionsCacheDir")) msPar["conditionsCacheDir"] = par[_key].getParameter<std::string> ("conditionsCacheDir");
+        else msPar["conditionsCacheDir"] = "";
+        if (par[_key].exists("verifyConditionsCache")) mbPar["verifyConditionsCache"] = par[_key].getParameter<bool> ("verifyConditionsCache");
+        else mbPar["verifyConditionsCache"] = false;
         
         if (_missing_config) {
             std::cout << mLegend
@@ -124,14 +139,19 @@ void BaseEventSelector::BeginJob(std::map<std::string, edm::ParameterSet const >
         }
     }
     
+    mConditions.SetDirectory(msPar["conditionsCacheDir"]);
+    mConditions.SetVerifyChecksums(mbPar["verifyConditionsCache"]);
+    if (mConditions.IsEnabled()) std::cout << mLegend << "conditions cached in " << mConditions.GetDirectory() << std::endl;
+    
     msPar["btagger"] = mBtagCond.getAlgoName(msPar["btagOP"]);
     mdPar["btag_min_discr"] = mBtagCond.getDiscriminant(msPar["btagOP"]);
     
     bTagCut = mdPar["btag_min_discr"];
+    mBtaggerSlot = mBtagLabels.Add(msPar["btagger"]);
     std::cout << "b-tag check "<<msPar["btagOP"]<<" "<< msPar["btagger"]<<" "<<mdPar["btag_min_discr"]<<std::endl;
     
     if ( mbPar["isMc"] && ( mbPar["JECup"] || mbPar["JECdown"]))
-        jecUnc = new JetCorrectionUncertainty(*(new JetCorrectorParameters(msPar["JEC_txtfile"].c_str(), "Total")));
+        jecUnc = new JetCorrectionUncertainty(*(new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["JEC_txtfile"], "Total"))));
 
     vector<JetCorrectorParameters> vPar;
     vector<JetCorrectorParameters> vParAK8;
@@ -139,13 +159,13 @@ void BaseEventSelector::BeginJob(std::map<std::string, edm::ParameterSet const >
     if ( mbPar["isMc"] && mbPar["doNewJEC"] ) {
         // Create the JetCorrectorParameter objects, the order does not matter.
 
-        JetCorrectorParameters *L3JetPar  = new JetCorrectorParameters(msPar["MCL3JetPar"]);
-        JetCorrectorParameters *L2JetPar  = new JetCorrectorParameters(msPar["MCL2JetPar"]);
-    	JetCorrectorParameters *L1JetPar  = new JetCorrectorParameters(msPar["MCL1JetPar"]);
+        JetCorrectorParameters *L3JetPar  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["MCL3JetPar"]));
+        JetCorrectorParameters *L2JetPar  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["MCL2JetPar"]));
+    	JetCorrectorParameters *L1JetPar  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["MCL1JetPar"]));
         
-	JetCorrectorParameters *L3JetParAK8  = new JetCorrectorParameters(msPar["MCL3JetParAK8"]);
-        JetCorrectorParameters *L2JetParAK8  = new JetCorrectorParameters(msPar["MCL2JetParAK8"]);
-    	JetCorrectorParameters *L1JetParAK8  = new JetCorrectorParameters(msPar["MCL1JetParAK8"]);
+	JetCorrectorParameters *L3JetParAK8  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["MCL3JetParAK8"]));
+        JetCorrectorParameters *L2JetParAK8  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["MCL2JetParAK8"]));
+    	JetCorrectorParameters *L1JetParAK8  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["MCL1JetParAK8"]));
     	// Load the JetCorrectorParameter objects into a vector,
     	// IMPORTANT: THE ORDER MATTERS HERE !!!! 
     	vPar.push_back(*L1JetPar);
@@ -161,15 +181,15 @@ void BaseEventSelector::BeginJob(std::map<std::string, edm::ParameterSet const >
     else if ( !mbPar["isMc"] && mbPar["doNewJEC"] ) {
         // Create the JetCorrectorParameter objects, the order does not matter.
 
-        JetCorrectorParameters *ResJetPar = new JetCorrectorParameters(msPar["DataResJetPar"]); 
-    	JetCorrectorParameters *L3JetPar  = new JetCorrectorParameters(msPar["DataL3JetPar"]);
-    	JetCorrectorParameters *L2JetPar  = new JetCorrectorParameters(msPar["DataL2JetPar"]);
-    	JetCorrectorParameters *L1JetPar  = new JetCorrectorParameters(msPar["DataL1JetPar"]);
+        JetCorrectorParameters *ResJetPar = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["DataResJetPar"])); 
+    	JetCorrectorParameters *L3JetPar  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["DataL3JetPar"]));
+    	JetCorrectorParameters *L2JetPar  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["DataL2JetPar"]));
+    	JetCorrectorParameters *L1JetPar  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["DataL1JetPar"]));
 
-        JetCorrectorParameters *ResJetParAK8 = new JetCorrectorParameters(msPar["DataResJetParAK8"]); 
-    	JetCorrectorParameters *L3JetParAK8  = new JetCorrectorParameters(msPar["DataL3JetParAK8"]);
-    	JetCorrectorParameters *L2JetParAK8  = new JetCorrectorParameters(msPar["DataL2JetParAK8"]);
-    	JetCorrectorParameters *L1JetParAK8  = new JetCorrectorParameters(msPar["DataL1JetParAK8"]);
+        JetCorrectorParameters *ResJetParAK8 = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["DataResJetParAK8"])); 
+    	JetCorrectorParameters *L3JetParAK8  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["DataL3JetParAK8"]));
+    	JetCorrectorParameters *L2JetParAK8  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["DataL2JetParAK8"]));
+    	JetCorrectorParameters *L1JetParAK8  = new JetCorrectorParameters(mConditions.GetJetCorrectorParameters(msPar["DataL1JetParAK8"]));
     	// Load the JetCorrectorParameter objects into a vector,
     	// IMPORTANT: THE ORDER MATTERS HERE !!!! 
     	vPar.push_back(*L1JetPar);
@@ -189,9 +209,109 @@ void BaseEventSelector::BeginJob(std::map<std::string, edm::ParameterSet const >
     }
     JetCorrector = new FactorizedJetCorrector(vPar);
     JetCorrectorAK8 = new FactorizedJetCorrector(vParAK8);
+
+    // same levels evaluated without ROOT formulas, FactorizedJetCorrector otherwise
+    mbValidateCompiledJEC = mbPar["validateCompiledJEC"];
+    if ( mbPar["doNewJEC"] && mbPar["useCompiledJEC"] ) {
+        mpCompiledJEC = new CompiledJetCorrector(vPar);
+        mpCompiledJECAK8 = new CompiledJetCorrector(vParAK8);
+        if (!mpCompiledJEC->IsValid() || !mpCompiledJECAK8->IsValid()) {
+            std::cout << mLegend << "compiled jet energy corrections not usable: "
+            << mpCompiledJEC->GetError() << mpCompiledJECAK8->GetError() << std::endl;
+            std::cout << mLegend << "using FactorizedJetCorrector" << std::endl;
+            delete mpCompiledJEC;
+            delete mpCompiledJECAK8;
+            mpCompiledJEC = 0;
+            mpCompiledJECAK8 = 0;
+        }
+        else {
+            std::cout << mLegend << "compiled jet energy corrections, "
+            << mpCompiledJEC->GetNCompiledLevels() << "/" << mpCompiledJEC->GetNLevels() << " AK4 and "
+            << mpCompiledJECAK8->GetNCompiledLevels() << "/" << mpCompiledJECAK8->GetNLevels() << " AK8 levels native" << std::endl;
+        }
+    }
   
 }
 
+double BaseEventSelector::jesCorrection(const pat::Jet & jet, double pt_raw, double rho, bool doAK8Corr)
+{
+    FactorizedJetCorrector * _corrector = doAK8Corr ? JetCorrectorAK8 : JetCorrector;
+    CompiledJetCorrector const * _compiled = doAK8Corr ? mpCompiledJECAK8 : mpCompiledJEC;
+
+    if (_compiled && !mbValidateCompiledJEC) {
+        return _compiled->GetCorrection(jet.eta(), pt_raw, jet.jetArea(), rho);
+    }
+
+    double correction = 1.0;
+    _corrector->setJetEta(jet.eta());
+    _corrector->setJetPt(pt_raw);
+    _corrector->setJetA(jet.jetArea());
+    _corrector->setRho(rho);
+
+    try{
+        correction = _corrector->getCorrection();
+    }
+    catch(...){
+        std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
+        std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
+        std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
+        return correction;
+    }
+
+    // validation mode: both are evaluated, the reference is used
+    if (_compiled) {
+        double _fast = _compiled->GetCorrection(jet.eta(), pt_raw, jet.jetArea(), rho);
+        if (_fast != correction && mNJecMismatch++ < 10) {
+            std::cout << mLegend << "compiled JEC mismatch: eta " << jet.eta() << " pt " << pt_raw
+            << " area " << jet.jetArea() << " rho " << rho << (doAK8Corr ? " AK8 " : " AK4 ")
+            << _fast << " instead of " << correction << std::endl;
+        }
+    }
+
+    return correction;
+}
+
+void BaseEventSelector::CorrectJets(std::vector<pat::Jet> const & jets, edm::EventBase const & event, bool doAK8Corr)
+{
+    size_t _n = jets.size();
+    mvJecCorr.assign(_n, 1.0);
+    if (_n == 0) return;
+
+    if (mbPar["doNewJEC"]) {
+        edm::Handle<double> rhoHandle;
+        edm::InputTag rhoSrc_("fixedGridRhoAll", "");
+        event.getByLabel(rhoSrc_, rhoHandle);
+        double rho = std::max(*(rhoHandle.product()), 0.0);
+
+        // data jets are corrected with the AK4 levels, as in correctJet
+        bool _ak8 = mbPar["isMc"] && doAK8Corr;
+        CompiledJetCorrector const * _compiled = _ak8 ? mpCompiledJECAK8 : mpCompiledJEC;
+        if (_compiled && !mbValidateCompiledJEC) {
+            mvJecIn.resize(4*_n);
+            float * _eta = &mvJecIn[0];
+            float * _pt = _eta + _n;
+            float * _area = _pt + _n;
+            float * _corr = _area + _n;
+            for (size_t i = 0; i != _n; ++i) {
+                _eta[i] = jets[i].eta();
+                _pt[i] = jets[i].correctedJet(0).pt();
+                _area[i] = jets[i].jetArea();
+            }
+            _compiled->GetCorrections(_n, _eta, _pt, _area, rho, _corr);
+            for (size_t i = 0; i != _n; ++i) mvJecCorr[i] = _corr[i];
+        }
+        else {
+            for (size_t i = 0; i != _n; ++i) mvJecCorr[i] = jesCorrection(jets[i], jets[i].correctedJet(0).pt(), rho, _ak8);
+        }
+    }
+
+    for (size_t i = 0; i != _n; ++i) {
+        if (mCorrJets.find(std::make_pair(&jets[i], doAK8Corr)) == mCorrJets.end()) {
+            keepCorrectedJet(jets[i], doAK8Corr, applyJetCorrections(jets[i], mvJecCorr[i]));
+        }
+    }
+}
+
 double BaseEventSelector::GetPerp(TVector3 & v1, TVector3 & v2)
 {
     double perp;
@@ -205,15 +325,114 @@ double BaseEventSelector::GetPerp(TVector3 & v1, TVector3 & v2)
     return perp;
 }
 
+std::vector<int> BaseEventSelector::GetCutFlowCounts() const
+{
+    std::vector<int> _counts;
+    for (cut_flow_map::const_iterator cut = cutFlow_.begin(); cut != cutFlow_.end(); ++cut) {
+        _counts.push_back(static_cast<int>(cut->second));
+    }
+    return _counts;
+}
+
+std::vector<std::string> BaseEventSelector::GetCutFlowNames() const
+{
+    std::vector<std::string> _names;
+    for (cut_flow_map::const_iterator cut = cutFlow_.begin(); cut != cutFlow_.end(); ++cut) {
+        _names.push_back(cut->first.str());
+    }
+    return _names;
+}
+
+void BaseEventSelector::AddCutFlowCounts(std::vector<int> const & counts)
+{
+    if (counts.size() != cutFlow_.size()) {
+        std::cout << mLegend << "cut flow size mismatch: " << counts.size()
+        << " instead of " << cutFlow_.size() << ", ignoring" << std::endl;
+        return;
+    }
+    for (size_t i = 0; i != counts.size(); ++i) {
+        cutFlow_[i].second += counts[i];
+    }
+}
+
+GenEventIndex const & BaseEventSelector::GetGenEventIndex(edm::EventBase const & event,
+                                                          edm::InputTag const & prunedTag,
+                                                          edm::InputTag const & packedTag)
+{
+    // rebuilt only if another collection is asked for in the same event
+    bool _withPacked = !packedTag.label().empty();
+    if (mGenIndex.IsBuilt() && mGenIndexTag == prunedTag && (!_withPacked || mGenIndexPackedTag == packedTag)) return mGenIndex;
+    
+    edm::Handle<reco::GenParticleCollection> _pruned;
+    event.getByLabel(prunedTag, _pruned);
+    if (_withPacked) {
+        edm::Handle<std::vector<pat::PackedGenParticle> > _packed;
+        event.getByLabel(packedTag, _packed);
+        mGenIndex.Build(*_pruned, _packed.product());
+    }
+    else mGenIndex.Build(*_pruned);
+    
+    mGenIndexTag = prunedTag;
+    mGenIndexPackedTag = packedTag;
+    
+    return mGenIndex;
+}
+
+GenWeightReader const & BaseEventSelector::GetGenWeights(edm::EventBase const & event,
+                                                         edm::InputTag const & genInfoTag,
+                                                         edm::InputTag const & lheTag,
+                                                         edm::InputTag const & lheRunInfoTag)
+{
+    // read again only if other products are asked for in the same event
+    if (!mGenWeights.IsReadFrom(genInfoTag, lheTag)) mGenWeights.Read(event, genInfoTag, lheTag, lheRunInfoTag);
+    
+    return mGenWeights;
+}
+
 void BaseEventSelector::Init( void )
 {
     // init sanity check histograms
-    mpEc->SetHistogram(mName, "jes_correction", 100, 0.8, 1.2);
-    mpEc->SetHistogram(mName, "met_correction", 100, 0.0, 2.0);
-    mpEc->SetHistogram(mName, "nBtagSfCorrections", 100, 0.0, 10.0);
+    mHistJesCorrection = mpEc->SetHistogram(mName, "jes_correction", 100, 0.8, 1.2);
+    mHistMetCorrection = mpEc->SetHistogram(mName, "met_correction", 100, 0.0, 2.0);
+    mHistNBtagSfCorrections = mpEc->SetHistogram(mName, "nBtagSfCorrections", 100, 0.0, 10.0);
 }
 
 TLorentzVector BaseEventSelector::correctJet(const pat::Jet & jet, edm::EventBase const & event, bool doAK8Corr)
+{
+    // every jet is corrected once per event, by the selector or the first calculator
+    std::map<std::pair<pat::Jet const *, bool>, TLorentzVector>::const_iterator iCorr = mCorrJets.find(std::make_pair(&jet, doAK8Corr));
+    if (iCorr != mCorrJets.end()) return iCorr->second;
+
+    double correction = 1.0;
+
+    if (mbPar["doNewJEC"]) {
+        edm::Handle<double> rhoHandle;
+        edm::InputTag rhoSrc_("fixedGridRhoAll", "");
+        event.getByLabel(rhoSrc_, rhoHandle);
+        double rho = std::max(*(rhoHandle.product()), 0.0);
+
+        // We need to undo the default corrections and then apply the new ones
+        double pt_raw = jet.correctedJet(0).pt();
+        if ( mbPar["isMc"] ) correction = jesCorrection(jet, pt_raw, rho, doAK8Corr);
+        else correction = jesCorrection(jet, pt_raw, rho);
+    }
+
+    return keepCorrectedJet(jet, doAK8Corr, applyJetCorrections(jet, correction));
+}
+
+TLorentzVector const & BaseEventSelector::keepCorrectedJet(const pat::Jet & jet, bool doAK8Corr, TLorentzVector const & jetP4)
+{
+    // sanity check - save the correction of every jet
+    double _orig_pt = jet.pt();
+    if (fabs(_orig_pt)<0.000000001){
+        _orig_pt = 0.000000001;
+    }
+    FillHist(mHistJesCorrection, jetP4.Pt()/_orig_pt);
+
+    return mCorrJets[std::make_pair(&jet, doAK8Corr)] = jetP4;
+}
+
+TLorentzVector BaseEventSelector::applyJetCorrections(const pat::Jet & jet, double correction)
 {
 
   // JES and JES systematics
@@ -226,52 +445,10 @@ TLorentzVector BaseEventSelector::correctJet(const pat::Jet & jet, edm::EventBas
     double ptscale = 1.0;
     double unc = 1.0;
     double pt = correctedJet.pt();
-    double correction = 1.0;
-
-    edm::Handle<double> rhoHandle;
-    edm::InputTag rhoSrc_("fixedGridRhoAll", "");
-    event.getByLabel(rhoSrc_, rhoHandle);
-    double rho = std::max(*(rhoHandle.product()), 0.0);
 
     if ( mbPar["isMc"] ){ 
 
     	if (mbPar["doNewJEC"]) {
-      	    // We need to undo the default corrections and then apply the new ones
-
-      	    double pt_raw = jet.correctedJet(0).pt();
-
-	    if (doAK8Corr){
-                JetCorrectorAK8->setJetEta(jet.eta());
-          	JetCorrectorAK8->setJetPt(pt_raw);
-                JetCorrectorAK8->setJetA(jet.jetArea());
-          	JetCorrectorAK8->setRho(rho); 
-    
-                try{
-    		    correction = JetCorrectorAK8->getCorrection();
-                }
-          	catch(...){
-    		    std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-    		    std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-    		    std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-                }
-	    }
-
-	    else{
-                JetCorrector->setJetEta(jet.eta());
-          	JetCorrector->setJetPt(pt_raw);
-                JetCorrector->setJetA(jet.jetArea());
-          	JetCorrector->setRho(rho); 
-    
-                try{
-    		    correction = JetCorrector->getCorrection();
-                }
-          	catch(...){
-    		    std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-    		    std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-    		    std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-                }
-	    }
-      
             correctedJet.scaleEnergy(correction);
             pt = correctedJet.pt();
 
@@ -351,24 +528,6 @@ TLorentzVector BaseEventSelector::correctJet(const pat::Jet & jet, edm::EventBas
     else if (!mbPar["isMc"]) {
       
         if (mbPar["doNewJEC"]) {
-	
-            // We need to undo the default corrections and then apply the new ones
-
-            double pt_raw = jet.correctedJet(0).pt();
-            JetCorrector->setJetEta(jet.eta());
-            JetCorrector->setJetPt(pt_raw);
-            JetCorrector->setJetA(jet.jetArea());
-            JetCorrector->setRho(rho); 
-	
-	    try{
-	        correction = JetCorrector->getCorrection();
-	    }
-	    catch(...){
-	        std::cout << mLegend << "WARNING! Exception thrown by JetCorrectionUncertainty!" << std::endl;
-	        std::cout << mLegend << "WARNING! Possibly, trying to correct a jet/MET outside correction range." << std::endl;
-	        std::cout << mLegend << "WARNING! Jet/MET will remain uncorrected." << std::endl;
-	    }
-	  
             correctedJet.scaleEnergy(correction);
             pt = correctedJet.pt();
 
@@ -379,18 +538,6 @@ TLorentzVector BaseEventSelector::correctJet(const pat::Jet & jet, edm::EventBas
     jetP4.SetPtEtaPhiM(correctedJet.pt()*unc*ptscale, correctedJet.eta(),correctedJet.phi(), correctedJet.mass() );
     //std::cout<<"jet pt: "<<jetP4.Pt()<<" eta: "<<jetP4.Eta()<<" phi: "<<jetP4.Phi()<<" energy: "<<jetP4.E()<<std::endl;
 
-
-    // sanity check - save correction of the first jet
-    if (mNCorrJets==0){
-        double _orig_pt = jet.pt();
-        if (fabs(_orig_pt)<0.000000001){
-            _orig_pt = 0.000000001;
-        }
-        SetHistValue("jes_correction", jetP4.Pt()/_orig_pt);
-        ++mNCorrJets;
-    }
-
-
     return jetP4;
 }
 
@@ -398,7 +545,7 @@ bool BaseEventSelector::isJetTagged(const pat::Jet & jet, edm::EventBase const &
 {
     bool _isTagged = false;
     
-    if ( jet.bDiscriminator( msPar["btagger"] ) > bTagCut ) _isTagged = true;
+    if ( mBtagLabels.BDiscriminator(jet, mBtaggerSlot) > bTagCut ) _isTagged = true;
     
     if (mbPar["isMc"] && applySF) {
         TLorentzVector lvjet = correctJet(jet, event);
@@ -447,6 +594,6 @@ TLorentzVector BaseEventSelector::correctMet(const pat::MET & met, edm::EventBas
     if (abs(_orig_met) < 1.e-9) {
         _orig_met = 1.e-9;
     }
-    SetHistValue("met_correction", correctedMET_p4.Pt()/_orig_met);
+    FillHist(mHistMetCorrection, correctedMET_p4.Pt()/_orig_met);
     return correctedMET_p4;
 }
@@ -8,6 +8,7 @@
 #include <limits>   // std::numeric_limits
 
 #include "DataFormats/Math/interface/LorentzVector.h"
+#include "LJMet/Com/interface/FourVector.h"
 #include "LJMet/Com/interface/BaseCalc.h"
 #include "LJMet/Com/interface/LjmetEventContent.h"
 #include "LJMet/Com/interface/LjmetFactory.h"
@@ -24,6 +25,7 @@ public:
     virtual int BeginJob();
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
     virtual int EndJob();
+    virtual bool HasSideEffects() const { return false; }
     
 private:
     bool debug_;
@@ -33,7 +35,7 @@ private:
                      std::vector<edm::Ptr<pat::Electron> > const & vTightElectrons,
                      std::vector<std::pair<TLorentzVector,bool> > const & vCorrBtagJets,
                      TLorentzVector const & corrMET,
-                     std::vector<TLorentzVector> const & vCAWJets,
+                     std::vector<FourVector> const & vCAWJets,
                      bool isMuon );
 };
 
@@ -99,15 +101,11 @@ int CATopoCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
     
     edm::Handle<std::vector<pat::Jet> > CAWJets;
     event.getByLabel(AK8slimmedJetColl_it, CAWJets);
-    std::vector<TLorentzVector> CAWP4;
-    TLorentzVector CAJet;
+    std::vector<FourVector> CAWP4;
+    CAWP4.reserve(CAWJets->size());
     
     for (std::vector<pat::Jet>::const_iterator ijet = CAWJets->begin(); ijet != CAWJets->end(); ijet++) {
-        CAJet.SetPxPyPzE(ijet->px(),
-                         ijet->py(),
-                         ijet->pz(),
-                         ijet->energy());
-        CAWP4.push_back(CAJet);
+        CAWP4.push_back(FourVector::FromCandidate(*ijet));
     }
     
     FillBranches(vSelMuons,
@@ -124,13 +122,13 @@ int CATopoCalc::FillBranches( std::vector<edm::Ptr<pat::Muon> > const & vSelMuon
                              std::vector<edm::Ptr<pat::Electron> > const & vSelElectrons,
                              std::vector<std::pair<TLorentzVector,bool>> const & vCorrBtagJets,
                              TLorentzVector const & corrMET,
-                             std::vector<TLorentzVector> const & vCAWJets,
+                             std::vector<FourVector> const & vCAWJets,
                              bool isMuon
                              )
 {
     while(1) {
         //Create lepton and met four vectors
-        TLorentzVector tlv_lepton;
+        FourVector tlv_lepton;
         
         if ( vSelMuons.size() == 0 && vSelElectrons.size() == 0) break;
         if ( vSelMuons.size() > 0 && vSelElectrons.size() > 0) {
@@ -155,13 +153,10 @@ int CATopoCalc::FillBranches( std::vector<edm::Ptr<pat::Muon> > const & vSelMuon
         if ( corrMET.Pt() > 0 ){ }
         else break;
         
-        TLorentzVector tlv_met( corrMET.Px(),
-                               corrMET.Py(),
-                               corrMET.Pz(),
-                               corrMET.Energy() );
+        FourVector const tlv_met = FourVector::FromLorentz(corrMET);
         
-        std::vector<TLorentzVector> jets;
-        std::vector<TLorentzVector> bjets;
+        std::vector<FourVector> jets;
+        std::vector<FourVector> bjets;
         int nJets = 0;
         int nBJets = 0;
         std::vector <double> bJetPt;
@@ -172,18 +167,19 @@ int CATopoCalc::FillBranches( std::vector<edm::Ptr<pat::Muon> > const & vSelMuon
         for (vector<std::pair<TLorentzVector,bool>>::const_iterator jet = vCorrBtagJets.begin(); jet != vCorrBtagJets.end(); ++jet){
             
             if( vCAWJets.size() > 0 ){
-                double CAtoAKJetDR = vCAWJets[0].DeltaR((*jet).first);
+                FourVector const jetP4 = FourVector::FromLorentz((*jet).first);
+                double CAtoAKJetDR = fourvector::DeltaR(vCAWJets[0], jetP4);
                 if( CAtoAKJetDR > 0.65 ){
                     if((*jet).second){
-                        bjets.push_back((*jet).first);
-                        bJetPt.push_back((*jet).first.Pt());
-                        bJetEta.push_back((*jet).first.Eta());
-                        bJetPhi.push_back((*jet).first.Phi());
+                        bjets.push_back(jetP4);
+                        bJetPt.push_back(jetP4.Pt());
+                        bJetEta.push_back(jetP4.Eta());
+                        bJetPhi.push_back(jetP4.Phi());
                         
                         ++nBJets;
                     }
                     else{
-                        jets.push_back((*jet).first);
+                        jets.push_back(jetP4);
                         ++nJets;
                     }
                 }
@@ -195,7 +191,7 @@ int CATopoCalc::FillBranches( std::vector<edm::Ptr<pat::Muon> > const & vSelMuon
         double minDRCAtoB = std::numeric_limits<double>::max();
         double CAMindrBMass = -std::numeric_limits<double>::max();
         double dR = std::numeric_limits<double>::max();
-        TLorentzVector bestTop;
+        FourVector bestTop;
         double topMass = -std::numeric_limits<double>::max();
         double massDiff = std::numeric_limits<double>::max();
         double tPrimeMassBestTop = -std::numeric_limits<double>::max();
@@ -216,7 +212,7 @@ int CATopoCalc::FillBranches( std::vector<edm::Ptr<pat::Muon> > const & vSelMuon
                 }
                 
                 //Find the bjet nearest to the CA jet but not overlapping
-                dR = vCAWJets[0].DeltaR(bjets[i]);
+                dR = fourvector::DeltaR(vCAWJets[0], bjets[i]);
                 if( dR < minDRCAtoB ){
                     minDRCAtoB = dR;
                     CAMindrBMass = double((vCAWJets[0] + bjets[i]).M());
@@ -117,7 +117,7 @@ protected:
     edm::Ptr<pat::Muon>     muon0_;
     edm::Ptr<pat::Electron> electron0_;
 
-    map<int,map<int,vector<int> > > mmvBadLaserCalEvents;
+    ConditionsCache::EventList mBadLaserCalEvents;
 
 private:
   
@@ -371,28 +371,7 @@ void ChargedHiggsEventSelector::BeginJob( std::map<std::string, edm::ParameterSe
     set("All cuts", true);
     
     if (mbPar["doLaserCalFilt"]){
-      std::ifstream inFile("../data/badLaserCalFiltEvents.txt");
-      string line,subString;
-      int begin,end;
-      while(inFile.good()){
-	getline(inFile,line);
-	begin=0;
-	end=line.find(":");
-	subString=line.substr(begin,end-begin);
-	int run=atoi(subString.c_str());
-	begin=end+1;
-	end=line.find(":",begin+1);
-	subString=line.substr(begin,end-begin);
-	int lumi=atoi(subString.c_str());
-	begin=end+1;
-	end=line.length();
-	subString=line.substr(begin,end-begin);
-	int event=atoi(subString.c_str());
-
-	if(mmvBadLaserCalEvents.find(run)==mmvBadLaserCalEvents.end()) mmvBadLaserCalEvents[run]=map<int,vector<int> >();
-	if(mmvBadLaserCalEvents[run].find(lumi)==mmvBadLaserCalEvents[run].end()) mmvBadLaserCalEvents[run][lumi]=vector<int>();
-	mmvBadLaserCalEvents[run][lumi].push_back(event);
-      }
+      mBadLaserCalEvents = GetConditionsCache().GetEventList("../data/badLaserCalFiltEvents.txt");
     }
     
 } // initialize() 
@@ -528,18 +507,8 @@ bool ChargedHiggsEventSelector::operator()( edm::EventBase const & event, pat::s
 	//_____ Laser Calibration Correction Filter____________
 	//
 	if ( considerCut("Laser calibration correction filter") ) {
-          bool passLaserCal=true;                                                                                                                                                           
 	  int runNo=event.id().run(), lumiNo=event.id().luminosityBlock(), eventNo=event.id().event();
-	  if (mmvBadLaserCalEvents.find(runNo)!=mmvBadLaserCalEvents.end()){
-	    if (mmvBadLaserCalEvents[runNo].find(lumiNo)!=mmvBadLaserCalEvents[runNo].end()){
-	      for (unsigned int i=0; i<mmvBadLaserCalEvents[runNo][lumiNo].size(); i++){
-		if (eventNo==mmvBadLaserCalEvents[runNo][lumiNo][i]){
-		  passLaserCal=false;
-		}
-	      }
-	    }
-	  }
-	  if(passLaserCal) passCut(ret, "Laser calibration correction filter");                                                                                                           
+          if (!mBadLaserCalEvents.Contains(runNo, lumiNo, eventNo)) passCut(ret, "Laser calibration correction filter");
 	}
 
         //======================================================
@@ -564,6 +533,9 @@ bool ChargedHiggsEventSelector::operator()( edm::EventBase const & event, pat::s
         // try to get earlier produced data (in a calc)
         //std::cout << "Must be 2.34: " << GetTestValue() << std::endl;
 
+        // JES factors of all jets evaluated together
+        CorrectJets(*mhJets, event);
+
         for (std::vector<pat::Jet>::const_iterator _ijet = mhJets->begin();
              _ijet != mhJets->end(); ++_ijet){
       
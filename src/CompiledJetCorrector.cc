@@ -0,0 +1,520 @@
+/*
+ Jet energy corrections with compiled JetCorrectorParameters levels
+ */
+
+
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+#include "CondFormats/JetMETObjects/interface/JetCorrectorParameters.h"
+#include "CondFormats/JetMETObjects/interface/SimpleJetCorrector.h"
+#include "LJMet/Com/interface/CompiledJetCorrector.h"
+
+
+
+namespace {
+
+    int const kMaxStack = 64;
+    int const kMaxVar = 4;
+
+    enum OpCode {
+        kConst, kPar, kVar,
+        kAdd, kSub, kMul, kDiv, kNeg, kNot,
+        kLT, kGT, kLE, kGE, kEQ, kNE, kAnd, kOr,
+        kPow, kMax, kMin,
+        kLog, kLog10, kExp, kSqrt, kAbs
+    };
+
+    // TMath::Max and TMath::Min, which differ from std:: for NaN
+    inline double tmathMax(double a, double b){ return a >= b ? a : b; }
+    inline double tmathMin(double a, double b){ return a <= b ? a : b; }
+
+
+
+    class Parser {
+        //
+        // recursive descent over the TFormula subset used in the
+        // correction files, emitting stack operations in evaluation order
+        //
+
+    public:
+
+        Parser(std::string const & text, std::vector<CompiledJetCorrector::Formula::Op> & ops):
+        mText(text), mPos(0), mOk(true), mvOp(ops){}
+
+        bool Parse(){
+            parseOr();
+            skip();
+            return mOk && mPos == mText.size();
+        }
+
+    private:
+
+        void emit(int code, int arg = 0, double value = 0.0){
+            CompiledJetCorrector::Formula::Op _op;
+            _op.code = code;
+            _op.arg = arg;
+            _op.value = value;
+            mvOp.push_back(_op);
+        }
+
+        void skip(){ while (mPos < mText.size() && std::isspace(static_cast<unsigned char>(mText[mPos]))) ++mPos; }
+
+        bool accept(char const * token){
+            skip();
+            size_t const _n = std::char_traits<char>::length(token);
+            if (mText.compare(mPos, _n, token) != 0) return false;
+            mPos += _n;
+            return true;
+        }
+
+        void expect(char const * token){ if (!accept(token)) mOk = false; }
+
+        void parseOr(){
+            parseAnd();
+            while (mOk && accept("||")){ parseAnd(); emit(kOr); }
+        }
+
+        void parseAnd(){
+            parseCompare();
+            while (mOk && accept("&&")){ parseCompare(); emit(kAnd); }
+        }
+
+        void parseCompare(){
+            parseSum();
+            while (mOk){
+                int _code;
+                if (accept("<="))      _code = kLE;
+                else if (accept(">=")) _code = kGE;
+                else if (accept("==")) _code = kEQ;
+                else if (accept("!=")) _code = kNE;
+                else if (accept("<"))  _code = kLT;
+                else if (accept(">"))  _code = kGT;
+                else break;
+                parseSum();
+                emit(_code);
+            }
+        }
+
+        void parseSum(){
+            parseProduct();
+            while (mOk){
+                if (accept("+"))      { parseProduct(); emit(kAdd); }
+                else if (accept("-")) { parseProduct(); emit(kSub); }
+                else break;
+            }
+        }
+
+        void parseProduct(){
+            parseUnary();
+            while (mOk){
+                if (accept("*"))      { parseUnary(); emit(kMul); }
+                else if (accept("/")) { parseUnary(); emit(kDiv); }
+                else break;
+            }
+        }
+
+        void parseUnary(){
+            if (accept("-"))      { parseUnary(); emit(kNeg); }
+            else if (accept("+")) { parseUnary(); }
+            else if (accept("!") ){ parseUnary(); emit(kNot); }
+            else parsePower();
+        }
+
+        void parsePower(){
+            parsePrimary();
+            if (mOk && accept("^")){ parseUnary(); emit(kPow); }
+        }
+
+        void parsePrimary(){
+            skip();
+            if (mPos >= mText.size()){ mOk = false; return; }
+            char const _c = mText[mPos];
+
+            if (_c == '('){
+                ++mPos;
+                parseOr();
+                expect(")");
+            }
+            else if (_c == '['){
+                ++mPos;
+                char * _end = 0;
+                long const _i = std::strtol(mText.c_str() + mPos, &_end, 10);
+                if (_end == mText.c_str() + mPos || _i < 0){ mOk = false; return; }
+                mPos = _end - mText.c_str();
+                expect("]");
+                emit(kPar, static_cast<int>(_i));
+            }
+            else if (std::isdigit(static_cast<unsigned char>(_c)) || _c == '.'){
+                char * _end = 0;
+                double const _v = std::strtod(mText.c_str() + mPos, &_end);
+                if (_end == mText.c_str() + mPos){ mOk = false; return; }
+                mPos = _end - mText.c_str();
+                emit(kConst, 0, _v);
+            }
+            else if (std::isalpha(static_cast<unsigned char>(_c))){
+                size_t const _start = mPos;
+                while (mPos < mText.size() && (std::isalnum(static_cast<unsigned char>(mText[mPos]))
+                                               || mText[mPos] == '_' || mText[mPos] == ':')) ++mPos;
+                std::string _name = mText.substr(_start, mPos - _start);
+                if (_name.compare(0, 7, "TMath::") == 0){
+                    _name = _name.substr(7);
+                    if (!_name.empty()) _name[0] = std::tolower(static_cast<unsigned char>(_name[0]));
+                    if (_name == "power") _name = "pow";
+                }
+                parseName(_name);
+            }
+            else mOk = false;
+        }
+
+        void parseName(std::string const & name){
+            if (name == "x"){ emit(kVar, 0); return; }
+            if (name == "y"){ emit(kVar, 1); return; }
+            if (name == "z"){ emit(kVar, 2); return; }
+            if (name == "t"){ emit(kVar, 3); return; }
+
+            int _code, _nArgs = 1;
+            if (name == "log")                       _code = kLog;
+            else if (name == "log10")                _code = kLog10;
+            else if (name == "exp")                  _code = kExp;
+            else if (name == "sqrt")                 _code = kSqrt;
+            else if (name == "abs" || name == "fabs") _code = kAbs;
+            else if (name == "pow")                  { _code = kPow; _nArgs = 2; }
+            else if (name == "max")                  { _code = kMax; _nArgs = 2; }
+            else if (name == "min")                  { _code = kMin; _nArgs = 2; }
+            else { mOk = false; return; }
+
+            expect("(");
+            for (int i = 0; mOk && i != _nArgs; ++i){
+                if (i) expect(",");
+                parseOr();
+            }
+            expect(")");
+            emit(_code);
+        }
+
+        std::string const & mText;
+        size_t mPos;
+        bool mOk;
+        std::vector<CompiledJetCorrector::Formula::Op> & mvOp;
+    };
+
+
+
+    //
+    // hand-written forms, the same operations in the same order as the strings
+    //
+
+    double constantForm(double const *, double const * p){
+        return p[0];
+    }
+
+    // standard L2Relative and L3Absolute
+    double standardForm(double const * x, double const * p){
+        double const _l = std::log10(x[0]);
+        return p[0]+(p[1]/(std::pow(_l,2.0)+p[2]))+(p[3]*std::exp(-(p[4]*((_l-p[5])*(_l-p[5])))))+(p[6]*std::exp(-(p[7]*((_l-p[8])*(_l-p[8])))));
+    }
+
+    // L1FastJet with x = Rho, y = JetPt, z = JetA
+    double l1FastJetForm(double const * x, double const * p){
+        return tmathMax(0.0001,1-(x[2]/x[1])*(p[0]+(p[1]*(x[0]-p[3]))*(1+p[2]*std::log(x[1]))));
+    }
+
+    // L1FastJet with x = JetA, y = Rho, z = JetPt
+    double l1FastJetOldForm(double const * x, double const * p){
+        return tmathMax(0.0001,1-x[1]*(p[0]+(p[1]*x[2])*(1+p[2]*std::log(x[0])))/x[0]);
+    }
+
+    struct KnownForm {
+        char const * formula;       // without spaces
+        CompiledJetCorrector::Formula::Kernel kernel;
+    };
+
+    KnownForm const kKnownForms[] = {
+        {"[0]", constantForm},
+        {"[0]+([1]/(pow(log10(x),2)+[2]))+([3]*exp(-([4]*((log10(x)-[5])*(log10(x)-[5])))))+([6]*exp(-([7]*((log10(x)-[8])*(log10(x)-[8])))))", standardForm},
+        {"max(0.0001,1-(z/y)*([0]+([1]*(x-[3]))*(1+[2]*log(y))))", l1FastJetForm},
+        {"max(0.0001,1-y*([0]+([1]*z)*(1+[2]*log(x)))/x)", l1FastJetOldForm}
+    };
+}
+
+
+
+bool CompiledJetCorrector::Formula::Compile(std::string const & formula){
+    mKernel = 0;
+    mvOp.clear();
+    mMaxDepth = 0;
+
+    Parser _parser(formula, mvOp);
+    if (!_parser.Parse()) return false;
+
+    // stack depth, and the parameters and variables used
+    int _depth = 0;
+    for (size_t i = 0; i != mvOp.size(); ++i){
+        int const _code = mvOp[i].code;
+        if (_code == kConst || _code == kPar || _code == kVar) ++_depth;
+        else if (_code >= kAdd && _code <= kMin && _code != kNeg && _code != kNot) --_depth;
+        mMaxDepth = std::max(mMaxDepth, _depth);
+    }
+    if (_depth != 1 || mMaxDepth > kMaxStack) return false;
+
+    std::string _compact;
+    for (size_t i = 0; i != formula.size(); ++i){
+        if (!std::isspace(static_cast<unsigned char>(formula[i]))) _compact += formula[i];
+    }
+    for (size_t i = 0; i != sizeof(kKnownForms)/sizeof(kKnownForms[0]); ++i){
+        if (_compact == kKnownForms[i].formula) mKernel = kKnownForms[i].kernel;
+    }
+
+    return true;
+}
+
+
+
+int CompiledJetCorrector::Formula::MaxParameter() const{
+    int _max = -1;
+    for (size_t i = 0; i != mvOp.size(); ++i){
+        if (mvOp[i].code == kPar) _max = std::max(_max, mvOp[i].arg);
+    }
+    return _max;
+}
+
+
+
+double CompiledJetCorrector::Formula::Eval(double const * x, double const * par) const{
+    if (mKernel) return mKernel(x, par);
+
+    double _stack[kMaxStack];
+    int _top = -1;
+    for (std::vector<Op>::const_iterator op = mvOp.begin(); op != mvOp.end(); ++op){
+        switch (op->code){
+        case kConst: _stack[++_top] = op->value; break;
+        case kPar:   _stack[++_top] = par[op->arg]; break;
+        case kVar:   _stack[++_top] = x[op->arg]; break;
+        case kNeg:   _stack[_top] = -_stack[_top]; break;
+        case kNot:   _stack[_top] = !_stack[_top]; break;
+        case kLog:   _stack[_top] = std::log(_stack[_top]); break;
+        case kLog10: _stack[_top] = std::log10(_stack[_top]); break;
+        case kExp:   _stack[_top] = std::exp(_stack[_top]); break;
+        case kSqrt:  _stack[_top] = std::sqrt(_stack[_top]); break;
+        case kAbs:   _stack[_top] = std::fabs(_stack[_top]); break;
+        default: {
+            double const _b = _stack[_top--];
+            double & _a = _stack[_top];
+            switch (op->code){
+            case kAdd: _a = _a + _b; break;
+            case kSub: _a = _a - _b; break;
+            case kMul: _a = _a * _b; break;
+            case kDiv: _a = _a / _b; break;
+            case kLT:  _a = _a < _b; break;
+            case kGT:  _a = _a > _b; break;
+            case kLE:  _a = _a <= _b; break;
+            case kGE:  _a = _a >= _b; break;
+            case kEQ:  _a = _a == _b; break;
+            case kNE:  _a = _a != _b; break;
+            case kAnd: _a = _a && _b; break;
+            case kOr:  _a = _a || _b; break;
+            case kPow: _a = _b == 2.0 ? _a*_a : std::pow(_a, _b); break;  // as the kernels are compiled
+            case kMax: _a = tmathMax(_a, _b); break;
+            case kMin: _a = tmathMin(_a, _b); break;
+            }
+        }
+        }
+    }
+    return _stack[0];
+}
+
+
+
+CompiledJetCorrector::CompiledJetCorrector(std::vector<JetCorrectorParameters> const & levels):
+mValid(true){
+
+    mvLevel.resize(levels.size());
+    for (size_t l = 0; l != levels.size() && mValid; ++l){
+        JetCorrectorParameters const & _par = levels[l];
+        JetCorrectorParameters::Definitions const & _def = _par.definitions();
+        Level & _level = mvLevel[l];
+        _level.pGeneric = 0;
+
+        // variables, as FactorizedJetCorrector names them
+        for (unsigned i = 0; i != _def.nBinVar() + _def.nParVar(); ++i){
+            bool const _isBin = i < _def.nBinVar();
+            std::string const _name = _isBin ? _def.binVar(i) : _def.parVar(i - _def.nBinVar());
+            int _var;
+            if (_name == "JetEta")   _var = kJetEta;
+            else if (_name == "JetPt") _var = kJetPt;
+            else if (_name == "JetA")  _var = kJetA;
+            else if (_name == "Rho")   _var = kRho;
+            else {
+                mValid = false;
+                mError = "level " + _def.level() + " uses unsupported variable " + _name;
+                break;
+            }
+            (_isBin ? _level.vBinVar : _level.vParVar).push_back(_var);
+        }
+        if (!mValid) break;
+        if (_level.vParVar.size() > static_cast<size_t>(kMaxVar)){
+            mValid = false;
+            mError = "level " + _def.level() + " has more than 4 formula variables";
+            break;
+        }
+
+        // flat bin and parameter tables
+        size_t const _nBinVar = _level.vBinVar.size();
+        size_t const _nParVar = _level.vParVar.size();
+        _level.nBins = _par.size();
+        _level.vParStart.push_back(0);
+        bool _rangesOk = true;
+        for (unsigned b = 0; b != _par.size(); ++b){
+            JetCorrectorParameters::Record const & _record = _par.record(b);
+            for (size_t j = 0; j != _nBinVar; ++j){
+                _level.vXMin.push_back(_record.xMin(j));
+                _level.vXMax.push_back(_record.xMax(j));
+            }
+            std::vector<float> const & _p = _record.parameters();
+            if (_p.size() < 2*_nParVar) _rangesOk = false;
+            for (size_t j = 0; j != 2*_nParVar; ++j) _level.vRange.push_back(j < _p.size() ? _p[j] : 0.0f);
+            for (size_t j = 2*_nParVar; j < _p.size(); ++j) _level.vPar.push_back(_p[j]);
+            _level.vParStart.push_back(_level.vPar.size());
+        }
+
+        // one bin variable with ordered, disjoint bins: the first match of
+        // a linear search is the only one, so it can be found by bisection
+        _level.sorted = (_nBinVar == 1);
+        for (size_t b = 1; _level.sorted && b < _level.nBins; ++b){
+            if (!(_level.vXMin[b-1] < _level.vXMin[b]) || _level.vXMax[b-1] > _level.vXMin[b]) _level.sorted = false;
+        }
+
+        // response functions need inverting, left to SimpleJetCorrector
+        _level.compiled = !_def.isResponse() && _rangesOk && _level.formula.Compile(_def.formula());
+        for (size_t b = 0; _level.compiled && b < _level.nBins; ++b){
+            if (static_cast<size_t>(_level.formula.MaxParameter() + 1) > _level.vParStart[b+1] - _level.vParStart[b]) _level.compiled = false;
+        }
+        if (!_level.compiled) _level.pGeneric = new SimpleJetCorrector(_par);
+    }
+
+    if (!mValid){
+        for (size_t l = 0; l != mvLevel.size(); ++l) delete mvLevel[l].pGeneric;
+        mvLevel.clear();
+    }
+}
+
+
+
+CompiledJetCorrector::~CompiledJetCorrector(){
+    for (size_t l = 0; l != mvLevel.size(); ++l) delete mvLevel[l].pGeneric;
+}
+
+
+
+size_t CompiledJetCorrector::GetNCompiledLevels() const{
+    size_t _n = 0;
+    for (size_t l = 0; l != mvLevel.size(); ++l) if (mvLevel[l].compiled) ++_n;
+    return _n;
+}
+
+
+
+int CompiledJetCorrector::findBin(Level const & level, float const * x) const{
+    size_t const _nBinVar = level.vBinVar.size();
+
+    if (level.sorted){
+        float const _x = x[level.vBinVar[0]];
+        // last bin starting at or below x
+        std::vector<float>::const_iterator it = std::upper_bound(level.vXMin.begin(), level.vXMin.end(), _x);
+        if (it == level.vXMin.begin()) return -1;
+        size_t const _b = (it - level.vXMin.begin()) - 1;
+        return (_x >= level.vXMin[_b] && _x < level.vXMax[_b]) ? static_cast<int>(_b) : -1;
+    }
+
+    // as JetCorrectorParameters::binIndex
+    for (size_t b = 0; b != level.nBins; ++b){
+        size_t j = 0;
+        for (; j != _nBinVar; ++j){
+            float const _x = x[level.vBinVar[j]];
+            if (!(_x >= level.vXMin[b*_nBinVar + j] && _x < level.vXMax[b*_nBinVar + j])) break;
+        }
+        if (j == _nBinVar) return static_cast<int>(b);
+    }
+    return -1;
+}
+
+
+
+float CompiledJetCorrector::evalLevel(Level const & level, float const * vars) const{
+    //
+    // SimpleJetCorrector::correction for one level
+    //
+
+    if (!level.compiled){
+        std::vector<float> _vx, _vy;
+        for (size_t j = 0; j != level.vBinVar.size(); ++j) _vx.push_back(vars[level.vBinVar[j]]);
+        for (size_t j = 0; j != level.vParVar.size(); ++j) _vy.push_back(vars[level.vParVar[j]]);
+        return level.pGeneric->correction(_vx, _vy);
+    }
+
+    int const _bin = findBin(level, vars);
+    if (_bin < 0) return 1.0f;
+
+    // variables clamped to the ranges of the bin, in float
+    double _xx[kMaxVar] = {0.0, 0.0, 0.0, 0.0};
+    size_t const _nParVar = level.vParVar.size();
+    float const * _range = &level.vRange[0] + 2*_nParVar*_bin;
+    for (size_t i = 0; i != _nParVar; ++i){
+        _xx[i] = std::min(_range[2*i+1], std::max(_range[2*i], vars[level.vParVar[i]]));
+    }
+
+    double const * _p = level.vPar.empty() ? 0 : &level.vPar[0] + level.vParStart[_bin];
+    return static_cast<float>(level.formula.Eval(_xx, _p));
+}
+
+
+
+float CompiledJetCorrector::GetCorrection(float eta, float pt, float area, float rho) const{
+    //
+    // as FactorizedJetCorrector: every level sees the pt corrected by the previous ones
+    //
+
+    float _vars[4];
+    _vars[kJetEta] = eta;
+    _vars[kJetPt] = pt;
+    _vars[kJetA] = area;
+    _vars[kRho] = rho;
+
+    float _scale = 1.0f;
+    for (size_t l = 0; l != mvLevel.size(); ++l){
+        float const _factor = evalLevel(mvLevel[l], _vars);
+        _scale *= _factor;
+        _vars[kJetPt] *= _factor;
+    }
+    return _scale;
+}
+
+
+
+void CompiledJetCorrector::GetCorrections(size_t n, float const * eta, float const * pt, float const * area,
+                                          float rho, float * corrections) const{
+    //
+    // level by level over all jets, the tables of a level stay in cache
+    //
+
+    std::vector<float> _pt(pt, pt + n);
+    std::fill(corrections, corrections + n, 1.0f);
+
+    float _vars[4];
+    _vars[kRho] = rho;
+    for (size_t l = 0; l != mvLevel.size(); ++l){
+        Level const & _level = mvLevel[l];
+        for (size_t i = 0; i != n; ++i){
+            _vars[kJetEta] = eta[i];
+            _vars[kJetPt] = _pt[i];
+            _vars[kJetA] = area[i];
+            float const _factor = evalLevel(_level, _vars);
+            corrections[i] *= _factor;
+            _pt[i] *= _factor;
+        }
+    }
+}
@@ -0,0 +1,496 @@
+/*
+ Binary cache of parsed conditions payloads
+ */
+
+
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "TFile.h"
+#include "TH1D.h"
+
+#include "CondFormats/JetMETObjects/interface/JetCorrectorParameters.h"
+#include "LJMet/Com/interface/ConditionsCache.h"
+
+
+
+namespace {
+
+    char const kMagic[8] = {'L', 'J', 'M', 'C', 'O', 'N', 'D', '\0'};
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t kind;
+        uint64_t sourceSize;
+        int64_t sourceMtime;
+        uint64_t payloadSize;
+        uint64_t checksum;      // of the payload
+        uint32_t keySize;       // source path and tag, stored after the header
+        uint32_t reserved;
+    };
+
+    size_t align8(size_t n){ return (n + 7) & ~size_t(7); }
+
+    uint64_t fnv1a(char const * data, size_t size, uint64_t hash = 14695981039346656037ULL){
+        for (size_t i = 0; i != size; ++i){
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    std::string absolutePath(std::string const & path){
+        char * _real = realpath(path.c_str(), 0);
+        if (!_real) return path;
+        std::string _path(_real);
+        free(_real);
+        return _path;
+    }
+
+    std::string cacheKey(std::string const & source, std::string const & tag){
+        return absolutePath(source) + '\n' + tag;
+    }
+
+
+
+    //
+    // payload serialisation, every block padded to 8 bytes
+    //
+    template <class T>
+    void append(std::vector<char> & out, T const * data, size_t n){
+        size_t const _offset = out.size();
+        out.resize(align8(_offset + n*sizeof(T)), 0);
+        if (n) std::memcpy(&out[_offset], data, n*sizeof(T));
+    }
+
+    template <class T>
+    void append(std::vector<char> & out, T value){ append(out, &value, 1); }
+
+    class Reader {
+    public:
+        Reader(char const * data, size_t size): mpData(data), mSize(size), mOffset(0), mOk(true){}
+
+        template <class T>
+        T const * Get(size_t n){
+            if (!mOk || n > mSize){ mOk = false; return 0; }
+            size_t const _bytes = align8(n*sizeof(T));
+            if (mSize - mOffset < _bytes){ mOk = false; return 0; }
+            T const * _p = reinterpret_cast<T const *>(mpData + mOffset);
+            mOffset += _bytes;
+            return _p;
+        }
+
+        template <class T>
+        T Value(){ T const * _p = Get<T>(1); return _p ? *_p : T(); }
+
+        bool IsOk() const { return mOk && mOffset == mSize; }
+
+    private:
+        char const * mpData;
+        size_t mSize;
+        size_t mOffset;
+        bool mOk;
+    };
+
+
+
+    //
+    // JetCorrectorParameters: definitions line, bin bounds and parameters
+    //
+    bool plainToken(std::string const & s){
+        if (s.empty()) return false;
+        for (size_t i = 0; i != s.size(); ++i) if (std::isspace(static_cast<unsigned char>(s[i])) || s[i] == '{' || s[i] == '}') return false;
+        return true;
+    }
+
+    bool encodeJec(JetCorrectorParameters const & par, std::vector<char> & out){
+        JetCorrectorParameters::Definitions const & _def = par.definitions();
+        std::ostringstream _line;
+        _line << _def.nBinVar();
+        for (unsigned i = 0; i != _def.nBinVar(); ++i) _line << ' ' << _def.binVar(i);
+        _line << ' ' << _def.nParVar();
+        for (unsigned i = 0; i != _def.nParVar(); ++i) _line << ' ' << _def.parVar(i);
+        _line << ' ' << _def.formula() << ' ' << (_def.isResponse() ? "Response" : "Correction") << ' ' << _def.level();
+
+        // the definitions are rebuilt from this line, so every field must be one token
+        bool _plain = plainToken(_def.formula()) && plainToken(_def.level());
+        for (unsigned i = 0; i != _def.nBinVar(); ++i) _plain = _plain && plainToken(_def.binVar(i));
+        for (unsigned i = 0; i != _def.nParVar(); ++i) _plain = _plain && plainToken(_def.parVar(i));
+        if (!_plain) return false;
+
+        std::string const _text = _line.str();
+        uint32_t const _nVar = _def.nBinVar();
+        uint32_t const _nRec = par.size();
+        std::vector<uint32_t> _start(1, 0);
+        std::vector<float> _min, _max, _par;
+        for (unsigned i = 0; i != _nRec; ++i){
+            JetCorrectorParameters::Record const & _rec = par.record(i);
+            for (unsigned j = 0; j != _nVar; ++j){
+                _min.push_back(_rec.xMin(j));
+                _max.push_back(_rec.xMax(j));
+            }
+            _par.insert(_par.end(), _rec.parameters().begin(), _rec.parameters().end());
+            _start.push_back(_par.size());
+        }
+
+        out.clear();
+        append(out, _nVar);
+        append(out, _nRec);
+        append(out, uint32_t(_text.size()));
+        append(out, _text.data(), _text.size());
+        append(out, &_start[0], _start.size());
+        append(out, _min.empty() ? 0 : &_min[0], _min.size());
+        append(out, _max.empty() ? 0 : &_max[0], _max.size());
+        append(out, _par.empty() ? 0 : &_par[0], _par.size());
+        return true;
+    }
+
+    bool decodeJec(char const * data, size_t size, JetCorrectorParameters & par){
+        Reader _in(data, size);
+        uint32_t const _nVar = _in.Value<uint32_t>();
+        uint32_t const _nRec = _in.Value<uint32_t>();
+        uint32_t const _textSize = _in.Value<uint32_t>();
+        char const * _text = _in.Get<char>(_textSize);
+        uint32_t const * _start = _in.Get<uint32_t>(_nRec + 1);
+        float const * _min = _in.Get<float>(size_t(_nRec)*_nVar);
+        float const * _max = _in.Get<float>(size_t(_nRec)*_nVar);
+        float const * _par = _start ? _in.Get<float>(_start[_nRec]) : 0;
+        if (!_in.IsOk()) return false;
+
+        std::vector<JetCorrectorParameters::Record> _records;
+        _records.reserve(_nRec);
+        for (uint32_t i = 0; i != _nRec; ++i){
+            if (_start[i] > _start[i+1]) return false;
+            std::vector<float> _recMin(_min + i*_nVar, _min + (i+1)*_nVar);
+            std::vector<float> _recMax(_max + i*_nVar, _max + (i+1)*_nVar);
+            std::vector<float> _recPar(_par + _start[i], _par + _start[i+1]);
+            _records.push_back(JetCorrectorParameters::Record(_nVar, _recMin, _recMax, _recPar));
+        }
+        JetCorrectorParameters::Definitions const _def(std::string(_text, _textSize));
+        par = JetCorrectorParameters(_def, _records);
+        return true;
+    }
+
+
+
+    //
+    // event list: sorted (run, lumi, event) triplets
+    //
+    bool entryLess(ConditionsCache::EventList::Entry const & a, ConditionsCache::EventList::Entry const & b){
+        if (a.run != b.run) return a.run < b.run;
+        if (a.lumi != b.lumi) return a.lumi < b.lumi;
+        return a.event < b.event;
+    }
+
+    bool entryEqual(ConditionsCache::EventList::Entry const & a, ConditionsCache::EventList::Entry const & b){
+        return a.run == b.run && a.lumi == b.lumi && a.event == b.event;
+    }
+
+    bool parseEventList(std::string const & file, std::vector<char> & out){
+        std::ifstream _in(file.c_str());
+        if (!_in) return false;
+
+        std::vector<ConditionsCache::EventList::Entry> _entries;
+        std::string _line;
+        while (std::getline(_in, _line)){
+            size_t const _c1 = _line.find(':');
+            if (_c1 == std::string::npos) continue;
+            size_t const _c2 = _line.find(':', _c1 + 1);
+            if (_c2 == std::string::npos) continue;
+            ConditionsCache::EventList::Entry _entry;
+            _entry.run = std::atoi(_line.substr(0, _c1).c_str());
+            _entry.lumi = std::atoi(_line.substr(_c1 + 1, _c2 - _c1 - 1).c_str());
+            _entry.event = std::atoi(_line.substr(_c2 + 1).c_str());
+            _entries.push_back(_entry);
+        }
+        std::sort(_entries.begin(), _entries.end(), entryLess);
+        _entries.erase(std::unique(_entries.begin(), _entries.end(), entryEqual), _entries.end());
+
+        out.clear();
+        append(out, uint64_t(_entries.size()));
+        append(out, _entries.empty() ? 0 : &_entries[0], _entries.size());
+        return true;
+    }
+
+    bool decodeEventList(char const * data, size_t size,
+                         ConditionsCache::EventList::Entry const * & begin,
+                         ConditionsCache::EventList::Entry const * & end){
+        Reader _in(data, size);
+        uint64_t const _n = _in.Value<uint64_t>();
+        begin = _in.Get<ConditionsCache::EventList::Entry>(_n);
+        if (!_in.IsOk()) return false;
+        end = begin + _n;
+        return true;
+    }
+
+
+
+    //
+    // 1D histogram: binning, contents and sum of squared weights with under/overflow
+    //
+    bool readHistogram(std::string const & file, std::string const & name, std::vector<char> & out){
+        TFile _file(file.c_str(), "READ");
+        if (!_file.IsOpen()) return false;
+        TH1 const * _hist = dynamic_cast<TH1 const *>(_file.Get(name.c_str()));
+        if (!_hist || _hist->GetDimension() != 1) return false;
+
+        uint32_t const _nBins = _hist->GetNbinsX();
+        uint32_t const _variable = _hist->GetXaxis()->IsVariableBinSize();
+        std::string const _title = _hist->GetTitle();
+        std::vector<double> _edges(_nBins + 1), _content(_nBins + 2), _sumw2;
+        for (uint32_t i = 0; i != _nBins + 1; ++i) _edges[i] = _hist->GetXaxis()->GetBinLowEdge(i + 1);
+        for (uint32_t i = 0; i != _nBins + 2; ++i) _content[i] = _hist->GetBinContent(i);
+        if (_hist->GetSumw2N()){
+            _sumw2.assign(_hist->GetSumw2()->GetArray(), _hist->GetSumw2()->GetArray() + _nBins + 2);
+        }
+
+        out.clear();
+        append(out, _nBins);
+        append(out, _variable);
+        append(out, uint32_t(_sumw2.size()));
+        append(out, uint32_t(_title.size()));
+        append(out, _title.data(), _title.size());
+        append(out, _hist->GetEntries());
+        append(out, &_edges[0], _edges.size());
+        append(out, &_content[0], _content.size());
+        append(out, _sumw2.empty() ? 0 : &_sumw2[0], _sumw2.size());
+        return true;
+    }
+
+    TH1D * decodeHistogram(char const * data, size_t size, std::string const & name){
+        Reader _in(data, size);
+        uint32_t const _nBins = _in.Value<uint32_t>();
+        uint32_t const _variable = _in.Value<uint32_t>();
+        uint32_t const _nSumw2 = _in.Value<uint32_t>();
+        uint32_t const _titleSize = _in.Value<uint32_t>();
+        char const * _title = _in.Get<char>(_titleSize);
+        double const _entries = _in.Value<double>();
+        double const * _edges = _in.Get<double>(_nBins + 1);
+        double const * _content = _in.Get<double>(_nBins + 2);
+        double const * _sumw2 = _in.Get<double>(_nSumw2);
+        if (!_in.IsOk() || _nBins == 0 || (_nSumw2 && _nSumw2 != _nBins + 2)) return 0;
+
+        bool const _addDirectory = TH1::AddDirectoryStatus();
+        TH1::AddDirectory(kFALSE);
+        std::string const _titleString(_title, _titleSize);
+        TH1D * _hist = _variable ?
+            new TH1D(name.c_str(), _titleString.c_str(), _nBins, _edges) :
+            new TH1D(name.c_str(), _titleString.c_str(), _nBins, _edges[0], _edges[_nBins]);
+        TH1::AddDirectory(_addDirectory);
+
+        for (uint32_t i = 0; i != _nBins + 2; ++i) _hist->SetBinContent(i, _content[i]);
+        if (_nSumw2){
+            _hist->Sumw2();
+            std::copy(_sumw2, _sumw2 + _nSumw2, _hist->GetSumw2()->GetArray());
+        }
+        _hist->SetEntries(_entries);
+        return _hist;
+    }
+}
+
+
+
+struct ConditionsCache::Mapping::Region {
+    Region(): base(0), length(0), data(0), size(0){}
+    ~Region(){ if (base) munmap(base, length); }
+
+    void * base;
+    size_t length;
+    std::vector<char> buffer;   // payload not backed by a cache file
+    char const * data;
+    size_t size;
+};
+
+
+
+char const * ConditionsCache::Mapping::GetData() const {
+    return mpRegion ? mpRegion->data : 0;
+}
+
+
+
+size_t ConditionsCache::Mapping::GetSize() const {
+    return mpRegion ? mpRegion->size : 0;
+}
+
+
+
+bool ConditionsCache::EventList::Contains(int run, int lumi, int event) const {
+    Entry const _entry = {run, lumi, event};
+    return std::binary_search(mpBegin, mpEnd, _entry, entryLess);
+}
+
+
+
+void ConditionsCache::SetDirectory(std::string const & directory){
+    mDirectory = directory;
+    if (mDirectory.empty()) return;
+    if (mkdir(mDirectory.c_str(), 0775) != 0 && errno != EEXIST){
+        std::cout << "[ConditionsCache]: cannot create " << mDirectory << ", not caching conditions" << std::endl;
+        mDirectory.clear();
+    }
+}
+
+
+
+std::string ConditionsCache::cachePath(std::string const & source, std::string const & tag, Kind kind) const {
+    std::string const _key = cacheKey(source, tag);
+    uint32_t const _kind = kind;
+    uint64_t const _hash = fnv1a(reinterpret_cast<char const *>(&_kind), sizeof(_kind), fnv1a(_key.data(), _key.size()));
+
+    size_t const _slash = source.find_last_of('/');
+    std::string const _base = _slash == std::string::npos ? source : source.substr(_slash + 1);
+    char _hex[17];
+    std::snprintf(_hex, sizeof(_hex), "%016llx", static_cast<unsigned long long>(_hash));
+    return mDirectory + "/" + _base + "-" + _hex + ".ljc";
+}
+
+
+
+ConditionsCache::Mapping ConditionsCache::Open(std::string const & source, std::string const & tag, Kind kind) const {
+    Mapping _mapping;
+    if (!IsEnabled()) return _mapping;
+
+    struct stat _source;
+    if (stat(source.c_str(), &_source) != 0) return _mapping;
+
+    int const _fd = open(cachePath(source, tag, kind).c_str(), O_RDONLY);
+    if (_fd < 0) return _mapping;
+    struct stat _file;
+    if (fstat(_fd, &_file) != 0 || size_t(_file.st_size) < sizeof(Header)){
+        close(_fd);
+        return _mapping;
+    }
+    void * const _base = mmap(0, _file.st_size, PROT_READ, MAP_SHARED, _fd, 0);
+    close(_fd);
+    if (_base == MAP_FAILED) return _mapping;
+
+    std::shared_ptr<Mapping::Region> _region(new Mapping::Region);
+    _region->base = _base;
+    _region->length = _file.st_size;
+
+    // anything unexpected means the file is rebuilt from the source
+    Header const & _header = *static_cast<Header const *>(_base);
+    std::string const _key = cacheKey(source, tag);
+    size_t const _offset = align8(sizeof(Header) + _header.keySize);
+    if (std::memcmp(_header.magic, kMagic, sizeof(kMagic)) != 0) return _mapping;
+    if (_header.version != kFormatVersion || _header.kind != uint32_t(kind)) return _mapping;
+    if (_header.sourceSize != uint64_t(_source.st_size) || _header.sourceMtime != int64_t(_source.st_mtime)) return _mapping;
+    if (_header.keySize != _key.size() || _offset + _header.payloadSize != size_t(_file.st_size)) return _mapping;
+
+    char const * const _bytes = static_cast<char const *>(_base);
+    if (std::memcmp(_bytes + sizeof(Header), _key.data(), _key.size()) != 0) return _mapping;
+    // size and mtime of the source vouch for the payload, the full pass over it is on demand
+    if (mbVerify && fnv1a(_bytes + _offset, _header.payloadSize) != _header.checksum) return _mapping;
+
+    _region->data = _bytes + _offset;
+    _region->size = _header.payloadSize;
+    _mapping.mpRegion = _region;
+    return _mapping;
+}
+
+
+
+bool ConditionsCache::Store(std::string const & source, std::string const & tag, Kind kind, std::vector<char> const & payload) const {
+    if (!IsEnabled()) return false;
+
+    struct stat _source;
+    if (stat(source.c_str(), &_source) != 0) return false;
+
+    std::string const _key = cacheKey(source, tag);
+    Header _header;
+    std::memset(&_header, 0, sizeof(_header));
+    std::memcpy(_header.magic, kMagic, sizeof(kMagic));
+    _header.version = kFormatVersion;
+    _header.kind = kind;
+    _header.sourceSize = _source.st_size;
+    _header.sourceMtime = _source.st_mtime;
+    _header.payloadSize = payload.size();
+    _header.checksum = fnv1a(payload.empty() ? 0 : &payload[0], payload.size());
+    _header.keySize = _key.size();
+
+    std::vector<char> _prefix(align8(sizeof(Header) + _key.size()), 0);
+    std::memcpy(&_prefix[0], &_header, sizeof(Header));
+    std::memcpy(&_prefix[sizeof(Header)], _key.data(), _key.size());
+
+    // written under a name of its own, then renamed over the cache file in one step
+    std::string const _path = cachePath(source, tag, kind);
+    std::ostringstream _tmp;
+    _tmp << _path << ".tmp." << getpid();
+    FILE * _out = std::fopen(_tmp.str().c_str(), "wb");
+    if (!_out) return false;
+    bool _ok = std::fwrite(&_prefix[0], 1, _prefix.size(), _out) == _prefix.size();
+    if (_ok && !payload.empty()) _ok = std::fwrite(&payload[0], 1, payload.size(), _out) == payload.size();
+    _ok = std::fclose(_out) == 0 && _ok;
+    if (_ok) _ok = std::rename(_tmp.str().c_str(), _path.c_str()) == 0;
+    if (!_ok) std::remove(_tmp.str().c_str());
+    return _ok;
+}
+
+
+
+JetCorrectorParameters ConditionsCache::GetJetCorrectorParameters(std::string const & file, std::string const & section) const {
+    Mapping const _cached = Open(file, section, kJetCorrectorParameters);
+    if (_cached.IsValid()){
+        JetCorrectorParameters _par;
+        if (decodeJec(_cached.GetData(), _cached.GetSize(), _par)) return _par;
+    }
+
+    JetCorrectorParameters const _par(file, section);
+    std::vector<char> _payload;
+    if (IsEnabled() && encodeJec(_par, _payload)) Store(file, section, kJetCorrectorParameters, _payload);
+    return _par;
+}
+
+
+
+ConditionsCache::EventList ConditionsCache::GetEventList(std::string const & file) const {
+    EventList _list;
+    _list.mMapping = Open(file, "", kEventList);
+    if (_list.mMapping.IsValid() &&
+        decodeEventList(_list.mMapping.GetData(), _list.mMapping.GetSize(), _list.mpBegin, _list.mpEnd)) return _list;
+
+    std::shared_ptr<Mapping::Region> _region(new Mapping::Region);
+    if (!parseEventList(file, _region->buffer)){
+        std::cout << "[ConditionsCache]: cannot read event list " << file << std::endl;
+        return EventList();
+    }
+    Store(file, "", kEventList, _region->buffer);
+
+    // kept in memory, shared by copies of the list like a mapped file
+    _region->data = &_region->buffer[0];
+    _region->size = _region->buffer.size();
+    _list.mMapping.mpRegion = _region;
+    decodeEventList(_list.mMapping.GetData(), _list.mMapping.GetSize(), _list.mpBegin, _list.mpEnd);
+    return _list;
+}
+
+
+
+TH1D * ConditionsCache::GetHistogram(std::string const & file, std::string const & name) const {
+    Mapping const _cached = Open(file, name, kHistogram);
+    if (_cached.IsValid()){
+        TH1D * _hist = decodeHistogram(_cached.GetData(), _cached.GetSize(), name);
+        if (_hist) return _hist;
+    }
+
+    std::vector<char> _payload;
+    if (!readHistogram(file, name, _payload)) return 0;
+    Store(file, name, kHistogram, _payload);
+    return decodeHistogram(&_payload[0], _payload.size(), name);
+}
@@ -10,6 +10,7 @@
 #include "LJMet/Com/interface/BaseCalc.h"
 #include "LJMet/Com/interface/LjmetFactory.h"
 #include "LJMet/Com/interface/LjmetEventContent.h"
+#include "LJMet/Com/interface/EtaPhiIndex.h"
 
 #include "EgammaAnalysis/ElectronTools/interface/ElectronEffectiveArea.h"
 #include "LJMet/Com/interface/TopElectronSelector.h"
@@ -31,6 +32,7 @@ public:
     virtual int BeginJob();
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
     virtual int EndJob(){return 0;}
+    virtual bool HasSideEffects() const { return false; }
     
 private:
     
@@ -48,13 +50,18 @@ private:
     boost::shared_ptr<TopElectronSelector>     electronSelL_, electronSelM_, electronSelT_;
     std::vector<reco::Vertex> goodPVs;
     int findMatch(const reco::GenParticleCollection & genParticles, int idToMatch, double eta, double phi);
+    // eta-phi index of the gen particles, built on the first match in an event
+    EtaPhiIndex genEtaPhi;
+    reco::GenParticleCollection const * genEtaPhiSource;
     double mdeltaR(double eta1, double phi1, double eta2, double phi2);
-    void fillMotherInfo(const reco::Candidate *mother, int i, vector <int> & momid, vector <int> & momstatus, vector<double> & mompt, vector<double> & mometa, vector<double> & momphi, vector<double> & momenergy);
+    /// Up to 11 generations of first mothers of the gen particle iGen
+    void fillMotherInfo(GenEventIndex const & genIndex, int iGen, ArenaVector<int> & momid, ArenaVector<int> & momstatus, ArenaVector<double> & mompt, ArenaVector<double> & mometa, ArenaVector<double> & momphi, ArenaVector<double> & momenergy);
 };
 
 static int reg = LjmetFactory::GetInstance()->Register(new DileptonCalc(), "DileptonCalc");
 
-DileptonCalc::DileptonCalc()
+DileptonCalc::DileptonCalc():
+genEtaPhiSource(0)
 {
 }
 
@@ -118,6 +125,11 @@ int DileptonCalc::BeginJob()
 
 int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector)
 {
+    // output vectors live in the event scratch memory
+    EventArena & arena = GetArena();
+    
+    genEtaPhiSource = 0;
+    
     //
     // compute event variables here
     //
@@ -183,61 +195,61 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
     //
     
     //Four vector
-    std::vector <double> elPt;
-    std::vector <double> elEta;
-    std::vector <double> elPhi;
-    std::vector <double> elEnergy;
+    ArenaVector<double> elPt(arena);
+    ArenaVector<double> elEta(arena);
+    ArenaVector<double> elPhi(arena);
+    ArenaVector<double> elEnergy(arena);
     
     //Quality criteria
-    std::vector <double> elRelIso;
-    std::vector <double> elDxy;
-    std::vector <int>    elNotConversion;
-    std::vector <int>    elChargeConsistent;
-    std::vector <int>    elIsEBEE;
-    std::vector <int>    elQuality;
-    std::vector <int>    elCharge;
+    ArenaVector<double> elRelIso(arena);
+    ArenaVector<double> elDxy(arena);
+    ArenaVector<int>    elNotConversion(arena);
+    ArenaVector<int>    elChargeConsistent(arena);
+    ArenaVector<int>    elIsEBEE(arena);
+    ArenaVector<int>    elQuality(arena);
+    ArenaVector<int>    elCharge(arena);
     
     //ID requirement
-    std::vector <double> elDeta;
-    std::vector <double> elDphi;
-    std::vector <double> elSihih;
-    std::vector <double> elHoE;
-    std::vector <double> elD0;
-    std::vector <double> elDZ;
-    std::vector <double> elOoemoop;
-    std::vector <int>    elMHits;
-    std::vector <int>    elVtxFitConv;
+    ArenaVector<double> elDeta(arena);
+    ArenaVector<double> elDphi(arena);
+    ArenaVector<double> elSihih(arena);
+    ArenaVector<double> elHoE(arena);
+    ArenaVector<double> elD0(arena);
+    ArenaVector<double> elDZ(arena);
+    ArenaVector<double> elOoemoop(arena);
+    ArenaVector<int>    elMHits(arena);
+    ArenaVector<int>    elVtxFitConv(arena);
 
     //added CMSDAS variables
-    std::vector <double> diElMass;
-    std::vector <int> elCharge1;
-    std::vector <int> elCharge2;
+    ArenaVector<double> diElMass(arena);
+    ArenaVector<int> elCharge1(arena);
+    ArenaVector<int> elCharge2(arena);
 
     //Extra info about isolation
-    std::vector <double> elChIso;
-    std::vector <double> elNhIso;
-    std::vector <double> elPhIso;
-    std::vector <double> elAEff;
-    std::vector <double> elRhoIso;
+    ArenaVector<double> elChIso(arena);
+    ArenaVector<double> elNhIso(arena);
+    ArenaVector<double> elPhIso(arena);
+    ArenaVector<double> elAEff(arena);
+    ArenaVector<double> elRhoIso(arena);
     
     //mother-information
     //Generator level information -- MC matching
-    vector<double> elGen_Reco_dr;
-    vector<int> elPdgId;
-    vector<int> elStatus;
-    vector<int> elMatched;
-    vector<int> elNumberOfMothers;
-    vector<double> elMother_pt;
-    vector<double> elMother_eta;
-    vector<double> elMother_phi;
-    vector<double> elMother_energy;
-    vector<int> elMother_id;
-    vector<int> elMother_status;
+    ArenaVector<double> elGen_Reco_dr(arena);
+    ArenaVector<int> elPdgId(arena);
+    ArenaVector<int> elStatus(arena);
+    ArenaVector<int> elMatched(arena);
+    ArenaVector<int> elNumberOfMothers(arena);
+    ArenaVector<double> elMother_pt(arena);
+    ArenaVector<double> elMother_eta(arena);
+    ArenaVector<double> elMother_phi(arena);
+    ArenaVector<double> elMother_energy(arena);
+    ArenaVector<int> elMother_id(arena);
+    ArenaVector<int> elMother_status(arena);
     //Matched gen electron information:
-    vector<double> elMatchedPt;
-    vector<double> elMatchedEta;
-    vector<double> elMatchedPhi;
-    vector<double> elMatchedEnergy;
+    ArenaVector<double> elMatchedPt(arena);
+    ArenaVector<double> elMatchedEta(arena);
+    ArenaVector<double> elMatchedPhi(arena);
+    ArenaVector<double> elMatchedEnergy(arena);
     
     edm::Handle<double> rhoHandle;
     event.getByLabel(rhoSrc_it, rhoHandle);
@@ -346,7 +358,7 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
                         elMatchedPhi.push_back(p.phi());
                         elMatchedEnergy.push_back(p.energy());
                         int oldSize = elMother_id.size();
-                        fillMotherInfo(p.mother(), 0, elMother_id, elMother_status, elMother_pt, elMother_eta, elMother_phi, elMother_energy);
+                        fillMotherInfo(selector->GetGenEventIndex(event, genParticles_it), matchId, elMother_id, elMother_status, elMother_pt, elMother_eta, elMother_phi, elMother_energy);
                         elNumberOfMothers.push_back(elMother_id.size()-oldSize);
                     }
                 }
@@ -429,53 +441,53 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
     //_____ Muons _____________________________
     //
     
-    std::vector <int> muCharge;
-    std::vector <int> muGlobal;
+    ArenaVector<int> muCharge(arena);
+    ArenaVector<int> muGlobal(arena);
     
     //Four vector
-    std::vector <double> muPt;
-    std::vector <double> muEta;
-    std::vector <double> muPhi;
-    std::vector <double> muEnergy;
+    ArenaVector<double> muPt(arena);
+    ArenaVector<double> muEta(arena);
+    ArenaVector<double> muPhi(arena);
+    ArenaVector<double> muEnergy(arena);
     
     //Quality criteria
-    std::vector <double> muChi2;
-    std::vector <double> muDxy;
-    std::vector <double> muDz;
-    std::vector <double> muRelIso;
+    ArenaVector<double> muChi2(arena);
+    ArenaVector<double> muDxy(arena);
+    ArenaVector<double> muDz(arena);
+    ArenaVector<double> muRelIso(arena);
     
-    std::vector <int> muNValMuHits;
-    std::vector <int> muNMatchedStations;
-    std::vector <int> muNValPixelHits;
-    std::vector <int> muNTrackerLayers;
+    ArenaVector<int> muNValMuHits(arena);
+    ArenaVector<int> muNMatchedStations(arena);
+    ArenaVector<int> muNValPixelHits(arena);
+    ArenaVector<int> muNTrackerLayers(arena);
     
     //Extra info about isolation
-    std::vector <double> muChIso;
-    std::vector <double> muNhIso;
-    std::vector <double> muGIso;
-    std::vector <double> muPuIso;
+    ArenaVector<double> muChIso(arena);
+    ArenaVector<double> muNhIso(arena);
+    ArenaVector<double> muGIso(arena);
+    ArenaVector<double> muPuIso(arena);
 
     //ID info
-    std::vector <int> muIsTight;
-    std::vector<int> muIsLoose;
+    ArenaVector<int> muIsTight(arena);
+    ArenaVector<int> muIsLoose(arena);
     
     //Generator level information -- MC matching
-    vector<double> muGen_Reco_dr;
-    vector<int> muPdgId;
-    vector<int> muStatus;
-    vector<int> muMatched;
-    vector<int> muNumberOfMothers;
-    vector<double> muMother_pt;
-    vector<double> muMother_eta;
-    vector<double> muMother_phi;
-    vector<double> muMother_energy;
-    vector<int> muMother_id;
-    vector<int> muMother_status;
+    ArenaVector<double> muGen_Reco_dr(arena);
+    ArenaVector<int> muPdgId(arena);
+    ArenaVector<int> muStatus(arena);
+    ArenaVector<int> muMatched(arena);
+    ArenaVector<int> muNumberOfMothers(arena);
+    ArenaVector<double> muMother_pt(arena);
+    ArenaVector<double> muMother_eta(arena);
+    ArenaVector<double> muMother_phi(arena);
+    ArenaVector<double> muMother_energy(arena);
+    ArenaVector<int> muMother_id(arena);
+    ArenaVector<int> muMother_status(arena);
     //Matched gen muon information:
-    vector<double> muMatchedPt;
-    vector<double> muMatchedEta;
-    vector<double> muMatchedPhi;
-    vector<double> muMatchedEnergy;
+    ArenaVector<double> muMatchedPt(arena);
+    ArenaVector<double> muMatchedEta(arena);
+    ArenaVector<double> muMatchedPhi(arena);
+    ArenaVector<double> muMatchedEnergy(arena);
     
     for (std::vector<edm::Ptr<pat::Muon> >::const_iterator imu = vSelMuons.begin(); imu != vSelMuons.end(); imu++){
         //Protect against muons without tracks (should never happen, but just in case)
@@ -545,7 +557,7 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
                         muMatchedPhi.push_back(p.phi());
                         muMatchedEnergy.push_back(p.energy());
                         int oldSize = muMother_id.size();
-                        fillMotherInfo(p.mother(), 0, muMother_id, muMother_status, muMother_pt, muMother_eta, muMother_phi, muMother_energy);
+                        fillMotherInfo(selector->GetGenEventIndex(event, genParticles_it), matchId, muMother_id, muMother_status, muMother_pt, muMother_eta, muMother_phi, muMother_energy);
                         muNumberOfMothers.push_back(muMother_id.size()-oldSize);
                     }
                 }
@@ -624,29 +636,29 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
     event.getByLabel(topJetColl, topJets);
     
     //Four vector
-    std::vector <double> CATopJetPt;
-    std::vector <double> CATopJetEta;
-    std::vector <double> CATopJetPhi;
-    std::vector <double> CATopJetEnergy;
+    ArenaVector<double> CATopJetPt(arena);
+    ArenaVector<double> CATopJetEta(arena);
+    ArenaVector<double> CATopJetPhi(arena);
+    ArenaVector<double> CATopJetEnergy(arena);
     
-    std::vector <double> CATopJetCSV;
+    ArenaVector<double> CATopJetCSV(arena);
     //   std::vector <double> CATopJetRCN;
     
     //Identity
-    std::vector <int> CATopJetIndex;
-    std::vector <int> CATopJetnDaughters;
+    ArenaVector<int> CATopJetIndex(arena);
+    ArenaVector<int> CATopJetnDaughters(arena);
     
     //Top-like properties
-    std::vector <double> CATopJetTopMass;
-    std::vector <double> CATopJetMinPairMass;
+    ArenaVector<double> CATopJetTopMass(arena);
+    ArenaVector<double> CATopJetMinPairMass(arena);
     
     //Daughter four vector and index
-    std::vector <double> CATopDaughterPt;
-    std::vector <double> CATopDaughterEta;
-    std::vector <double> CATopDaughterPhi;
-    std::vector <double> CATopDaughterEnergy;
+    ArenaVector<double> CATopDaughterPt(arena);
+    ArenaVector<double> CATopDaughterEta(arena);
+    ArenaVector<double> CATopDaughterPhi(arena);
+    ArenaVector<double> CATopDaughterEnergy(arena);
     
-    std::vector <int> CATopDaughterMotherIndex;
+    ArenaVector<int> CATopDaughterMotherIndex(arena);
     
     for (std::vector<pat::Jet>::const_iterator ijet = topJets->begin(); ijet != topJets->end(); ijet++) {
         
@@ -709,28 +721,28 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
     event.getByLabel(CAWJetColl, CAWJets);
     
     //Four vector
-    std::vector <double> CAWJetPt;
-    std::vector <double> CAWJetEta;
-    std::vector <double> CAWJetPhi;
-    std::vector <double> CAWJetEnergy;
+    ArenaVector<double> CAWJetPt(arena);
+    ArenaVector<double> CAWJetEta(arena);
+    ArenaVector<double> CAWJetPhi(arena);
+    ArenaVector<double> CAWJetEnergy(arena);
     
-    std::vector <double> CAWJetCSV;
+    ArenaVector<double> CAWJetCSV(arena);
     //   std::vector <double> CAWJetRCN;
     
     //Identity
-    std::vector <int> CAWJetIndex;
-    std::vector <int> CAWJetnDaughters;
+    ArenaVector<int> CAWJetIndex(arena);
+    ArenaVector<int> CAWJetnDaughters(arena);
     
     //Mass
-    std::vector <double> CAWJetMass;
+    ArenaVector<double> CAWJetMass(arena);
     
     //Daughter four vector and index
-    std::vector <double> CAWDaughterPt;
-    std::vector <double> CAWDaughterEta;
-    std::vector <double> CAWDaughterPhi;
-    std::vector <double> CAWDaughterEnergy;
+    ArenaVector<double> CAWDaughterPt(arena);
+    ArenaVector<double> CAWDaughterEta(arena);
+    ArenaVector<double> CAWDaughterPhi(arena);
+    ArenaVector<double> CAWDaughterEnergy(arena);
     
-    std::vector <int> CAWDaughterMotherIndex;
+    ArenaVector<int> CAWDaughterMotherIndex(arena);
     
     for (std::vector<pat::Jet>::const_iterator ijet = CAWJets->begin(); ijet != CAWJets->end(); ijet++){
         
@@ -792,12 +804,12 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
     event.getByLabel(CA8JetColl, CA8Jets);
     
     //Four vector
-    std::vector <double> CA8JetPt;
-    std::vector <double> CA8JetEta;
-    std::vector <double> CA8JetPhi;
-    std::vector <double> CA8JetEnergy;
+    ArenaVector<double> CA8JetPt(arena);
+    ArenaVector<double> CA8JetEta(arena);
+    ArenaVector<double> CA8JetPhi(arena);
+    ArenaVector<double> CA8JetEnergy(arena);
     
-    std::vector <double> CA8JetCSV;
+    ArenaVector<double> CA8JetCSV(arena);
     //   std::vector <double> CA8JetRCN;
     
     for (std::vector<pat::Jet>::const_iterator ijet = CA8Jets->begin(); ijet != CA8Jets->end(); ijet++){
@@ -823,13 +835,13 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
     
     //Get AK5 Jets
     //Four vector
-    std::vector <double> AK5JetPt;
-    std::vector <double> AK5JetEta;
-    std::vector <double> AK5JetPhi;
-    std::vector <double> AK5JetEnergy;
+    ArenaVector<double> AK5JetPt(arena);
+    ArenaVector<double> AK5JetEta(arena);
+    ArenaVector<double> AK5JetPhi(arena);
+    ArenaVector<double> AK5JetEnergy(arena);
     
-    std::vector <int>    AK5JetTBag;
-    std::vector <double> AK5JetRCN;
+    ArenaVector<int>    AK5JetTBag(arena);
+    ArenaVector<double> AK5JetRCN(arena);
     
     for (std::vector<edm::Ptr<pat::Jet> >::const_iterator ijet = vSelJets.begin();
          ijet != vSelJets.end(); ijet++){
@@ -884,21 +896,22 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
     //
     
     //Four vector
-    std::vector <double> genPt;
-    std::vector <double> genEta;
-    std::vector <double> genPhi;
-    std::vector <double> genEnergy;
+    ArenaVector<double> genPt(arena);
+    ArenaVector<double> genEta(arena);
+    ArenaVector<double> genPhi(arena);
+    ArenaVector<double> genEnergy(arena);
     
     //Identity
-    std::vector <int> genID;
-    std::vector <int> genIndex;
-    std::vector <int> genStatus;
-    std::vector <int> genMotherID;
-    std::vector <int> genMotherIndex;
+    ArenaVector<int> genID(arena);
+    ArenaVector<int> genIndex(arena);
+    ArenaVector<int> genStatus(arena);
+    ArenaVector<int> genMotherID(arena);
+    ArenaVector<int> genMotherIndex(arena);
     
     if (isMc){
         edm::Handle<reco::GenParticleCollection> genParticles;
         event.getByLabel(genParticles_it, genParticles);
+        GenEventIndex const & genTables = selector->GetGenEventIndex(event, genParticles_it);
         
         for(size_t i = 0; i < genParticles->size(); i++){
             const reco::GenParticle & p = (*genParticles).at(i);
@@ -927,16 +940,8 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
                 
                 if (not bKeep) continue;
                 
-                //Find index of mother
-                int mInd = 0;
-                for(size_t j = 0; j < genParticles->size(); j++){
-                    const reco::GenParticle & q = (*genParticles).at(j);
-                    if (q.status() != 3) continue;
-                    if (mother->pdgId() == q.pdgId() and fabs(mother->eta() - q.eta()) < 0.01 and fabs(mother->pt() - q.pt()) < 0.01){
-                        mInd = (int) j;
-                        break;
-                    }
-                }
+                //Index of mother, -1 if it is not in the collection
+                int mInd = genTables.Mother(i);
                 
                 //Four vector
                 genPt     . push_back(p.pt());
@@ -972,19 +977,17 @@ int DileptonCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector *
 
 int DileptonCalc::findMatch(const reco::GenParticleCollection & genParticles, int idToMatch, double eta, double phi)
 {
-    float dRtmp = 1000;
-    float closestDR = 10000.;
-    int closestGenPart = -1;
-    
-    for(size_t j = 0; j < genParticles.size(); ++ j) {
-        const reco::GenParticle & p = (genParticles).at(j);
-        dRtmp = mdeltaR( eta, phi, p.eta(), p.phi());
-        if ( dRtmp < closestDR && abs(p.pdgId()) == idToMatch){// && dRtmp < 0.3) {
-            closestDR = dRtmp;
-            closestGenPart = j;
-        }//end of requirement for matching
-    }//end of gen particle loop 
-    return closestGenPart;
+    //
+    // closest gen particle with |pdgId| == idToMatch; only matches
+    // within deltaR 0.3 are used, so the index is searched up to there
+    //
+    if (genEtaPhiSource != &genParticles){
+        genEtaPhi.Build(genParticles);
+        genEtaPhiSource = &genParticles;
+    }
+    
+    return genEtaPhi.Nearest(eta, phi, 0.3,
+                             [&genParticles, idToMatch](int j){ return abs(genParticles[j].pdgId()) == idToMatch; });
 }
 
 
@@ -992,17 +995,20 @@ double DileptonCalc::mdeltaR(double eta1, double phi1, double eta2, double phi2)
     return std::sqrt(deltaR2 (eta1, phi1, eta2, phi2));
 }
 
-void DileptonCalc::fillMotherInfo(const reco::Candidate *mother, int i, vector <int> & momid, vector <int> & momstatus, vector<double> & mompt, vector<double> & mometa, vector<double> & momphi, vector<double> & momenergy)
+void DileptonCalc::fillMotherInfo(GenEventIndex const & genIndex, int iGen, ArenaVector<int> & momid, ArenaVector<int> & momstatus, ArenaVector<double> & mompt, ArenaVector<double> & mometa, ArenaVector<double> & momphi, ArenaVector<double> & momenergy)
 {
-    if(mother) {
-        momid.push_back(mother->pdgId());
-        momstatus.push_back(mother->status());
-        mompt.push_back(mother->pt());
-        mometa.push_back(mother->eta());
-        momphi.push_back(mother->phi());
-        momenergy.push_back(mother->energy());
-        if(i<10)fillMotherInfo(mother->mother(), i+1, momid, momstatus, mompt, mometa, momphi, momenergy);
+    //
+    // mothers from the genealogy tables, closest first
+    //
+    std::vector<int> ancestors;
+    genIndex.Ancestors(iGen, 11, ancestors);
+    for (size_t k = 0; k < ancestors.size(); ++k) {
+        const reco::GenParticle & mother = (*genIndex.GetCollection())[ancestors[k]];
+        momid.push_back(mother.pdgId());
+        momstatus.push_back(mother.status());
+        mompt.push_back(mother.pt());
+        mometa.push_back(mother.eta());
+        momphi.push_back(mother.phi());
+        momenergy.push_back(mother.energy());
     }
-    
-    
 } 
@@ -0,0 +1,123 @@
+/*
+ Per-event eta-phi binned index of a collection, for deltaR matching
+ */
+
+
+
+#include <algorithm>
+
+#include "LJMet/Com/interface/EtaPhiIndex.h"
+
+
+
+namespace {
+
+    struct AcceptAll {
+        bool operator()(int) const { return true; }
+    };
+
+    struct CollectKeys {
+        double eta, phi, cone2;
+        std::vector<int> & keys;
+        CollectKeys(double e, double p, double c2, std::vector<int> & k): eta(e), phi(p), cone2(c2), keys(k){}
+        template <class E>
+        void operator()(E const & entry){
+            if (EtaPhiIndex::DeltaR2(eta, phi, entry.eta, entry.phi) <= cone2) keys.push_back(entry.key);
+        }
+    };
+}
+
+
+
+EtaPhiIndex::EtaPhiIndex(double cellSize, double maxEta):
+mMaxEta(maxEta),
+mBuilt(false){
+
+    if (cellSize <= 0.0) cellSize = 0.4;
+
+    mNEta = std::max(1, static_cast<int>(std::ceil(2.0*maxEta/cellSize)));
+    mNPhi = std::max(1, static_cast<int>(std::floor(2.0*M_PI/cellSize)));
+    mEtaWidth = 2.0*maxEta/mNEta;
+    mPhiWidth = 2.0*M_PI/mNPhi;
+
+    mvCellStart.assign(mNEta*mNPhi+1, 0);
+}
+
+
+
+void EtaPhiIndex::Clear(){
+    mvPending.clear();
+    mvEntry.clear();
+    std::fill(mvCellStart.begin(), mvCellStart.end(), 0);
+    mBuilt = false;
+}
+
+
+
+void EtaPhiIndex::Add(double eta, double phi, int key){
+    Entry _entry;
+    _entry.eta = eta;
+    _entry.phi = phi;
+    _entry.key = key;
+    mvPending.push_back(_entry);
+    mBuilt = false;
+}
+
+
+
+void EtaPhiIndex::Build(){
+    //
+    // counting sort of all entries by cell, stable in key order
+    //
+
+    mvPending.insert(mvPending.end(), mvEntry.begin(), mvEntry.end());
+
+    std::vector<int> _cell(mvPending.size());
+    std::fill(mvCellStart.begin(), mvCellStart.end(), 0);
+    for (size_t i = 0; i != mvPending.size(); ++i){
+        _cell[i] = etaCell(mvPending[i].eta)*mNPhi + phiCell(mvPending[i].phi);
+        ++mvCellStart[_cell[i]+1];
+    }
+    for (size_t c = 1; c != mvCellStart.size(); ++c){
+        mvCellStart[c] += mvCellStart[c-1];
+    }
+
+    mvEntry.resize(mvPending.size());
+    std::vector<int> _next(mvCellStart.begin(), mvCellStart.end()-1);
+    for (size_t i = 0; i != mvPending.size(); ++i){
+        mvEntry[_next[_cell[i]]++] = mvPending[i];
+    }
+
+    mvPending.clear();
+    mBuilt = true;
+}
+
+
+
+int EtaPhiIndex::Nearest(double eta, double phi, double maxDR, double * dR) const{
+    return Nearest(eta, phi, maxDR, AcceptAll(), dR);
+}
+
+
+
+void EtaPhiIndex::WithinCone(double eta, double phi, double coneDR, std::vector<int> & keys) const{
+    keys.clear();
+    CollectKeys _collect(eta, phi, coneDR*coneDR, keys);
+    visitCells(eta, phi, coneDR, _collect);
+    std::sort(keys.begin(), keys.end());
+}
+
+
+
+int EtaPhiIndex::etaCell(double eta) const{
+    int _cell = static_cast<int>(std::floor((eta + mMaxEta)/mEtaWidth));
+    return std::max(0, std::min(_cell, mNEta-1));
+}
+
+
+
+int EtaPhiIndex::phiCell(double phi) const{
+    // same cell numbering as the queries, phi = pi belongs to cell 0
+    int _cell = static_cast<int>(std::floor((DeltaPhi(phi, 0.0) + M_PI)/mPhiWidth));
+    return ((_cell % mNPhi) + mNPhi) % mNPhi;
+}
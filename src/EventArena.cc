@@ -0,0 +1,75 @@
+/*
+ Event-scoped monotonic memory for scratch containers
+ */
+
+
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "LJMet/Com/interface/EventArena.h"
+
+
+
+EventArena::EventArena(size_t blockSize):
+mCurrent(0),
+mOffset(0),
+mUsed(0){
+    std::memset(mFree, 0, sizeof(mFree));
+    Block _block;
+    _block.size = std::max(blockSize, size_t(4096));
+    _block.data = static_cast<char *>(::operator new(_block.size));
+    mvBlock.push_back(_block);
+}
+
+
+
+EventArena::~EventArena(){
+    for (size_t i = 0; i != mvBlock.size(); ++i) ::operator delete(mvBlock[i].data);
+}
+
+
+
+size_t EventArena::GetCapacity() const{
+    size_t _capacity = 0;
+    for (size_t i = 0; i != mvBlock.size(); ++i) _capacity += mvBlock[i].size;
+    return _capacity;
+}
+
+
+
+void EventArena::addBlock(size_t minSize){
+    //
+    // move on to the next block, reusing one left from an earlier
+    // event if it is big enough, otherwise allocate a bigger one
+    //
+    ++mCurrent;
+    mOffset = 0;
+    if (mCurrent < mvBlock.size() && mvBlock[mCurrent].size >= minSize) return;
+
+    Block _block;
+    _block.size = std::max(minSize, 2*mvBlock[mCurrent-1].size);
+    _block.data = static_cast<char *>(::operator new(_block.size));
+    if (mCurrent < mvBlock.size()){
+        ::operator delete(mvBlock[mCurrent].data);
+        mvBlock[mCurrent] = _block;
+    }
+    else mvBlock.push_back(_block);
+}
+
+
+
+void EventArena::Reset(){
+    if (mvBlock.size() > 1){
+        size_t const _capacity = GetCapacity();
+        for (size_t i = 0; i != mvBlock.size(); ++i) ::operator delete(mvBlock[i].data);
+        mvBlock.resize(1);
+        mvBlock[0].size = _capacity;
+        mvBlock[0].data = static_cast<char *>(::operator new(_capacity));
+    }
+    mCurrent = 0;
+    mOffset = 0;
+    mUsed = 0;
+    std::memset(mFree, 0, sizeof(mFree));
+}
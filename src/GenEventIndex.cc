@@ -0,0 +1,158 @@
+/*
+ Event-scoped genealogy tables for the generator particles
+ */
+
+
+
+#include <cstdlib>
+
+#include "LJMet/Com/interface/GenEventIndex.h"
+
+
+
+GenEventIndex::GenEventIndex():
+mpPruned(0){
+}
+
+
+
+void GenEventIndex::Clear(){
+    mpPruned = 0;
+    mIndex.clear();
+    mvMotherStart.clear();
+    mvMother.clear();
+    mvDaughterStart.clear();
+    mvDaughter.clear();
+    mvFirstCopy.clear();
+    mvLastCopy.clear();
+    mvTopChain.clear();
+    mvPackedMother.clear();
+}
+
+
+
+void GenEventIndex::Build(reco::GenParticleCollection const & pruned,
+                          std::vector<pat::PackedGenParticle> const * packed){
+    //
+    // one pass for the pointer map, one for the mother/daughter
+    // arrays, then copy resolution and the top decay chains
+    //
+
+    Clear();
+    mpPruned = &pruned;
+
+    int const _n = pruned.size();
+    mIndex.reserve(_n);
+    for (int i = 0; i != _n; ++i){
+        mIndex[static_cast<reco::Candidate const *>(&pruned[i])] = i;
+    }
+
+    mvMotherStart.reserve(_n+1);
+    mvDaughterStart.reserve(_n+1);
+    mvMotherStart.push_back(0);
+    mvDaughterStart.push_back(0);
+    for (int i = 0; i != _n; ++i){
+        reco::GenParticle const & p = pruned[i];
+        for (size_t k = 0; k != p.numberOfMothers(); ++k){
+            mvMother.push_back(Index(p.mother(k)));
+        }
+        mvMotherStart.push_back(mvMother.size());
+        for (size_t k = 0; k != p.numberOfDaughters(); ++k){
+            mvDaughter.push_back(Index(p.daughter(k)));
+        }
+        mvDaughterStart.push_back(mvDaughter.size());
+    }
+
+    // copies; the step limit guards against malformed cyclic records
+    mvFirstCopy.resize(_n);
+    mvLastCopy.resize(_n);
+    for (int i = 0; i != _n; ++i){
+        int _first = i;
+        for (int _step = 0, _m = sameIdMother(_first); _m >= 0 && _step != _n; ++_step, _m = sameIdMother(_first)) _first = _m;
+        mvFirstCopy[i] = _first;
+        int _last = i;
+        for (int _step = 0, _d = sameIdDaughter(_last); _d >= 0 && _step != _n; ++_step, _d = sameIdDaughter(_last)) _last = _d;
+        mvLastCopy[i] = _last;
+    }
+
+    for (int i = 0; i != _n; ++i){
+        if (abs(pruned[i].pdgId()) == 6 && mvLastCopy[i] == i) classifyTop(i);
+    }
+
+    if (packed){
+        mvPackedMother.resize(packed->size());
+        for (size_t i = 0; i != packed->size(); ++i){
+            reco::Candidate const * _mother = (*packed)[i].numberOfMothers() > 0 ? (*packed)[i].mother(0) : 0;
+            mvPackedMother[i] = _mother ? Index(_mother) : -1;
+        }
+    }
+}
+
+
+
+void GenEventIndex::Ancestors(int i, int maxDepth, std::vector<int> & ancestors) const{
+    ancestors.clear();
+    for (int _m = Mother(i); _m >= 0 && (int)ancestors.size() < maxDepth; _m = Mother(_m)){
+        ancestors.push_back(_m);
+    }
+}
+
+
+
+int GenEventIndex::sameIdDaughter(int i) const{
+    int const _id = (*mpPruned)[i].pdgId();
+    for (int k = mvDaughterStart[i]; k != mvDaughterStart[i+1]; ++k){
+        if (mvDaughter[k] >= 0 && (*mpPruned)[mvDaughter[k]].pdgId() == _id) return mvDaughter[k];
+    }
+    return -1;
+}
+
+
+
+int GenEventIndex::sameIdMother(int i) const{
+    int const _id = (*mpPruned)[i].pdgId();
+    for (int k = mvMotherStart[i]; k != mvMotherStart[i+1]; ++k){
+        if (mvMother[k] >= 0 && (*mpPruned)[mvMother[k]].pdgId() == _id) return mvMother[k];
+    }
+    return -1;
+}
+
+
+
+void GenEventIndex::classifyTop(int top){
+    TopChain _chain;
+    _chain.top = top;
+    _chain.b = -1;
+    _chain.w = -1;
+    _chain.wDau1 = -1;
+    _chain.wDau2 = -1;
+    _chain.decay = kUnknown;
+
+    for (int k = 0; k != NDaughters(top); ++k){
+        int const _d = Daughter(top, k);
+        if (_d < 0) continue;
+        int const _id = abs((*mpPruned)[_d].pdgId());
+        if (_id == 24) _chain.w = mvLastCopy[_d];
+        else if (_id >= 1 && _id <= 5 && _chain.b < 0) _chain.b = _d;
+    }
+
+    if (_chain.w >= 0){
+        for (int k = 0; k != NDaughters(_chain.w); ++k){
+            int const _d = Daughter(_chain.w, k);
+            if (_d < 0) continue;
+            int const _id = abs((*mpPruned)[_d].pdgId());
+            if (_id == 11 || _id == 13 || _id == 15){
+                _chain.decay = (_id == 11) ? kElectron : ((_id == 13) ? kMuon : kTau);
+                if (_chain.wDau1 >= 0) _chain.wDau2 = _chain.wDau1;
+                _chain.wDau1 = _d;
+            }
+            else if (_id == 12 || _id == 14 || _id == 16 || (_id >= 1 && _id <= 5)){
+                if (_chain.wDau1 < 0) _chain.wDau1 = _d;
+                else if (_chain.wDau2 < 0) _chain.wDau2 = _d;
+            }
+        }
+        if (_chain.decay == kUnknown && _chain.wDau1 >= 0 && _chain.wDau2 >= 0) _chain.decay = kHadronic;
+    }
+
+    mvTopChain.push_back(_chain);
+}
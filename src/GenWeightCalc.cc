@@ -0,0 +1,91 @@
+/*
+ Calculator for the generator weights stored in the input
+
+ Reads the GenEventInfoProduct weight and the LHE scale and PDF
+ weights instead of evaluating the PDF sets with LHAPDF:
+
+   genWeight         GenEventInfoProduct::weight()
+   genWeightRatios   LHE weights divided by the LHE nominal weight
+   genWeightLayout   key of the ids and groups of genWeightRatios
+
+ The ratios are set as doubles; outputs.branchPrecision stores them
+ as float, or truncated/quantised, on disk.
+
+ The sums of the weights over all processed events, selected or
+ not, and the ids and groups of each layout are written by the
+ run/lumi summary (see RunLumiSummary), with the inputs set here.
+ ljmet turns the summary on for MC whenever this calculator runs.
+ */
+
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LJMet/Com/interface/BaseCalc.h"
+#include "LJMet/Com/interface/BaseEventSelector.h"
+#include "LJMet/Com/interface/LjmetFactory.h"
+#include "LJMet/Com/interface/LjmetEventContent.h"
+#include "LJMet/Com/interface/GenWeightReader.h"
+
+
+
+class LjmetFactory;
+
+
+
+class GenWeightCalc : public BaseCalc{
+
+public:
+
+    GenWeightCalc();
+    virtual ~GenWeightCalc(){}
+
+    virtual int BeginJob();
+    virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
+    virtual int EndJob(){ return 0; }
+
+
+private:
+
+    edm::InputTag mGenInfoSrc;
+    edm::InputTag mLheSrc;
+    edm::InputTag mLheRunInfoSrc;
+};
+
+
+
+//static int reg = LjmetFactory::GetInstance()->Register(new GenWeightCalc(), "GenWeightCalc");
+
+
+
+GenWeightCalc::GenWeightCalc(){
+}
+
+
+
+int GenWeightCalc::BeginJob(){
+
+    mGenInfoSrc = mPset.getUntrackedParameter<edm::InputTag>("genInfoSrc", edm::InputTag("generator"));
+    mLheSrc = mPset.getUntrackedParameter<edm::InputTag>("lheSrc", edm::InputTag("externalLHEProducer"));
+    mLheRunInfoSrc = mPset.getUntrackedParameter<edm::InputTag>("lheRunInfoSrc", edm::InputTag("externalLHEProducer"));
+
+    return 0;
+}
+
+
+
+int GenWeightCalc::AnalyzeEvent(edm::EventBase const & event,
+                                BaseEventSelector * selector){
+
+    if (!selector->IsMc()) return 0;
+
+    GenWeightReader const & weights = selector->GetGenWeights(event, mGenInfoSrc, mLheSrc, mLheRunInfoSrc);
+
+    SetValue("genWeight", weights.GetNominal());
+    SetValue("genWeightRatios", weights.GetRatios());
+    SetValue("genWeightLayout", static_cast<int>(weights.GetLayout().key));
+
+    return 0;
+}
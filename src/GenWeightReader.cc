@@ -0,0 +1,211 @@
+/*
+ Generator weights stored in the input, with their layout from the LHE run header
+ */
+
+
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#include "TFile.h"
+
+#include "LJMet/Com/interface/GenWeightReader.h"
+#include "DataFormats/FWLite/interface/ChainEvent.h"
+#include "DataFormats/FWLite/interface/Event.h"
+#include "DataFormats/FWLite/interface/Run.h"
+#include "SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h"
+#include "SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h"
+#include "SimDataFormats/GeneratorProducts/interface/LHERunInfoProduct.h"
+
+
+
+namespace {
+
+    std::string lower(std::string s){
+        std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+        return s;
+    }
+
+    /// Value of key="..." or key='...' in the text of a tag, empty if absent
+    std::string attribute(std::string const & tag, std::string const & key){
+        std::string const _tag = lower(tag);
+        size_t _pos = 0;
+        while ((_pos = _tag.find(key, _pos)) != std::string::npos){
+            size_t _eq = _pos + key.size();
+            bool const _start = _pos == 0 || std::isspace(_tag[_pos-1]);
+            _pos = _eq;
+            while (_eq < _tag.size() && std::isspace(_tag[_eq])) ++_eq;
+            if (!_start || _eq == _tag.size() || _tag[_eq] != '=') continue;
+            ++_eq;
+            while (_eq < _tag.size() && std::isspace(_tag[_eq])) ++_eq;
+            if (_eq == _tag.size() || (_tag[_eq] != '"' && _tag[_eq] != '\'')) continue;
+            size_t const _end = _tag.find(_tag[_eq], _eq + 1);
+            if (_end == std::string::npos) return "";
+            return tag.substr(_eq + 1, _end - _eq - 1);
+        }
+        return "";
+    }
+
+    int classify(std::string const & groupName, std::string const & weight){
+        std::string const _group = lower(groupName);
+        if (_group.find("scale") != std::string::npos) return GenWeightReader::kScale;
+        if (_group.find("pdf") != std::string::npos) return GenWeightReader::kPdf;
+        std::string const _weight = lower(weight);
+        if (_weight.find("mur") != std::string::npos || _weight.find("muf") != std::string::npos) return GenWeightReader::kScale;
+        if (_weight.find("pdf") != std::string::npos) return GenWeightReader::kPdf;
+        return GenWeightReader::kOther;
+    }
+
+    int classifyId(std::string const & id){
+        char * _end = 0;
+        long const _id = std::strtol(id.c_str(), &_end, 10);
+        if (_end == id.c_str() || *_end != '\0') return GenWeightReader::kOther;
+        if (_id >= 1001 && _id <= 1009) return GenWeightReader::kScale;
+        if (_id >= 2001) return GenWeightReader::kPdf;
+        return GenWeightReader::kOther;
+    }
+
+    unsigned fnv1a(std::string const & s, unsigned hash){
+        for (size_t i = 0; i != s.size(); ++i){
+            hash ^= static_cast<unsigned char>(s[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    /// Input file of the event, empty outside FWLite
+    std::string fileName(edm::EventBase const & event){
+        TFile const * _file = 0;
+        if (fwlite::ChainEvent const * _chain = dynamic_cast<fwlite::ChainEvent const *>(&event)) _file = _chain->getTFile();
+        else if (fwlite::Event const * _event = dynamic_cast<fwlite::Event const *>(&event)) _file = _event->getTFile();
+        return _file ? _file->GetName() : "";
+    }
+}
+
+
+
+GenWeightReader::GenWeightReader():
+mbRead(false),
+mNominal(1.0),
+mLayoutRun(0){
+    mLayout.key = 0;
+}
+
+
+
+void GenWeightReader::Read(edm::EventBase const & event,
+                           edm::InputTag const & genInfoTag,
+                           edm::InputTag const & lheTag,
+                           edm::InputTag const & lheRunInfoTag){
+    mbRead = true;
+    mGenInfoTag = genInfoTag;
+    mLheTag = lheTag;
+    mNominal = 1.0;
+    mvRatio.clear();
+
+    edm::Handle<GenEventInfoProduct> hGenInfo;
+    event.getByLabel(genInfoTag, hGenInfo);
+    if (hGenInfo.isValid()) mNominal = hGenInfo->weight();
+
+    edm::Handle<LHEEventProduct> hLhe;
+    if (!lheTag.label().empty()) event.getByLabel(lheTag, hLhe);
+
+    // the ids are only compared again when the file or run changes
+    unsigned const _run = event.id().run();
+    std::string const _file = fileName(event);
+    bool const _newBlock = _run != mLayoutRun || _file != mLayoutFile;
+
+    mvId.clear();
+    if (hLhe.isValid()){
+        std::vector<LHEEventProduct::WGT> const & _weights = hLhe->weights();
+        double const _lheNominal = hLhe->originalXWGTUP();
+        for (size_t i = 0; i != _weights.size(); ++i){
+            mvRatio.push_back(_lheNominal != 0.0 ? _weights[i].wgt/_lheNominal : 0.0);
+        }
+        if (_newBlock || mvRatio.size() != mLayout.vId.size()){
+            for (size_t i = 0; i != _weights.size(); ++i) mvId.push_back(_weights[i].id);
+        }
+    }
+    else if (hGenInfo.isValid() && hGenInfo->weights().size() > 1){
+        std::vector<double> const & _weights = hGenInfo->weights();
+        for (size_t i = 1; i != _weights.size(); ++i){
+            mvRatio.push_back(_weights[0] != 0.0 ? _weights[i]/_weights[0] : 0.0);
+        }
+        if (_newBlock || mvRatio.size() != mLayout.vId.size()){
+            for (size_t i = 1; i != _weights.size(); ++i) mvId.push_back("gen" + std::to_string(i));
+        }
+    }
+
+    if (_newBlock || mvRatio.size() != mLayout.vId.size()){
+        mLayoutRun = _run;
+        mLayoutFile = _file;
+        buildLayout(event, lheRunInfoTag, mvId);
+    }
+}
+
+
+
+void GenWeightReader::buildLayout(edm::EventBase const & event, edm::InputTag const & lheRunInfoTag,
+                                  std::vector<std::string> const & ids){
+    //
+    // weight id -> group from the <initrwgt> header block of the run
+    //
+
+    std::vector<std::string> _headerId, _headerGroupName;
+    std::vector<int> _headerGroup;
+
+    fwlite::Run const * _run = 0;
+    if (fwlite::ChainEvent const * _chain = dynamic_cast<fwlite::ChainEvent const *>(&event)) _run = &_chain->getRun();
+    else if (fwlite::Event const * _event = dynamic_cast<fwlite::Event const *>(&event)) _run = &_event->getRun();
+
+    edm::Handle<LHERunInfoProduct> hRunInfo;
+    if (_run && !lheRunInfoTag.label().empty()) _run->getByLabel(lheRunInfoTag, hRunInfo);
+    if (hRunInfo.isValid()){
+        for (LHERunInfoProduct::headers_const_iterator iHeader = hRunInfo->headers_begin(); iHeader != hRunInfo->headers_end(); ++iHeader){
+            if (iHeader->tag() != "initrwgt") continue;
+
+            std::string _text;
+            for (std::vector<std::string>::const_iterator iLine = iHeader->lines().begin(); iLine != iHeader->lines().end(); ++iLine) _text += *iLine + "\n";
+
+            // <weightgroup ...> <weight id=...> text </weight> ... </weightgroup>
+            std::string _groupName;
+            size_t _pos = 0;
+            while ((_pos = _text.find('<', _pos)) != std::string::npos){
+                size_t const _close = _text.find('>', _pos);
+                if (_close == std::string::npos) break;
+                std::string const _tag = _text.substr(_pos + 1, _close - _pos - 1);
+                std::string const _name = lower(_tag.substr(0, _tag.find_first_of(" \t\n")));
+                _pos = _close + 1;
+
+                if (_name == "weightgroup"){
+                    _groupName = attribute(_tag, "name");
+                    if (_groupName.empty()) _groupName = attribute(_tag, "type");
+                }
+                else if (_name == "/weightgroup") _groupName.clear();
+                else if (_name == "weight"){
+                    size_t const _end = _text.find("</weight>", _pos);
+                    std::string const _content = _tag + " " + _text.substr(_pos, _end == std::string::npos ? std::string::npos : _end - _pos);
+                    _headerId.push_back(attribute(_tag, "id"));
+                    _headerGroupName.push_back(_groupName);
+                    _headerGroup.push_back(classify(_groupName, _content));
+                    if (_end != std::string::npos) _pos = _end + 9;
+                }
+            }
+        }
+    }
+
+    mLayout.vId = ids;
+    mLayout.vGroup.assign(ids.size(), kOther);
+    mLayout.vGroupName.assign(ids.size(), "");
+    mLayout.key = 2166136261u;
+    for (size_t i = 0; i != ids.size(); ++i){
+        mLayout.key = fnv1a(ids[i] + ",", mLayout.key);
+        size_t const h = std::find(_headerId.begin(), _headerId.end(), ids[i]) - _headerId.begin();
+        if (h != _headerId.size() && _headerGroup[h] != kOther){
+            mLayout.vGroup[i] = _headerGroup[h];
+            mLayout.vGroupName[i] = _headerGroupName[h];
+        }
+        else mLayout.vGroup[i] = classifyId(ids[i]);
+    }
+}
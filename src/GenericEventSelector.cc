@@ -0,0 +1,656 @@
+// -*- C++ -*-
+//
+// FWLite PAT analyzer-selector configured entirely by cut expressions
+//
+// The muon, electron and jet selections are lists of "<variable> <op> <value>"
+// expressions evaluated on column (structure-of-arrays) copies of the
+// object variables, see ObjectColumns.h. The selected objects are
+// published through the usual BaseEventSelector accessors.
+//
+#ifndef LJMet_Com_interface_GenericEventSelector_h
+#define LJMet_Com_interface_GenericEventSelector_h
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "DataFormats/Common/interface/TriggerResults.h"
+#include "DataFormats/PatCandidates/interface/Jet.h"
+#include "DataFormats/PatCandidates/interface/MET.h"
+#include "DataFormats/PatCandidates/interface/Muon.h"
+#include "DataFormats/PatCandidates/interface/Electron.h"
+#include "DataFormats/VertexReco/interface/Vertex.h"
+#include "FWCore/Common/interface/TriggerNames.h"
+#include "PhysicsTools/SelectorUtils/interface/PFJetIDSelectionFunctor.h"
+#include "PhysicsTools/SelectorUtils/interface/PVSelector.h"
+#include "LJMet/Com/interface/BaseEventSelector.h"
+#include "LJMet/Com/interface/LjmetFactory.h"
+#include "LJMet/Com/interface/ObjectColumns.h"
+#include "LJMet/Com/interface/EtaPhiIndex.h"
+
+
+
+class GenericEventSelector : public BaseEventSelector {
+
+public:
+
+
+    GenericEventSelector();
+    ~GenericEventSelector();
+
+
+    // executes before loop over events
+    virtual void BeginJob(std::map<std::string, edm::ParameterSet const > par);
+
+    // main method where the cuts are applied
+    virtual bool operator()( edm::EventBase const & event, pat::strbitset & ret);
+
+    // executes after loop over events
+    virtual void EndJob(){}
+
+
+protected:
+
+    // variables known to the column loaders
+    enum MuonVariable {
+        kMuPt, kMuEta, kMuAbsEta, kMuPhi, kMuEnergy, kMuCharge,
+        kMuHasTracks, kMuIsGlobal, kMuIsTracker, kMuIsPF, kMuIsLoose, kMuIsTight,
+        kMuNormChi2, kMuNValidMuonHits, kMuNMatchedStations, kMuNValidPixelHits, kMuNTrackerLayers,
+        kMuDxy, kMuDz, kMuRelIso,
+        kMuNVariables
+    };
+
+    enum ElectronVariable {
+        kElPt, kElEta, kElAbsEta, kElPhi, kElEnergy, kElCharge,
+        kElSCEta, kElAbsSCEta, kElHasGsfTrack,
+        kElDEtaIn, kElDPhiIn, kElSigmaIEtaIEta, kElHOverE, kElOoEmooP,
+        kElDxy, kElDz, kElMissingHits, kElPassConversionVeto, kElRelIso,
+        kElNVariables
+    };
+
+    enum JetVariable {
+        kJetPt, kJetEta, kJetAbsEta, kJetPhi, kJetEnergy,
+        kJetCorrPt, kJetPassId, kJetBDiscriminator, kJetNConstituents,
+        kJetChargedHadronFraction, kJetNeutralHadronFraction,
+        kJetChargedEmFraction, kJetNeutralEmFraction, kJetChargedMultiplicity,
+        kJetMinLeptonDR,
+        kJetNVariables
+    };
+
+    boost::shared_ptr<PFJetIDSelectionFunctor> jetSel_;
+    boost::shared_ptr<PVSelector>              pvSel_;
+
+    edm::Handle<edm::TriggerResults >           mhEdmTriggerResults;
+    edm::Handle<std::vector<pat::Jet> >         mhJets;
+    edm::Handle<std::vector<pat::Muon> >        mhMuons;
+    edm::Handle<std::vector<pat::Electron> >    mhElectrons;
+    edm::Handle<std::vector<pat::MET> >         mhMet;
+    edm::Handle<std::vector<reco::Vertex> >     h_primVtx;
+
+
+private:
+
+    void configureSelection(edm::ParameterSet const & pset, std::string const & name,
+                            ColumnSelection & selection, ObjectColumns & columns);
+    /// map the registered column names to loader variables, exit on unknown names
+    void resolveVariables(ObjectColumns const & columns, char const * const names[], int nNames,
+                          std::vector<int> & variables, std::string const & collection);
+
+    void loadMuons(reco::Vertex const * pv);
+    void loadElectrons(reco::Vertex const * pv);
+    void loadJets(edm::EventBase const & event);
+
+    bool bFirstEntry;
+
+    ObjectColumns mMuonColumns;
+    ObjectColumns mElectronColumns;
+    ObjectColumns mJetColumns;
+    std::vector<int> mvMuonVariable;
+    std::vector<int> mvElectronVariable;
+    std::vector<int> mvJetVariable;
+
+    ColumnSelection mMuonTight;
+    ColumnSelection mMuonLoose;
+    ColumnSelection mElectronTight;
+    ColumnSelection mElectronLoose;
+    ColumnSelection mJetAll;
+    ColumnSelection mJetSelected;
+
+    LabelIndexCache mJetLabels;
+    int mBtagSlot;
+
+    // selected leptons for the jet-lepton deltaR column
+    EtaPhiIndex mLeptonEtaPhi;
+
+    std::vector<int> mvIndex;
+    std::vector<char> mvJetMask;
+};
+
+
+static int reg = LjmetFactory::GetInstance()->Register(new GenericEventSelector(), "GenericSelector");
+
+
+
+namespace {
+
+    char const * const muonVariableNames[] = {
+        "pt", "eta", "abseta", "phi", "energy", "charge",
+        "hasTracks", "isGlobal", "isTracker", "isPF", "isLoose", "isTight",
+        "normChi2", "nValidMuonHits", "nMatchedStations", "nValidPixelHits", "nTrackerLayers",
+        "dxy", "dz", "relIso"
+    };
+
+    char const * const electronVariableNames[] = {
+        "pt", "eta", "abseta", "phi", "energy", "charge",
+        "scEta", "absSCEta", "hasGsfTrack",
+        "dEtaIn", "dPhiIn", "sigmaIEtaIEta", "hOverE", "ooEmooP",
+        "dxy", "dz", "missingHits", "passConversionVeto", "relIso"
+    };
+
+    char const * const jetVariableNames[] = {
+        "pt", "eta", "abseta", "phi", "energy",
+        "corrPt", "passId", "bDiscriminator", "nConstituents",
+        "chargedHadronFraction", "neutralHadronFraction",
+        "chargedEmFraction", "neutralEmFraction", "chargedMultiplicity",
+        "minLeptonDR"
+    };
+}
+
+
+
+GenericEventSelector::GenericEventSelector(){
+}
+
+
+GenericEventSelector::~GenericEventSelector(){
+}
+
+
+void GenericEventSelector::BeginJob( std::map<std::string, edm::ParameterSet const> par){
+
+    BaseEventSelector::BeginJob(par);
+
+    std::string _key;
+
+    _key = "pfJetIDSelector";
+    if ( par.find(_key)!=par.end() ){
+        jetSel_ = boost::shared_ptr<PFJetIDSelectionFunctor>( new PFJetIDSelectionFunctor(par[_key]) );
+    }
+    else {
+        std::cout << mLegend << "jet ID selector not configured, exiting"
+        << std::endl;
+        std::exit(-1);
+    }
+
+    _key = "pvSelector";
+    if ( par.find(_key)!=par.end() ){
+        pvSel_ = boost::shared_ptr<PVSelector>( new PVSelector(par[_key]) );
+    }
+    else {
+        std::cout << mLegend << "PV selector not configured, exiting"
+        << std::endl;
+        std::exit(-1);
+    }
+
+    _key = "event_selector";
+    if ( par.find(_key)!=par.end() ){
+        edm::ParameterSet const & _ps = par[_key];
+
+        mbPar["trigger_cut"]         = _ps.exists("trigger_cut") ? _ps.getParameter<bool>("trigger_cut") : false;
+        mbPar["dump_trigger"]        = _ps.exists("dump_trigger") ? _ps.getParameter<bool>("dump_trigger") : false;
+        mvsPar["trigger_path"]       = _ps.exists("trigger_path") ? _ps.getParameter<std::vector<std::string> >("trigger_path") : std::vector<std::string>();
+        mbPar["pv_cut"]              = _ps.exists("pv_cut") ? _ps.getParameter<bool>("pv_cut") : false;
+
+        mtPar["trigger_collection"]  = _ps.getParameter<edm::InputTag>("trigger_collection");
+        mtPar["pv_collection"]       = _ps.getParameter<edm::InputTag>("pv_collection");
+        mtPar["jet_collection"]      = _ps.getParameter<edm::InputTag>("jet_collection");
+        mtPar["muon_collection"]     = _ps.getParameter<edm::InputTag>("muon_collection");
+        mtPar["electron_collection"] = _ps.getParameter<edm::InputTag>("electron_collection");
+        mtPar["met_collection"]      = _ps.getParameter<edm::InputTag>("met_collection");
+
+        // multiplicity and MET cuts are only applied if given
+        std::string const _counts[] = {"min_muon", "max_muon", "min_electron", "max_electron",
+                                       "min_lepton", "max_lepton", "min_jet", "max_jet"};
+        for (size_t i = 0; i != sizeof(_counts)/sizeof(_counts[0]); ++i){
+            if (_ps.exists(_counts[i])) miPar[_counts[i]] = _ps.getParameter<int>(_counts[i]);
+        }
+        if (_ps.exists("min_met")) mdPar["min_met"] = _ps.getParameter<double>("min_met");
+
+        configureSelection(_ps, "muon_tight",     mMuonTight,     mMuonColumns);
+        configureSelection(_ps, "muon_loose",     mMuonLoose,     mMuonColumns);
+        configureSelection(_ps, "electron_tight", mElectronTight, mElectronColumns);
+        configureSelection(_ps, "electron_loose", mElectronLoose, mElectronColumns);
+        configureSelection(_ps, "jet_all",        mJetAll,        mJetColumns);
+        configureSelection(_ps, "jet_selected",   mJetSelected,   mJetColumns);
+    }
+    else {
+        std::cout << mLegend << "event selector not configured, exiting"
+        << std::endl;
+        std::exit(-1);
+    }
+
+    resolveVariables(mMuonColumns, muonVariableNames, kMuNVariables, mvMuonVariable, "muon");
+    resolveVariables(mElectronColumns, electronVariableNames, kElNVariables, mvElectronVariable, "electron");
+    resolveVariables(mJetColumns, jetVariableNames, kJetNVariables, mvJetVariable, "jet");
+
+    mBtagSlot = mJetLabels.Add(msPar["btagger"]);
+
+    std::cout << mLegend << "initializing generic selection" << std::endl;
+
+    bFirstEntry = true;
+
+    push_back("No selection");
+    set("No selection");
+
+    push_back("Trigger");
+    push_back("Primary vertex");
+    push_back("Min muon");
+    push_back("Max muon");
+    push_back("Min electron");
+    push_back("Max electron");
+    push_back("Min lepton");
+    push_back("Max lepton");
+    push_back("Min jet multiplicity");
+    push_back("Max jet multiplicity");
+    push_back("Min MET");
+    push_back("All cuts");          // sanity check
+
+    set("Trigger", mbPar["trigger_cut"]);
+    set("Primary vertex", mbPar["pv_cut"]);
+
+    std::string const _countCuts[] = {"Min muon", "Max muon", "Min electron", "Max electron",
+                                      "Min lepton", "Max lepton", "Min jet multiplicity", "Max jet multiplicity"};
+    std::string const _countPars[] = {"min_muon", "max_muon", "min_electron", "max_electron",
+                                      "min_lepton", "max_lepton", "min_jet", "max_jet"};
+    for (size_t i = 0; i != sizeof(_countCuts)/sizeof(_countCuts[0]); ++i){
+        if (miPar.find(_countPars[i]) != miPar.end()) set(_countCuts[i], miPar[_countPars[i]]);
+        else set(_countCuts[i], false);
+    }
+
+    if (mdPar.find("min_met") != mdPar.end()) set("Min MET", mdPar["min_met"]);
+    else set("Min MET", false);
+
+    set("All cuts", true);
+
+}
+
+
+
+void GenericEventSelector::configureSelection(edm::ParameterSet const & pset, std::string const & name,
+                                              ColumnSelection & selection, ObjectColumns & columns){
+    if (!pset.exists(name)) return;
+
+    std::string _bad;
+    if (!selection.Configure(pset.getParameter<std::vector<std::string> >(name), columns, _bad)){
+        std::cout << mLegend << "cannot parse cut \"" << _bad << "\" in " << name << ", exiting"
+        << std::endl;
+        std::exit(-1);
+    }
+}
+
+
+
+void GenericEventSelector::resolveVariables(ObjectColumns const & columns, char const * const names[], int nNames,
+                                            std::vector<int> & variables, std::string const & collection){
+    variables.assign(columns.NColumns(), -1);
+    for (size_t c = 0; c != columns.NColumns(); ++c){
+        for (int v = 0; v != nNames; ++v){
+            if (columns.GetName(c) == names[v]) variables[c] = v;
+        }
+        if (variables[c] < 0){
+            std::cout << mLegend << "unknown " << collection << " variable " << columns.GetName(c) << ", known are:";
+            for (int v = 0; v != nNames; ++v) std::cout << " " << names[v];
+            std::cout << std::endl << mLegend << "exiting" << std::endl;
+            std::exit(-1);
+        }
+    }
+}
+
+
+
+void GenericEventSelector::loadMuons(reco::Vertex const * pv){
+    //
+    // one pass over the collection per requested variable
+    //
+    std::vector<pat::Muon> const & _muons = *mhMuons;
+    size_t const _n = _muons.size();
+    mMuonColumns.Resize(_n);
+
+    for (size_t c = 0; c != mvMuonVariable.size(); ++c){
+        ObjectColumns::Column & _x = mMuonColumns.Get(c);
+        switch (mvMuonVariable[c]){
+        case kMuPt:       for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].pt(); break;
+        case kMuEta:      for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].eta(); break;
+        case kMuAbsEta:   for (size_t i = 0; i != _n; ++i) _x[i] = fabs(_muons[i].eta()); break;
+        case kMuPhi:      for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].phi(); break;
+        case kMuEnergy:   for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].energy(); break;
+        case kMuCharge:   for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].charge(); break;
+        case kMuHasTracks:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = _muons[i].globalTrack().isNonnull() && _muons[i].globalTrack().isAvailable()
+                     && _muons[i].innerTrack().isNonnull() && _muons[i].innerTrack().isAvailable();
+            }
+            break;
+        case kMuIsGlobal:  for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].isGlobalMuon(); break;
+        case kMuIsTracker: for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].isTrackerMuon(); break;
+        case kMuIsPF:      for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].isPFMuon(); break;
+        case kMuIsLoose:   for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].isLooseMuon(); break;
+        case kMuIsTight:   for (size_t i = 0; i != _n; ++i) _x[i] = pv ? _muons[i].isTightMuon(*pv) : 0; break;
+        case kMuNormChi2:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = _muons[i].globalTrack().isNonnull() ? _muons[i].globalTrack()->normalizedChi2() : 999.0;
+            }
+            break;
+        case kMuNValidMuonHits:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = _muons[i].globalTrack().isNonnull() ? _muons[i].globalTrack()->hitPattern().numberOfValidMuonHits() : 0;
+            }
+            break;
+        case kMuNMatchedStations: for (size_t i = 0; i != _n; ++i) _x[i] = _muons[i].numberOfMatchedStations(); break;
+        case kMuNValidPixelHits:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = _muons[i].innerTrack().isNonnull() ? _muons[i].innerTrack()->hitPattern().numberOfValidPixelHits() : 0;
+            }
+            break;
+        case kMuNTrackerLayers:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = _muons[i].innerTrack().isNonnull() ? _muons[i].innerTrack()->hitPattern().trackerLayersWithMeasurement() : 0;
+            }
+            break;
+        case kMuDxy:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = (pv && _muons[i].muonBestTrack().isNonnull()) ? fabs(_muons[i].muonBestTrack()->dxy(pv->position())) : 999.0;
+            }
+            break;
+        case kMuDz:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = (pv && _muons[i].muonBestTrack().isNonnull()) ? fabs(_muons[i].muonBestTrack()->dz(pv->position())) : 999.0;
+            }
+            break;
+        case kMuRelIso:
+            for (size_t i = 0; i != _n; ++i){
+                reco::MuonPFIsolation const & _iso = _muons[i].pfIsolationR04();
+                _x[i] = (_iso.sumChargedHadronPt + std::max(0.0, _iso.sumNeutralHadronEt + _iso.sumPhotonEt - 0.5*_iso.sumPUPt))/_muons[i].pt();
+            }
+            break;
+        }
+    }
+}
+
+
+
+void GenericEventSelector::loadElectrons(reco::Vertex const * pv){
+    std::vector<pat::Electron> const & _electrons = *mhElectrons;
+    size_t const _n = _electrons.size();
+    mElectronColumns.Resize(_n);
+
+    for (size_t c = 0; c != mvElectronVariable.size(); ++c){
+        ObjectColumns::Column & _x = mElectronColumns.Get(c);
+        switch (mvElectronVariable[c]){
+        case kElPt:       for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].pt(); break;
+        case kElEta:      for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].eta(); break;
+        case kElAbsEta:   for (size_t i = 0; i != _n; ++i) _x[i] = fabs(_electrons[i].eta()); break;
+        case kElPhi:      for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].phi(); break;
+        case kElEnergy:   for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].energy(); break;
+        case kElCharge:   for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].charge(); break;
+        case kElSCEta:    for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].superCluster()->eta(); break;
+        case kElAbsSCEta: for (size_t i = 0; i != _n; ++i) _x[i] = fabs(_electrons[i].superCluster()->eta()); break;
+        case kElHasGsfTrack:
+            for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].gsfTrack().isNonnull() && _electrons[i].gsfTrack().isAvailable();
+            break;
+        case kElDEtaIn:   for (size_t i = 0; i != _n; ++i) _x[i] = fabs(_electrons[i].deltaEtaSuperClusterTrackAtVtx()); break;
+        case kElDPhiIn:   for (size_t i = 0; i != _n; ++i) _x[i] = fabs(_electrons[i].deltaPhiSuperClusterTrackAtVtx()); break;
+        case kElSigmaIEtaIEta: for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].full5x5_sigmaIetaIeta(); break;
+        case kElHOverE:   for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].hadronicOverEm(); break;
+        case kElOoEmooP:
+            for (size_t i = 0; i != _n; ++i){
+                double const _e = _electrons[i].ecalEnergy();
+                _x[i] = _e > 0.0 ? fabs(1.0/_e - _electrons[i].eSuperClusterOverP()/_e) : 999.0;
+            }
+            break;
+        case kElDxy:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = (pv && _electrons[i].gsfTrack().isNonnull()) ? fabs(_electrons[i].gsfTrack()->dxy(pv->position())) : 999.0;
+            }
+            break;
+        case kElDz:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = (pv && _electrons[i].gsfTrack().isNonnull()) ? fabs(_electrons[i].gsfTrack()->dz(pv->position())) : 999.0;
+            }
+            break;
+        case kElMissingHits:
+            for (size_t i = 0; i != _n; ++i){
+                _x[i] = _electrons[i].gsfTrack().isNonnull() ? _electrons[i].gsfTrack()->hitPattern().numberOfHits(reco::HitPattern::MISSING_INNER_HITS) : 999;
+            }
+            break;
+        case kElPassConversionVeto: for (size_t i = 0; i != _n; ++i) _x[i] = _electrons[i].passConversionVeto(); break;
+        case kElRelIso:
+            for (size_t i = 0; i != _n; ++i){
+                reco::GsfElectron::PflowIsolationVariables const & _iso = _electrons[i].pfIsolationVariables();
+                _x[i] = (_iso.sumChargedHadronPt + std::max(0.0, _iso.sumNeutralHadronEt + _iso.sumPhotonEt - 0.5*_iso.sumPUPt))/_electrons[i].pt();
+            }
+            break;
+        }
+    }
+}
+
+
+
+void GenericEventSelector::loadJets(edm::EventBase const & event){
+    std::vector<pat::Jet> const & _jets = *mhJets;
+    size_t const _n = _jets.size();
+    mJetColumns.Resize(_n);
+
+    for (size_t c = 0; c != mvJetVariable.size(); ++c){
+        ObjectColumns::Column & _x = mJetColumns.Get(c);
+        switch (mvJetVariable[c]){
+        case kJetPt:      for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].pt(); break;
+        case kJetEta:     for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].eta(); break;
+        case kJetAbsEta:  for (size_t i = 0; i != _n; ++i) _x[i] = fabs(_jets[i].eta()); break;
+        case kJetPhi:     for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].phi(); break;
+        case kJetEnergy:  for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].energy(); break;
+        case kJetCorrPt:
+            CorrectJets(_jets, event);
+            for (size_t i = 0; i != _n; ++i) _x[i] = correctJet(_jets[i], event).Pt();
+            break;
+        case kJetPassId:
+            {
+                pat::strbitset _retJet = jetSel_->getBitTemplate();
+                for (size_t i = 0; i != _n; ++i){
+                    _retJet.set(false);
+                    _x[i] = (*jetSel_)(_jets[i], _retJet);
+                }
+            }
+            break;
+        case kJetBDiscriminator: for (size_t i = 0; i != _n; ++i) _x[i] = mJetLabels.BDiscriminator(_jets[i], mBtagSlot); break;
+        case kJetNConstituents:  for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].numberOfDaughters(); break;
+        case kJetChargedHadronFraction: for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].chargedHadronEnergyFraction(); break;
+        case kJetNeutralHadronFraction: for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].neutralHadronEnergyFraction(); break;
+        case kJetChargedEmFraction:     for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].chargedEmEnergyFraction(); break;
+        case kJetNeutralEmFraction:     for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].neutralEmEnergyFraction(); break;
+        case kJetChargedMultiplicity:   for (size_t i = 0; i != _n; ++i) _x[i] = _jets[i].chargedMultiplicity(); break;
+        case kJetMinLeptonDR:
+            for (size_t i = 0; i != _n; ++i){
+                double _dr = 0.0;
+                _x[i] = (mLeptonEtaPhi.Nearest(_jets[i].eta(), _jets[i].phi(), 10.0, &_dr) >= 0) ? _dr : 999.0;
+            }
+            break;
+        }
+    }
+}
+
+
+
+bool GenericEventSelector::operator()( edm::EventBase const & event, pat::strbitset & ret){
+
+    while(1){ // standard infinite while loop trick to avoid nested ifs
+
+        passCut(ret, "No selection");
+
+        //
+        //_____ Trigger cuts __________________________________
+        //
+        mvSelTriggers.clear();
+        if ( considerCut("Trigger") ) {
+
+            event.getByLabel( mtPar["trigger_collection"], mhEdmTriggerResults );
+            const edm::TriggerNames trigNames = event.triggerNames(*mhEdmTriggerResults);
+
+            unsigned int _tSize = mhEdmTriggerResults->size();
+
+            // dump trigger names
+            if (bFirstEntry && mbPar["dump_trigger"]){
+                for (unsigned int i=0; i<_tSize; i++){
+                    std::cout << i << "   " << trigNames.triggerName(i) << std::endl;
+                }
+            }
+
+            int _passTrig = 0;
+            std::vector<std::string> const & _paths = mvsPar["trigger_path"];
+            for (unsigned int ipath = 0; ipath < _paths.size(); ipath++){
+                unsigned int _tIndex = trigNames.triggerIndex(_paths[ipath]);
+                int _accept = (_tIndex<_tSize && mhEdmTriggerResults->accept(_tIndex)) ? 1 : 0;
+                mvSelTriggers.push_back(_accept);
+                _passTrig += _accept;
+            }
+
+            if ( ignoreCut("Trigger") || _passTrig > 0 ) passCut(ret, "Trigger");
+            else break;
+
+        } // end of trigger cuts
+
+
+        //
+        //_____ Primary vertex cuts __________________________________
+        //
+        mvSelPVs.clear();
+        event.getByLabel( mtPar["pv_collection"], h_primVtx );
+        for (size_t i = 0; i != h_primVtx->size(); ++i){
+            mvSelPVs.push_back(edm::Ptr<reco::Vertex>(h_primVtx, i));
+        }
+        reco::Vertex const * _pv = h_primVtx->empty() ? 0 : &h_primVtx->front();
+
+        if ( considerCut("Primary vertex") ) {
+
+            if ( (*pvSel_)(event) || ignoreCut("Primary vertex") ) passCut(ret, "Primary vertex");
+            else break;
+
+        } // end of PV cuts
+
+
+        //
+        //_____ Muons, electrons ________________________________
+        //
+        event.getByLabel( mtPar["muon_collection"], mhMuons );
+        loadMuons(_pv);
+
+        mMuonTight.Select(mMuonColumns, mvIndex);
+        mvAllMuons.clear();
+        for (size_t i = 0; i != mhMuons->size(); ++i) mvAllMuons.push_back(edm::Ptr<pat::Muon>(mhMuons, i));
+        mvSelMuons.clear();
+        for (size_t i = 0; i != mvIndex.size(); ++i) mvSelMuons.push_back(mvAllMuons[mvIndex[i]]);
+        mvLooseMuons.clear();
+        if (!mMuonLoose.IsEmpty()){
+            mMuonLoose.Select(mMuonColumns, mvIndex);
+            for (size_t i = 0; i != mvIndex.size(); ++i) mvLooseMuons.push_back(mvAllMuons[mvIndex[i]]);
+        }
+
+        event.getByLabel( mtPar["electron_collection"], mhElectrons );
+        loadElectrons(_pv);
+
+        mElectronTight.Select(mElectronColumns, mvIndex);
+        mvAllElectrons.clear();
+        for (size_t i = 0; i != mhElectrons->size(); ++i) mvAllElectrons.push_back(edm::Ptr<pat::Electron>(mhElectrons, i));
+        mvSelElectrons.clear();
+        for (size_t i = 0; i != mvIndex.size(); ++i) mvSelElectrons.push_back(mvAllElectrons[mvIndex[i]]);
+        mvLooseElectrons.clear();
+        if (!mElectronLoose.IsEmpty()){
+            mElectronLoose.Select(mElectronColumns, mvIndex);
+            for (size_t i = 0; i != mvIndex.size(); ++i) mvLooseElectrons.push_back(mvAllElectrons[mvIndex[i]]);
+        }
+
+        int const _nSelMuons = mvSelMuons.size();
+        int const _nSelElectrons = mvSelElectrons.size();
+        int const _nSelLeptons = _nSelMuons + _nSelElectrons;
+
+        if ( ignoreCut("Min muon") || _nSelMuons >= cut("Min muon", int()) ) passCut(ret, "Min muon");
+        else break;
+        if ( ignoreCut("Max muon") || _nSelMuons <= cut("Max muon", int()) ) passCut(ret, "Max muon");
+        else break;
+        if ( ignoreCut("Min electron") || _nSelElectrons >= cut("Min electron", int()) ) passCut(ret, "Min electron");
+        else break;
+        if ( ignoreCut("Max electron") || _nSelElectrons <= cut("Max electron", int()) ) passCut(ret, "Max electron");
+        else break;
+        if ( ignoreCut("Min lepton") || _nSelLeptons >= cut("Min lepton", int()) ) passCut(ret, "Min lepton");
+        else break;
+        if ( ignoreCut("Max lepton") || _nSelLeptons <= cut("Max lepton", int()) ) passCut(ret, "Max lepton");
+        else break;
+
+
+        //
+        //_____ Jets __________________________________
+        //
+        mLeptonEtaPhi.Clear();
+        for (int i = 0; i != _nSelMuons; ++i) mLeptonEtaPhi.Add(mvSelMuons[i]->eta(), mvSelMuons[i]->phi(), i);
+        for (int i = 0; i != _nSelElectrons; ++i) mLeptonEtaPhi.Add(mvSelElectrons[i]->eta(), mvSelElectrons[i]->phi(), _nSelMuons+i);
+        mLeptonEtaPhi.Build();
+
+        event.getByLabel( mtPar["jet_collection"], mhJets );
+        loadJets(event);
+
+        mJetAll.Evaluate(mJetColumns, mvJetMask);
+        mvAllJets.clear();
+        for (size_t i = 0; i != mvJetMask.size(); ++i){
+            if (mvJetMask[i]) mvAllJets.push_back(edm::Ptr<pat::Jet>(mhJets, i));
+        }
+        mJetSelected.Select(mJetColumns, mvIndex, &mvJetMask);
+        mvSelJets.clear();
+        for (size_t i = 0; i != mvIndex.size(); ++i) mvSelJets.push_back(edm::Ptr<pat::Jet>(mhJets, mvIndex[i]));
+
+        int const _nSelJets = mvSelJets.size();
+
+        if ( ignoreCut("Min jet multiplicity") || _nSelJets >= cut("Min jet multiplicity", int()) ) passCut(ret, "Min jet multiplicity");
+        else break;
+        if ( ignoreCut("Max jet multiplicity") || _nSelJets <= cut("Max jet multiplicity", int()) ) passCut(ret, "Max jet multiplicity");
+        else break;
+
+
+        //
+        //_____ MET cuts __________________________________
+        //
+        event.getByLabel( mtPar["met_collection"], mhMet );
+        mpMet = edm::Ptr<pat::MET>( mhMet, 0);
+
+        if ( considerCut("Min MET") ) {
+
+            if ( ignoreCut("Min MET") || (mpMet.isNonnull() && mpMet.isAvailable() && mpMet->et() > cut("Min MET", double())) ) passCut(ret, "Min MET");
+            else break;
+
+        } // end of MET cuts
+
+
+        //
+        //_____ Btagging selection _____________________
+        //
+        mvSelBtagJets.clear();
+        for (std::vector<edm::Ptr<pat::Jet> >::const_iterator _ijet = mvSelJets.begin();
+             _ijet != mvSelJets.end(); ++_ijet){
+
+            if ( isJetTagged(**_ijet, event) ) mvSelBtagJets.push_back(*_ijet);
+        }
+
+        passCut(ret, "All cuts");
+        break;
+
+    } // end of while loop
+
+    bFirstEntry = false;
+
+    return (bool)ret;
+}// end of operator()
+
+
+
+#endif
@@ -0,0 +1,811 @@
+/*
+ Calculator for the HitFit kinematic fit of lepton+jets ttbar events
+
+ Every jet type permutation of the leading jets is fitted under the
+ W and top mass constraints, for the neutrino solutions selected by
+ hitfitNuSolution (0 smaller |pz|, 1 larger |pz|, 2 both). Permutations
+ that cannot be the right one are dropped before fitting: b-tagged
+ jets must take the b slots, and the unfitted W and top masses must
+ be inside wide windows. The remaining fits are spread over a pool
+ of workers, each with its own fitter and event workspace. The pool
+ is started at the first event, so that no thread exists when ljmet
+ forks its workers after BeginJob.
+ The fits of every event fill HitFitInfoBranches, whose per-fit
+ kinematics, resolutions and pulls are written as vector branches.
+ hitfitDebug prints a summary of the fits of every event.
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "FWCore/ParameterSet/interface/FileInPath.h"
+#include "LJMet/Com/interface/BaseCalc.h"
+#include "LJMet/Com/interface/LjmetFactory.h"
+#include "LJMet/Com/interface/LjmetEventContent.h"
+#include "LJMet/Com/interface/FourVector.h"
+#include "LJMet/Com/interface/NeutrinoSolver.h"
+#include "LJMet/Com/interface/WorkerPool.h"
+#include "LJMet/Com/interface/HitFitInfoBranches.h"
+#include "TopQuarkAnalysis/TopHitFit/interface/Defaults_Text.h"
+#include "TopQuarkAnalysis/TopHitFit/interface/Top_Fit.h"
+#include "TopQuarkAnalysis/TopHitFit/interface/Lepjets_Event.h"
+#include "TopQuarkAnalysis/TopHitFit/interface/LeptonTranslatorBase.h"
+#include "TopQuarkAnalysis/TopHitFit/interface/JetTranslatorBase.h"
+#include "TopQuarkAnalysis/TopHitFit/interface/METTranslatorBase.h"
+
+
+
+// all the kinematic leaves of one object in HitFitInfoBranches
+#define HITFIT_SET_MOMENTUM(info, name, i, v)       \
+    info->name##E[i]     = v.E();                   \
+    info->name##P[i]     = v.P();                   \
+    info->name##Px[i]    = v.Px();                  \
+    info->name##Py[i]    = v.Py();                  \
+    info->name##Pz[i]    = v.Pz();                  \
+    info->name##Pt[i]    = v.Pt();                  \
+    info->name##Eta[i]   = v.Eta();                 \
+    info->name##Theta[i] = v.Theta();               \
+    info->name##Phi[i]   = v.Phi()
+
+#define HITFIT_SET_KINEMATICS(info, name, i, v)     \
+    info->name##Mass[i]  = v.M();                   \
+    HITFIT_SET_MOMENTUM(info, name, i, v)
+
+// C, R, N and inverse of one HitFit resolution
+#define HITFIT_SET_RESOLUTION(info, name, i, res)   \
+    info->name##C[i]       = res.C();               \
+    info->name##R[i]       = res.R();               \
+    info->name##N[i]       = res.N();               \
+    info->name##Inverse[i] = res.inverse()
+
+
+
+class LjmetFactory;
+
+
+
+class HitFitCalc : public BaseCalc{
+
+public:
+
+    HitFitCalc();
+    virtual ~HitFitCalc();
+
+    virtual int BeginJob();
+    virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
+    virtual int EndJob();
+
+
+private:
+
+    struct FitWorker {
+        //
+        // fitter and event workspace of one worker, reused for every fit
+        //
+        FitWorker(hitfit::Top_Fit_Args const & args, double lepWMass, double hadWMass, double topMass):
+        fit(args, lepWMass, hadWMass, topMass),
+        event(0, 0){}
+
+        hitfit::Top_Fit fit;
+        hitfit::Lepjets_Event event;
+        hitfit::Column_Vector pullX;
+        hitfit::Column_Vector pullY;
+    };
+
+    struct Candidate {
+        //
+        // permutation and neutrino solution that passed the pre-checks,
+        // with the unfitted kinematics used for them
+        //
+        size_t permutation;
+        int nuSolution;
+        FourVector neutrino;
+        FourVector lepW;
+        FourVector lepTop;
+        FourVector hadW;
+        FourVector hadTop;
+    };
+
+    struct FitOutput {
+        //
+        // what a worker keeps of a fit before its workspace is reused
+        //
+        double chi2;
+        double mt;
+        double sigmt;
+        double umwhad;
+        double utmass;
+        int jetType[kMAX_HITFIT_JET];
+        FourVector lepton;
+        FourVector neutrino;
+        FourVector jet[kMAX_HITFIT_JET];
+        size_t nPullX;
+        size_t nPullY;
+        double pullX[kMAX_HITFIT_VAR];
+        double pullY[kMAX_HITFIT_VAR];
+    };
+
+    static FourVector toFourVector(hitfit::Fourvec const & v){ return FourVector(v.px(), v.py(), v.pz(), v.e()); }
+    static bool isB(int type){ return type == hitfit::lepb_label || type == hitfit::hadb_label; }
+
+    void startWorkers();
+    void buildPermutations();
+    bool setEvent(edm::EventBase const & event, BaseEventSelector * selector);
+    void prune(BaseEventSelector * selector);
+    bool inWindow(double mass, double target, double window) const { return window <= 0.0 || std::fabs(mass - target) < window; }
+    void fitOne(size_t i, size_t worker);
+    void fillInfo();
+    void setOutputs();
+    template <class T, class V> void setArray(std::string const & name, T const * values, size_t n);
+
+    // configuration
+    int mLepId;
+    int mNuSolution;        // 0 smaller |pz|, 1 larger |pz|, 2 both
+    bool mDebug;
+    double mLepWMass;
+    double mHadWMass;
+    double mTopMass;
+    double mMinLeptonPt;
+    double mMinJetPt;
+    double mMinMet;
+    size_t mMaxNJet;
+    bool mElectronObjRes;
+    bool mMuonObjRes;
+    bool mJetObjRes;
+    bool mMetObjRes;
+    bool mBTagPruning;
+    double mPruneWMass;     // half widths of the pre-check windows, 0 disables
+    double mPruneTopMass;
+    unsigned int mNThreads;
+    std::string mDefaultFile;
+
+    hitfit::LeptonTranslatorBase<pat::Electron> * mpElectronTranslator;
+    hitfit::LeptonTranslatorBase<pat::Muon> * mpMuonTranslator;
+    hitfit::JetTranslatorBase<pat::Jet> * mpJetTranslator;
+    hitfit::METTranslatorBase<pat::MET> * mpMetTranslator;
+
+    WorkerPool * mpPool;
+    std::vector<FitWorker *> mvWorker;
+
+    // jet types of every permutation, per number of jets
+    std::vector<std::vector<std::vector<int> > > mvvPermutation;
+
+    // event, translated once: each jet as b and as light
+    hitfit::Lepjets_Event mBaseEvent;
+    std::vector<hitfit::Lepjets_Event_Jet> mvJetB;
+    std::vector<hitfit::Lepjets_Event_Jet> mvJetLight;
+    std::vector<FourVector> mvP4B;
+    std::vector<FourVector> mvP4Light;
+    std::vector<bool> mvTagged;
+    std::vector<int> mvJetIndex;
+    FourVector mLepton;
+    FourVector mMet;
+    bool mComplexNu;
+    size_t mNPermutations;
+
+    std::vector<Candidate> mvCandidate;
+    std::vector<FitOutput> mvOutput;
+    std::vector<int> mvSorted;
+
+    HitFitInfoBranches * mpInfo;
+
+    long mNFits;
+    long mNPruned;
+};
+
+
+
+//static int reg = LjmetFactory::GetInstance()->Register(new HitFitCalc(), "HitFitCalc");
+
+
+
+HitFitCalc::HitFitCalc():
+mpElectronTranslator(0),
+mpMuonTranslator(0),
+mpJetTranslator(0),
+mpMetTranslator(0),
+mpPool(0),
+mBaseEvent(0, 0),
+mComplexNu(false),
+mNPermutations(0),
+mpInfo(0),
+mNFits(0),
+mNPruned(0){
+}
+
+
+
+HitFitCalc::~HitFitCalc(){
+}
+
+
+
+int HitFitCalc::BeginJob(){
+
+    if (mPset.exists("hitFitLepId")) mLepId = mPset.getParameter<int>("hitFitLepId");
+    else                             mLepId = 13;
+
+    mNuSolution  = mPset.getUntrackedParameter<int>("hitfitNuSolution", 2);
+    mDebug       = mPset.getUntrackedParameter<bool>("hitfitDebug", false);
+    mLepWMass    = mPset.getUntrackedParameter<double>("hitfitLepWMass", 80.4);
+    mHadWMass    = mPset.getUntrackedParameter<double>("hitfitHadWMass", 80.4);
+    mTopMass     = mPset.getUntrackedParameter<double>("hitfitTopMass", 0.0);
+    mMinLeptonPt = mPset.getUntrackedParameter<double>("hitfitMinLeptonPt", 15.0);
+    mMinJetPt    = mPset.getUntrackedParameter<double>("hitfitMinJetPt", 15.0);
+    mMinMet      = mPset.getUntrackedParameter<double>("hitfitMinMET", 0.0);
+    mMaxNJet     = mPset.getUntrackedParameter<unsigned int>("hitfitMaxNJet", kMAX_HITFIT_JET);
+
+    mElectronObjRes = mPset.getUntrackedParameter<bool>("hitfitElectronObjRes", false);
+    mMuonObjRes     = mPset.getUntrackedParameter<bool>("hitfitMuonObjRes", false);
+    mJetObjRes      = mPset.getUntrackedParameter<bool>("hitfitJetObjRes", false);
+    mMetObjRes      = mPset.getUntrackedParameter<bool>("hitfitMETsObjRes", false);
+
+    mBTagPruning  = mPset.getUntrackedParameter<bool>("hitfitBTagPruning", true);
+    mPruneWMass   = mPset.getUntrackedParameter<double>("hitfitPruneWMassWindow", 50.0);
+    mPruneTopMass = mPset.getUntrackedParameter<double>("hitfitPruneTopMassWindow", 100.0);
+
+    mNThreads = mPset.getUntrackedParameter<unsigned int>("hitfitNThreads", 1);
+
+    if (mLepId != 11 && mLepId != 13){
+        std::cout << mLegend << "hitFitLepId must be 11 or 13, not " << mLepId << std::endl;
+        std::exit(-1);
+    }
+    if (mNuSolution < 0 || mNuSolution > 2){
+        std::cout << mLegend << "hitfitNuSolution must be 0, 1 or 2, not " << mNuSolution << std::endl;
+        std::exit(-1);
+    }
+    if (mMaxNJet < kMIN_HITFIT_JET || mMaxNJet > kMAX_HITFIT_JET){
+        std::cout << mLegend << "hitfitMaxNJet must be between " << kMIN_HITFIT_JET
+        << " and " << kMAX_HITFIT_JET << std::endl;
+        std::exit(-1);
+    }
+    if (mNThreads == 0) mNThreads = 1;
+
+    mDefaultFile = mPset.getUntrackedParameter<edm::FileInPath>("hitfitDefault").fullPath();
+    std::string const _electronRes = mPset.getUntrackedParameter<edm::FileInPath>("hitfitElectronResolution").fullPath();
+    std::string const _muonRes = mPset.getUntrackedParameter<edm::FileInPath>("hitfitMuonResolution").fullPath();
+    std::string const _udscRes = mPset.getUntrackedParameter<edm::FileInPath>("hitfitUdscJetResolution").fullPath();
+    std::string const _bRes = mPset.getUntrackedParameter<edm::FileInPath>("hitfitBJetResolution").fullPath();
+    std::string const _metRes = mPset.getUntrackedParameter<edm::FileInPath>("hitfitMETResolution").fullPath();
+    std::string const _jetLevel = mPset.getUntrackedParameter<std::string>("hitfitJetCorrectionLevel", "L3Absolute");
+    double const _udscJes = mPset.getUntrackedParameter<double>("hitfitUdscJES", 1.0);
+    double const _bJes = mPset.getUntrackedParameter<double>("hitfitBJES", 1.0);
+
+    mpElectronTranslator = new hitfit::LeptonTranslatorBase<pat::Electron>(_electronRes);
+    mpMuonTranslator = new hitfit::LeptonTranslatorBase<pat::Muon>(_muonRes);
+    mpJetTranslator = new hitfit::JetTranslatorBase<pat::Jet>(_udscRes, _bRes, _jetLevel, _udscJes, _bJes);
+    mpMetTranslator = new hitfit::METTranslatorBase<pat::MET>(_metRes);
+
+    buildPermutations();
+
+    // zeroed once; every event overwrites the entries it uses
+    mpInfo = new HitFitInfoBranches();
+    mpInfo->clear();
+
+    std::cout << mLegend << "HitFit with up to " << mMaxNJet << " jets, "
+    << mNThreads << " thread(s)" << std::endl;
+
+    return 0;
+}
+
+
+
+void HitFitCalc::startWorkers(){
+    //
+    // the pool threads would not survive the fork of the ljmet
+    // workers, so they are started in the process that uses them
+    //
+
+    // every worker gets its own fitter, they share nothing while fitting
+    hitfit::Defaults_Text const _defaults(mDefaultFile);
+    hitfit::Top_Fit_Args const _args(_defaults);
+    mpPool = new WorkerPool(mNThreads);
+    for (size_t i = 0; i != mpPool->GetNWorkers(); ++i){
+        mvWorker.push_back(new FitWorker(_args, mLepWMass, mHadWMass, mTopMass));
+    }
+}
+
+
+
+void HitFitCalc::buildPermutations(){
+    //
+    // distinct jet type assignments, as enumerated by RunHitFit:
+    // the two W jets share a label, the extra jets are unknown
+    //
+
+    mvvPermutation.assign(mMaxNJet + 1, std::vector<std::vector<int> >());
+    for (size_t n = kMIN_HITFIT_JET; n <= mMaxNJet; ++n){
+        std::vector<int> _types(n, hitfit::unknown_label);
+        _types[0] = hitfit::lepb_label;
+        _types[1] = hitfit::hadb_label;
+        _types[2] = hitfit::hadw1_label;
+        _types[3] = hitfit::hadw1_label;
+        std::sort(_types.begin(), _types.end());
+        do {
+            mvvPermutation[n].push_back(_types);
+        } while (std::next_permutation(_types.begin(), _types.end()));
+    }
+}
+
+
+
+int HitFitCalc::AnalyzeEvent(edm::EventBase const & event,
+                             BaseEventSelector * selector){
+    //
+    // fit the permutations of the leading jets that pass the pre-checks
+    //
+
+    mvCandidate.clear();
+    mNPermutations = 0;
+
+    if (!mpPool) startWorkers();
+
+    if (setEvent(event, selector)){
+        prune(selector);
+
+        mvOutput.resize(mvCandidate.size());
+        mpPool->Run(mvCandidate.size(), [this](size_t i, size_t worker){ fitOne(i, worker); });
+
+        mNFits += mvCandidate.size();
+        mNPruned += (mNuSolution == 2 ? 2 : 1)*mNPermutations - mvCandidate.size();
+    }
+
+    fillInfo();
+    setOutputs();
+
+    return 0;
+}
+
+
+
+bool HitFitCalc::setEvent(edm::EventBase const & event, BaseEventSelector * selector){
+    //
+    // translate the lepton, MET and jets for HitFit, once per event
+    //
+
+    std::vector<edm::Ptr<pat::Jet> >      const & vSelJets = selector->GetSelectedJets();
+    std::vector<edm::Ptr<pat::Jet> >      const & vSelBtagJets = selector->GetSelectedBtagJets();
+    std::vector<edm::Ptr<pat::Muon> >     const & vSelMuons = selector->GetSelectedMuons();
+    std::vector<edm::Ptr<pat::Electron> > const & vSelElectrons = selector->GetSelectedElectrons();
+    edm::Ptr<pat::MET>                    const & pMet = selector->GetMet();
+
+    mvJetIndex.clear();
+
+    if (pMet.isNull() || pMet->pt() < mMinMet) return false;
+
+    if (mLepId == 13 && (vSelMuons.empty() || vSelMuons[0]->pt() < mMinLeptonPt)) return false;
+    if (mLepId == 11 && (vSelElectrons.empty() || vSelElectrons[0]->pt() < mMinLeptonPt)) return false;
+
+    for (size_t i = 0; i != vSelJets.size() && mvJetIndex.size() != mMaxNJet; ++i){
+        if (vSelJets[i]->pt() < mMinJetPt) continue;
+        mvJetIndex.push_back(i);
+    }
+    if (mvJetIndex.size() < kMIN_HITFIT_JET) return false;
+
+    mBaseEvent = hitfit::Lepjets_Event(static_cast<int>(event.id().run()), static_cast<int>(event.id().event()));
+    if (mLepId == 13) mBaseEvent.add_lep((*mpMuonTranslator)(*vSelMuons[0], hitfit::muon_label, mMuonObjRes));
+    else              mBaseEvent.add_lep((*mpElectronTranslator)(*vSelElectrons[0], hitfit::electron_label, mElectronObjRes));
+    mBaseEvent.met() = (*mpMetTranslator)(*pMet, mMetObjRes);
+    mBaseEvent.kt_res() = mpMetTranslator->KtResolution(*pMet, mMetObjRes);
+
+    // the jet correction and resolution depend only on b or light
+    mvJetB.clear();
+    mvJetLight.clear();
+    mvP4B.clear();
+    mvP4Light.clear();
+    mvTagged.clear();
+    for (size_t j = 0; j != mvJetIndex.size(); ++j){
+        pat::Jet const & _jet = *vSelJets[mvJetIndex[j]];
+        mvJetB.push_back((*mpJetTranslator)(_jet, hitfit::hadb_label, mJetObjRes));
+        mvJetLight.push_back((*mpJetTranslator)(_jet, hitfit::unknown_label, mJetObjRes));
+        mvP4B.push_back(toFourVector(mvJetB.back().p()));
+        mvP4Light.push_back(toFourVector(mvJetLight.back().p()));
+        mvTagged.push_back(std::find(vSelBtagJets.begin(), vSelBtagJets.end(), vSelJets[mvJetIndex[j]]) != vSelBtagJets.end());
+        mBaseEvent.add_jet(mvJetLight.back());
+    }
+
+    mLepton = toFourVector(mBaseEvent.lep(0).p());
+    mMet = toFourVector(mBaseEvent.met());
+
+    return true;
+}
+
+
+
+void HitFitCalc::prune(BaseEventSelector * selector){
+    //
+    // keep the permutations and neutrino solutions worth fitting
+    //
+
+    size_t const _nJet = mvJetIndex.size();
+    std::vector<std::vector<int> > const & _perms = mvvPermutation[_nJet];
+    mNPermutations = _perms.size();
+
+    // neutrino solutions as HitFit orders them: smaller |pz| first
+    NeutrinoSolver::Solution const & _solution = selector->GetNeutrinoSolver().Solve(mLepton, mMet, 0.0, mLepWMass);
+    mComplexNu = _solution.IsComplex();
+    double _pz[2] = { _solution.GetPz(0), _solution.GetPz(1) };
+    if (std::fabs(_pz[1]) < std::fabs(_pz[0])) std::swap(_pz[0], _pz[1]);
+
+    FourVector _nu[2];
+    FourVector _lepW[2];
+    for (int s = 0; s != 2; ++s){
+        double const _e = std::sqrt(mMet.Pt2() + _pz[s]*_pz[s]);
+        _nu[s] = FourVector(mMet.Px(), mMet.Py(), _pz[s], _e);
+        _lepW[s] = mLepton + _nu[s];
+    }
+
+    // the b slots take as many of the tagged jets as they can hold
+    size_t _nTagged = 0;
+    for (size_t j = 0; j != _nJet; ++j) if (mvTagged[j]) ++_nTagged;
+    size_t const _nTaggedB = std::min<size_t>(_nTagged, 2);
+
+    for (size_t p = 0; p != _perms.size() && mvCandidate.size() + 2 <= kMAX_HITFIT; ++p){
+        std::vector<int> const & _types = _perms[p];
+
+        int _lepB = -1;
+        int _hadB = -1;
+        size_t _nTagB = 0;
+        FourVector _hadW;
+        for (size_t j = 0; j != _nJet; ++j){
+            if (_types[j] == hitfit::lepb_label) _lepB = j;
+            else if (_types[j] == hitfit::hadb_label) _hadB = j;
+            else if (_types[j] == hitfit::hadw1_label) _hadW += mvP4Light[j];
+            if (isB(_types[j]) && mvTagged[j]) ++_nTagB;
+        }
+        if (mBTagPruning && _nTagB != _nTaggedB) continue;
+        if (!inWindow(_hadW.M(), mHadWMass, mPruneWMass)) continue;
+
+        FourVector const _hadTop = _hadW + mvP4B[_hadB];
+        double const _mHadTop = _hadTop.M();
+        if (mTopMass > 0.0 && !inWindow(_mHadTop, mTopMass, mPruneTopMass)) continue;
+
+        for (int s = 0; s != 2; ++s){
+            if (mNuSolution != 2 && s != mNuSolution) continue;
+            FourVector const _lepTop = _lepW[s] + mvP4B[_lepB];
+            // a free top mass is still the same for both tops
+            double const _target = mTopMass > 0.0 ? mTopMass : _mHadTop;
+            if (!inWindow(_lepTop.M(), _target, mPruneTopMass)) continue;
+
+            Candidate _c;
+            _c.permutation = p;
+            _c.nuSolution = s;
+            _c.neutrino = _nu[s];
+            _c.lepW = _lepW[s];
+            _c.lepTop = _lepTop;
+            _c.hadW = _hadW;
+            _c.hadTop = _hadTop;
+            mvCandidate.push_back(_c);
+        }
+    }
+}
+
+
+
+void HitFitCalc::fitOne(size_t i, size_t worker){
+    //
+    // runs on a worker thread: touches only its own workspace and output
+    //
+
+    Candidate const & _c = mvCandidate[i];
+    std::vector<int> const & _types = mvvPermutation[mvJetIndex.size()][_c.permutation];
+    FitWorker & _w = *mvWorker[worker];
+    FitOutput & _out = mvOutput[i];
+
+    // copy-assignment keeps the capacity of the workspace vectors
+    _w.event = mBaseEvent;
+    for (size_t j = 0; j != _types.size(); ++j){
+        _w.event.jet(j) = isB(_types[j]) ? mvJetB[j] : mvJetLight[j];
+        _w.event.jet(j).type() = _types[j];
+    }
+
+    bool _nuz = (_c.nuSolution == 1);
+    _out.chi2 = _w.fit.fit_one_perm(_w.event, _nuz,
+                                    _out.umwhad, _out.utmass, _out.mt, _out.sigmt,
+                                    _w.pullX, _w.pullY);
+
+    _out.lepton = toFourVector(_w.event.lep(0).p());
+    _out.neutrino = toFourVector(_w.event.met());
+    for (size_t j = 0; j != _types.size(); ++j){
+        _out.jetType[j] = _w.event.jet(j).type();
+        _out.jet[j] = toFourVector(_w.event.jet(j).p());
+    }
+    _out.nPullX = std::min<size_t>(_w.pullX.num_row(), kMAX_HITFIT_VAR);
+    _out.nPullY = std::min<size_t>(_w.pullY.num_row(), kMAX_HITFIT_VAR);
+    for (size_t v = 0; v != _out.nPullX; ++v) _out.pullX[v] = _w.pullX[v];
+    for (size_t v = 0; v != _out.nPullY; ++v) _out.pullY[v] = _w.pullY[v];
+}
+
+
+
+void HitFitCalc::fillInfo(){
+    //
+    // HitFitInfoBranches entries of the fits done in this event
+    //
+
+    HitFitInfoBranches * const _info = mpInfo;
+    size_t const _nFit = mvCandidate.size();
+    size_t const _nJet = _nFit > 0 ? mvJetIndex.size() : 0;
+
+    _info->hitfit = (_nFit > 0);
+    _info->nHitFit = _nFit;
+    _info->nHitFitJet = _nJet;
+    _info->nHitFitXnHitFitJet = _nFit*_nJet;
+    _info->LepInfoIndex = (_nFit > 0 ? 0 : -1);
+    for (size_t j = 0; j != _nJet; ++j){
+        _info->JetIndex[j] = mvJetIndex[j];
+        _info->JetInfoIndex[j] = mvJetIndex[j];
+    }
+
+    size_t _nX = 0;
+    size_t _nY = 0;
+    for (size_t i = 0; i != _nFit; ++i){
+        _nX = std::max(_nX, mvOutput[i].nPullX);
+        _nY = std::max(_nY, mvOutput[i].nPullY);
+    }
+    _info->hitfitNX = _nX;
+    _info->hitfitNY = _nY;
+    _info->nHitFitXnX = _nFit*_nX;
+    _info->nHitFitXnY = _nFit*_nY;
+
+    // the lepton and kt resolutions are the same for every fit
+    if (_nFit > 0){
+        hitfit::Vector_Resolution const & _lepRes = mBaseEvent.lep(0).res();
+        _info->unfittedLeptonPResC = _lepRes.p_res().C();
+        _info->unfittedLeptonPResR = _lepRes.p_res().R();
+        _info->unfittedLeptonPResN = _lepRes.p_res().N();
+        _info->unfittedLeptonPResInverse = _lepRes.p_res().inverse();
+        _info->unfittedLeptonEtaResC = _lepRes.eta_res().C();
+        _info->unfittedLeptonEtaResR = _lepRes.eta_res().R();
+        _info->unfittedLeptonEtaResN = _lepRes.eta_res().N();
+        _info->unfittedLeptonEtaResInverse = _lepRes.eta_res().inverse();
+        _info->unfittedLeptonPhiResC = _lepRes.phi_res().C();
+        _info->unfittedLeptonPhiResR = _lepRes.phi_res().R();
+        _info->unfittedLeptonPhiResN = _lepRes.phi_res().N();
+        _info->unfittedLeptonPhiResInverse = _lepRes.phi_res().inverse();
+        _info->unfittedLeptonResPtFlag = _lepRes.use_et();
+
+        hitfit::Resolution const & _ktRes = mBaseEvent.kt_res();
+        _info->unfittedKtResC = _ktRes.C();
+        _info->unfittedKtResR = _ktRes.R();
+        _info->unfittedKtResN = _ktRes.N();
+        _info->unfittedKtResInverse = _ktRes.inverse();
+    }
+
+    _info->nHitFitConverge = 0;
+    _info->MinChi2Index = -1;
+    _info->MaxChi2Index = -1;
+    _info->SumExpHalfChi2 = 0.0;
+
+    for (size_t i = 0; i != _nFit; ++i){
+        Candidate const & _c = mvCandidate[i];
+        FitOutput const & _out = mvOutput[i];
+        std::vector<int> const & _types = mvvPermutation[_nJet][_c.permutation];
+
+        FourVector _fittedHadW;
+        FourVector _fittedHadB;
+        FourVector _fittedLepB;
+        for (size_t j = 0; j != _nJet; ++j){
+            size_t const _k = i*_nJet + j;
+            bool const _b = isB(_types[j]);
+            FourVector const & _unfitted = _b ? mvP4B[j] : mvP4Light[j];
+            hitfit::Vector_Resolution const & _res = _b ? mvJetB[j].res() : mvJetLight[j].res();
+            _info->JetType[_k] = _out.jetType[j];
+            HITFIT_SET_KINEMATICS(_info, unfittedJet, _k, _unfitted);
+            HITFIT_SET_KINEMATICS(_info, fittedJet, _k, _out.jet[j]);
+            HITFIT_SET_RESOLUTION(_info, unfittedJetPRes, _k, _res.p_res());
+            HITFIT_SET_RESOLUTION(_info, unfittedJetEtaRes, _k, _res.eta_res());
+            HITFIT_SET_RESOLUTION(_info, unfittedJetPhiRes, _k, _res.phi_res());
+            _info->unfittedJetResPtFlag[_k] = _res.use_et();
+
+            if (_out.jetType[j] == hitfit::lepb_label) _fittedLepB = _out.jet[j];
+            else if (_out.jetType[j] == hitfit::hadb_label) _fittedHadB = _out.jet[j];
+            else if (_out.jetType[j] == hitfit::hadw1_label || _out.jetType[j] == hitfit::hadw2_label) _fittedHadW += _out.jet[j];
+        }
+
+        _info->NeutrinoSol[i] = (_c.nuSolution == 1);
+        _info->RealNeutrinoSol[i] = !mComplexNu;
+        HITFIT_SET_MOMENTUM(_info, unfittedNeutrino, i, _c.neutrino);
+        _info->unfittedNeutrinoPzRe[i] = _c.neutrino.Pz();
+        HITFIT_SET_KINEMATICS(_info, unfittedLepW, i, _c.lepW);
+        HITFIT_SET_KINEMATICS(_info, unfittedLepTop, i, _c.lepTop);
+        HITFIT_SET_KINEMATICS(_info, unfittedHadW, i, _c.hadW);
+        HITFIT_SET_KINEMATICS(_info, unfittedHadTop, i, _c.hadTop);
+        FourVector const _unfittedTt = _c.lepTop + _c.hadTop;
+        HITFIT_SET_KINEMATICS(_info, unfittedTt, i, _unfittedTt);
+        _info->unfittedTopMass[i] = _out.utmass;
+
+        FourVector const _fittedLepW = _out.lepton + _out.neutrino;
+        FourVector const _fittedLepTop = _fittedLepW + _fittedLepB;
+        FourVector const _fittedHadTop = _fittedHadW + _fittedHadB;
+        FourVector const _fittedTt = _fittedLepTop + _fittedHadTop;
+        HITFIT_SET_MOMENTUM(_info, fittedLepton, i, _out.lepton);
+        HITFIT_SET_MOMENTUM(_info, fittedNeutrino, i, _out.neutrino);
+        HITFIT_SET_KINEMATICS(_info, fittedLepW, i, _fittedLepW);
+        HITFIT_SET_KINEMATICS(_info, fittedLepTop, i, _fittedLepTop);
+        HITFIT_SET_KINEMATICS(_info, fittedHadW, i, _fittedHadW);
+        HITFIT_SET_KINEMATICS(_info, fittedHadTop, i, _fittedHadTop);
+        HITFIT_SET_KINEMATICS(_info, fittedTt, i, _fittedTt);
+        _info->fittedTopMass[i] = _out.mt;
+        _info->fittedTopMassSigma[i] = _out.sigmt;
+
+        // HitFit returns a negative chi2 when the fit fails
+        bool const _converge = (_out.chi2 >= 0.0);
+        _info->Chi2[i] = _out.chi2;
+        _info->Converge[i] = _converge;
+        for (size_t v = 0; v != _nX; ++v) _info->PullX[i*_nX + v] = v < _out.nPullX ? _out.pullX[v] : 0.0;
+        for (size_t v = 0; v != _nY; ++v) _info->PullY[i*_nY + v] = v < _out.nPullY ? _out.pullY[v] : 0.0;
+
+        _info->ExpHalfChi2[i] = _converge ? std::exp(-0.5*_out.chi2) : 0.0;
+        _info->SumExpHalfChi2 += _info->ExpHalfChi2[i];
+        if (!_converge) continue;
+        ++_info->nHitFitConverge;
+        if (_info->MinChi2Index < 0 || _out.chi2 < _info->Chi2[_info->MinChi2Index]) _info->MinChi2Index = i;
+        if (_info->MaxChi2Index < 0 || _out.chi2 > _info->Chi2[_info->MaxChi2Index]) _info->MaxChi2Index = i;
+    }
+    _info->AllConverge = (_nFit > 0 && _info->nHitFitConverge == _nFit);
+
+    _info->SumChi2Probability = 0.0;
+    for (size_t i = 0; i != _nFit; ++i){
+        _info->Chi2Probability[i] = _info->SumExpHalfChi2 > 0.0 ? _info->ExpHalfChi2[i]/_info->SumExpHalfChi2 : 0.0;
+        _info->SumChi2Probability += _info->Chi2Probability[i];
+    }
+
+    // converged fits by increasing chi2, then the failed ones
+    mvSorted.resize(_nFit);
+    for (size_t i = 0; i != _nFit; ++i) mvSorted[i] = i;
+    std::stable_sort(mvSorted.begin(), mvSorted.end(), [_info](int a, int b){
+        if (_info->Converge[a] != _info->Converge[b]) return static_cast<bool>(_info->Converge[a]);
+        return _info->Converge[a] && _info->Chi2[a] < _info->Chi2[b];
+    });
+    for (size_t i = 0; i != _nFit; ++i) _info->SortedChi2Index[i] = mvSorted[i];
+}
+
+
+
+template <class T, class V>
+void HitFitCalc::setArray(std::string const & name, T const * values, size_t n){
+    //
+    // the first n entries of a HitFitInfoBranches array, as a vector branch
+    //
+
+    ArenaVector<V> _v(values, values + n, GetArena());
+    SetValue(name, _v);
+}
+
+
+
+void HitFitCalc::setOutputs(){
+    //
+    // per-fit results, and the best fit, for the ntuple
+    //
+
+    HitFitInfoBranches const * const _info = mpInfo;
+    size_t const _nFit = _info->nHitFit;
+    size_t const _nFitJet = _info->nHitFitXnHitFitJet;
+
+    SetValue("hitfitN", static_cast<int>(_nFit));
+    SetValue("hitfitNJet", static_cast<int>(_info->nHitFitJet));
+    SetValue("hitfitNConverge", static_cast<int>(_info->nHitFitConverge));
+    SetValue("hitfitNPruned", static_cast<int>((mNuSolution == 2 ? 2 : 1)*mNPermutations - _nFit));
+    setArray<Double_t, double>("hitfitChi2", _info->Chi2, _nFit);
+    setArray<Double_t, double>("hitfitChi2Probability", _info->Chi2Probability, _nFit);
+    setArray<Bool_t, int>("hitfitConverge", _info->Converge, _nFit);
+    setArray<Int_t, int>("hitfitSortedChi2Index", _info->SortedChi2Index, _nFit);
+    setArray<Bool_t, int>("hitfitNeutrinoSolution", _info->NeutrinoSol, _nFit);
+    setArray<Int_t, int>("hitfitJetType", _info->JetType, _nFitJet);
+    setArray<Double_t, double>("hitfitFittedTopMass", _info->fittedTopMass, _nFit);
+    setArray<Double_t, double>("hitfitFittedTopMassSigma", _info->fittedTopMassSigma, _nFit);
+    setArray<Double_t, double>("hitfitUnfittedHadWMass", _info->unfittedHadWMass, _nFit);
+    setArray<Double_t, double>("hitfitUnfittedHadTopMass", _info->unfittedHadTopMass, _nFit);
+    setArray<Double_t, double>("hitfitUnfittedLepTopMass", _info->unfittedLepTopMass, _nFit);
+    setArray<Double_t, double>("hitfitUnfittedTtMass", _info->unfittedTtMass, _nFit);
+    setArray<Double_t, double>("hitfitUnfittedNeutrinoPz", _info->unfittedNeutrinoPz, _nFit);
+
+    // fitted objects of every fit
+    setArray<Double_t, double>("hitfitFittedLeptonPt", _info->fittedLeptonPt, _nFit);
+    setArray<Double_t, double>("hitfitFittedLeptonEta", _info->fittedLeptonEta, _nFit);
+    setArray<Double_t, double>("hitfitFittedLeptonPhi", _info->fittedLeptonPhi, _nFit);
+    setArray<Double_t, double>("hitfitFittedLeptonE", _info->fittedLeptonE, _nFit);
+    setArray<Double_t, double>("hitfitFittedNeutrinoPt", _info->fittedNeutrinoPt, _nFit);
+    setArray<Double_t, double>("hitfitFittedNeutrinoEta", _info->fittedNeutrinoEta, _nFit);
+    setArray<Double_t, double>("hitfitFittedNeutrinoPhi", _info->fittedNeutrinoPhi, _nFit);
+    setArray<Double_t, double>("hitfitFittedNeutrinoPz", _info->fittedNeutrinoPz, _nFit);
+    setArray<Double_t, double>("hitfitFittedLepWMass", _info->fittedLepWMass, _nFit);
+    setArray<Double_t, double>("hitfitFittedHadWMass", _info->fittedHadWMass, _nFit);
+    setArray<Double_t, double>("hitfitFittedLepTopMass", _info->fittedLepTopMass, _nFit);
+    setArray<Double_t, double>("hitfitFittedHadTopMass", _info->fittedHadTopMass, _nFit);
+    setArray<Double_t, double>("hitfitFittedTtMass", _info->fittedTtMass, _nFit);
+
+    // jets of every fit, hitfitNJet per fit
+    setArray<Double_t, double>("hitfitUnfittedJetPt", _info->unfittedJetPt, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetEta", _info->unfittedJetEta, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetPhi", _info->unfittedJetPhi, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetE", _info->unfittedJetE, _nFitJet);
+    setArray<Double_t, double>("hitfitFittedJetPt", _info->fittedJetPt, _nFitJet);
+    setArray<Double_t, double>("hitfitFittedJetEta", _info->fittedJetEta, _nFitJet);
+    setArray<Double_t, double>("hitfitFittedJetPhi", _info->fittedJetPhi, _nFitJet);
+    setArray<Double_t, double>("hitfitFittedJetE", _info->fittedJetE, _nFitJet);
+
+    // resolutions the fits used
+    setArray<Double_t, double>("hitfitUnfittedJetPResC", _info->unfittedJetPResC, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetPResR", _info->unfittedJetPResR, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetPResN", _info->unfittedJetPResN, _nFitJet);
+    setArray<Bool_t, int>("hitfitUnfittedJetPResInverse", _info->unfittedJetPResInverse, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetEtaResC", _info->unfittedJetEtaResC, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetEtaResR", _info->unfittedJetEtaResR, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetEtaResN", _info->unfittedJetEtaResN, _nFitJet);
+    setArray<Bool_t, int>("hitfitUnfittedJetEtaResInverse", _info->unfittedJetEtaResInverse, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetPhiResC", _info->unfittedJetPhiResC, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetPhiResR", _info->unfittedJetPhiResR, _nFitJet);
+    setArray<Double_t, double>("hitfitUnfittedJetPhiResN", _info->unfittedJetPhiResN, _nFitJet);
+    setArray<Bool_t, int>("hitfitUnfittedJetPhiResInverse", _info->unfittedJetPhiResInverse, _nFitJet);
+    setArray<Bool_t, int>("hitfitUnfittedJetResPtFlag", _info->unfittedJetResPtFlag, _nFitJet);
+
+    SetValue("hitfitUnfittedLeptonPResC", _info->unfittedLeptonPResC);
+    SetValue("hitfitUnfittedLeptonPResR", _info->unfittedLeptonPResR);
+    SetValue("hitfitUnfittedLeptonPResN", _info->unfittedLeptonPResN);
+    SetValue("hitfitUnfittedLeptonEtaResC", _info->unfittedLeptonEtaResC);
+    SetValue("hitfitUnfittedLeptonEtaResR", _info->unfittedLeptonEtaResR);
+    SetValue("hitfitUnfittedLeptonEtaResN", _info->unfittedLeptonEtaResN);
+    SetValue("hitfitUnfittedLeptonPhiResC", _info->unfittedLeptonPhiResC);
+    SetValue("hitfitUnfittedLeptonPhiResR", _info->unfittedLeptonPhiResR);
+    SetValue("hitfitUnfittedLeptonPhiResN", _info->unfittedLeptonPhiResN);
+    SetValue("hitfitUnfittedLeptonResPtFlag", static_cast<int>(_info->unfittedLeptonResPtFlag));
+    SetValue("hitfitUnfittedKtResC", _info->unfittedKtResC);
+    SetValue("hitfitUnfittedKtResR", _info->unfittedKtResR);
+    SetValue("hitfitUnfittedKtResN", _info->unfittedKtResN);
+
+    // pulls of every fit, hitfitNX and hitfitNY per fit
+    SetValue("hitfitNX", static_cast<int>(_info->hitfitNX));
+    SetValue("hitfitNY", static_cast<int>(_info->hitfitNY));
+    setArray<Double_t, double>("hitfitPullX", _info->PullX, _info->nHitFitXnX);
+    setArray<Double_t, double>("hitfitPullY", _info->PullY, _info->nHitFitXnY);
+
+    int const _best = _info->MinChi2Index;
+    SetValue("hitfitBestIndex", _best);
+    SetValue("hitfitBestChi2", _best < 0 ? -1.0 : _info->Chi2[_best]);
+    SetValue("hitfitBestTopMass", _best < 0 ? -1.0 : _info->fittedTopMass[_best]);
+    SetValue("hitfitBestTopMassSigma", _best < 0 ? -1.0 : _info->fittedTopMassSigma[_best]);
+    SetValue("hitfitBestTtMass", _best < 0 ? -1.0 : _info->fittedTtMass[_best]);
+
+    if (mDebug){
+        std::cout << mLegend << _nFit << " fits of " << (mNuSolution == 2 ? 2 : 1)*mNPermutations
+        << " permutations, " << _info->nHitFitConverge << " converged";
+        if (_best >= 0) std::cout << ", best chi2 " << _info->Chi2[_best] << " top mass " << _info->fittedTopMass[_best];
+        std::cout << std::endl;
+    }
+}
+
+
+
+int HitFitCalc::EndJob(){
+
+    std::cout << mLegend << "HitFit fits: " << mNFits
+    << ", permutations pruned before fitting: " << mNPruned << std::endl;
+
+    delete mpPool;
+    mpPool = 0;
+    for (size_t i = 0; i != mvWorker.size(); ++i) delete mvWorker[i];
+    mvWorker.clear();
+
+    delete mpInfo;
+    mpInfo = 0;
+
+    delete mpElectronTranslator;
+    delete mpMuonTranslator;
+    delete mpJetTranslator;
+    delete mpMetTranslator;
+    mpElectronTranslator = 0;
+    mpMuonTranslator = 0;
+    mpJetTranslator = 0;
+    mpMetTranslator = 0;
+
+    return 0;
+}
@@ -0,0 +1,416 @@
+/*
+ Calculator for lepton isolation recomputed from the packed PF candidates
+
+ Mini-isolation, with a cone of miniIsoKt/pt kept between miniIsoMinCone
+ and miniIsoMaxCone, and the fixed cones of isoCones, for the selected
+ muons and electrons. The candidates are sorted once per event into
+ eta-phi indices of charged hadrons from the primary vertex, charged
+ pileup, neutral hadrons and photons. Each lepton visits the candidates
+ inside its largest cone once, filling the sums of all its cones.
+
+ The neutral sums are corrected for pileup with delta-beta (half the
+ charged pileup) and with rho times an effective area scaled to the cone.
+ Veto cones and thresholds follow the SUSY mini-isolation recipe.
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LJMet/Com/interface/BaseCalc.h"
+#include "LJMet/Com/interface/LjmetFactory.h"
+#include "LJMet/Com/interface/LjmetEventContent.h"
+#include "LJMet/Com/interface/EtaPhiIndex.h"
+#include "DataFormats/PatCandidates/interface/PackedCandidate.h"
+#include "DataFormats/PatCandidates/interface/Muon.h"
+#include "DataFormats/PatCandidates/interface/Electron.h"
+
+
+
+class LjmetFactory;
+
+
+
+class IsolationCalc : public BaseCalc{
+
+public:
+
+    IsolationCalc();
+    virtual ~IsolationCalc();
+
+    virtual int BeginJob();
+    virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
+    virtual int EndJob(){ return 0; }
+    virtual bool HasSideEffects() const { return false; }
+
+
+private:
+
+    enum Category { kCharged, kChargedPU, kNeutral, kPhoton, kNCategories };
+
+    struct Vetoes {
+        //
+        // veto cone around the lepton and pt threshold, per category
+        //
+        double deadCone2[kNCategories];
+        double minPt[kNCategories];
+    };
+
+    struct LeptonOutputs {
+        //
+        // output branches of one lepton flavour, one entry per selected lepton
+        //
+        std::vector<double> miniCone;
+        std::vector<double> miniCh;
+        std::vector<double> miniNh;
+        std::vector<double> miniPh;
+        std::vector<double> miniPU;
+        std::vector<double> miniDB;
+        std::vector<double> miniEA;
+        std::vector<std::vector<double> > vRelDB;   // per fixed cone
+        std::vector<std::vector<double> > vRelEA;
+    };
+
+    struct AddPt {
+        //
+        // EtaPhiIndex visitor adding candidate pt to every cone containing it
+        //
+        AddPt(std::vector<pat::PackedCandidate> const & c, std::vector<double> const & cone2, double dead2, double min, double * s):
+        cands(c), vCone2(cone2), deadCone2(dead2), minPt(min), sum(s){}
+
+        void operator()(int key, double dr2){
+            if (dr2 < deadCone2) return;
+            double const _pt = cands[key].pt();
+            if (minPt > 0.0 && _pt <= minPt) return;
+            for (size_t c = 0; c != vCone2.size(); ++c){
+                if (dr2 < vCone2[c]) sum[c] += _pt;
+            }
+        }
+
+        std::vector<pat::PackedCandidate> const & cands;
+        std::vector<double> const & vCone2;
+        double deadCone2;
+        double minPt;
+        double * sum;
+    };
+
+    static int category(pat::PackedCandidate const & cand);
+    static double effectiveArea(std::vector<double> const & etaBins, std::vector<double> const & areas, double eta);
+
+    void buildIndices(std::vector<pat::PackedCandidate> const & cands);
+    void isolate(std::vector<pat::PackedCandidate> const & cands, double pt, double eta, double phi, Vetoes const & vetoes);
+    void fill(LeptonOutputs & out, double pt, double ea);
+    void setOutputs(std::string const & prefix, LeptonOutputs const & out);
+    static void clear(LeptonOutputs & out);
+
+    // configuration
+    edm::InputTag mPFCandsSrc;
+    edm::InputTag mRhoSrc;
+    double mMiniIsoKt;
+    double mMiniIsoMinCone;
+    double mMiniIsoMaxCone;
+    std::vector<double> mvIsoCone;
+    std::vector<std::string> mvConeLabel;
+    std::vector<double> mvMuEAEtaBins;
+    std::vector<double> mvMuEA;
+    std::vector<double> mvElEAEtaBins;
+    std::vector<double> mvElEA;
+
+    Vetoes mMuonVetoes;
+    Vetoes mElectronBarrelVetoes;
+    Vetoes mElectronEndcapVetoes;
+
+    // per event
+    EtaPhiIndex mIndex[kNCategories];
+    double mRho;
+    std::vector<double> mvCone;         // cone 0 is the mini-isolation cone
+    std::vector<double> mvCone2;
+    std::vector<double> mvSum;          // kNCategories x cones
+
+    LeptonOutputs mMuons;
+    LeptonOutputs mElectrons;
+};
+
+
+
+//static int reg = LjmetFactory::GetInstance()->Register(new IsolationCalc(), "IsolationCalc");
+
+
+
+IsolationCalc::IsolationCalc():
+mRho(0.0){
+}
+
+
+
+IsolationCalc::~IsolationCalc(){
+}
+
+
+
+int IsolationCalc::BeginJob(){
+
+    if (mPset.exists("packedPFCands")) mPFCandsSrc = mPset.getParameter<edm::InputTag>("packedPFCands");
+    else                               mPFCandsSrc = edm::InputTag("packedPFCandidates");
+
+    if (mPset.exists("rhoSrc")) mRhoSrc = mPset.getParameter<edm::InputTag>("rhoSrc");
+    else                        mRhoSrc = edm::InputTag("fixedGridRhoFastjetAll");
+
+    mMiniIsoKt      = mPset.getUntrackedParameter<double>("miniIsoKt", 10.0);
+    mMiniIsoMinCone = mPset.getUntrackedParameter<double>("miniIsoMinCone", 0.05);
+    mMiniIsoMaxCone = mPset.getUntrackedParameter<double>("miniIsoMaxCone", 0.2);
+
+    std::vector<double> _cones;
+    _cones.push_back(0.3);
+    _cones.push_back(0.4);
+    mvIsoCone = mPset.getUntrackedParameter<std::vector<double> >("isoCones", _cones);
+
+    // Spring15 effective areas: muons as used with mini-isolation, electrons for cone 0.3
+    double const _muBins[] = {0.0, 0.8, 1.3, 2.0, 2.2, 2.5};
+    double const _muEA[]   = {0.0735, 0.0619, 0.0465, 0.0433, 0.0577};
+    double const _elBins[] = {0.0, 1.0, 1.479, 2.0, 2.2, 2.3, 2.4, 2.5};
+    double const _elEA[]   = {0.1752, 0.1862, 0.1411, 0.1534, 0.1903, 0.2243, 0.2687};
+    mvMuEAEtaBins = mPset.getUntrackedParameter<std::vector<double> >("muEAEtaBins", std::vector<double>(_muBins, _muBins + 6));
+    mvMuEA        = mPset.getUntrackedParameter<std::vector<double> >("muEffectiveAreas", std::vector<double>(_muEA, _muEA + 5));
+    mvElEAEtaBins = mPset.getUntrackedParameter<std::vector<double> >("elEAEtaBins", std::vector<double>(_elBins, _elBins + 8));
+    mvElEA        = mPset.getUntrackedParameter<std::vector<double> >("elEffectiveAreas", std::vector<double>(_elEA, _elEA + 7));
+
+    if (mvMuEAEtaBins.size() != mvMuEA.size() + 1 || mvElEAEtaBins.size() != mvElEA.size() + 1){
+        std::cout << mLegend << "effective area tables need one more eta bin edge than areas" << std::endl;
+        std::exit(-1);
+    }
+    if (mMiniIsoMinCone <= 0.0 || mMiniIsoMaxCone < mMiniIsoMinCone){
+        std::cout << mLegend << "bad mini-isolation cone range "
+        << mMiniIsoMinCone << " - " << mMiniIsoMaxCone << std::endl;
+        std::exit(-1);
+    }
+
+    // branch suffix of each fixed cone, 0.3 -> 03
+    double _maxCone = mMiniIsoMaxCone;
+    for (size_t c = 0; c != mvIsoCone.size(); ++c){
+        char _label[32];
+        std::snprintf(_label, sizeof(_label), "%g", mvIsoCone[c]);
+        std::string _suffix(_label);
+        _suffix.erase(std::remove(_suffix.begin(), _suffix.end(), '.'), _suffix.end());
+        mvConeLabel.push_back(_suffix);
+        _maxCone = std::max(_maxCone, mvIsoCone[c]);
+    }
+
+    // cells about the size of the largest cone
+    for (int c = 0; c != kNCategories; ++c) mIndex[c] = EtaPhiIndex(_maxCone, 5.0);
+
+    mvCone.assign(mvIsoCone.size() + 1, 0.0);
+    mvCone2.assign(mvIsoCone.size() + 1, 0.0);
+    for (size_t c = 0; c != mvIsoCone.size(); ++c){
+        mvCone[c+1] = mvIsoCone[c];
+        mvCone2[c+1] = mvIsoCone[c]*mvIsoCone[c];
+    }
+    mvSum.assign(kNCategories*mvCone.size(), 0.0);
+    mMuons.vRelDB.resize(mvIsoCone.size());
+    mMuons.vRelEA.resize(mvIsoCone.size());
+    mElectrons.vRelDB.resize(mvIsoCone.size());
+    mElectrons.vRelEA.resize(mvIsoCone.size());
+
+    // muons: small veto cones, 0.5 GeV threshold for all but charged from the PV
+    mMuonVetoes.deadCone2[kCharged]   = 0.0001*0.0001;
+    mMuonVetoes.deadCone2[kChargedPU] = 0.01*0.01;
+    mMuonVetoes.deadCone2[kNeutral]   = 0.01*0.01;
+    mMuonVetoes.deadCone2[kPhoton]    = 0.01*0.01;
+    mMuonVetoes.minPt[kCharged]   = 0.0;
+    mMuonVetoes.minPt[kChargedPU] = 0.5;
+    mMuonVetoes.minPt[kNeutral]   = 0.5;
+    mMuonVetoes.minPt[kPhoton]    = 0.5;
+
+    // electrons: no vetoes in the barrel; tracks and photons from the
+    // electron footprint are vetoed in the endcaps
+    for (int c = 0; c != kNCategories; ++c){
+        mElectronBarrelVetoes.deadCone2[c] = 0.0;
+        mElectronBarrelVetoes.minPt[c] = 0.0;
+        mElectronEndcapVetoes.minPt[c] = 0.0;
+    }
+    mElectronEndcapVetoes.deadCone2[kCharged]   = 0.015*0.015;
+    mElectronEndcapVetoes.deadCone2[kChargedPU] = 0.015*0.015;
+    mElectronEndcapVetoes.deadCone2[kNeutral]   = 0.0;
+    mElectronEndcapVetoes.deadCone2[kPhoton]    = 0.08*0.08;
+
+    return 0;
+}
+
+
+
+int IsolationCalc::AnalyzeEvent(edm::EventBase const & event,
+                                BaseEventSelector * selector){
+    //
+    // isolation of the selected leptons from one pass over the candidates
+    //
+
+    std::vector<edm::Ptr<pat::Muon> > const & vSelMuons = selector->GetSelectedMuons();
+    std::vector<edm::Ptr<pat::Electron> > const & vSelElectrons = selector->GetSelectedElectrons();
+
+    clear(mMuons);
+    clear(mElectrons);
+
+    if (!vSelMuons.empty() || !vSelElectrons.empty()){
+        edm::Handle<std::vector<pat::PackedCandidate> > hPFCands;
+        event.getByLabel(mPFCandsSrc, hPFCands);
+        std::vector<pat::PackedCandidate> const & _cands = *hPFCands;
+
+        edm::Handle<double> hRho;
+        event.getByLabel(mRhoSrc, hRho);
+        if (!hRho.isValid()){
+            std::cout << mLegend << "rho " << mRhoSrc.encode()
+            << " not found in the event, check rhoSrc" << std::endl;
+            std::exit(-1);
+        }
+        mRho = std::max(*hRho, 0.0);
+
+        buildIndices(_cands);
+
+        for (size_t i = 0; i != vSelMuons.size(); ++i){
+            pat::Muon const & _mu = *vSelMuons[i];
+            isolate(_cands, _mu.pt(), _mu.eta(), _mu.phi(), mMuonVetoes);
+            fill(mMuons, _mu.pt(), effectiveArea(mvMuEAEtaBins, mvMuEA, _mu.eta()));
+        }
+
+        for (size_t i = 0; i != vSelElectrons.size(); ++i){
+            pat::Electron const & _el = *vSelElectrons[i];
+            double const _scEta = _el.superCluster().isNonnull() ? _el.superCluster()->eta() : _el.eta();
+            bool const _endcap = std::fabs(_scEta) > 1.479;
+            isolate(_cands, _el.pt(), _el.eta(), _el.phi(), _endcap ? mElectronEndcapVetoes : mElectronBarrelVetoes);
+            fill(mElectrons, _el.pt(), effectiveArea(mvElEAEtaBins, mvElEA, _scEta));
+        }
+    }
+
+    setOutputs("mu", mMuons);
+    setOutputs("el", mElectrons);
+
+    return 0;
+}
+
+
+
+int IsolationCalc::category(pat::PackedCandidate const & cand){
+    if (cand.charge() != 0){
+        if (cand.fromPV() > 1) return std::abs(cand.pdgId()) == 211 ? kCharged : -1;
+        return kChargedPU;
+    }
+    if (cand.pdgId() == 130) return kNeutral;
+    if (cand.pdgId() == 22) return kPhoton;
+    return -1;
+}
+
+
+
+double IsolationCalc::effectiveArea(std::vector<double> const & etaBins, std::vector<double> const & areas, double eta){
+    // beyond the last edge, the last area
+    double const _absEta = std::fabs(eta);
+    for (size_t i = 0; i != areas.size(); ++i){
+        if (_absEta < etaBins[i+1]) return areas[i];
+    }
+    return areas.empty() ? 0.0 : areas.back();
+}
+
+
+
+void IsolationCalc::buildIndices(std::vector<pat::PackedCandidate> const & cands){
+    for (int c = 0; c != kNCategories; ++c) mIndex[c].Clear();
+    for (size_t i = 0; i != cands.size(); ++i){
+        int const _category = category(cands[i]);
+        if (_category >= 0) mIndex[_category].Add(cands[i].eta(), cands[i].phi(), i);
+    }
+    for (int c = 0; c != kNCategories; ++c) mIndex[c].Build();
+}
+
+
+
+void IsolationCalc::isolate(std::vector<pat::PackedCandidate> const & cands,
+                            double pt, double eta, double phi, Vetoes const & vetoes){
+    //
+    // sums of every category in every cone, one index query per category
+    //
+
+    mvCone[0] = std::min(mMiniIsoMaxCone, std::max(mMiniIsoMinCone, mMiniIsoKt/pt));
+    mvCone2[0] = mvCone[0]*mvCone[0];
+    double const _maxCone = *std::max_element(mvCone.begin(), mvCone.end());
+
+    std::fill(mvSum.begin(), mvSum.end(), 0.0);
+    size_t const _nCones = mvCone.size();
+    for (int c = 0; c != kNCategories; ++c){
+        AddPt _add(cands, mvCone2, vetoes.deadCone2[c], vetoes.minPt[c], &mvSum[c*_nCones]);
+        mIndex[c].ForEachInCone(eta, phi, _maxCone, _add);
+    }
+}
+
+
+
+void IsolationCalc::fill(LeptonOutputs & out, double pt, double ea){
+    //
+    // relative isolations from the sums of the last isolate()
+    //
+
+    size_t const _nCones = mvCone.size();
+    double const * _ch = &mvSum[kCharged*_nCones];
+    double const * _pu = &mvSum[kChargedPU*_nCones];
+    double const * _nh = &mvSum[kNeutral*_nCones];
+    double const * _ph = &mvSum[kPhoton*_nCones];
+
+    out.miniCone.push_back(mvCone[0]);
+    out.miniCh.push_back(_ch[0]);
+    out.miniNh.push_back(_nh[0]);
+    out.miniPh.push_back(_ph[0]);
+    out.miniPU.push_back(_pu[0]);
+
+    for (size_t c = 0; c != _nCones; ++c){
+        // effective areas are given for a cone of 0.3
+        double const _area = ea*mvCone2[c]/(0.3*0.3);
+        double const _db = (_ch[c] + std::max(0.0, _nh[c] + _ph[c] - 0.5*_pu[c]))/pt;
+        double const _ea = (_ch[c] + std::max(0.0, _nh[c] + _ph[c] - mRho*_area))/pt;
+        if (c == 0){
+            out.miniDB.push_back(_db);
+            out.miniEA.push_back(_ea);
+        }
+        else {
+            out.vRelDB[c-1].push_back(_db);
+            out.vRelEA[c-1].push_back(_ea);
+        }
+    }
+}
+
+
+
+void IsolationCalc::clear(LeptonOutputs & out){
+    out.miniCone.clear();
+    out.miniCh.clear();
+    out.miniNh.clear();
+    out.miniPh.clear();
+    out.miniPU.clear();
+    out.miniDB.clear();
+    out.miniEA.clear();
+    for (size_t c = 0; c != out.vRelDB.size(); ++c){
+        out.vRelDB[c].clear();
+        out.vRelEA[c].clear();
+    }
+}
+
+
+
+void IsolationCalc::setOutputs(std::string const & prefix, LeptonOutputs const & out){
+    SetValue(prefix + "MiniIsoCone", out.miniCone);
+    SetValue(prefix + "MiniIsoCh",   out.miniCh);
+    SetValue(prefix + "MiniIsoNh",   out.miniNh);
+    SetValue(prefix + "MiniIsoPh",   out.miniPh);
+    SetValue(prefix + "MiniIsoPU",   out.miniPU);
+    SetValue(prefix + "MiniIsoDB",   out.miniDB);
+    SetValue(prefix + "MiniIsoEA",   out.miniEA);
+
+    for (size_t c = 0; c != mvConeLabel.size(); ++c){
+        SetValue(prefix + "RelIsoDB" + mvConeLabel[c], out.vRelDB[c]);
+        SetValue(prefix + "RelIsoEA" + mvConeLabel[c], out.vRelEA[c]);
+    }
+}
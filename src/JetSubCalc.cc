@@ -12,6 +12,9 @@
 #include "LJMet/Com/interface/BaseCalc.h"
 #include "LJMet/Com/interface/LjmetFactory.h"
 #include "LJMet/Com/interface/LjmetEventContent.h"
+#include "LJMet/Com/interface/LabelIndexCache.h"
+#include "LJMet/Com/interface/JetConstituentColumns.h"
+#include "LJMet/Com/interface/JetSubstructure.h"
 #include "DataFormats/PatCandidates/interface/Jet.h"
 #include "DataFormats/PatCandidates/interface/PackedCandidate.h"
 #include "DataFormats/PatCandidates/interface/PATObject.h"
@@ -27,14 +30,47 @@ public:
     virtual int BeginJob();
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
     virtual int EndJob();
+    virtual bool HasSideEffects() const { return false; }
     
 private:
     edm::InputTag slimmedJetColl_it;
     edm::InputTag slimmedJetsAK8Coll_it;
     std::string bDiscriminant;
     std::string tagInfo;
+    
+    // label positions, separate for the two collections as their layouts differ
+    LabelIndexCache ak4Labels;
+    LabelIndexCache ak8Labels;
+    int ak4CsvSlot, vtxNtracksSlot, vtxMassSlot, vtx3DValSlot, vtx3DSigSlot, pileupJetIdSlot;
+    int ak8CsvSlot, prunedMassSlot, trimmedMassSlot, filteredMassSlot, tau1Slot, tau2Slot, tau3Slot;
+    
+    // daughter dumps are only filled if any of their branches is requested;
+    // in compact mode they go to packed 16-bit columns instead
+    bool compactDaughters;
+    bool doDaughters;
+    bool doAK8Daughters;
+    bool doCompactDaughters;
+    bool doCompactAK8Daughters;
+    
+    // AK8 substructure recomputed from the constituents, with its own parameters
+    bool computeSubstructure;
+    JetSubstructure substructure;
+    std::string subjetLabel;
+    double subjetCSVL, subjetCSVM, subjetCSVT;
 };
 
+// packed candidates, descending through subjets if the daughters are jets
+static void addConstituents(reco::Candidate const & theCandidate, JetSubstructure & theSubstructure)
+{
+    if (theCandidate.numberOfDaughters() == 0) {
+        theSubstructure.AddConstituent(theCandidate.px(), theCandidate.py(), theCandidate.pz(), theCandidate.energy());
+        return;
+    }
+    for (size_t ui = 0; ui < theCandidate.numberOfDaughters(); ui++) {
+        addConstituents(*theCandidate.daughter(ui), theSubstructure);
+    }
+}
+
 static int reg = LjmetFactory::GetInstance()->Register(new JetSubCalc(), "JetSubCalc");
 
 JetSubCalc::JetSubCalc()
@@ -59,6 +95,60 @@ int JetSubCalc::BeginJob()
     if (mPset.exists("tagInfo")) tagInfo = mPset.getParameter<std::string>("tagInfo");
     else tagInfo = "caTop";
     
+    ak4CsvSlot      = ak4Labels.Add(bDiscriminant);
+    vtxNtracksSlot  = ak4Labels.AddUserFloat("vtxNtracks");
+    vtxMassSlot     = ak4Labels.AddUserFloat("vtxMass");
+    vtx3DValSlot    = ak4Labels.AddUserFloat("vtx3DVal");
+    vtx3DSigSlot    = ak4Labels.AddUserFloat("vtx3DSig");
+    pileupJetIdSlot = ak4Labels.AddUserFloat("pileupJetId:fullDiscriminant");
+    
+    ak8CsvSlot       = ak8Labels.Add(bDiscriminant);
+    prunedMassSlot   = ak8Labels.AddUserFloat("ak8PFJetsCHSPrunedLinks");
+    trimmedMassSlot  = ak8Labels.AddUserFloat("ak8PFJetsCHSTrimmedLinks");
+    filteredMassSlot = ak8Labels.AddUserFloat("ak8PFJetsCHSFilteredLinks");
+    tau1Slot         = ak8Labels.AddUserFloat("NjettinessAK8:tau1");
+    tau2Slot         = ak8Labels.AddUserFloat("NjettinessAK8:tau2");
+    tau3Slot         = ak8Labels.AddUserFloat("NjettinessAK8:tau3");
+    
+    if (mPset.exists("compactDaughters")) compactDaughters = mPset.getParameter<bool>("compactDaughters");
+    else compactDaughters = false;
+    
+    doDaughters = !compactDaughters
+               && (IsRequested("theJetDaughterPt") || IsRequested("theJetDaughterEta")
+               || IsRequested("theJetDaughterPhi") || IsRequested("theJetDaughterEnergy")
+               || IsRequested("theJetDaughterMotherIndex"));
+    doAK8Daughters = !compactDaughters
+                  && (IsRequested("theJetAK8DaughterPt") || IsRequested("theJetAK8DaughterEta")
+                  || IsRequested("theJetAK8DaughterPhi") || IsRequested("theJetAK8DaughterEnergy")
+                  || IsRequested("theJetAK8DaughterMotherIndex"));
+    doCompactDaughters = compactDaughters
+                      && (IsRequested("theJetDaughterOffset") || IsRequested("theJetDaughterDEta")
+                      || IsRequested("theJetDaughterDPhi") || IsRequested("theJetDaughterLogPtFrac")
+                      || IsRequested("theJetDaughterType"));
+    doCompactAK8Daughters = compactDaughters
+                         && (IsRequested("theJetAK8DaughterOffset") || IsRequested("theJetAK8DaughterDEta")
+                         || IsRequested("theJetAK8DaughterDPhi") || IsRequested("theJetAK8DaughterLogPtFrac")
+                         || IsRequested("theJetAK8DaughterType"));
+    
+    if (mPset.exists("computeSubstructure")) computeSubstructure = mPset.getParameter<bool>("computeSubstructure");
+    else computeSubstructure = false;
+    
+    if (computeSubstructure) {
+        substructure.SetNsubjettiness(mPset.getUntrackedParameter<double>("nsubBeta", 1.0),
+                                      mPset.getUntrackedParameter<double>("nsubR0", 0.8));
+        substructure.SetSoftDrop(mPset.getUntrackedParameter<double>("softDropBeta", 0.0),
+                                 mPset.getUntrackedParameter<double>("softDropZcut", 0.1),
+                                 mPset.getUntrackedParameter<double>("softDropR0", 0.8));
+        substructure.SetPruning(mPset.getUntrackedParameter<double>("pruningZcut", 0.1),
+                                mPset.getUntrackedParameter<double>("pruningRcutFactor", 0.5));
+        substructure.SetEcfBeta(mPset.getUntrackedParameter<double>("ecfBeta", 1.0));
+        
+        subjetLabel = mPset.getUntrackedParameter<std::string>("subjetLabel", "SoftDrop");
+        subjetCSVL  = mPset.getUntrackedParameter<double>("subjetCSVL", 0.244);
+        subjetCSVM  = mPset.getUntrackedParameter<double>("subjetCSVM", 0.679);
+        subjetCSVT  = mPset.getUntrackedParameter<double>("subjetCSVT", 0.898);
+    }
+    
     return 0;
 }
 
@@ -66,46 +156,56 @@ int JetSubCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
 {
     float subjetCSV;
     int CSVL, CSVM, CSVT;
+    
+    // output vectors live in the event scratch memory
+    EventArena & arena = GetArena();
 
     // I think these are AK4
     edm::Handle<std::vector<pat::Jet> > theJets;
     event.getByLabel(slimmedJetColl_it, theJets);
     
     // Available variables
-    std::vector<double> theJetPt;
-    std::vector<double> theJetEta;
-    std::vector<double> theJetPhi;
-    std::vector<double> theJetEnergy;
-    std::vector<double> theJetCSV;
+    ArenaVector<double> theJetPt(arena);
+    ArenaVector<double> theJetEta(arena);
+    ArenaVector<double> theJetPhi(arena);
+    ArenaVector<double> theJetEnergy(arena);
+    ArenaVector<double> theJetCSV(arena);
     
     // Additional variables related to the associated secondary vertex if there is one
     // Mass of the vertex
-    std::vector<double> theJetVtxMass;
+    ArenaVector<double> theJetVtxMass(arena);
     // Number of tracks
-    std::vector<double> theJetVtxNtracks;
+    ArenaVector<double> theJetVtxNtracks(arena);
     // Decay length value and significance
-    std::vector<double> theJetVtx3DVal;
-    std::vector<double> theJetVtx3DSig;
+    ArenaVector<double> theJetVtx3DVal(arena);
+    ArenaVector<double> theJetVtx3DSig(arena);
     
     // Discriminator for the MVA PileUp id.
     // NOTE: Training used is for ak5PFJetsCHS in CMSSW 5.3.X and Run 1 pileup
-    std::vector<double> theJetPileupJetId;
+    ArenaVector<double> theJetPileupJetId(arena);
     
     //Identity
-    std::vector<int> theJetIndex;
-    std::vector<int> theJetnDaughters;
+    ArenaVector<int> theJetIndex(arena);
+    ArenaVector<int> theJetnDaughters(arena);
     
     //Daughter four vector and index
-    std::vector<double> theJetDaughterPt;
-    std::vector<double> theJetDaughterEta;
-    std::vector<double> theJetDaughterPhi;
-    std::vector<double> theJetDaughterEnergy;
+    ArenaVector<double> theJetDaughterPt(arena);
+    ArenaVector<double> theJetDaughterEta(arena);
+    ArenaVector<double> theJetDaughterPhi(arena);
+    ArenaVector<double> theJetDaughterEnergy(arena);
+    
+    ArenaVector<int> theJetDaughterMotherIndex(arena);
     
-    std::vector<int> theJetDaughterMotherIndex;
+    // compact daughters: offsets into jet-relative 16-bit columns
+    ArenaVector<int>   theJetDaughterOffset(arena);
+    ArenaVector<short> theJetDaughterDEta(arena);
+    ArenaVector<short> theJetDaughterDPhi(arena);
+    ArenaVector<short> theJetDaughterLogPtFrac(arena);
+    ArenaVector<short> theJetDaughterType(arena);
     
-    std::vector<int> theJetCSVLSubJets;
-    std::vector<int> theJetCSVMSubJets;
-    std::vector<int> theJetCSVTSubJets;
+    ArenaVector<int> theJetCSVLSubJets(arena);
+    ArenaVector<int> theJetCSVMSubJets(arena);
+    ArenaVector<int> theJetCSVTSubJets(arena);
     
     double theVtxMass, theVtxNtracks, theVtx3DVal, theVtx3DSig, thePileupJetId;
     
@@ -113,16 +213,16 @@ int JetSubCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
         int index = (int)(ijet-theJets->begin());
         
         theVtxNtracks  = -std::numeric_limits<double>::max();
-        theVtxNtracks  = (double)ijet->userFloat("vtxNtracks");
+        theVtxNtracks  = (double)ak4Labels.UserFloat(*ijet, vtxNtracksSlot);
         
         if (theVtxNtracks > 0) {
             theVtxMass     = -std::numeric_limits<double>::max();
             theVtx3DVal    = -std::numeric_limits<double>::max();
             theVtx3DSig    = -std::numeric_limits<double>::max();
 
-            theVtxMass     = (double)ijet->userFloat("vtxMass");
-            theVtx3DVal    = (double)ijet->userFloat("vtx3DVal");
-            theVtx3DSig    = (double)ijet->userFloat("vtx3DSig");
+            theVtxMass     = (double)ak4Labels.UserFloat(*ijet, vtxMassSlot);
+            theVtx3DVal    = (double)ak4Labels.UserFloat(*ijet, vtx3DValSlot);
+            theVtx3DSig    = (double)ak4Labels.UserFloat(*ijet, vtx3DSigSlot);
             
             theJetVtxNtracks.push_back(theVtxNtracks);
             theJetVtxMass.push_back(theVtxMass);
@@ -131,14 +231,14 @@ int JetSubCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
         }
         
         thePileupJetId = -std::numeric_limits<double>::max();
-        thePileupJetId = (double)ijet->userFloat("pileupJetId:fullDiscriminant");
+        thePileupJetId = (double)ak4Labels.UserFloat(*ijet, pileupJetIdSlot);
         theJetPileupJetId.push_back(thePileupJetId);
         
         theJetPt    .push_back(ijet->pt());
         theJetEta   .push_back(ijet->eta());
         theJetPhi   .push_back(ijet->phi());
         theJetEnergy.push_back(ijet->energy());
-        theJetCSV.push_back(ijet->bDiscriminator( bDiscriminant ));
+        theJetCSV.push_back(ak4Labels.BDiscriminator(*ijet, ak4CsvSlot));
         
         theJetIndex.push_back(index);
         theJetnDaughters.push_back((int)ijet->numberOfDaughters());
@@ -148,7 +248,18 @@ int JetSubCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
         CSVT = 0;
         subjetCSV = -std::numeric_limits<float>::max();
         
-        for (size_t ui = 0; ui < ijet->numberOfDaughters(); ui++) {
+        if (doCompactDaughters) {
+            theJetDaughterOffset.push_back((int)theJetDaughterType.size());
+            jetconstituents::Writer const writer(ijet->pt(), ijet->eta(), ijet->phi());
+            for (size_t ui = 0; ui < ijet->numberOfDaughters(); ui++) {
+                reco::Candidate const * theDaughter = ijet->daughter(ui);
+                writer.Add(theDaughter->pt(), theDaughter->eta(), theDaughter->phi(),
+                           theDaughter->pdgId(), theDaughter->charge(),
+                           theJetDaughterDEta, theJetDaughterDPhi, theJetDaughterLogPtFrac, theJetDaughterType);
+            }
+        }
+        
+        for (size_t ui = 0; doDaughters && ui < ijet->numberOfDaughters(); ui++) {
             pat::PackedCandidate const * theDaughter = dynamic_cast<pat::PackedCandidate const *>(ijet->daughter(ui));
             
             theJetDaughterPt    .push_back(theDaughter->pt());
@@ -198,6 +309,15 @@ int JetSubCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
     
     SetValue("theJetDaughterMotherIndex", theJetDaughterMotherIndex);
     
+    if (doCompactDaughters) {
+        theJetDaughterOffset.push_back((int)theJetDaughterType.size());
+        SetValue("theJetDaughterOffset",     theJetDaughterOffset);
+        SetValue("theJetDaughterDEta",       theJetDaughterDEta);
+        SetValue("theJetDaughterDPhi",       theJetDaughterDPhi);
+        SetValue("theJetDaughterLogPtFrac",  theJetDaughterLogPtFrac);
+        SetValue("theJetDaughterType",       theJetDaughterType);
+    }
+    
     SetValue("theJetCSVLSubJets", theJetCSVLSubJets);
     SetValue("theJetCSVMSubJets", theJetCSVMSubJets);
     SetValue("theJetCSVTSubJets", theJetCSVTSubJets);
@@ -207,41 +327,60 @@ int JetSubCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
     event.getByLabel(slimmedJetsAK8Coll_it, theAK8Jets);
     
     // Four vector
-    std::vector<double> theJetAK8Pt;
-    std::vector<double> theJetAK8Eta;
-    std::vector<double> theJetAK8Phi;
-    std::vector<double> theJetAK8Energy;
-    std::vector<double> theJetAK8CSV;
+    ArenaVector<double> theJetAK8Pt(arena);
+    ArenaVector<double> theJetAK8Eta(arena);
+    ArenaVector<double> theJetAK8Phi(arena);
+    ArenaVector<double> theJetAK8Energy(arena);
+    ArenaVector<double> theJetAK8CSV(arena);
     
     // Pruned, trimmed and filtered masses available
-    std::vector<double> theJetAK8PrunedMass;
-    std::vector<double> theJetAK8TrimmedMass;
-    std::vector<double> theJetAK8FilteredMass;
+    ArenaVector<double> theJetAK8PrunedMass(arena);
+    ArenaVector<double> theJetAK8TrimmedMass(arena);
+    ArenaVector<double> theJetAK8FilteredMass(arena);
     
     // n-subjettiness variables tau1, tau2, and tau3 available
-    std::vector<double> theJetAK8NjettinessTau1;
-    std::vector<double> theJetAK8NjettinessTau2;
-    std::vector<double> theJetAK8NjettinessTau3;
+    ArenaVector<double> theJetAK8NjettinessTau1(arena);
+    ArenaVector<double> theJetAK8NjettinessTau2(arena);
+    ArenaVector<double> theJetAK8NjettinessTau3(arena);
     
-    std::vector<double> theJetAK8caTopTopMass;
-    std::vector<double> theJetAK8caTopMinMass;
-    std::vector<int> theJetAK8caTopnSubJets;
+    ArenaVector<double> theJetAK8caTopTopMass(arena);
+    ArenaVector<double> theJetAK8caTopMinMass(arena);
+    ArenaVector<int> theJetAK8caTopnSubJets(arena);
 
-    std::vector<double> theJetAK8Mass;
-    std::vector<int>    theJetAK8Index;
-    std::vector<int>    theJetAK8nDaughters;
+    ArenaVector<double> theJetAK8Mass(arena);
+    ArenaVector<int>    theJetAK8Index(arena);
+    ArenaVector<int>    theJetAK8nDaughters(arena);
     
     // Daughter four vector and index
-    std::vector<double> theJetAK8DaughterPt;
-    std::vector<double> theJetAK8DaughterEta;
-    std::vector<double> theJetAK8DaughterPhi;
-    std::vector<double> theJetAK8DaughterEnergy;
-    
-    std::vector<int> theJetAK8DaughterMotherIndex;
-    
-    std::vector<int> theJetAK8CSVLSubJets;
-    std::vector<int> theJetAK8CSVMSubJets;
-    std::vector<int> theJetAK8CSVTSubJets;
+    ArenaVector<double> theJetAK8DaughterPt(arena);
+    ArenaVector<double> theJetAK8DaughterEta(arena);
+    ArenaVector<double> theJetAK8DaughterPhi(arena);
+    ArenaVector<double> theJetAK8DaughterEnergy(arena);
+    
+    ArenaVector<int> theJetAK8DaughterMotherIndex(arena);
+    
+    ArenaVector<int>   theJetAK8DaughterOffset(arena);
+    ArenaVector<short> theJetAK8DaughterDEta(arena);
+    ArenaVector<short> theJetAK8DaughterDPhi(arena);
+    ArenaVector<short> theJetAK8DaughterLogPtFrac(arena);
+    ArenaVector<short> theJetAK8DaughterType(arena);
+    
+    ArenaVector<int> theJetAK8CSVLSubJets(arena);
+    ArenaVector<int> theJetAK8CSVMSubJets(arena);
+    ArenaVector<int> theJetAK8CSVTSubJets(arena);
+    
+    // substructure recomputed from the constituents
+    ArenaVector<double> theJetAK8CalcTau1(arena);
+    ArenaVector<double> theJetAK8CalcTau2(arena);
+    ArenaVector<double> theJetAK8CalcTau3(arena);
+    ArenaVector<double> theJetAK8SoftDropMass(arena);
+    ArenaVector<double> theJetAK8CalcPrunedMass(arena);
+    ArenaVector<double> theJetAK8ECFC2(arena);
+    ArenaVector<double> theJetAK8ECFD2(arena);
+    ArenaVector<int>    theJetAK8nSoftDropDaughters(arena);
+    ArenaVector<int>    theJetAK8nSubJets(arena);
+    ArenaVector<double> theJetAK8SubJetMaxCSV(arena);
+    ArenaVector<double> theJetAK8SubJetMinCSV(arena);
     
     double topMass, minMass;
     int nSubJets;
@@ -254,22 +393,22 @@ int JetSubCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
         thePrunedMass   = -std::numeric_limits<double>::max();
         theTrimmedMass  = -std::numeric_limits<double>::max();
         theFilteredMass = -std::numeric_limits<double>::max();
-        thePrunedMass   = (double)ijet->userFloat("ak8PFJetsCHSPrunedLinks");
-        theTrimmedMass  = (double)ijet->userFloat("ak8PFJetsCHSTrimmedLinks");
-        theFilteredMass = (double)ijet->userFloat("ak8PFJetsCHSFilteredLinks");
+        thePrunedMass   = (double)ak8Labels.UserFloat(*ijet, prunedMassSlot);
+        theTrimmedMass  = (double)ak8Labels.UserFloat(*ijet, trimmedMassSlot);
+        theFilteredMass = (double)ak8Labels.UserFloat(*ijet, filteredMassSlot);
         
         theNjettinessTau1 = -std::numeric_limits<double>::max();
         theNjettinessTau2 = -std::numeric_limits<double>::max();
         theNjettinessTau3 = -std::numeric_limits<double>::max();
-        theNjettinessTau1 = (double)ijet->userFloat("NjettinessAK8:tau1");
-        theNjettinessTau2 = (double)ijet->userFloat("NjettinessAK8:tau2");
-        theNjettinessTau3 = (double)ijet->userFloat("NjettinessAK8:tau3");
+        theNjettinessTau1 = (double)ak8Labels.UserFloat(*ijet, tau1Slot);
+        theNjettinessTau2 = (double)ak8Labels.UserFloat(*ijet, tau2Slot);
+        theNjettinessTau3 = (double)ak8Labels.UserFloat(*ijet, tau3Slot);
 
         theJetAK8Pt    .push_back(ijet->pt());
         theJetAK8Eta   .push_back(ijet->eta());
         theJetAK8Phi   .push_back(ijet->phi());
         theJetAK8Energy.push_back(ijet->energy());
-        theJetAK8CSV.push_back(ijet->bDiscriminator( bDiscriminant ));
+        theJetAK8CSV.push_back(ak8Labels.BDiscriminator(*ijet, ak8CsvSlot));
         
         theJetAK8PrunedMass  .push_back(thePrunedMass);
         theJetAK8TrimmedMass .push_back(theTrimmedMass);
@@ -305,7 +444,56 @@ int JetSubCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
         CSVM = 0;
         CSVT = 0;
         
-        for (size_t ui = 0; ui < ijet->numberOfDaughters(); ui++) {
+        if (computeSubstructure) {
+            substructure.Clear();
+            for (size_t ui = 0; ui < ijet->numberOfDaughters(); ui++) {
+                addConstituents(*ijet->daughter(ui), substructure);
+            }
+            JetSubstructure::Result const & theSubstructure = substructure.Compute();
+            
+            theJetAK8CalcTau1.push_back(theSubstructure.tau1);
+            theJetAK8CalcTau2.push_back(theSubstructure.tau2);
+            theJetAK8CalcTau3.push_back(theSubstructure.tau3);
+            theJetAK8SoftDropMass.push_back(theSubstructure.softDropMass);
+            theJetAK8CalcPrunedMass.push_back(theSubstructure.prunedMass);
+            theJetAK8ECFC2.push_back(theSubstructure.ecfC2);
+            theJetAK8ECFD2.push_back(theSubstructure.ecfD2);
+            theJetAK8nSoftDropDaughters.push_back(theSubstructure.nSoftDrop);
+            
+            double maxCSV = -std::numeric_limits<double>::max();
+            double minCSV = -std::numeric_limits<double>::max();
+            int nSubJetsBtag = 0;
+            if (ijet->hasSubjets(subjetLabel)) {
+                pat::JetPtrCollection const & theSubJets = ijet->subjets(subjetLabel);
+                nSubJetsBtag = (int)theSubJets.size();
+                for (size_t ui = 0; ui < theSubJets.size(); ui++) {
+                    subjetCSV = theSubJets[ui]->bDiscriminator(bDiscriminant);
+                    if (ui == 0 || subjetCSV > maxCSV) maxCSV = subjetCSV;
+                    if (ui == 0 || subjetCSV < minCSV) minCSV = subjetCSV;
+                    if (theSubJets[ui]->pt() > 20.) {
+                        if (subjetCSV > subjetCSVL) CSVL++;
+                        if (subjetCSV > subjetCSVM) CSVM++;
+                        if (subjetCSV > subjetCSVT) CSVT++;
+                    }
+                }
+            }
+            theJetAK8nSubJets.push_back(nSubJetsBtag);
+            theJetAK8SubJetMaxCSV.push_back(maxCSV);
+            theJetAK8SubJetMinCSV.push_back(minCSV);
+        }
+        
+        if (doCompactAK8Daughters) {
+            theJetAK8DaughterOffset.push_back((int)theJetAK8DaughterType.size());
+            jetconstituents::Writer const writer(ijet->pt(), ijet->eta(), ijet->phi());
+            for (size_t ui = 0; ui < ijet->numberOfDaughters(); ui++) {
+                reco::Candidate const * theDaughter = ijet->daughter(ui);
+                writer.Add(theDaughter->pt(), theDaughter->eta(), theDaughter->phi(),
+                           theDaughter->pdgId(), theDaughter->charge(),
+                           theJetAK8DaughterDEta, theJetAK8DaughterDPhi, theJetAK8DaughterLogPtFrac, theJetAK8DaughterType);
+            }
+        }
+        
+        for (size_t ui = 0; doAK8Daughters && ui < ijet->numberOfDaughters(); ui++) {
             pat::PackedCandidate const * theDaughter = dynamic_cast<pat::PackedCandidate const *>(ijet->daughter(ui));
             theJetAK8DaughterPt    .push_back(theDaughter->pt());
             theJetAK8DaughterEta   .push_back(theDaughter->eta());
@@ -360,10 +548,33 @@ int JetSubCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * s
     
     SetValue("theJetAK8DaughterMotherIndex", theJetAK8DaughterMotherIndex);
     
+    if (doCompactAK8Daughters) {
+        theJetAK8DaughterOffset.push_back((int)theJetAK8DaughterType.size());
+        SetValue("theJetAK8DaughterOffset",     theJetAK8DaughterOffset);
+        SetValue("theJetAK8DaughterDEta",       theJetAK8DaughterDEta);
+        SetValue("theJetAK8DaughterDPhi",       theJetAK8DaughterDPhi);
+        SetValue("theJetAK8DaughterLogPtFrac",  theJetAK8DaughterLogPtFrac);
+        SetValue("theJetAK8DaughterType",       theJetAK8DaughterType);
+    }
+    
     SetValue("theJetAK8CSVLSubJets", theJetAK8CSVLSubJets);
     SetValue("theJetAK8CSVMSubJets", theJetAK8CSVMSubJets);
     SetValue("theJetAK8CSVTSubJets", theJetAK8CSVTSubJets);
     
+    if (computeSubstructure) {
+        SetValue("theJetAK8CalcTau1",           theJetAK8CalcTau1);
+        SetValue("theJetAK8CalcTau2",           theJetAK8CalcTau2);
+        SetValue("theJetAK8CalcTau3",           theJetAK8CalcTau3);
+        SetValue("theJetAK8SoftDropMass",       theJetAK8SoftDropMass);
+        SetValue("theJetAK8CalcPrunedMass",     theJetAK8CalcPrunedMass);
+        SetValue("theJetAK8ECFC2",              theJetAK8ECFC2);
+        SetValue("theJetAK8ECFD2",              theJetAK8ECFD2);
+        SetValue("theJetAK8nSoftDropDaughters", theJetAK8nSoftDropDaughters);
+        SetValue("theJetAK8nSubJets",           theJetAK8nSubJets);
+        SetValue("theJetAK8SubJetMaxCSV",       theJetAK8SubJetMaxCSV);
+        SetValue("theJetAK8SubJetMinCSV",       theJetAK8SubJetMinCSV);
+    }
+    
     return 0;
 }
 
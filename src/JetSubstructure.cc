@@ -0,0 +1,148 @@
+/*
+ Jet substructure computed from the jet constituents
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "fastjet/ClusterSequence.hh"
+#include "fastjet/JetDefinition.hh"
+#include "fastjet/tools/Pruner.hh"
+
+#include "LJMet/Com/interface/JetSubstructure.h"
+#include "LJMet/Com/interface/Njettiness.hh"
+
+
+
+JetSubstructure::JetSubstructure():
+mpNjettiness(0),
+mSoftDropBeta(0.0),
+mSoftDropZcut(0.1),
+mSoftDropR0(0.8),
+mPruningZcut(0.1),
+mPruningRcutFactor(0.5),
+mEcfBeta(1.0){
+    SetNsubjettiness(1.0, 0.8);
+}
+
+
+
+JetSubstructure::~JetSubstructure(){
+    delete mpNjettiness;
+}
+
+
+
+void JetSubstructure::SetNsubjettiness(double beta, double R0){
+    delete mpNjettiness;
+    mpNjettiness = new Njettiness(Njettiness::onepass_kt_axes, NsubParameters(beta, R0));
+}
+
+
+
+void JetSubstructure::SetSoftDrop(double beta, double zcut, double R0){
+    mSoftDropBeta = beta;
+    mSoftDropZcut = zcut;
+    mSoftDropR0 = R0;
+}
+
+
+
+void JetSubstructure::SetPruning(double zcut, double rcutFactor){
+    mPruningZcut = zcut;
+    mPruningRcutFactor = rcutFactor;
+}
+
+
+
+JetSubstructure::Result const & JetSubstructure::Compute(){
+    mResult.tau1 = mResult.tau2 = mResult.tau3 = -1.0;
+    mResult.softDropMass = mResult.prunedMass = -1.0;
+    mResult.ecfC2 = mResult.ecfD2 = -1.0;
+    mResult.nSoftDrop = 0;
+    if (mvParticle.empty()) return mResult;
+
+    mResult.tau1 = mpNjettiness->getTau(1, mvParticle);
+    mResult.tau2 = mpNjettiness->getTau(2, mvParticle);
+    mResult.tau3 = mpNjettiness->getTau(3, mvParticle);
+
+    // C/A with a radius large enough to merge all the constituents
+    fastjet::JetDefinition const _caDef(fastjet::cambridge_algorithm, fastjet::JetDefinition::max_allowable_R);
+    fastjet::ClusterSequence const _cs(mvParticle, _caDef);
+    std::vector<fastjet::PseudoJet> const _jets = fastjet::sorted_by_pt(_cs.inclusive_jets());
+    if (_jets.empty()) return mResult;
+    fastjet::PseudoJet const & _ca = _jets[0];
+
+    fastjet::Pruner const _pruner(fastjet::cambridge_algorithm, mPruningZcut, mPruningRcutFactor);
+    mResult.prunedMass = _pruner(_ca).m();
+
+    // soft drop: follow the harder branch until the softer passes
+    double const _r02 = mSoftDropR0*mSoftDropR0;
+    fastjet::PseudoJet _sd = _ca;
+    fastjet::PseudoJet _p1, _p2;
+    while (_sd.has_parents(_p1, _p2)){
+        double const _pt1 = _p1.pt();
+        double const _pt2 = _p2.pt();
+        if (_pt1 + _pt2 <= 0.0) break;
+        double const _z = std::min(_pt1, _pt2)/(_pt1 + _pt2);
+        double const _dr2 = _p1.squared_distance(_p2);
+        if (_z > mSoftDropZcut*std::pow(_dr2/_r02, 0.5*mSoftDropBeta)) break;
+        _sd = _pt1 > _pt2 ? _p1 : _p2;
+    }
+    mResult.softDropMass = _sd.m();
+
+    std::vector<fastjet::PseudoJet> const _groomed = _sd.constituents();
+    mResult.nSoftDrop = _groomed.size();
+    computeEcf(_groomed);
+
+    return mResult;
+}
+
+
+
+void JetSubstructure::computeEcf(std::vector<fastjet::PseudoJet> const & particles){
+    size_t const _n = particles.size();
+    if (_n < 3) return;
+
+    mvPt.resize(_n);
+    mvPair.resize(_n*_n);
+
+    double _e1 = 0.0;
+    for (size_t i = 0; i != _n; ++i){
+        mvPt[i] = particles[i].pt();
+        _e1 += mvPt[i];
+    }
+    if (_e1 <= 0.0) return;
+
+    // dR_ij^beta, upper triangle only
+    double const _halfBeta = 0.5*mEcfBeta;
+    double _e2 = 0.0;
+    for (size_t i = 0; i != _n; ++i){
+        double * const _row = &mvPair[i*_n];
+        for (size_t j = i + 1; j != _n; ++j){
+            _row[j] = std::pow(particles[i].squared_distance(particles[j]), _halfBeta);
+            _e2 += mvPt[i]*mvPt[j]*_row[j];
+        }
+    }
+
+    double _e3 = 0.0;
+    for (size_t i = 0; i != _n; ++i){
+        double const * const _rowI = &mvPair[i*_n];
+        for (size_t j = i + 1; j != _n; ++j){
+            double const _wij = mvPt[i]*mvPt[j]*_rowI[j];
+            double const * const _rowJ = &mvPair[j*_n];
+            double _sum = 0.0;
+            for (size_t k = j + 1; k != _n; ++k) _sum += mvPt[k]*_rowI[k]*_rowJ[k];
+            _e3 += _wij*_sum;
+        }
+    }
+
+    // normalised e2 = ECF2/ECF1^2, e3 = ECF3/ECF1^3
+    _e2 /= _e1*_e1;
+    _e3 /= _e1*_e1*_e1;
+    if (_e2 <= 0.0) return;
+    mResult.ecfC2 = _e3/(_e2*_e2);
+    mResult.ecfD2 = _e3/(_e2*_e2*_e2);
+}
@@ -4,7 +4,9 @@
 #include "LJMet/Com/interface/TopAngleUtils.h"
 
 #include "TMatrixDSymEigen.h"
+#include "TMath.h"
 
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
 
@@ -13,6 +15,31 @@ using namespace std;
 using namespace top_cafe;
 
 
+
+// phi in [0, 2pi), as FourVector::Phi() returned for the phi branches
+static double Phi0To2Pi(FourVector const & v){
+    double const _phi = v.Phi();
+    return _phi < 0.0 ? _phi + 2.0*M_PI : _phi;
+}
+
+// momentum component i = 0, 1, 2 for the momentum tensor
+static double Component(FourVector const & v, int i){
+    return i == 0 ? v.Px() : (i == 1 ? v.Py() : v.Pz());
+}
+
+// The lepton of LeptonMETxy has always been built from m_lepton[0], i.e.
+// FourVector(px) = (px, 0, 0, sqrt(2)|px|) since it keeps the mass
+// of its (px, 0, 0, 0) argument; the Cos_* angles are defined with it
+static FourVector LeptonMETxyLepton(FourVector const & lepton){
+    return FourVector(lepton.Px(), 0., 0., std::sqrt(2.)*std::fabs(lepton.Px()));
+}
+
+// the transverse neutrino of LeptonMETxy
+static FourVector LeptonMETxyNeutrino(FourVector const & neutrino){
+    return FourVector(neutrino.Px(), neutrino.Py(), 0., neutrino.Pt());
+}
+
+
 // Initiate LJetsTopoVarsNew using one lepton, one MET and
 // 4 leading jets momenta. Note that if fewer than 4 jets are supplied,
 // some variables are not well-defined. Every effort is made to process
@@ -25,9 +52,9 @@ using namespace top_cafe;
 //			    TLorentzVector & met,
 //			    bool isMuon){
 
-int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jets,
-                               TLorentzVector & lepton,
-                               TLorentzVector & met,
+int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > & jets,
+                               FourVector const & lepton,
+                               FourVector const & met,
                                bool isMuon,
                                bool bestTop){
     
@@ -36,8 +63,8 @@ int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jet
     eigenval.ResizeTo(3);
     eigenval.Zero();
     
-    m_met = TMBLorentzVector(met);
-    m_lepton = TMBLorentzVector(lepton);
+    m_met = met;
+    m_lepton = lepton;
     
     // loop over jets
     nJets = 0; // will return this as result
@@ -67,8 +94,7 @@ int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jet
         
         ++cnt;
         
-        TMBLorentzVector _j((*jet).first.Pt(),(*jet).first.Eta(),(*jet).first.Phi(),(*jet).first.Energy(),TMBLorentzVector::kPtEtaPhiE);
-        m_jets.push_back(_j);
+        m_jets.push_back(FourVector::FromLorentz((*jet).first));
         
         bool tagged=false;
         
@@ -104,9 +130,6 @@ int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jet
             }
         }
         
-        double nu_px = m_met.Px();
-        double nu_py = m_met.Py();
-        
         //set all OK flags to FALSE;
         _htOK = false;
         _evtTopoOK = false;
@@ -117,7 +140,7 @@ int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jet
             /****************************************************************/
             /// alternative method estimate Pz of neutrino//////////////
             /****************************************************************/
-            TLorentzVector p4Nu, p4OtherNu;
+            FourVector p4Nu, p4OtherNu;
             fzCalculator.SetMET(m_met);
             fzCalculator.SetLepton(m_lepton);
             if (m_isMuon) {
@@ -127,8 +150,8 @@ int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jet
             }
             
             double pzNu = fzCalculator.Calculate();
-            p4Nu = TLorentzVector();
-            p4OtherNu = TLorentzVector();
+            p4Nu = FourVector();
+            p4OtherNu = FourVector();
             
             p4Nu.SetPxPyPzE(m_met.Px(), m_met.Py(), pzNu, sqrt(m_met.Px()*m_met.Px()+m_met.Py()*m_met.Py()+pzNu*pzNu));
             double pzOtherNu = fzCalculator.getOther();
@@ -137,13 +160,13 @@ int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jet
             if ( fzCalculator.IsComplex() ) {
                 double ptNu1 = fzCalculator.getPtneutrino(1);
                 double ptNu2 = fzCalculator.getPtneutrino(2);
-                TLorentzVector p4Nu1tmp;
-                TLorentzVector p4Nu2tmp;
+                FourVector p4Nu1tmp;
+                FourVector p4Nu2tmp;
                 
                 p4Nu1tmp.SetPxPyPzE( ptNu1*m_met.Px()/m_met.Pt(), ptNu1*m_met.Py()/m_met.Pt(), pzNu, sqrt(ptNu1*ptNu1+pzNu*pzNu));
                 p4Nu2tmp.SetPxPyPzE( ptNu2*m_met.Px()/m_met.Pt(), ptNu2*m_met.Py()/m_met.Pt(), pzNu, sqrt(ptNu2*ptNu2+pzNu*pzNu));
                 
-                TLorentzVector Wtmp;
+                FourVector Wtmp;
                 Wtmp = m_lepton + p4Nu1tmp;
                 double Wm1 = 0;
                 double Wm2 = 0;
@@ -156,11 +179,11 @@ int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jet
                 p4OtherNu = p4Nu; // since we chose the real part, the two solutions are the same.
             }
             
-            TLorentzVector p4LepW = m_lepton + p4Nu;
-            TLorentzVector p4OtherLepW = m_lepton + p4OtherNu;
+            FourVector p4LepW = m_lepton + p4Nu;
+            FourVector p4OtherLepW = m_lepton + p4OtherNu;
             
-            TLorentzVector Top1;
-            TLorentzVector Top2;
+            FourVector Top1;
+            FourVector Top2;
             double TopMass1=0.0;
             double TopMass2=0.0;
             double BestTopMass1 = -99999.0;
@@ -178,56 +201,26 @@ int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jet
             } // loop over jets
             
             if (fabs(172.5-BestTopMass1) < fabs(172.5-BestTopMass2)) {
-                _neutrino.SetPxPyPzE(p4Nu.Px(),p4Nu.Py(),p4Nu.Pz(),p4Nu.E());
-                _otherneutrino.SetPxPyPzE(p4OtherNu.Px(),p4OtherNu.Py(),p4OtherNu.Pz(),p4OtherNu.E());
+                _neutrino = p4Nu;
+                _otherneutrino = p4OtherNu;
             }
             else {
-                _neutrino.SetPxPyPzE(p4OtherNu.Px(),p4OtherNu.Py(),p4OtherNu.Pz(),p4OtherNu.E());
-                _otherneutrino.SetPxPyPzE(p4Nu.Px(),p4Nu.Py(),p4Nu.Pz(),p4Nu.E());
+                _neutrino = p4OtherNu;
+                _otherneutrino = p4Nu;
             }
         }
         
         else {
-            double nu_pz = 0.;
-            double othernu_pz = 0.;
-            double nu_e  = sqrt(pow(nu_px,2)+pow(nu_py,2));
-            
-            double Mw    = 80.4;  // NGO fix this!(read from one place)
-            double l_px  = m_lepton.Px();
-            double l_py  = m_lepton.Py();
-            double l_pz  = m_lepton.Pz();
-            double l_pt  = m_lepton.Pt();
-            double l_e   = m_lepton.E();
-            double Mt    = sqrt(pow(l_pt+nu_e ,2)-
-                                pow(l_px+nu_px,2)-
-                                pow(l_py+nu_py,2));
-            //if(debug) cout << "making W Mt = " << Mt << endl;
-            double A;
-            if (Mt<Mw) A = pow(Mw,2)/2.;
-            else       {           // assume Mt=Mw, rescale MET accordingly (NGO???)
-                A = pow(Mt,2)/2.;
-                double k = nu_e*l_pt - nu_px*l_px - nu_py*l_py;
-                k = (k == 0. ? 0.00001 : k);
-                //if(debug) cout << "K = " << k << endl;
-                double scf = 0.5*pow(Mw,2)/k ;
-                //if(debug) cout << "neutrio px py before  = " << nu_px  << " " << nu_py <<  endl;
-                nu_px *= scf;
-                nu_py *= scf;
-                //if(debug) cout << "neutrio px py after  = " << nu_px  << " " << nu_py <<  endl;
-                nu_e = sqrt(pow(nu_px,2)+pow(nu_py,2));
-            }
-            double B = nu_px*l_px + nu_py*l_py;
-            double C = TMath::Max(1. + pow(nu_e,2) * (pow(l_pz,2)-pow(l_e,2)) / pow(A+B,2)  , 0.);
-            C = sqrt(C);
-            double S1= (-(A+B)*l_pz + (A+B)*l_e*C) / (pow(l_pz,2)-pow(l_e,2));
-            double S2= (-(A+B)*l_pz - (A+B)*l_e*C) / (pow(l_pz,2)-pow(l_e,2));
-            // choose solution with smallest |l_pz| a la Run I
-            nu_pz = fabs (S1) < fabs (S2) ? S1 : S2 ;
-            othernu_pz = fabs (S1) < fabs (S2) ? S2 : S1 ;
+            // W mass constraint with mT <= mW, the MET rescaled if needed;
+            // smallest |pz| first a la Run I. Solved once per event
+            const NeutrinoSolver::Solution & solution =
+                fzCalculator.GetSolver().Solve(m_lepton, m_met, 0., 80.4);  // NGO fix this!(read from one place)
+            FourVector nu = solution.GetConstrained(0);
+            FourVector othernu = solution.GetConstrained(1);
             
             //NGO: NOTE: neutrino PX, PY are not necessarily metPX, metPY any more!!!
-            _neutrino.SetPxPyPzE(nu_px,nu_py,nu_pz,nu_e);
-            _otherneutrino.SetPxPyPzE(nu_px,nu_py,othernu_pz,nu_e);
+            _neutrino = nu;
+            _otherneutrino = othernu;
         }
         
         ++nJets;
@@ -239,7 +232,7 @@ int LJetsTopoVarsNew::setEvent(const vector<std::pair<TLorentzVector,bool> > jet
 }
 
 
-int LJetsTopoVarsNew::setEventMetFixed(TLorentzVector& Jet1, TLorentzVector& Jet2, TLorentzVector& Jet3, TLorentzVector& Jet4, TLorentzVector& NewMet,TLorentzVector& Muon1, double min_dr_jet_lepton)
+int LJetsTopoVarsNew::setEventMetFixed(FourVector const & Jet1, FourVector const & Jet2, FourVector const & Jet3, FourVector const & Jet4, FourVector const & NewMet, FourVector const & Muon1, double min_dr_jet_lepton)
 {
     
     using namespace std;
@@ -252,19 +245,17 @@ int LJetsTopoVarsNew::setEventMetFixed(TLorentzVector& Jet1, TLorentzVector& Jet
     eigenval.ResizeTo(3);
     eigenval.Zero();
     
-    m_met = TMBLorentzVector(NewMet[0],NewMet[1],NewMet[2],NewMet[3],TMBLorentzVector::kXYZE);
-    // cout<<"!!! NewMet eneryg = "<<m_met(3)<<endl;
-    m_lepton= TMBLorentzVector(Muon1[0],Muon1[1],Muon1[2],Muon1[3],TMBLorentzVector::kXYZE);
-    TMBLorentzVector jets[4] = {Jet1,Jet2,Jet3,Jet4};
+    m_met = NewMet;
+    m_lepton = Muon1;
+    FourVector jets[4] = {Jet1,Jet2,Jet3,Jet4};
     
     // cout << "jets_1_px = "<<jets[0][0];
     // cout << "jets_3_energy = "<<jets[2][3];
     
     for (int i = 0; i<4; i++){
         //cout << "LJetsTopoVarsNew::setEvent(): jet pt() = " << jet -> pt() << endl;
-        TMBLorentzVector _j(jets[i][0],jets[i][1],jets[i][2],jets[i][3],TMBLorentzVector::kXYZE);
-        if (m_lepton.DeltaR(_j) > min_dr_jet_lepton){
-            m_jets.push_back(_j);
+        if (fourvector::DeltaR(m_lepton, jets[i]) > min_dr_jet_lepton){
+            m_jets.push_back(jets[i]);
             //jet++;
             //  cout << "!!!!!!! i = "<<i<<endl;
         }
@@ -284,8 +275,6 @@ int LJetsTopoVarsNew::setEventMetFixed(TLorentzVector& Jet1, TLorentzVector& Jet
     //cout<<"IM stick inside jets"<<endl;
     
     cout<<"m_jets size = "<<m_jets.size()<<endl;
-    double nu_px = m_met.Px();
-    double nu_py = m_met.Py();
     
     //set all OK flags to FALSE;
     _htOK = false;
@@ -295,43 +284,13 @@ int LJetsTopoVarsNew::setEventMetFixed(TLorentzVector& Jet1, TLorentzVector& Jet
     
     //
     // calculate neutrino lorentz vector (from Tobi's TopSvtAnalysis)
-    //
-    double nu_pz = 0.;
-    double nu_e  = sqrt(pow(nu_px,2)+pow(nu_py,2));
-    
-    double Mw    = WMassPdg;
-    double l_px  = m_lepton.Px();
-    double l_py  = m_lepton.Py();
-    double l_pz  = m_lepton.Pz();
-    double l_pt  = m_lepton.Pt();
-    double l_e   = m_lepton.E();
-    double Mt    = sqrt(pow(l_pt+nu_e ,2)-
-                        pow(l_px+nu_px,2)-
-                        pow(l_py+nu_py,2));
-    
-    double A;
-    // FIXME: do we need this Mt to Mw fix?
-    if (Mt<Mw) A = pow(Mw,2)/2.;
-    else       {           // assume Mt=Mw, rescale MET accordingly
-        A = pow(Mt,2)/2.;
-        double k = nu_e*l_pt - nu_px*l_px - nu_py*l_py;
-        k = (k == 0. ? 0.00001 : k);
-        double scf = 0.5*pow(Mw,2)/k ;
-        nu_px *= scf;
-        nu_py *= scf;
-        nu_e = sqrt(pow(nu_px,2)+pow(nu_py,2));
-    }
-    double B = nu_px*l_px + nu_py*l_py;
-    double C = TMath::Max(1. + pow(nu_e,2) * (pow(l_pz,2)-pow(l_e,2)) / pow(A+B,2)  , 0.);
-    C = sqrt(C);
-    double S1= (-(A+B)*l_pz + (A+B)*l_e*C) / (pow(l_pz,2)-pow(l_e,2));
-    double S2= (-(A+B)*l_pz - (A+B)*l_e*C) / (pow(l_pz,2)-pow(l_e,2));
-    
     // choose solution with smallest |l_pz| a la Run I
-    nu_pz = fabs (S1) < fabs (S2) ? S1 : S2 ;
+    // FIXME: do we need this Mt to Mw fix?
+    //
+    FourVector nu = fzCalculator.GetSolver().Solve(m_lepton, m_met, 0., WMassPdg).GetConstrained(0);
     
     //NGO: NOTE: neutrino PX, PY are not necessarily metPX, metPY any more!!!
-    _neutrino.SetPxPyPzE(nu_px,nu_py,nu_pz,nu_e);
+    _neutrino = nu;
     
     cout<<"!!!!!!!!!!!!!!!"<<endl;
     cout<< "im beofre variable defintion"<<endl;
@@ -352,7 +311,7 @@ double LJetsTopoVarsNew::pzothernu() const
 
 double LJetsTopoVarsNew::aplanarity() const
 {
-    vector<TMBLorentzVector> objects(m_jets);
+    vector<FourVector> objects(m_jets);
     objects.push_back(m_lepton);
     TopTopologicalVariables jetsPlusLepton(objects);
     return jetsPlusLepton.Aplanarity();
@@ -366,7 +325,7 @@ double LJetsTopoVarsNew::centrality() const
 
 double LJetsTopoVarsNew::sphericity() const
 {
-    vector<TMBLorentzVector> objects(m_jets);
+    vector<FourVector> objects(m_jets);
     objects.push_back(m_lepton);
     TopTopologicalVariables jetsPlusLepton(objects);
     return jetsPlusLepton.Sphericity();
@@ -380,7 +339,7 @@ double LJetsTopoVarsNew::ht() const
 
 double LJetsTopoVarsNew::htpluslepton() const
 {
-    vector<TMBLorentzVector> objects(m_jets);
+    vector<FourVector> objects(m_jets);
     objects.push_back(m_lepton);
     TopTopologicalVariables jetsPlusLepton(objects);
     return jetsPlusLepton.Ht();
@@ -388,7 +347,7 @@ double LJetsTopoVarsNew::htpluslepton() const
 
 double LJetsTopoVarsNew::methtpluslepton() const
 {
-    vector<TMBLorentzVector> objects(m_jets);
+    vector<FourVector> objects(m_jets);
     objects.push_back(m_lepton);
     objects.push_back(m_met);
     TopTopologicalVariables metjetsPlusLepton(objects);
@@ -402,7 +361,7 @@ double LJetsTopoVarsNew::h() const
 }
 
 double  LJetsTopoVarsNew::H_AllJets_MinusBestJet(){
-    //std::vector<TMBLorentzVector> GoodJetsMinusBestJet;
+    //std::vector<FourVector> GoodJetsMinusBestJet;
     //GoodJetsMinusBestJet=_GoodJetsMinusBestJet
     //if(debug) cout << "halljGoodJetsMinusBestJet   " << _GoodJetsMinusBestJet.size() << endl;
     TopTopologicalVariables jets(_GoodJetsMinusBestJet);
@@ -448,7 +407,7 @@ double LJetsTopoVarsNew::dphiLepJ4()
 
 double LJetsTopoVarsNew::Jet1Jet2_DeltaPhi() {
     if(m_jets.size()>1) {
-        return TMath::Abs(m_jets.at(0).DeltaPhi(m_jets.at(1)));
+        return TMath::Abs(fourvector::DeltaPhi(m_jets.at(0).Phi(), m_jets.at(1).Phi()));
     } else return -100;
 }
 
@@ -508,7 +467,7 @@ double LJetsTopoVarsNew::minDijetDeltaR() const
     //double eTmin = 9999.;
     for(int i=0;i<nJet-1;i++){
         for(int j=i+1;j<nJet;j++){
-            double dR = m_jets[i].DeltaR(m_jets[j]);
+            double dR = fourvector::DeltaR(m_jets[i], m_jets[j]);
             if(dR<dRmin){
                 dRmin = dR;
                 //eTmin = std::min(m_jets[i].Pt(),m_jets[j].Pt());
@@ -522,18 +481,18 @@ double LJetsTopoVarsNew::minDijetDeltaR() const
 
 
 double LJetsTopoVarsNew::Hz() {
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     objects.assign(m_jets.begin(), m_jets.end());
     objects.push_back(m_lepton);
     objects.push_back(_neutrino);
     double pz = 0;
-    for (vector<TMBLorentzVector>::iterator obj = objects.begin(); obj!=objects.end(); ++obj) pz += abs((*obj).Pz());
+    for (vector<FourVector>::iterator obj = objects.begin(); obj!=objects.end(); ++obj) pz += abs((*obj).Pz());
     return pz;
 }
 
 double LJetsTopoVarsNew::HT2() {
     if (m_jets.size()==0) return 0.;
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     objects.assign(++m_jets.begin(), m_jets.end());
     TopTopologicalVariables topo(objects);
     return topo.Ht();
@@ -544,7 +503,7 @@ double LJetsTopoVarsNew::HT2prime() {
 }
 
 double  LJetsTopoVarsNew::HT_AllJets_MinusBestJet(){
-    //std::vector<TMBLorentzVector> GoodJetsMinusBestJet;
+    //std::vector<FourVector> GoodJetsMinusBestJet;
     //GoodJetsMinusBestJet=_GoodJetsMinusBestJet
     TopTopologicalVariables jets(_GoodJetsMinusBestJet);
     return jets.Ht();
@@ -552,9 +511,9 @@ double  LJetsTopoVarsNew::HT_AllJets_MinusBestJet(){
 
 double  LJetsTopoVarsNew::AllJets_MinusBestJet_Pt(){
     if(m_jets.size()>1) {
-        std::vector<TMBLorentzVector> GoodJetsMinusBestJet;
+        std::vector<FourVector> GoodJetsMinusBestJet;
         GoodJetsMinusBestJet=_GoodJetsMinusBestJet;
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         //if(debug) cout << "alljptGoodJetsMinusBestJet   " << GoodJetsMinusBestJet.size() << endl;
         for (unsigned int i=0; i<GoodJetsMinusBestJet.size(); i++) {
             objects.push_back(GoodJetsMinusBestJet.at(i));
@@ -566,13 +525,13 @@ double  LJetsTopoVarsNew::AllJets_MinusBestJet_Pt(){
 }
 
 double  LJetsTopoVarsNew::J1_NotBestJet_Pt(){
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     //if(debug) cout << "m_jets.size()    " << m_jets.size()<< endl;
     if(m_jets.size()>1) {
-        std::vector<TMBLorentzVector> GoodJetsMinusBestJet;
+        std::vector<FourVector> GoodJetsMinusBestJet;
         GoodJetsMinusBestJet=_GoodJetsMinusBestJet;
         //if(debug) cout << "j1ptGoodJetsMinusBestJet   " << GoodJetsMinusBestJet.size() << endl;
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         objects.push_back(GoodJetsMinusBestJet.at(0));
         TopTopologicalVariables topo(objects);
         //if(debug) cout << "top.pt    " << topo.Pt() << endl;
@@ -585,7 +544,7 @@ double  LJetsTopoVarsNew::J1_NotBestJet_Pt(){
 
 double  LJetsTopoVarsNew::J1_NotBestJet_Eta(){
     if(m_jets.size()>1) {
-        std::vector<TMBLorentzVector> GoodJetsMinusBestJet;
+        std::vector<FourVector> GoodJetsMinusBestJet;
         GoodJetsMinusBestJet=_GoodJetsMinusBestJet;
         if (GoodJetsMinusBestJet.size()){
             return GoodJetsMinusBestJet.at(0).Eta();
@@ -595,10 +554,10 @@ double  LJetsTopoVarsNew::J1_NotBestJet_Eta(){
 
 double  LJetsTopoVarsNew::J1_NotBestJet_Phi(){
     if(m_jets.size()>1) {
-        std::vector<TMBLorentzVector> GoodJetsMinusBestJet;
+        std::vector<FourVector> GoodJetsMinusBestJet;
         GoodJetsMinusBestJet=_GoodJetsMinusBestJet;
         if (GoodJetsMinusBestJet.size()){
-            return GoodJetsMinusBestJet.at(0).Phi();
+            return Phi0To2Pi(GoodJetsMinusBestJet.at(0));
         } else return -100;
     } else return -100;
 }
@@ -606,12 +565,12 @@ double  LJetsTopoVarsNew::J1_NotBestJet_Phi(){
 
 
 double  LJetsTopoVarsNew::J2_NotBestJet_Pt(){
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     //if(debug) cout << "m_jets.size()    " << m_jets.size()<< endl;
     if(m_jets.size()>2) {
-        std::vector<TMBLorentzVector> GoodJetsMinusBestJet;
+        std::vector<FourVector> GoodJetsMinusBestJet;
         GoodJetsMinusBestJet=_GoodJetsMinusBestJet;
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         objects.push_back(GoodJetsMinusBestJet.at(1));
         TopTopologicalVariables topo(objects);
         return topo.Pt();
@@ -621,7 +580,7 @@ double  LJetsTopoVarsNew::J2_NotBestJet_Pt(){
 
 double  LJetsTopoVarsNew::J2_NotBestJet_Eta(){
     if(m_jets.size()>2) {
-        std::vector<TMBLorentzVector> GoodJetsMinusBestJet;
+        std::vector<FourVector> GoodJetsMinusBestJet;
         GoodJetsMinusBestJet=_GoodJetsMinusBestJet;
         if (GoodJetsMinusBestJet.size()){
             return GoodJetsMinusBestJet.at(1).Eta();
@@ -631,7 +590,7 @@ double  LJetsTopoVarsNew::J2_NotBestJet_Eta(){
 
 
 double LJetsTopoVarsNew::W_MT() {
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     //objects.push_back(_neutrino);  //_neutrino was made with W mass constraint; use MET instead
     objects.push_back(m_met);
     objects.push_back(m_lepton);
@@ -640,7 +599,7 @@ double LJetsTopoVarsNew::W_MT() {
 }
 
 double LJetsTopoVarsNew::W_Pt() {
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     //objects.push_back(_neutrino);  //_neutrino was made with W mass constraint; use MET instead
     objects.push_back(m_met);
     objects.push_back(m_lepton);
@@ -649,7 +608,7 @@ double LJetsTopoVarsNew::W_Pt() {
 }
 
 double LJetsTopoVarsNew::W_M() {
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     objects.push_back(_neutrino);  //_neutrino was made with W mass constraint; use MET instead
     //	objects.push_back(m_met);
     objects.push_back(m_lepton);
@@ -659,7 +618,7 @@ double LJetsTopoVarsNew::W_M() {
 
 double LJetsTopoVarsNew::Jet1Jet2_M() {
     if(m_jets.size()>=2) {
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         objects.push_back(m_jets.at(0));
         objects.push_back(m_jets.at(1));
         TopTopologicalVariables topo(objects);
@@ -669,7 +628,7 @@ double LJetsTopoVarsNew::Jet1Jet2_M() {
 
 double LJetsTopoVarsNew::Jet1Jet2_Pt() {
     if(m_jets.size()>=2) {
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         objects.push_back(m_jets.at(0));
         objects.push_back(m_jets.at(1));
         TopTopologicalVariables topo(objects);
@@ -679,13 +638,13 @@ double LJetsTopoVarsNew::Jet1Jet2_Pt() {
 
 double LJetsTopoVarsNew::Jet1Jet2_DeltaR() {
     if(m_jets.size()>=2) {
-        return m_jets.at(0).DeltaR(m_jets.at(1));
+        return fourvector::DeltaR(m_jets.at(0), m_jets.at(1));
     } else return -1;
 }
 
 double LJetsTopoVarsNew::Jet1Jet2W_M() {
     if(m_jets.size()>=2) {
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         objects.push_back(_neutrino);  //_neutrino was made with W mass constraint; use MET instead
         //	objects.push_back(m_met);
         objects.push_back(m_lepton);
@@ -698,7 +657,7 @@ double LJetsTopoVarsNew::Jet1Jet2W_M() {
 
 double LJetsTopoVarsNew::Jet1Jet2W_Pt() {
     if(m_jets.size()>=2) {
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         objects.push_back(_neutrino);  //_neutrino was made with W mass constraint; use MET instead
         //	objects.push_back(m_met);
         objects.push_back(m_lepton);
@@ -718,9 +677,9 @@ double LJetsTopoVarsNew::LeptonJet_DeltaR() {
     
     double dR = -1.;
     if (m_jets.size()>=2) {
-        dR = m_lepton.DeltaR(m_jets.at(0))< m_lepton.DeltaR(m_jets.at(1)) ? m_lepton.DeltaR(m_jets.at(0)) : m_lepton.DeltaR(m_jets.at(1));
+        dR = fourvector::DeltaR(m_lepton, m_jets.at(0))< fourvector::DeltaR(m_lepton, m_jets.at(1)) ? fourvector::DeltaR(m_lepton, m_jets.at(0)) : fourvector::DeltaR(m_lepton, m_jets.at(1));
     } else if (m_jets.size()==1) {
-        dR = m_lepton.DeltaR(m_jets.at(0));
+        dR = fourvector::DeltaR(m_lepton, m_jets.at(0));
     } else if (m_jets.size()==0) {
         dR = -1.;
     }
@@ -730,7 +689,7 @@ double LJetsTopoVarsNew::LeptonJet_DeltaR() {
 double LJetsTopoVarsNew::Muon_DeltaR() {
     //is this already stored in the muon somewhere?
     double DeltaR = 1e99;
-    for (unsigned int i=0; i<m_jets.size(); i++) DeltaR = min(DeltaR, m_lepton.DeltaR(m_jets.at(i)));
+    for (unsigned int i=0; i<m_jets.size(); i++) DeltaR = min(DeltaR, fourvector::DeltaR(m_lepton, m_jets.at(i)));
     return DeltaR;
 }
 
@@ -764,18 +723,18 @@ double LJetsTopoVarsNew::LightJet_DiscVal(){
 
 double LJetsTopoVarsNew::BestTop() {
     
-    TMBLorentzVector Top;
+    FourVector Top;
     //std::cout<<" Topovar calc lepton pt "<<m_lepton.Pt()<<" neutrino pt "<<_neutrino.Pt()<<std::endl;
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector BestTop;
+    FourVector W = m_lepton + _neutrino;
+    FourVector BestTop;
     bool foundindex=false;
     
     double TopMass=0.0;
     double BestTopMass = -99999.0;
     //std::cout<< " Topovar calc TestBestTop njets = " <<m_jets.size() << std::endl;
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     SetBestTop_JetIndex(-1);
-    std::vector<TMBLorentzVector> GoodJetsMinusBestJet;
+    std::vector<FourVector> GoodJetsMinusBestJet;
     SetGoodJetsMinusBestJet(GoodJetsMinusBestJet);
     for (unsigned int i=0; i< m_jets.size(); i++ ) {
         Top = W + m_jets[i];
@@ -786,7 +745,7 @@ double LJetsTopoVarsNew::BestTop() {
             BestTop = Top;
             
             //std::cout << "New Best Top Mass is " << TopMass << endl;
-            TMBLorentzVector TestBestTop = GetBestTop();
+            FourVector TestBestTop = GetBestTop();
             //std::cout << " Topovar == TestBestTop" << TestBestTop.M() << std::endl;
             
             SetBestTop_JetIndex(i);
@@ -813,9 +772,9 @@ double LJetsTopoVarsNew::BestTop() {
 
 double  LJetsTopoVarsNew::SecBestTop(){
     double TopMass=0.0;
-    TMBLorentzVector Top;
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector SecBestTop;
+    FourVector Top;
+    FourVector W = m_lepton + _neutrino;
+    FourVector SecBestTop;
     unsigned int index = GetBestTop_JetIndex();
     for (unsigned int i=0; i< m_jets.size(); i++ ) {
         if (i != index){
@@ -829,9 +788,9 @@ double  LJetsTopoVarsNew::SecBestTop(){
 
 double  LJetsTopoVarsNew::SecBestBTagTop(){
     double TopMass = -10.0;
-    TMBLorentzVector Top;
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector SecBestBTagTop;
+    FourVector Top;
+    FourVector W = m_lepton + _neutrino;
+    FourVector SecBestBTagTop;
     unsigned int index = GetBestTop_JetIndex();
     for (unsigned int i=0; i< m_jets.size(); i++ ) {
         if (i != index){
@@ -851,22 +810,22 @@ double  LJetsTopoVarsNew::SecBestBTagTop(){
 
 double LJetsTopoVarsNew::BestTopBJet_Phi() {
     
-    TMBLorentzVector Top;
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector BestTop;
+    FourVector Top;
+    FourVector W = m_lepton + _neutrino;
+    FourVector BestTop;
     bool foundindex=false;
     
     double TopMass=0.0;
     double BestTopMass = 5000.0;
     double BestTopBJetPhi = -100.;
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     for (unsigned int i=0; i< m_jets.size(); i++ ) {
         Top = W + m_jets[i];
         TopMass = Top.M();
         if ( fabs(172.5-TopMass) <  fabs(172.5-BestTopMass) ) {
             BestTopMass = TopMass;
             BestTop = Top;
-            BestTopBJetPhi = m_jets[i].Phi();
+            BestTopBJetPhi = Phi0To2Pi(m_jets[i]);
             foundindex = true;
         }
     } // loop over jets
@@ -879,15 +838,15 @@ double LJetsTopoVarsNew::BestTopBJet_Phi() {
 }
 double LJetsTopoVarsNew::BestTopBJet_Pt() {
     
-    TMBLorentzVector Top;
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector BestTop;
+    FourVector Top;
+    FourVector W = m_lepton + _neutrino;
+    FourVector BestTop;
     bool foundindex=false;
     
     double TopMass=0.0;
     double BestTopMass = 5000.0;
     double BestTopBJetPt = -100.;
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     for (unsigned int i=0; i< m_jets.size(); i++ ) {
         Top = W + m_jets[i];
         TopMass = Top.M();
@@ -908,15 +867,15 @@ double LJetsTopoVarsNew::BestTopBJet_Pt() {
 
 double LJetsTopoVarsNew::BestTopBJet_Eta() {
     
-    TMBLorentzVector Top;
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector BestTop;
+    FourVector Top;
+    FourVector W = m_lepton + _neutrino;
+    FourVector BestTop;
     bool foundindex=false;
     
     double TopMass=0.0;
     double BestTopMass = 5000.0;
     double BestTopBJetEta = -100.;
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     for (unsigned int i=0; i< m_jets.size(); i++ ) {
         Top = W + m_jets[i];
         TopMass = Top.M();
@@ -937,15 +896,15 @@ double LJetsTopoVarsNew::BestTopBJet_Eta() {
 
 double LJetsTopoVarsNew::BestTop_Pt() {
     
-    TMBLorentzVector Top;
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector BestTop;
+    FourVector Top;
+    FourVector W = m_lepton + _neutrino;
+    FourVector BestTop;
     bool foundindex=false;
     
     double TopMass=0.0;
     double BestTopMass = 5000.0;
     double BestTopPt = -10.;
-    vector<TMBLorentzVector> objects;
+    vector<FourVector> objects;
     for (unsigned int i=0; i< m_jets.size(); i++ ) {
         Top = W + m_jets[i];
         TopMass = Top.M();
@@ -968,8 +927,8 @@ double LJetsTopoVarsNew::BestTop_Pt() {
 double LJetsTopoVarsNew::BTagTopMass()
 {
     
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector LeadingbtagTop;
+    FourVector W = m_lepton + _neutrino;
+    FourVector LeadingbtagTop;
     double mass = -10.;
     if (number_of_tagged_jets){
         LeadingbtagTop = W + m_jets[tagged_jet_highpt_index];
@@ -983,8 +942,8 @@ double LJetsTopoVarsNew::BTagTopMass()
 double LJetsTopoVarsNew::BTagTop_Pt()
 {
     
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector LeadingbtagTop;
+    FourVector W = m_lepton + _neutrino;
+    FourVector LeadingbtagTop;
     double pt = -10.;
     if (number_of_tagged_jets){
         LeadingbtagTop = W + m_jets[tagged_jet_highpt_index];
@@ -999,8 +958,8 @@ double LJetsTopoVarsNew::BTagTop_Pt()
 double LJetsTopoVarsNew::SecBTagTopMass()
 {
     
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector SecLeadingbtagTop;
+    FourVector W = m_lepton + _neutrino;
+    FourVector SecLeadingbtagTop;
     double mass = -10.;
     if (number_of_tagged_jets>1){
         SecLeadingbtagTop = W + m_jets[second_tagged_jet_highpt_index];
@@ -1012,8 +971,8 @@ double LJetsTopoVarsNew::SecBTagTopMass()
 
 double LJetsTopoVarsNew::SecBTagTop_Pt()
 {
-    TMBLorentzVector W = m_lepton + _neutrino;
-    TMBLorentzVector SecLeadingbtagTop;
+    FourVector W = m_lepton + _neutrino;
+    FourVector SecLeadingbtagTop;
     double pt = -10.;
     if (number_of_tagged_jets>1){
         SecLeadingbtagTop = W + m_jets[second_tagged_jet_highpt_index];
@@ -1024,7 +983,7 @@ double LJetsTopoVarsNew::SecBTagTop_Pt()
 
 double LJetsTopoVarsNew::Jet1TagJet2TagW_M(){
     if(m_jets.size()>=2) {
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         objects.push_back(_neutrino);  //_neutrino was made with W mass constraint; use MET instead
         //	objects.push_back(m_met);
         objects.push_back(m_lepton);
@@ -1040,7 +999,7 @@ double LJetsTopoVarsNew::Jet1TagJet2TagW_M(){
 double LJetsTopoVarsNew::BestJetJet2W_M() {
     if(m_jets.size()>=2) {
         
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         objects.push_back(_neutrino);
         objects.push_back(m_lepton);
         unsigned int index = GetBestTop_JetIndex();
@@ -1071,7 +1030,7 @@ double LJetsTopoVarsNew::LepTopBJet_DeltaR() {
         unsigned int index = GetBestTop_JetIndex();
         //cout<< "----------------"<<endl;
         //std::cout << "best top bjet is jet" << index+1 << std::endl;
-        //std::cout << "LepTopBJet_DeltaR = " << m_lepton.DeltaR(m_jets.at(index)) << std::endl;
+        //std::cout << "LepTopBJet_DeltaR = " << fourvector::DeltaR(m_lepton, m_jets.at(index)) << std::endl;
         double deta = m_lepton.Eta()-m_jets[index].Eta();
         double dphi = m_lepton.Phi()-m_jets[index].Phi();
         if (dphi > TMath::Pi()) dphi -= 2*TMath::Pi();
@@ -1088,7 +1047,7 @@ double LJetsTopoVarsNew::LepTopBJet_DeltaR() {
         //if (m_jets.size()>6) cout<< "m_jet7.pt, eta, phi, energy = "<<m_jets[6].Pt()<<", "<<m_jets[6].Eta()<<", "<<m_jets[6].Phi()<<", "<<m_jets[6][3]<<endl;
         //if (m_jets.size()>7) cout<< "m_jet8.pt, eta, phi, energy = "<<m_jets[7].Pt()<<", "<<m_jets[7].Eta()<<", "<<m_jets[7].Phi()<<", "<<m_jets[7][3]<<endl;
         //if (m_jets.size()>8) cout<< "m_jet9.pt, eta, phi, energy = "<<m_jets[8].Pt()<<", "<<m_jets[8].Eta()<<", "<<m_jets[8].Phi()<<", "<<m_jets[8][3]<<endl;
-        return m_lepton.DeltaR(m_jets.at(index));
+        return fourvector::DeltaR(m_lepton, m_jets.at(index));
     } else return 1e99;
 }
 
@@ -1096,7 +1055,7 @@ double LJetsTopoVarsNew::LepTopBJet_Dphi() {
     if(m_jets.size()>0) {
         unsigned int index = GetBestTop_JetIndex();
         //std::cout << "index is " << index << std::endl;
-        return fabs(m_jets.at(index).Phi()-m_lepton.Phi());
+        return fabs(Phi0To2Pi(m_jets.at(index))-Phi0To2Pi(m_lepton));
     } else return 1e99;
 }
 
@@ -1118,14 +1077,14 @@ double LJetsTopoVarsNew::BestJet_Eta() {
 double LJetsTopoVarsNew::BestJet_Phi() {
     if(m_jets.size()>0) {
         unsigned int index = GetBestTop_JetIndex();
-        return m_jets.at(index).Phi();
+        return Phi0To2Pi(m_jets.at(index));
     } else return -10;
 }
 
 
 double LJetsTopoVarsNew::AllJets_M() {
     if(m_jets.size()) {
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         for (unsigned int i=0; i<m_jets.size(); i++) {
             objects.push_back(m_jets.at(i));
         }
@@ -1136,7 +1095,7 @@ double LJetsTopoVarsNew::AllJets_M() {
 
 double LJetsTopoVarsNew::AllJetsW_M() {//sqrt_shat
     if(m_jets.size()>=2) {
-        vector<TMBLorentzVector> objects;
+        vector<FourVector> objects;
         objects.push_back(_neutrino);  //_neutrino was made with W mass constraint; use MET instead
         //	objects.push_back(m_met);
         objects.push_back(m_lepton);
@@ -1153,10 +1112,10 @@ double LJetsTopoVarsNew::AllJetsW_M() {//sqrt_shat
 /*
  int LJetsTopoVarsNew::LeptonMETxy() {
  std::cout<<"in leptonmetxy"<<std::endl;
- vector<TMBLorentzVector> LeptonMETxy;
+ vector<FourVector> LeptonMETxy;
  LeptonMETxy.clear();
  LeptonMETxy.push_back(m_lepton[0]);
- TMBLorentzVector nu;
+ FourVector nu;
  nu.SetXYZM(_neutrino[0],_neutrino[1],0.0,0.0);
  LeptonMETxy.push_back(nu);
  SetLeptonMETxy(LeptonMETxy);
@@ -1169,15 +1128,13 @@ double LJetsTopoVarsNew::Cos_BestJetLepton_BestTop() {
     
     double Cos_BestJetLepton_Besttop=-10.0;
     
-    vector<TMBLorentzVector> LeptonMETxy;
+    vector<FourVector> LeptonMETxy;
     LeptonMETxy.clear();
-    LeptonMETxy.push_back(m_lepton[0]);
-    TMBLorentzVector nu;
-    nu.SetXYZM(_neutrino[0],_neutrino[1],0.0,0.0);
-    LeptonMETxy.push_back(nu);
+    LeptonMETxy.push_back(LeptonMETxyLepton(m_lepton));
+    LeptonMETxy.push_back(LeptonMETxyNeutrino(_neutrino));
     SetLeptonMETxy(LeptonMETxy);
     
-    TMBLorentzVector BestTop = GetBestTop();
+    FourVector BestTop = GetBestTop();
     unsigned int index = GetBestTop_JetIndex();
     
     //std::cout << "  Cos_BestJetLepton_BestTop- jet index == " <<  index <<  std::endl;
@@ -1196,15 +1153,13 @@ double LJetsTopoVarsNew::Cos_LightjetJetLepton_BestTop() {
     
     double Cos_LightjetJetLepton_BestTop=-10.0;
     
-    vector<TMBLorentzVector> LeptonMETxy;
+    vector<FourVector> LeptonMETxy;
     LeptonMETxy.clear();
-    LeptonMETxy.push_back(m_lepton[0]);
-    TMBLorentzVector nu;
-    nu.SetXYZM(_neutrino[0],_neutrino[1],0.0,0.0);
-    LeptonMETxy.push_back(nu);
+    LeptonMETxy.push_back(LeptonMETxyLepton(m_lepton));
+    LeptonMETxy.push_back(LeptonMETxyNeutrino(_neutrino));
     SetLeptonMETxy(LeptonMETxy);
     
-    TMBLorentzVector bestTop = GetBestTop();
+    FourVector bestTop = GetBestTop();
     
     TopAngleUtils angleutils;
     unsigned int index = untagged_jet_highpt_index;
@@ -1217,15 +1172,13 @@ double LJetsTopoVarsNew::Cos_LightjetJetLepton_BTagTop() {
     
     double Cos_LightjetJetLepton_BTagTop=-10.0;
     
-    vector<TMBLorentzVector> LeptonMETxy;
+    vector<FourVector> LeptonMETxy;
     LeptonMETxy.clear();
-    LeptonMETxy.push_back(m_lepton[0]);
-    TMBLorentzVector nu;
-    nu.SetXYZM(_neutrino[0],_neutrino[1],0.0,0.0);
-    LeptonMETxy.push_back(nu);
+    LeptonMETxy.push_back(LeptonMETxyLepton(m_lepton));
+    LeptonMETxy.push_back(LeptonMETxyNeutrino(_neutrino));
     SetLeptonMETxy(LeptonMETxy);
     
-    TMBLorentzVector btagTop = GetBTagTop();
+    FourVector btagTop = GetBTagTop();
     TopAngleUtils angleutils;
     unsigned int index = untagged_jet_highpt_index;
     
@@ -1233,6 +1186,45 @@ double LJetsTopoVarsNew::Cos_LightjetJetLepton_BTagTop() {
     
     return  Cos_LightjetJetLepton_BTagTop;
     
+}
+void LJetsTopoVarsNew::Cos_JetLepton_Tops(double * cosines) {
+    
+    cosines[0] = cosines[1] = cosines[2] = -10.0;
+    
+    vector<FourVector> LeptonMETxy;
+    LeptonMETxy.push_back(LeptonMETxyLepton(m_lepton));
+    LeptonMETxy.push_back(LeptonMETxyNeutrino(_neutrino));
+    SetLeptonMETxy(LeptonMETxy);
+    
+    FourVector bestTop = GetBestTop();
+    FourVector btagTop = GetBTagTop();
+    
+    // only the angles the scalar versions would compute, slot[i] is where result i goes
+    FourVector jet[3], lepton[3], frame[3];
+    unsigned int slot[3];
+    size_t n = 0;
+    if (bestTop.M()) {
+        jet[n] = m_jets.at(GetBestTop_JetIndex());
+        frame[n] = bestTop;
+        slot[n++] = 0;
+    }
+    if (bestTop.M() && number_of_untagged_jets) {
+        jet[n] = m_jets.at(untagged_jet_highpt_index);
+        frame[n] = bestTop;
+        slot[n++] = 1;
+    }
+    if (btagTop.M() && number_of_untagged_jets) {
+        jet[n] = m_jets.at(untagged_jet_highpt_index);
+        frame[n] = btagTop;
+        slot[n++] = 2;
+    }
+    for (size_t i = 0; i != n; ++i) lepton[i] = LeptonMETxy[0];
+    
+    double batch[3];
+    TopAngleUtils angleutils;
+    angleutils.CosAngles(jet, lepton, frame, n, batch);
+    for (size_t i = 0; i != n; ++i) cosines[slot[i]] = batch[i];
+    
 }
 
 //
@@ -1273,7 +1265,7 @@ void LJetsTopoVarsNew::calcHt(){
     double hzSigned = 0.;
     _ht[12]         =-1.;
     double mtjets   = 0.;
-    TMBLorentzVector Mevent;
+    FourVector Mevent;
     int nJet = m_jets.size();
     
     for(int i=0;i<nJet;i++){
@@ -1291,7 +1283,7 @@ void LJetsTopoVarsNew::calcHt(){
         }
         
         for(int j=i+1; j<nJet; j++){
-            double mDijet = (m_jets[i]+m_jets[j]).Mag();
+            double mDijet = (m_jets[i]+m_jets[j]).M();
             if(_ht[12]<0. || mDijet<_ht[12]){ _ht[12]=mDijet; }
         }
         mtjets +=
@@ -1356,7 +1348,7 @@ void LJetsTopoVarsNew::calcHt(){
     // total event invariant mass
     Mevent += m_lepton;
     Mevent += _neutrino;
-    _ht[17] = Mevent.Mag();
+    _ht[17] = Mevent.M();
     
     
     // sum of dijet invariant masses for three highest jets
@@ -1365,7 +1357,7 @@ void LJetsTopoVarsNew::calcHt(){
         double min=1e10;
         for(int i=0;i<2;i++){
             for(int j=i+1; j<3; j++){
-                double m = (m_jets[i]+m_jets[j]).Mag();
+                double m = (m_jets[i]+m_jets[j]).M();
                 _ht[18] += m;
                 double diff = TMath::Abs(WMassPdg-m);
                 if(diff<min){
@@ -1393,7 +1385,7 @@ void LJetsTopoVarsNew::calcEvtTopo(){
     //
     double psum = 0.;
     for(int k=0;k<nJet;k++){
-        psum += m_jets[k].Vect().Mag32();
+        psum += m_jets[k].P2();
     }
     
     TMatrixDSym M(3);
@@ -1401,7 +1393,7 @@ void LJetsTopoVarsNew::calcEvtTopo(){
         for(int j=i;j<3;j++){
             M(i,j)=0.;
             for(int k=0;k<nJet;k++){
-                M(i,j) += m_jets[k](i) * m_jets[k](j);
+                M(i,j) += Component(m_jets[k], i) * Component(m_jets[k], j);
             }
             M(i,j)/=psum;
             if(i!=j){M(j,i) = M(i,j);}
@@ -1448,21 +1440,21 @@ void LJetsTopoVarsNew::calcEvtTopo(){
     // include muon in calculation
     //
     // ------------------------------------------------------
-    std::vector<TMBLorentzVector> jetMu(m_jets);
+    std::vector<FourVector> jetMu(m_jets);
     jetMu.push_back(m_lepton);
     nJet = jetMu.size();
     
     // calculate tensor
     psum = 0.;
     for(int k=0;k<nJet;k++){
-        psum += jetMu[k].Vect().Mag32();
+        psum += jetMu[k].P2();
     }
     
     for(int i=0;i<3;i++){
         for(int j=i;j<3;j++){
             M(i,j)=0.;
             for(int k=0;k<nJet;k++){
-                M(i,j) += jetMu[k](i) * jetMu[k](j);
+                M(i,j) += Component(jetMu[k], i) * Component(jetMu[k], j);
             }
             M(i,j)/=psum;
             if(i!=j){M(j,i) = M(i,j);}
@@ -1497,7 +1489,7 @@ void LJetsTopoVarsNew::calcKt()
     double eTmin = 9999.;
     for(int i=0;i<nJet-1;i++){
         for(int j=i+1;j<nJet;j++){
-            double dR = m_jets[i].DeltaR(m_jets[j]);
+            double dR = fourvector::DeltaR(m_jets[i], m_jets[j]);
             if(dR<dRmin){
                 dRmin = dR;
                 eTmin = std::min(m_jets[i].Pt(),m_jets[j].Pt());
@@ -1531,7 +1523,7 @@ void LJetsTopoVarsNew::calcMt()
                              TMath::Power(_neutrino.Py(),2));
     
     
-    _mt[0] = TMath::Abs(m_lepton.DeltaPhi(_neutrino));
+    _mt[0] = TMath::Abs(fourvector::DeltaPhi(m_lepton.Phi(), _neutrino.Phi()));
     _mt[1] = TMath::Sqrt(2*m_lepton.Pt()*met*(1.-TMath::Cos(_mt[0])));
     
     _mtOK = true;
@@ -32,6 +32,7 @@ public:
     virtual int BeginJob(){return 0;}
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
     virtual int EndJob(){return 0;}
+    virtual bool HasSideEffects() const { return false; }
     
     
 private:
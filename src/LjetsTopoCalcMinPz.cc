@@ -10,6 +10,7 @@
 
 #include "DataFormats/Math/interface/LorentzVector.h"
 #include "LJMet/Com/interface/BaseCalc.h"
+#include "LJMet/Com/interface/FourVector.h"
 #include "LJMet/Com/interface/LJetsTopoVarsNew.h" // needs work on compatibility and refactoring
 #include "LJMet/Com/interface/LjmetEventContent.h"
 #include "LJMet/Com/interface/LjmetFactory.h"
@@ -33,11 +34,13 @@ public:
     }
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
     virtual int EndJob(){return 0;}
+    virtual bool HasSideEffects() const { return false; }
     
     
 private:
     
     bool debug_;
+    NeutrinoSolver * mpNuSolver;  // the selector's, shared by the calculators
     
     int FillLjetsBranches( std::vector<edm::Ptr<pat::Muon> > const & vTightMuons,
                           std::vector<edm::Ptr<pat::Electron> > const & vTightElectrons,
@@ -55,7 +58,8 @@ private:
 
 
 
-LjetsTopoCalcMinPz::LjetsTopoCalcMinPz(){
+LjetsTopoCalcMinPz::LjetsTopoCalcMinPz():
+mpNuSolver(0){
     mLegend = "[LjetsTopoCalcMinPz]: ";
 }
 
@@ -66,6 +70,8 @@ int LjetsTopoCalcMinPz::AnalyzeEvent(edm::EventBase const & event,
     // compute event variables here
     //
     
+    mpNuSolver = &selector->GetNeutrinoSolver();
+    
     //
     // _____ Get objects from the selector _____________________
     //
@@ -137,27 +143,27 @@ int LjetsTopoCalcMinPz::FillLjetsBranches( std::vector<edm::Ptr<pat::Muon> > con
     
     while(1){
         
-        TLorentzVector tlv_lepton;
+        FourVector lv_lepton;
         
         if ( vSelMuons.size() == 0 && vSelElectrons.size() == 0) break;
         if ( vSelMuons.size() > 0 && vSelElectrons.size() > 0) {
             std::cout<<mLegend<<"Two Leptons, using the Muon...."<<std::endl;
-            tlv_lepton.SetPxPyPzE( vSelMuons[0]->px(),
-                                  vSelMuons[0]->py(),
-                                  vSelMuons[0]->pz(),
-                                  vSelMuons[0]->energy() );
+            lv_lepton.SetPxPyPzE( vSelMuons[0]->px(),
+                                 vSelMuons[0]->py(),
+                                 vSelMuons[0]->pz(),
+                                 vSelMuons[0]->energy() );
         }
         if ( vSelMuons.size() > 0 ) {
-            tlv_lepton.SetPxPyPzE( vSelMuons[0]->px(),
-                                  vSelMuons[0]->py(),
-                                  vSelMuons[0]->pz(),
-                                  vSelMuons[0]->energy() );
+            lv_lepton.SetPxPyPzE( vSelMuons[0]->px(),
+                                 vSelMuons[0]->py(),
+                                 vSelMuons[0]->pz(),
+                                 vSelMuons[0]->energy() );
         }
         if ( vSelElectrons.size() > 0 ) {
-            tlv_lepton.SetPxPyPzE( vSelElectrons[0]->px(),
-                                  vSelElectrons[0]->py(),
-                                  vSelElectrons[0]->pz(),
-                                  vSelElectrons[0]->energy() );
+            lv_lepton.SetPxPyPzE( vSelElectrons[0]->px(),
+                                 vSelElectrons[0]->py(),
+                                 vSelElectrons[0]->pz(),
+                                 vSelElectrons[0]->energy() );
         }
         
         // make a vector of jets
@@ -186,14 +192,11 @@ int LjetsTopoCalcMinPz::FillLjetsBranches( std::vector<edm::Ptr<pat::Muon> > con
         if ( corrMET.Pt() > 0 ){ }
         else break;
         
-        TLorentzVector tlv_met( corrMET.Px(),
-                               corrMET.Py(),
-                               corrMET.Pz(),
-                               corrMET.Energy() );
+        FourVector lv_met = FourVector::FromLorentz(corrMET);
         
         // topovars calculator
         //LJetsTopoVarsNew topovars(tlv_jets, tlv_muon, tlv_met, isMuon, bestTop);
-        LJetsTopoVarsNew topovars(vCorrBtagJets, tlv_lepton, tlv_met, isMuon,  bestTop);
+        LJetsTopoVarsNew topovars(vCorrBtagJets, lv_lepton, lv_met, isMuon,  bestTop, 80.398, mpNuSolver);
         
         // compute branches
         SetValue("Jet1Jet2W_M", topovars.Jet1Jet2W_M());
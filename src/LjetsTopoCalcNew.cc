@@ -10,6 +10,7 @@
 
 #include "DataFormats/Math/interface/LorentzVector.h"
 #include "LJMet/Com/interface/BaseCalc.h"
+#include "LJMet/Com/interface/FourVector.h"
 #include "LJMet/Com/interface/LJetsTopoVarsNew.h" // needs work on compatibility and refactoring
 #include "LJMet/Com/interface/LjmetEventContent.h"
 #include "LJMet/Com/interface/LjmetFactory.h"
@@ -31,16 +32,28 @@ public:
         if (mPset.exists("debug"))      debug_ = mPset.getParameter<bool>("debug");
         else                            debug_ = false;
         
+        // compare the batched top frame angles to the one-at-a-time CosAngle
+        if (mPset.exists("validateBatchAngles")) validateBatchAngles_ = mPset.getParameter<bool>("validateBatchAngles");
+        else                                     validateBatchAngles_ = false;
+        nBatchAngleMismatch_ = 0;
+        
         return 0;
     }
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
-    virtual int EndJob(){return 0;}
+    virtual int EndJob(){
+        if (validateBatchAngles_) std::cout << mLegend << nBatchAngleMismatch_ << " batched angle mismatches" << std::endl;
+        return 0;
+    }
+    virtual bool HasSideEffects() const { return false; }
     
     
 private:
     
     bool bestTop_;
     bool debug_;
+    bool validateBatchAngles_;
+    int nBatchAngleMismatch_;
+    NeutrinoSolver * mpNuSolver;  // the selector's, shared by the calculators
     
     int FillLjetsBranches( std::vector<edm::Ptr<pat::Muon> > const & vTightMuons,
                           std::vector<edm::Ptr<pat::Electron> > const & vTightElectrons,
@@ -58,7 +71,10 @@ private:
 
 
 
-LjetsTopoCalcNew::LjetsTopoCalcNew(){
+LjetsTopoCalcNew::LjetsTopoCalcNew():
+validateBatchAngles_(false),
+nBatchAngleMismatch_(0),
+mpNuSolver(0){
     mLegend = "[LjetsTopoCalcNew]: ";
 }
 
@@ -69,6 +85,8 @@ int LjetsTopoCalcNew::AnalyzeEvent(edm::EventBase const & event,
     // compute event variables here
     //
     
+    mpNuSolver = &selector->GetNeutrinoSolver();
+    
     //
     // _____ Get objects from the selector _____________________
     //
@@ -140,27 +158,27 @@ int LjetsTopoCalcNew::FillLjetsBranches( std::vector<edm::Ptr<pat::Muon> > const
     
     while(1){
         
-        TLorentzVector tlv_lepton;
+        FourVector lv_lepton;
         
         if ( vSelMuons.size() == 0 && vSelElectrons.size() == 0) break;
         if ( vSelMuons.size() > 0 && vSelElectrons.size() > 0) {
             std::cout<<mLegend<<"Two Leptons, using the Muon...."<<std::endl;
-            tlv_lepton.SetPxPyPzE( vSelMuons[0]->px(),
-                                  vSelMuons[0]->py(),
-                                  vSelMuons[0]->pz(),
-                                  vSelMuons[0]->energy() );
+            lv_lepton.SetPxPyPzE( vSelMuons[0]->px(),
+                                 vSelMuons[0]->py(),
+                                 vSelMuons[0]->pz(),
+                                 vSelMuons[0]->energy() );
         }
         if ( vSelMuons.size() > 0 ) {
-            tlv_lepton.SetPxPyPzE( vSelMuons[0]->px(),
-                                  vSelMuons[0]->py(),
-                                  vSelMuons[0]->pz(),
-                                  vSelMuons[0]->energy() );
+            lv_lepton.SetPxPyPzE( vSelMuons[0]->px(),
+                                 vSelMuons[0]->py(),
+                                 vSelMuons[0]->pz(),
+                                 vSelMuons[0]->energy() );
         }
         if ( vSelElectrons.size() > 0 ) {
-            tlv_lepton.SetPxPyPzE( vSelElectrons[0]->px(),
-                                  vSelElectrons[0]->py(),
-                                  vSelElectrons[0]->pz(),
-                                  vSelElectrons[0]->energy() );
+            lv_lepton.SetPxPyPzE( vSelElectrons[0]->px(),
+                                 vSelElectrons[0]->py(),
+                                 vSelElectrons[0]->pz(),
+                                 vSelElectrons[0]->energy() );
         }
         
         // make a vector of jets
@@ -189,14 +207,11 @@ int LjetsTopoCalcNew::FillLjetsBranches( std::vector<edm::Ptr<pat::Muon> > const
         if ( corrMET.Pt() > 0 ){ }
         else break;
         
-        TLorentzVector tlv_met( corrMET.Px(),
-                               corrMET.Py(),
-                               corrMET.Pz(),
-                               corrMET.Energy() );
+        FourVector lv_met = FourVector::FromLorentz(corrMET);
         
         // topovars calculator
         //LJetsTopoVarsNew topovars(tlv_jets, tlv_muon, tlv_met, isMuon, bestTop);
-        LJetsTopoVarsNew topovars(vCorrBtagJets, tlv_lepton, tlv_met, isMuon,  bestTop);
+        LJetsTopoVarsNew topovars(vCorrBtagJets, lv_lepton, lv_met, isMuon,  bestTop, 80.398, mpNuSolver);
         
         // compute branches
         SetValue("aplanarity", topovars.aplanarity());
@@ -284,9 +299,20 @@ int LjetsTopoCalcNew::FillLjetsBranches( std::vector<edm::Ptr<pat::Muon> > const
         SetValue("SecBTagTop_Pt", topovars.SecBTagTop_Pt());
         SetValue("BestJetJet2W_M", topovars.BestJetJet2W_M());
         SetValue("Jet1TagJet2TagW_M", topovars.Jet1TagJet2TagW_M());
-        SetValue("Cos_BestJetLepton_BestTop", topovars.Cos_BestJetLepton_BestTop());
-        SetValue("Cos_LightjetJetLepton_BestTop", topovars.Cos_LightjetJetLepton_BestTop());
-        SetValue("Cos_LightjetJetLepton_BTagTop", topovars.Cos_LightjetJetLepton_BTagTop());
+        double cosTops[3];
+        topovars.Cos_JetLepton_Tops(cosTops);
+        if (validateBatchAngles_) {
+            double const scalar[3] = { topovars.Cos_BestJetLepton_BestTop(),
+                                       topovars.Cos_LightjetJetLepton_BestTop(),
+                                       topovars.Cos_LightjetJetLepton_BTagTop() };
+            for (unsigned int i = 0; i != 3; ++i) {
+                if (cosTops[i] != scalar[i] && nBatchAngleMismatch_++ < 10)
+                    std::cout << mLegend << "batched angle " << i << " mismatch: " << cosTops[i] << " instead of " << scalar[i] << std::endl;
+            }
+        }
+        SetValue("Cos_BestJetLepton_BestTop", cosTops[0]);
+        SetValue("Cos_LightjetJetLepton_BestTop", cosTops[1]);
+        SetValue("Cos_LightjetJetLepton_BTagTop", cosTops[2]);
         SetValue("HT_AllJets_MinusBestJet", topovars.HT_AllJets_MinusBestJet());
         SetValue("H_AllJets_MinusBestJet", topovars.H_AllJets_MinusBestJet());
         SetValue("J1_NotBestJet_Eta", topovars.J1_NotBestJet_Eta());
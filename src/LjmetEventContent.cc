@@ -6,8 +6,159 @@
 
 
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fnmatch.h>
+
 #include "LJMet/Com/interface/LjmetEventContent.h"
 #include "TH1.h"
+#include "TH2.h"
+#include "TROOT.h"
+
+
+
+namespace {
+    
+    template <class T>
+    void tableOf(std::map<std::string,T> & values, std::vector<T *> & table){
+        table.clear();
+        table.reserve(values.size());
+        for (typename std::map<std::string,T>::iterator iValue = values.begin(); iValue != values.end(); ++iValue){
+            table.push_back(&(iValue->second));
+        }
+    }
+    
+    template <class T, class S>
+    void gather(std::vector<T *> const & table, std::vector<S> & to){
+        to.resize(table.size());
+        for (size_t i = 0; i != table.size(); ++i) to[i] = *table[i];
+    }
+    
+    template <class T, class S>
+    void scatter(std::vector<S> const & from, std::vector<T *> const & table){
+        for (size_t i = 0; i != table.size(); ++i) *table[i] = from[i];
+    }
+}
+
+
+
+void LjmetEventContent::SlotTable::Build(BranchBuffer & buffer){
+    tableOf(buffer.mBoolBranch, mvBool);
+    tableOf(buffer.mIntBranch, mvInt);
+    tableOf(buffer.mDoubleBranch, mvDouble);
+    tableOf(buffer.mVectorBoolBranch, mvVectorBool);
+    tableOf(buffer.mVectorIntBranch, mvVectorInt);
+    tableOf(buffer.mVectorShortBranch, mvVectorShort);
+    tableOf(buffer.mVectorDoubleBranch, mvVectorDouble);
+}
+
+
+
+void LjmetEventContent::EventSlots::Gather(SlotTable const & table){
+    gather(table.mvBool, mvBool);
+    gather(table.mvInt, mvInt);
+    gather(table.mvDouble, mvDouble);
+    gather(table.mvVectorBool, mvVectorBool);
+    gather(table.mvVectorInt, mvVectorInt);
+    gather(table.mvVectorShort, mvVectorShort);
+    gather(table.mvVectorDouble, mvVectorDouble);
+}
+
+
+
+void LjmetEventContent::EventSlots::Scatter(SlotTable const & table) const{
+    scatter(mvBool, table.mvBool);
+    scatter(mvInt, table.mvInt);
+    scatter(mvDouble, table.mvDouble);
+    scatter(mvVectorBool, table.mvVectorBool);
+    scatter(mvVectorInt, table.mvVectorInt);
+    scatter(mvVectorShort, table.mvVectorShort);
+    scatter(mvVectorDouble, table.mvVectorDouble);
+}
+
+
+
+LjmetEventContent::StoragePolicy::StoragePolicy(edm::ParameterSet const & pset):
+mPattern(pset.getParameter<std::string>("pattern")),
+mType(kDouble),
+mMin(0.0),
+mMax(0.0),
+mNBits(0){
+    
+    std::string _storage = pset.getParameter<std::string>("storage");
+    if (_storage == "float") mType = kFloat;
+    else if (_storage == "truncated") mType = kTruncated;
+    else if (_storage == "quantized") mType = kQuantized;
+    else if (_storage != "double"){
+        std::cout << "[LjmetEventContent]: unknown storage " << _storage
+        << " for " << mPattern << ", keeping double" << std::endl;
+    }
+    
+    if (pset.exists("nbits")) mNBits = pset.getParameter<int>("nbits");
+    if (pset.exists("min")) mMin = pset.getParameter<double>("min");
+    if (pset.exists("max")) mMax = pset.getParameter<double>("max");
+    
+    if (mType == kTruncated) mNBits = std::max(1, std::min(mNBits, 23));
+    if (mType == kQuantized){
+        mNBits = std::max(2, std::min(mNBits, 24));
+        if (mMax <= mMin){
+            std::cout << "[LjmetEventContent]: empty range for " << mPattern
+            << ", storing as float" << std::endl;
+            mType = kFloat;
+        }
+    }
+}
+
+
+
+float LjmetEventContent::StoragePolicy::Round(double value) const{
+    
+    float _value = static_cast<float>(value);
+    
+    if (mType == kTruncated){
+        // round to nearest, keeping mNBits mantissa bits
+        if (!std::isfinite(_value)) return _value;
+        unsigned int _bits;
+        std::memcpy(&_bits, &_value, sizeof(_bits));
+        unsigned int const _drop = 23 - mNBits;
+        if (_drop > 0){
+            _bits += 1u << (_drop-1);
+            _bits &= ~((1u << _drop) - 1u);
+        }
+        std::memcpy(&_value, &_bits, sizeof(_value));
+    }
+    else if (mType == kQuantized){
+        double const _steps = static_cast<double>((1u << mNBits) - 1u);
+        double const _x = std::max(mMin, std::min(value, mMax));
+        double const _q = std::floor((_x - mMin)/(mMax - mMin)*_steps + 0.5);
+        _value = static_cast<float>(mMin + _q*(mMax - mMin)/_steps);
+    }
+    
+    return _value;
+}
+
+
+
+std::string LjmetEventContent::StoragePolicy::Float16Range() const{
+    //
+    // [0,0,nbits] keeps nbits mantissa bits, at most 14 in a
+    // Float16_t; [min,max,nbits] stores an nbits integer in the range
+    //
+    
+    char _range[128];
+    if (mType == kTruncated && mNBits >= 2 && mNBits <= 14){
+        snprintf(_range, sizeof(_range), "[0,0,%d]", mNBits);
+        return _range;
+    }
+    if (mType == kQuantized){
+        snprintf(_range, sizeof(_range), "[%.17g,%.17g,%d]", mMin, mMax, mNBits);
+        return _range;
+    }
+    return "";
+}
+
 
 
 LjmetEventContent::LjmetEventContent():
@@ -15,7 +166,15 @@ mName("LjmetEventContent"),
 mLegend("[LjmetEventContent]: "),
 mpTree(0),
 mFirstEntry(true),
-mVerbosity(0){
+mVerbosity(0),
+mScalarBasketSize(32000),
+mVectorBasketSize(32000),
+mOptimizeAfter(0),
+mOptimizeMemory(0),
+mAsyncWrite(false),
+mMaxWriteLag(16),
+mStopWriter(false),
+mWriteErrors(0){
 }
 
 
@@ -25,18 +184,69 @@ mName("LjmetEventContent"),
 mLegend("[LjmetEventContent]: "),
 mpTree(0),
 mFirstEntry(true),
-mVerbosity(0){
+mVerbosity(0),
+mScalarBasketSize(32000),
+mVectorBasketSize(32000),
+mOptimizeAfter(0),
+mOptimizeMemory(0),
+mAsyncWrite(false),
+mMaxWriteLag(16),
+mStopWriter(false),
+mWriteErrors(0){
     
     if (mPar.find("ljmet")!=mPar.end()){
         if (mPar["ljmet"].exists("verbosity")){
             mVerbosity = mPar["ljmet"].getParameter<int>("verbosity");
         }
+        if (mPar["ljmet"].exists("included_branches")){
+            mvIncludedBranches = mPar["ljmet"].getParameter<std::vector<std::string> >("included_branches");
+        }
+        if (mPar["ljmet"].exists("excluded_branches")){
+            mvExcludedBranches = mPar["ljmet"].getParameter<std::vector<std::string> >("excluded_branches");
+        }
+    }
+    
+    if (mPar.find("outputs")!=mPar.end()){
+        if (mPar["outputs"].exists("asyncWrite")){
+            mAsyncWrite = mPar["outputs"].getParameter<bool>("asyncWrite");
+        }
+        // ROOT's global locks must be in place before any input or output
+        // file is opened, not only when the writer thread starts
+        if (mAsyncWrite) ROOT::EnableThreadSafety();
+        if (mPar["outputs"].exists("asyncMaxLag")){
+            mMaxWriteLag = std::max(1, mPar["outputs"].getParameter<int>("asyncMaxLag"));
+        }
+        if (mPar["outputs"].exists("scalarBasketSize")){
+            mScalarBasketSize = mPar["outputs"].getParameter<int>("scalarBasketSize");
+        }
+        if (mPar["outputs"].exists("vectorBasketSize")){
+            mVectorBasketSize = mPar["outputs"].getParameter<int>("vectorBasketSize");
+        }
+        if (mPar["outputs"].exists("optimizeBasketsAfter")){
+            mOptimizeAfter = mPar["outputs"].getParameter<int>("optimizeBasketsAfter");
+        }
+        if (mPar["outputs"].exists("optimizeBasketsMemory")){
+            mOptimizeMemory = mPar["outputs"].getParameter<int>("optimizeBasketsMemory");
+        }
+        if (mPar["outputs"].exists("branchPrecision")){
+            std::vector<edm::ParameterSet> const _vPolicy =
+            mPar["outputs"].getParameter<std::vector<edm::ParameterSet> >("branchPrecision");
+            for (std::vector<edm::ParameterSet>::const_iterator iPolicy = _vPolicy.begin();
+                 iPolicy != _vPolicy.end(); ++iPolicy){
+                mvStoragePolicy.push_back(StoragePolicy(*iPolicy));
+            }
+        }
     }
 }
 
 
 
 LjmetEventContent::~LjmetEventContent(){
+    Finish();
+    
+    for (std::vector<EventSlots *>::iterator iBuf = mvFree.begin(); iBuf != mvFree.end(); ++iBuf){
+        delete *iBuf;
+    }
 }
 
 
@@ -47,60 +257,316 @@ void LjmetEventContent::SetTree(TTree * tree){
 
 
 
-void LjmetEventContent::SetValue(std::string key, bool value){
-    mBoolBranch[key] = value;
+bool LjmetEventContent::IsBranchRequested(std::string const & key){
+    //
+    // a branch is requested if it matches one of the included
+    // patterns (or none are given) and none of the excluded ones
+    //
+    
+    if (mvIncludedBranches.empty() && mvExcludedBranches.empty()) return true;
+    
+    std::map<std::string,bool>::const_iterator iReq = mRequested.find(key);
+    if (iReq != mRequested.end()) return iReq->second;
+    
+    bool _requested = mvIncludedBranches.empty();
+    std::vector<std::string>::const_iterator iPat;
+    for (iPat = mvIncludedBranches.begin(); iPat != mvIncludedBranches.end() && !_requested; ++iPat){
+        if (fnmatch(iPat->c_str(), key.c_str(), 0) == 0) _requested = true;
+    }
+    for (iPat = mvExcludedBranches.begin(); iPat != mvExcludedBranches.end() && _requested; ++iPat){
+        if (fnmatch(iPat->c_str(), key.c_str(), 0) == 0) _requested = false;
+    }
+    
+    if (mVerbosity>0 && !_requested){
+        std::cout << mLegend << "Branch " << key << " not requested, dropped" << std::endl;
+    }
+    
+    mRequested[key] = _requested;
+    return _requested;
+}
+
+
+
+bool LjmetEventContent::SetValue(std::string key, bool value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mBoolBranch[key] = value;
+    return true;
+}
+
+bool LjmetEventContent::SetValue(std::string key, int value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mIntBranch[key] = value;
+    return true;
+}
+
+
+
+bool LjmetEventContent::SetValue(std::string key, double value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mDoubleBranch[key] = value;
+    return true;
 }
 
-void LjmetEventContent::SetValue(std::string key, int value){
-    mIntBranch[key] = value;
+bool LjmetEventContent::SetValue(std::string key, std::vector<bool> const & value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mVectorBoolBranch[key] = value;
+    return true;
 }
 
+bool LjmetEventContent::SetValue(std::string key, ArenaVector<bool> const & value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mVectorBoolBranch[key].assign(value.begin(), value.end());
+    return true;
+}
 
+bool LjmetEventContent::SetValue(std::string key, std::vector<int> const & value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mVectorIntBranch[key] = value;
+    return true;
+}
+
+bool LjmetEventContent::SetValue(std::string key, ArenaVector<int> const & value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mVectorIntBranch[key].assign(value.begin(), value.end());
+    return true;
+}
 
-void LjmetEventContent::SetValue(std::string key, double value){
-    mDoubleBranch[key] = value;
+bool LjmetEventContent::SetValue(std::string key, std::vector<short> const & value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mVectorShortBranch[key] = value;
+    return true;
 }
 
-void LjmetEventContent::SetValue(std::string key, std::vector<bool> value){
-    mVectorBoolBranch[key] = value;
+bool LjmetEventContent::SetValue(std::string key, ArenaVector<short> const & value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mVectorShortBranch[key].assign(value.begin(), value.end());
+    return true;
 }
 
-void LjmetEventContent::SetValue(std::string key, std::vector<int> value){
-    mVectorIntBranch[key] = value;
+bool LjmetEventContent::SetValue(std::string key, std::vector<double> const & value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mVectorDoubleBranch[key] = value;
+    return true;
 }
 
-void LjmetEventContent::SetValue(std::string key, std::vector<double> value){
-    mVectorDoubleBranch[key] = value;
+bool LjmetEventContent::SetValue(std::string key, ArenaVector<double> const & value){
+    if (!IsBranchRequested(key)) return false;
+    mBuffer.mVectorDoubleBranch[key].assign(value.begin(), value.end());
+    return true;
 }
 
 
 
 void LjmetEventContent::Fill(){
     if (mFirstEntry){
-        createBranches();
+        if (mAsyncWrite){
+            // branches set later are not in the tree, the slots cover the rest
+            mWriteBuffer = mBuffer;
+            createBranches(mWriteBuffer);
+            mFrontSlots.Build(mBuffer);
+            mWriteSlots.Build(mWriteBuffer);
+            startWriter();
+        }
+        else createBranches(mBuffer);
         mFirstEntry = false;
     }
-    mpTree->Fill();
+    if (mAsyncWrite) pushEvent();
+    else{
+        roundReducedPrecision();
+        mpTree->Fill();
+        afterTreeFill();
+    }
     
     
     // fill histograms
-    // create histograms
-    std::map<std::string,std::map<std::string,LjmetEventContent::HistMetadata> >::iterator iMod;
-    std::map<std::string,LjmetEventContent::HistMetadata>::iterator iHist;
-    for (iMod=mDoubleHist.begin();iMod!=mDoubleHist.end();++iMod){
-        for (iHist=iMod->second.begin();iHist!=iMod->second.end();++iHist){
-            TH1 * _hist = iHist->second.GetHist();
-            if (_hist) _hist->Fill(iHist->second.GetValue());
+    fillHistograms();
+    
+    // the values are copied, event scratch memory can go
+    mArena.Reset();
+    
+    return;
+}
+
+
+
+void LjmetEventContent::Finish(){
+    //
+    // drain the queue of pending events and stop the writer thread
+    //
+    
+    if (!mWriter.joinable()) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        mStopWriter = true;
+    }
+    mPendingCond.notify_one();
+    mWriter.join();
+    
+    if (mWriteErrors > 0){
+        std::cout << mLegend << "WARNING! " << mWriteErrors
+        << " events could not be written to the output tree" << std::endl;
+    }
+    
+    return;
+}
+
+
+
+LjmetEventContent::StoragePolicy const &
+LjmetEventContent::getStoragePolicy(std::string const & name) const{
+    for (std::vector<StoragePolicy>::const_iterator iPolicy = mvStoragePolicy.begin();
+         iPolicy != mvStoragePolicy.end(); ++iPolicy){
+        if (fnmatch(iPolicy->mPattern.c_str(), name.c_str(), 0) == 0) return *iPolicy;
+    }
+    return mDefaultPolicy;
+}
+
+
+
+void LjmetEventContent::roundReducedPrecision(){
+    //
+    // copy double values into the float buffers the tree points to
+    //
+    
+    for (size_t i = 0; i != mvReducedBranch.size(); ++i){
+        *(mvReducedBranch[i].second) = mvReducedPolicy[i]->Round(*(mvReducedBranch[i].first));
+    }
+    
+    // ROOT truncates or quantises these when writing
+    for (size_t i = 0; i != mvFloat16Branch.size(); ++i){
+        *(mvFloat16Branch[i].second) = static_cast<Float16_t>(*(mvFloat16Branch[i].first));
+    }
+    
+    for (size_t i = 0; i != mvReducedVectorBranch.size(); ++i){
+        std::vector<double> const & _from = *(mvReducedVectorBranch[i].first);
+        std::vector<float> & _to = *(mvReducedVectorBranch[i].second);
+        StoragePolicy const & _policy = *(mvReducedVectorPolicy[i]);
+        _to.resize(_from.size());
+        for (size_t j = 0; j != _from.size(); ++j) _to[j] = _policy.Round(_from[j]);
+    }
+    
+    for (size_t i = 0; i != mvDouble32VectorBranch.size(); ++i){
+        std::vector<double> const & _from = *(mvDouble32VectorBranch[i].first);
+        std::vector<Double32_t> & _to = *(mvDouble32VectorBranch[i].second);
+        StoragePolicy const & _policy = *(mvDouble32VectorPolicy[i]);
+        _to.resize(_from.size());
+        for (size_t j = 0; j != _from.size(); ++j) _to[j] = _policy.Round(_from[j]);
+    }
+    
+    return;
+}
+
+
+
+void LjmetEventContent::afterTreeFill(){
+    //
+    // once the first entries show the actual branch sizes,
+    // redistribute the basket memory among the branches
+    //
+    
+    if (mOptimizeAfter <= 0 || mpTree->GetEntries() != mOptimizeAfter) return;
+    
+    // default: 30 MB, the TTree auto-flush default
+    Long64_t _memory = mOptimizeMemory;
+    if (_memory <= 0) _memory = 30000000;
+    
+    std::cout << mLegend << "Optimizing basket sizes after "
+    << mOptimizeAfter << " entries" << std::endl;
+    mpTree->OptimizeBaskets(_memory, 1.1, "");
+    
+    return;
+}
+
+
+
+void LjmetEventContent::startWriter(){
+    //
+    // the event loop keeps reading input while the writer
+    // compresses and writes the output tree; ROOT thread
+    // safety was enabled when the configuration was read
+    //
+    
+    mStopWriter = false;
+    mWriter = std::thread(&LjmetEventContent::writerLoop, this);
+    
+    std::cout << mLegend << "Asynchronous output writer started, maximum lag "
+    << mMaxWriteLag << " events" << std::endl;
+    
+    return;
+}
+
+
+
+void LjmetEventContent::pushEvent(){
+    //
+    // hand a snapshot of the current event over to the writer thread,
+    // block only if the writer is too far behind
+    //
+    
+    EventSlots * _event = 0;
+    {
+        std::unique_lock<std::mutex> lock(mWriteMutex);
+        while (mvPending.size() >= static_cast<size_t>(mMaxWriteLag)){
+            mSpaceCond.wait(lock);
+        }
+        if (!mvFree.empty()){
+            _event = mvFree.back();
+            mvFree.pop_back();
         }
     }
     
+    // snapshot outside the lock, the writer only touches queued buffers
+    if (!_event) _event = new EventSlots;
+    _event->Gather(mFrontSlots);
+    
+    {
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        mvPending.push_back(_event);
+    }
+    mPendingCond.notify_one();
+    
+    return;
+}
+
+
+
+void LjmetEventContent::writerLoop(){
+    //
+    // writer thread: copy queued events into the branch buffers
+    // and fill the tree, in the order the events were pushed
+    //
+    
+    while (true){
+        EventSlots * _event = 0;
+        {
+            std::unique_lock<std::mutex> lock(mWriteMutex);
+            while (mvPending.empty() && !mStopWriter){
+                mPendingCond.wait(lock);
+            }
+            if (mvPending.empty()) break;
+            _event = mvPending.front();
+            mvPending.pop_front();
+        }
+        mSpaceCond.notify_one();
+        
+        _event->Scatter(mWriteSlots);
+        roundReducedPrecision();
+        if (mpTree->Fill() < 0) ++mWriteErrors;
+        afterTreeFill();
+        
+        {
+            std::lock_guard<std::mutex> lock(mWriteMutex);
+            mvFree.push_back(_event);
+        }
+    }
     
     return;
 }
 
 
 
-int LjmetEventContent::createBranches(){
+int LjmetEventContent::createBranches(BranchBuffer & buffer){
     //
     // create branches in the tree according to maps
     //
@@ -109,20 +575,15 @@ int LjmetEventContent::createBranches(){
     std::cout << mLegend << "Creating branches in output tree" << std::endl;
     
     
-    //std::cout << mLegend << "Creating histograms: "
-    //	    << mDoubleHist.size() << std::endl;
-    //std::cout << mLegend << "Creating histograms: "
-    //	    << mDoubleHist["StopEventSelector"].size() << std::endl;
-    
-    
     // boolean branches
-    for(std::map<std::string,bool>::iterator br = mBoolBranch.begin();
-        br != mBoolBranch.end();
+    for(std::map<std::string,bool>::iterator br = buffer.mBoolBranch.begin();
+        br != buffer.mBoolBranch.end();
         ++br){
         std::string name_type = br->first+"/O";
         mpTree -> Branch(br->first.c_str(),
                          &(br->second),
-                         name_type.c_str());
+                         name_type.c_str(),
+                         mScalarBasketSize);
         
         if (mVerbosity>0){
             std::cout << mLegend << "Branch " << name_type
@@ -130,17 +591,18 @@ int LjmetEventContent::createBranches(){
         }
     }
     std::cout << mLegend << "boolean branches created: "
-    << mBoolBranch.size() << std::endl;
+    << buffer.mBoolBranch.size() << std::endl;
     
     
     // integer branches
-    for(std::map<std::string,int>::iterator br = mIntBranch.begin();
-        br != mIntBranch.end();
+    for(std::map<std::string,int>::iterator br = buffer.mIntBranch.begin();
+        br != buffer.mIntBranch.end();
         ++br){
         std::string name_type = br->first+"/I";
         mpTree -> Branch(br->first.c_str(),
                          &(br->second),
-                         name_type.c_str());
+                         name_type.c_str(),
+                         mScalarBasketSize);
         
         if (mVerbosity>0){
             std::cout << mLegend << "Branch " << name_type
@@ -148,17 +610,44 @@ int LjmetEventContent::createBranches(){
         }
     }
     std::cout << mLegend << "integer branches created: "
-    << mIntBranch.size() << std::endl;
+    << buffer.mIntBranch.size() << std::endl;
     
     
-    // double branches
-    for(std::map<std::string,double>::iterator br = mDoubleBranch.begin();
-        br != mDoubleBranch.end();
+    // double branches, possibly stored with reduced precision
+    int _nReduced = 0;
+    for(std::map<std::string,double>::iterator br = buffer.mDoubleBranch.begin();
+        br != buffer.mDoubleBranch.end();
         ++br){
         std::string name_type = br->first+"/D";
-        mpTree -> Branch(br->first.c_str(),
-                         &(br->second),
-                         name_type.c_str());
+        StoragePolicy const & _policy = getStoragePolicy(br->first);
+        std::string const _range = _policy.Float16Range();
+        if (_policy.mType == StoragePolicy::kDouble){
+            mpTree -> Branch(br->first.c_str(),
+                             &(br->second),
+                             name_type.c_str(),
+                             mScalarBasketSize);
+        }
+        else if (!_range.empty()){
+            name_type = br->first+"/f"+_range;
+            Float16_t & _float16 = mFloat16Branch[br->first];
+            mvFloat16Branch.push_back(std::make_pair(&(br->second), &_float16));
+            mpTree -> Branch(br->first.c_str(),
+                             &_float16,
+                             name_type.c_str(),
+                             mScalarBasketSize);
+            ++_nReduced;
+        }
+        else{
+            name_type = br->first+"/F";
+            float & _float = mFloatBranch[br->first];
+            mvReducedBranch.push_back(std::make_pair(&(br->second), &_float));
+            mvReducedPolicy.push_back(&_policy);
+            mpTree -> Branch(br->first.c_str(),
+                             &_float,
+                             name_type.c_str(),
+                             mScalarBasketSize);
+            ++_nReduced;
+        }
         
         if (mVerbosity>0){
             std::cout << mLegend << "Branch " << name_type
@@ -166,30 +655,33 @@ int LjmetEventContent::createBranches(){
         }
     }
     std::cout << mLegend << "double precision branches created: "
-    << mDoubleBranch.size() << std::endl;
+    << buffer.mDoubleBranch.size() << ", stored with reduced precision: "
+    << _nReduced << std::endl;
     
     
     // vector bool branches
-    for(std::map<std::string, std::vector<bool> >::iterator br = mVectorBoolBranch.begin();
-        br != mVectorBoolBranch.end();
+    for(std::map<std::string, std::vector<bool> >::iterator br = buffer.mVectorBoolBranch.begin();
+        br != buffer.mVectorBoolBranch.end();
         ++br){
         std::string name_type = br->first+" std::vector<bool>";
         mpTree -> Branch(br->first.c_str(),
-                         &(br->second));
+                         &(br->second),
+                         mVectorBasketSize);
         
         if (mVerbosity>0){
             std::cout << mLegend << "Branch " << name_type << " created" << std::endl;
         }
     }
-    std::cout << mLegend << "vector<bool> branches created: " << mVectorBoolBranch.size() << std::endl;
+    std::cout << mLegend << "vector<bool> branches created: " << buffer.mVectorBoolBranch.size() << std::endl;
     
     // vector int branches
-    for(std::map<std::string, std::vector<int> >::iterator br = mVectorIntBranch.begin();
-        br != mVectorIntBranch.end();
+    for(std::map<std::string, std::vector<int> >::iterator br = buffer.mVectorIntBranch.begin();
+        br != buffer.mVectorIntBranch.end();
         ++br){
         std::string name_type = br->first+" std::vector<int>";
         mpTree -> Branch(br->first.c_str(),
-                         &(br->second));
+                         &(br->second),
+                         mVectorBasketSize);
         
         if (mVerbosity>0){
             std::cout << mLegend << "Branch " << name_type
@@ -197,16 +689,63 @@ int LjmetEventContent::createBranches(){
         }
     }
     std::cout << mLegend << "vector<int> branches created: "
-    << mVectorIntBranch.size() << std::endl;
+    << buffer.mVectorIntBranch.size() << std::endl;
+    
+    // vector short branches, for packed 16-bit columns
+    for(std::map<std::string, std::vector<short> >::iterator br = buffer.mVectorShortBranch.begin();
+        br != buffer.mVectorShortBranch.end();
+        ++br){
+        std::string name_type = br->first+" std::vector<short>";
+        mpTree -> Branch(br->first.c_str(),
+                         &(br->second),
+                         mVectorBasketSize);
+        
+        if (mVerbosity>0){
+            std::cout << mLegend << "Branch " << name_type
+            << " created" << std::endl;
+        }
+    }
+    std::cout << mLegend << "vector<short> branches created: "
+    << buffer.mVectorShortBranch.size() << std::endl;
     
     
-    // vector double branches
-    for(std::map<std::string, std::vector<double> >::iterator br = mVectorDoubleBranch.begin();
-        br != mVectorDoubleBranch.end();
+    // vector double branches, possibly stored with reduced precision
+    _nReduced = 0;
+    for(std::map<std::string, std::vector<double> >::iterator br = buffer.mVectorDoubleBranch.begin();
+        br != buffer.mVectorDoubleBranch.end();
         ++br){
         std::string name_type = br->first+" std::vector<double>";
-        mpTree -> Branch(br->first.c_str(),
-                         &(br->second));
+        StoragePolicy const & _policy = getStoragePolicy(br->first);
+        if (_policy.mType == StoragePolicy::kDouble){
+            mpTree -> Branch(br->first.c_str(),
+                             &(br->second),
+                             mVectorBasketSize);
+        }
+        else if (_policy.mType != StoragePolicy::kFloat){
+            // no room for a range in a collection branch: Double32_t
+            // is written as float, the rounded-off bits compress away
+            name_type = br->first+" std::vector<Double32_t>";
+            std::vector<Double32_t> * & _address = mVectorDouble32Address[br->first];
+            _address = &(mVectorDouble32Branch[br->first]);
+            mvDouble32VectorBranch.push_back(std::make_pair(&(br->second), _address));
+            mvDouble32VectorPolicy.push_back(&_policy);
+            // through void *, so the class name is not checked against vector<double>
+            mpTree -> Branch(br->first.c_str(),
+                             "vector<Double32_t>",
+                             static_cast<void *>(&_address),
+                             mVectorBasketSize);
+            ++_nReduced;
+        }
+        else{
+            name_type = br->first+" std::vector<float>";
+            std::vector<float> & _float = mVectorFloatBranch[br->first];
+            mvReducedVectorBranch.push_back(std::make_pair(&(br->second), &_float));
+            mvReducedVectorPolicy.push_back(&_policy);
+            mpTree -> Branch(br->first.c_str(),
+                             &_float,
+                             mVectorBasketSize);
+            ++_nReduced;
+        }
         
         if (mVerbosity>0){
             std::cout << mLegend << "Branch " << name_type
@@ -214,7 +753,8 @@ int LjmetEventContent::createBranches(){
         }
     }
     std::cout << mLegend << "vector<double> branches created: "
-    << mVectorDoubleBranch.size() << std::endl;
+    << buffer.mVectorDoubleBranch.size() << ", stored with reduced precision: "
+    << _nReduced << std::endl;
     
     
     return 0;
@@ -222,68 +762,101 @@ int LjmetEventContent::createBranches(){
 
 
 
-void
+int
 LjmetEventContent::SetHistogram(std::string modname, std::string histname,
                                 int nbins, double low, double high){
     //
     // create histogram entry in event content,
-    // so it is created by the LjmetFactory
+    // so it is created by the main application
     //
     
+    return addHistogram(HistMetadata(modname, histname, nbins, low, high));
+}
+
+
+
+int
+LjmetEventContent::SetHistogram(std::string modname, std::string histname,
+                                int nbinsx, double xlow, double xhigh,
+                                int nbinsy, double ylow, double yhigh){
+    return addHistogram(HistMetadata(modname, histname, nbinsx, xlow, xhigh, nbinsy, ylow, yhigh));
+}
+
+
+
+int LjmetEventContent::addHistogram(HistMetadata const & hist){
     mLegend = "["+mName+"]: ";
     
-    //mDoubleHist[modname][histname]
-    
-    std::map<std::string,std::map<std::string,HistMetadata> >::iterator iMod;
-    std::map<std::string,HistMetadata>::iterator iHist;
-    
-    
-    iMod = mDoubleHist.lower_bound(modname);
-    
-    if(iMod != mDoubleHist.end() && !(mDoubleHist.key_comp()(modname, iMod->first))){
-        // key already exists
-        // update iMod->second
-        
-        iHist = iMod->second.lower_bound(histname);
-        if(iHist != iMod->second.end() && !(iMod->second.key_comp()(histname, iHist->first))){
-            // key already exists
-            // update iHist->second - not needed
-            std::cout << mLegend
-            << "Histogram " << modname << "/" << histname
-            << " is already set" << std::endl;
-        }
-        else{
-            // the key does not exist in the map
-            // add it to the map
-            
-            iMod->second.insert(
-                                iHist,
-                                std::pair<std::string,HistMetadata>(histname,
-                                                                    HistMetadata(histname,
-                                                                                 nbins,
-                                                                                 low,
-                                                                                 high)));
-        }
+    std::string const _key = hist.mModule + "/" + hist.mName;
+    std::map<std::string,int>::const_iterator iHandle = mHistHandle.find(_key);
+    if (iHandle != mHistHandle.end()){
+        std::cout << mLegend
+        << "Histogram " << _key
+        << " is already set" << std::endl;
+        return iHandle->second;
     }
     
-    else{
-        // the key does not exist in the map
-        // add it to the map
-        std::map<std::string,HistMetadata> _map;
-        _map.insert(std::pair<std::string,HistMetadata>(histname,
-                                                        HistMetadata(histname,
-                                                                     nbins,
-                                                                     low,
-                                                                     high)));
-        mDoubleHist.insert(iMod,
-                           std::pair<std::string,std::map<std::string,HistMetadata> >(modname, _map));
-        // Use iMod as a hint to insert,
-        // so it can avoid another lookup
-        
-    }
+    mvHist.push_back(hist);
+    mHistHandle[_key] = mvHist.size()-1;
     
+    return mvHist.size()-1;
+}
+
+
+
+int LjmetEventContent::GetHistHandle(std::string const & modname, std::string const & histname) const{
+    std::map<std::string,int>::const_iterator iHandle = mHistHandle.find(modname + "/" + histname);
+    return iHandle == mHistHandle.end() ? -1 : iHandle->second;
+}
+
+
+
+bool LjmetEventContent::acceptHistFill(int handle, bool is2D){
+    if (handle < 0) return false;
+    HistMetadata & _hist = mvHist[handle];
+    if (_hist.Is2D() == is2D) return true;
     
-    return;
+    // x, y and weight buffers must stay aligned
+    if (!_hist.mbMismatchReported){
+        mLegend = "["+mName+"]: ";
+        std::cout << mLegend << "Histogram " << _hist.mModule << "/" << _hist.mName
+        << " is " << (_hist.Is2D() ? "2D" : "1D") << ", ignoring "
+        << (is2D ? "2D" : "1D") << " values" << std::endl;
+        _hist.mbMismatchReported = true;
+    }
+    return false;
+}
+
+
+
+void LjmetEventContent::FillHist(int handle, double value, double weight){
+    if (!acceptHistFill(handle, false)) return;
+    HistMetadata & _hist = mvHist[handle];
+    if (_hist.mvX.empty()) mvFilledHist.push_back(handle);
+    _hist.mvX.push_back(value);
+    _hist.mvW.push_back(weight);
+}
+
+
+
+void LjmetEventContent::FillHist2D(int handle, double x, double y, double weight){
+    if (!acceptHistFill(handle, true)) return;
+    HistMetadata & _hist = mvHist[handle];
+    if (_hist.mvX.empty()) mvFilledHist.push_back(handle);
+    _hist.mvX.push_back(x);
+    _hist.mvY.push_back(y);
+    _hist.mvW.push_back(weight);
+}
+
+
+
+void LjmetEventContent::FillHistN(int handle, size_t n, double const * values, double const * weights){
+    if (n == 0 || !acceptHistFill(handle, false)) return;
+    HistMetadata & _hist = mvHist[handle];
+    if (_hist.mvX.empty()) mvFilledHist.push_back(handle);
+    _hist.mvX.insert(_hist.mvX.end(), values, values + n);
+    if (weights) _hist.mvW.insert(_hist.mvW.end(), weights, weights + n);
+    else _hist.mvW.resize(_hist.mvX.size(), 1.0);
 }
 
 
@@ -293,44 +866,50 @@ LjmetEventContent::SetHistValue(std::string modname,
                                 std::string histname,
                                 double value){
     //
-    // assign current hist value to hist metadata collection
+    // add a value to the histogram, looked up by name
     //
     
-    mLegend = "["+mName+"]: ";
-    
-    std::map<std::string,std::map<std::string,HistMetadata> >::iterator iMod;
-    std::map<std::string,HistMetadata>::iterator iHist;
-    
-    
-    iMod = mDoubleHist.lower_bound(modname);
-    
-    if(iMod != mDoubleHist.end() && !(mDoubleHist.key_comp()(modname, iMod->first))){
-        // key already exists
-        // update iMod->second
-        
-        iHist = iMod->second.lower_bound(histname);
-        if(iHist != iMod->second.end() && !(iMod->second.key_comp()(histname, iHist->first))){
-            // key already exists
-            // update iHist->second - not needed
-            iHist->second.SetValue(value);
-        }
-        else{
-            // the key does not exist in the map
-            // add it to the map
-            std::cout << mLegend << "Cannot set value, histogram "
-            << histname << " in module " << modname
-            << " does not exist" << std::endl;
-        }
-    }
-    
-    else{
-        // the key does not exist in the map
-        // add it to the map
+    int const _handle = GetHistHandle(modname, histname);
+    if (_handle < 0){
+        mLegend = "["+mName+"]: ";
         std::cout << mLegend << "Cannot set value, histogram "
         << modname << "/" << histname
         << " does not exist" << std::endl;
+        return;
     }
     
+    FillHist(_handle, value);
     
     return;
 }
+
+
+
+void LjmetEventContent::fillHistograms(){
+    //
+    // one FillN() per histogram with values in the event
+    //
+    
+    for (std::vector<int>::const_iterator iHandle = mvFilledHist.begin(); iHandle != mvFilledHist.end(); ++iHandle){
+        HistMetadata & _hist = mvHist[*iHandle];
+        TH1 * _th1 = _hist.GetHist();
+        if (_th1){
+            if (!_hist.Is2D()) _th1->FillN(_hist.mvX.size(), &_hist.mvX[0], &_hist.mvW[0]);
+            else static_cast<TH2 *>(_th1)->FillN(_hist.mvX.size(), &_hist.mvX[0], &_hist.mvY[0], &_hist.mvW[0]);
+        }
+    }
+    
+    ClearHistValues();
+}
+
+
+
+void LjmetEventContent::ClearHistValues(){
+    for (std::vector<int>::const_iterator iHandle = mvFilledHist.begin(); iHandle != mvFilledHist.end(); ++iHandle){
+        HistMetadata & _hist = mvHist[*iHandle];
+        _hist.mvX.clear();
+        _hist.mvY.clear();
+        _hist.mvW.clear();
+    }
+    mvFilledHist.clear();
+}
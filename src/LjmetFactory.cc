@@ -16,7 +16,7 @@
 LjmetFactory * LjmetFactory::instance = 0;
 
 
-LjmetFactory::LjmetFactory():theSelector(0){
+LjmetFactory::LjmetFactory():theSelector(0),mFirstAnalyze(true){
   mLegend = "[LjmetFactory]: ";
 }
 
@@ -161,10 +161,41 @@ void LjmetFactory::RunAllCalculators(edm::EventBase const & event, BaseEventSele
 
   for (std::map<std::string, BaseCalc * >::const_iterator iCalc = mpCalculators.begin();
        iCalc != mpCalculators.end(); ++iCalc){
+    if (mIdleCalcs.find(iCalc->first)!=mIdleCalcs.end()) continue;
     iCalc->second->SetEventContent(&ec);
     iCalc->second->AnalyzeEvent(event, selector);
   }
 
+
+  // output branches are fixed by the first filled event:
+  // calculators that produced nothing requested need not run again,
+  // unless other code may depend on what they do besides their output
+  if (mFirstAnalyze){
+    mFirstAnalyze = false;
+    for (std::map<std::string, BaseCalc * >::const_iterator iCalc = mpCalculators.begin();
+	 iCalc != mpCalculators.end(); ++iCalc){
+      if (!iCalc->second->HasSideEffects() && iCalc->second->HasNoRequestedOutput()){
+	std::cout << mLegend << "no requested output from "
+		  << iCalc->first << ", not running it" << std::endl;
+	mIdleCalcs.insert(iCalc->first);
+      }
+    }
+  }
+
+  return;
+}
+
+
+
+void LjmetFactory::SetAllCalcEventContent( LjmetEventContent * pEc ){
+  //
+  // Set each calc's event content
+  //
+  for (std::map<std::string, BaseCalc * >::const_iterator iCalc = mpCalculators.begin();
+       iCalc != mpCalculators.end(); ++iCalc){
+    iCalc->second->SetEventContent(pEc);
+  }
+
   return;
 }
 
@@ -228,6 +259,10 @@ void LjmetFactory::RunEndEvent(edm::EventBase const & event,
 void LjmetFactory::RunBeginEvent(edm::EventBase const & event, 
 				 LjmetEventContent & ec){
   
+  // events failing the selection are not filled, release their scratch memory
+  // and drop their histogram values here
+  ec.GetArena().Reset();
+  ec.ClearHistValues();
   theSelector->BeginEvent(event, ec);
 
   return;
@@ -0,0 +1,175 @@
+/*
+ Neutrino pz from the W mass constraint, cached per event
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "LJMet/Com/interface/NeutrinoSolver.h"
+
+
+
+namespace {
+
+    // component of (x, y, z) transverse to (px, py, pz), as TVector3::Perp(p)
+    double perp(double x, double y, double z, double px, double py, double pz){
+        double const _tot = px*px + py*py + pz*pz;
+        double const _ss = x*px + y*py + z*pz;
+        double _per = x*x + y*y + z*z;
+        if (_tot > 0.0) _per -= _ss*_ss/_tot;
+        return _per > 0.0 ? std::sqrt(_per) : 0.0;
+    }
+}
+
+
+
+void NeutrinoSolver::Solution::Solve(FourVector const & lepton, FourVector const & met, double leptonMass, double wMass){
+    mLepton = lepton;
+    mMet = met;
+    mLeptonMass = leptonMass;
+    mWMass = wMass;
+
+    double const _el  = lepton.E();
+    double const _plx = lepton.Px();
+    double const _ply = lepton.Py();
+    double const _plz = lepton.Pz();
+    double const _pnx = met.Px();
+    double const _pny = met.Py();
+    double const _ptn2 = _pnx*_pnx + _pny*_pny;
+    double const _ptn = std::sqrt(_ptn2);
+
+    //
+    // quadratic A*pz^2 + B*pz + C = 0 from (lepton + neutrino)^2 = mW^2
+    //
+    double const _delta = wMass*wMass - leptonMass*leptonMass;
+    double const _a = _delta + 2.0*_plx*_pnx + 2.0*_ply*_pny;
+    double const _A = 4.0*(_el*_el - _plz*_plz);
+    double const _B = -4.0*_a*_plz;
+    double const _C = 4.0*_el*_el*_ptn2 - _a*_a;
+    double const _disc = _B*_B - 4.0*_A*_C;
+
+    if (_disc < 0){
+        // real part, and the neutrino pt for which the discriminant is zero
+        mIsComplex = true;
+        mPz[0] = mPz[1] = -_B/(2.0*_A);
+
+        double const _pn = met.E();
+        double const _alpha = _plx*_pnx/_pn + _ply*_pny/_pn;
+        double const _AA = 4.0*_plz*_plz - 4.0*_el*_el + 4.0*_alpha*_alpha;
+        double const _BB = 4.0*_alpha*_delta;
+        double const _CC = _delta*_delta;
+        double const _sqrtDisc = std::sqrt(_BB*_BB - 4.0*_AA*_CC);
+        double const _pt1 = (-_BB + _sqrtDisc)/(2.0*_AA);
+        double const _pt2 = (-_BB - _sqrtDisc)/(2.0*_AA);
+        if (std::fabs(_pt1 - _ptn) < std::fabs(_pt2 - _ptn)){ mPtRescaled[0] = _pt1; mPtRescaled[1] = _pt2; }
+        else { mPtRescaled[0] = _pt2; mPtRescaled[1] = _pt1; }
+    }
+    else{
+        mIsComplex = false;
+        double const _sqrtDisc = std::sqrt(_disc);
+        mPz[0] = (-_B + _sqrtDisc)/(2.0*_A);
+        mPz[1] = (-_B - _sqrtDisc)/(2.0*_A);
+        mPtRescaled[0] = mPtRescaled[1] = -1.0;
+    }
+
+    //
+    // massless lepton with mT <= mW, rescaling the MET if needed
+    //
+    double _nx = _pnx;
+    double _ny = _pny;
+    double _ne = _ptn;
+    double const _plt = lepton.Pt();
+    double const _mt = std::sqrt((_plt + _ne)*(_plt + _ne) - (_plx + _nx)*(_plx + _nx) - (_ply + _ny)*(_ply + _ny));
+    double _halfM2;
+    if (_mt < wMass) _halfM2 = wMass*wMass/2.0;
+    else{
+        _halfM2 = _mt*_mt/2.0;
+        double _k = _ne*_plt - _nx*_plx - _ny*_ply;
+        _k = (_k == 0.0 ? 0.00001 : _k);
+        double const _scale = 0.5*wMass*wMass/_k;
+        _nx *= _scale;
+        _ny *= _scale;
+        _ne = std::sqrt(_nx*_nx + _ny*_ny);
+    }
+    double const _ab = _halfM2 + _nx*_plx + _ny*_ply;
+    double const _denom = _plz*_plz - _el*_el;
+    double const _c = std::sqrt(std::max(1.0 + _ne*_ne*_denom/(_ab*_ab), 0.0));
+    double const _s1 = (-_ab*_plz + _ab*_el*_c)/_denom;
+    double const _s2 = (-_ab*_plz - _ab*_el*_c)/_denom;
+    bool const _firstCentral = std::fabs(_s1) < std::fabs(_s2);
+    mConstrainedPx = _nx;
+    mConstrainedPy = _ny;
+    mConstrainedE = _ne;
+    mConstrainedPz[0] = _firstCentral ? _s1 : _s2;
+    mConstrainedPz[1] = _firstCentral ? _s2 : _s1;
+}
+
+
+
+double NeutrinoSolver::Solution::Choose(int choice, double & other) const{
+    if (mIsComplex){
+        other = mPz[0];
+        return mPz[0];
+    }
+
+    double const _pz1 = mPz[0];
+    double const _pz2 = mPz[1];
+    double const _plz = mLepton.Pz();
+    bool _first = true;
+
+    switch (choice){
+    case kDefault:
+        _first = !(std::fabs(_pz2 - _plz) < std::fabs(_pz1 - _plz));
+        if ((_first ? _pz1 : _pz2) > 300.0) _first = std::fabs(_pz1) < std::fabs(_pz2);
+        break;
+    case kClosest:
+        _first = !(std::fabs(_pz2 - _plz) < std::fabs(_pz1 - _plz));
+        break;
+    case kCentral:
+        _first = std::fabs(_pz1) < std::fabs(_pz2);
+        break;
+    case kMaxCosine:{
+        double const _plx = mLepton.Px();
+        double const _ply = mLepton.Py();
+        double const _wx = _plx + mMet.Px();
+        double const _wy = _ply + mMet.Py();
+        double const _sin1 = 2.0*perp(_plx, _ply, _plz, _wx, _wy, _plz + _pz1)/mWMass;
+        double const _sin2 = 2.0*perp(_plx, _ply, _plz, _wx, _wy, _plz + _pz2)/mWMass;
+        _first = std::sqrt(1.0 - _sin1*_sin1) > std::sqrt(1.0 - _sin2*_sin2);
+        break;
+    }
+    default:
+        other = 0.0;
+        return 0.0;
+    }
+
+    other = _first ? _pz2 : _pz1;
+    return _first ? _pz1 : _pz2;
+}
+
+
+
+NeutrinoSolver::NeutrinoSolver(size_t cacheSize):
+mCacheSize(cacheSize > 0 ? cacheSize : 1),
+mNext(0){
+    mvSolution.reserve(mCacheSize);
+}
+
+
+
+NeutrinoSolver::Solution const & NeutrinoSolver::Solve(FourVector const & lepton, FourVector const & met, double leptonMass, double wMass){
+    for (size_t i = 0; i != mvSolution.size(); ++i){
+        if (mvSolution[i].Matches(lepton, met, leptonMass, wMass)) return mvSolution[i];
+    }
+
+    size_t _slot = mvSolution.size();
+    if (_slot < mCacheSize) mvSolution.push_back(Solution());
+    else{
+        _slot = mNext;
+        mNext = (mNext + 1) % mCacheSize;
+    }
+    mvSolution[_slot].Solve(lepton, met, leptonMass, wMass);
+    return mvSolution[_slot];
+}
@@ -0,0 +1,136 @@
+/*
+ Column storage of object variables and column-wise cut selections
+ */
+
+
+
+#include <sstream>
+
+#include "LJMet/Com/interface/ObjectColumns.h"
+
+
+
+namespace {
+
+    // the loops below are written without branches so they vectorize
+    template <class Compare>
+    void applyCut(std::vector<double> const & column, double value, std::vector<char> & mask, Compare pass){
+        size_t const _n = mask.size();
+        double const * _x = column.data();
+        char * _m = mask.data();
+        for (size_t i = 0; i != _n; ++i) _m[i] &= pass(_x[i], value);
+    }
+
+    struct Less         { char operator()(double x, double v) const { return x <  v; } };
+    struct LessEqual    { char operator()(double x, double v) const { return x <= v; } };
+    struct Greater      { char operator()(double x, double v) const { return x >  v; } };
+    struct GreaterEqual { char operator()(double x, double v) const { return x >= v; } };
+    struct Equal        { char operator()(double x, double v) const { return x == v; } };
+    struct NotEqual     { char operator()(double x, double v) const { return x != v; } };
+
+    std::string trim(std::string const & s){
+        size_t const _first = s.find_first_not_of(" \t");
+        if (_first == std::string::npos) return "";
+        size_t const _last = s.find_last_not_of(" \t");
+        return s.substr(_first, _last-_first+1);
+    }
+}
+
+
+
+int ObjectColumns::AddColumn(std::string const & name){
+    int _column = FindColumn(name);
+    if (_column >= 0) return _column;
+    mvName.push_back(name);
+    mvColumn.push_back(Column(mSize));
+    return mvName.size()-1;
+}
+
+
+
+int ObjectColumns::FindColumn(std::string const & name) const{
+    for (size_t i = 0; i != mvName.size(); ++i){
+        if (mvName[i] == name) return i;
+    }
+    return -1;
+}
+
+
+
+void ObjectColumns::Resize(size_t n){
+    mSize = n;
+    for (size_t i = 0; i != mvColumn.size(); ++i) mvColumn[i].resize(n);
+}
+
+
+
+bool ColumnCut::Parse(std::string const & expression, ObjectColumns & columns){
+    size_t const _pos = expression.find_first_of("<>=!");
+    if (_pos == std::string::npos || _pos == 0) return false;
+
+    size_t _opEnd = _pos+1;
+    if (_opEnd < expression.size() && expression[_opEnd] == '=') ++_opEnd;
+    std::string const _op = expression.substr(_pos, _opEnd-_pos);
+
+    if      (_op == "<" ) mOp = kLess;
+    else if (_op == "<=") mOp = kLessEqual;
+    else if (_op == ">" ) mOp = kGreater;
+    else if (_op == ">=") mOp = kGreaterEqual;
+    else if (_op == "==") mOp = kEqual;
+    else if (_op == "!=") mOp = kNotEqual;
+    else return false;
+
+    std::string const _variable = trim(expression.substr(0, _pos));
+    std::istringstream _value(trim(expression.substr(_opEnd)));
+    if (_variable.empty() || !(_value >> mValue) || !_value.eof()) return false;
+
+    mColumn = columns.AddColumn(_variable);
+
+    return true;
+}
+
+
+
+void ColumnCut::Apply(ObjectColumns const & columns, std::vector<char> & mask) const{
+    ObjectColumns::Column const & _column = columns.Get(mColumn);
+    switch (mOp){
+    case kLess:         applyCut(_column, mValue, mask, Less());         break;
+    case kLessEqual:    applyCut(_column, mValue, mask, LessEqual());    break;
+    case kGreater:      applyCut(_column, mValue, mask, Greater());      break;
+    case kGreaterEqual: applyCut(_column, mValue, mask, GreaterEqual()); break;
+    case kEqual:        applyCut(_column, mValue, mask, Equal());        break;
+    case kNotEqual:     applyCut(_column, mValue, mask, NotEqual());     break;
+    }
+}
+
+
+
+bool ColumnSelection::Configure(std::vector<std::string> const & expressions, ObjectColumns & columns, std::string & bad){
+    std::vector<ColumnCut> _cuts(expressions.size());
+    for (size_t i = 0; i != expressions.size(); ++i){
+        if (!_cuts[i].Parse(expressions[i], columns)){
+            bad = expressions[i];
+            return false;
+        }
+    }
+    mvCut.swap(_cuts);
+    return true;
+}
+
+
+
+void ColumnSelection::Evaluate(ObjectColumns const & columns, std::vector<char> & mask, std::vector<char> const * seed) const{
+    if (seed) mask = *seed;
+    else mask.assign(columns.Size(), 1);
+    for (size_t c = 0; c != mvCut.size(); ++c) mvCut[c].Apply(columns, mask);
+}
+
+
+
+void ColumnSelection::Select(ObjectColumns const & columns, std::vector<int> & indices, std::vector<char> const * seed) const{
+    Evaluate(columns, mvMask, seed);
+    indices.clear();
+    for (size_t i = 0; i != mvMask.size(); ++i){
+        if (mvMask[i]) indices.push_back(i);
+    }
+}
@@ -47,6 +47,18 @@ cout << filename<<endl;
 }
 
 
+void PUWeighting::setPUHisto(const string filename, ConditionsCache const & cache){
+  // same histogram, parsed once per node when the cache is enabled
+  puHisto_Data = cache.GetHistogram(filename, "pileup");
+  if (puHisto_Data == 0) {
+    cout << "PUWeighting::setPUHisto: no pileup histogram in "<< filename << "\n";
+    return;
+  }
+  puHisto_Data->Sumw2();
+  puHisto_Data->Scale(1.0/ puHisto_Data->Integral());
+}
+
+
 void PUWeighting::setPUHisto(const TH1D * thehistData, const TH1F * thehistMC){
   
   puHisto_MC   = (TH1F*) thehistMC->Clone();
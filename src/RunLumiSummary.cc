@@ -0,0 +1,280 @@
+/*
+ Event counts, weight sums and cut flow per run and luminosity section
+ */
+
+
+
+#include <iostream>
+
+#include "TDirectory.h"
+#include "TTree.h"
+
+#include "LJMet/Com/interface/RunLumiSummary.h"
+#include "LJMet/Com/interface/BaseEventSelector.h"
+
+
+
+namespace {
+
+    template <class T>
+    void addTo(std::vector<T> & sum, std::vector<T> const & values){
+        if (sum.size() < values.size()) sum.resize(values.size(), T());
+        for (size_t i = 0; i != values.size(); ++i) sum[i] += values[i];
+    }
+}
+
+
+
+RunLumiSummary::RunLumiSummary(edm::InputTag const & genInfoTag,
+                               edm::InputTag const & lheTag,
+                               edm::InputTag const & lheRunInfoTag):
+mGenInfoTag(genInfoTag),
+mLheTag(lheTag),
+mLheRunInfoTag(lheRunInfoTag),
+mpLastSums(0){
+    mLastKey.run = 0;
+    mLastKey.lumi = 0;
+    mLastKey.layout = 0;
+}
+
+
+
+void RunLumiSummary::AddEvent(edm::EventBase const & event, BaseEventSelector * selector){
+
+    // weights are read once per event and shared with the calculators
+    GenWeightReader const * weights = 0;
+    if (selector->IsMc()) weights = &selector->GetGenWeights(event, mGenInfoTag, mLheTag, mLheRunInfoTag);
+
+    Key _key;
+    _key.run = event.id().run();
+    _key.lumi = event.id().luminosityBlock();
+    _key.layout = weights ? weights->GetLayout().key : 0;
+
+    if (!mpLastSums || _key != mLastKey){
+        // counts so far belong to the previous entry, this event is not selected yet
+        flushCutFlow(selector);
+
+        if (weights && mLayouts.find(_key.layout) == mLayouts.end()) mLayouts[_key.layout] = weights->GetLayout();
+
+        std::map<Key, Sums>::iterator iSums = mSums.find(_key);
+        if (iSums == mSums.end()){
+            Sums _sums;
+            _sums.nEvents = 0;
+            _sums.sumGenWeight = 0.0;
+            _sums.sumGenWeight2 = 0.0;
+            if (weights) _sums.vSumWeights.assign(weights->GetRatios().size(), 0.0);
+            iSums = mSums.insert(std::make_pair(_key, _sums)).first;
+        }
+        mLastKey = _key;
+        mpLastSums = &iSums->second;
+    }
+
+    ++mpLastSums->nEvents;
+    if (weights){
+        double const _nominal = weights->GetNominal();
+        std::vector<double> const & vRatio = weights->GetRatios();
+        mpLastSums->sumGenWeight += _nominal;
+        mpLastSums->sumGenWeight2 += _nominal*_nominal;
+        for (size_t i = 0; i != vRatio.size(); ++i) mpLastSums->vSumWeights[i] += _nominal*vRatio[i];
+    }
+}
+
+
+
+void RunLumiSummary::flushCutFlow(BaseEventSelector * selector){
+    std::vector<int> const _counts = selector->GetCutFlowCounts();
+    if (mpLastSums){
+        mpLastSums->vCutFlow.resize(_counts.size(), 0);
+        for (size_t i = 0; i != _counts.size(); ++i){
+            mpLastSums->vCutFlow[i] += _counts[i] - (i < mvLastCounts.size() ? mvLastCounts[i] : 0);
+        }
+    }
+    mvLastCounts = _counts;
+}
+
+
+
+void RunLumiSummary::Write(BaseEventSelector * selector){
+    //
+    // one entry per run, lumi and weight layout, the cut names
+    // and the weight layouts once
+    //
+
+    flushCutFlow(selector);
+    if (mSums.empty()) return;
+
+    writeTrees(selector->GetCutFlowNames(), mSums, mLayouts);
+}
+
+
+
+void RunLumiSummary::Combine(TDirectory * dir){
+    //
+    // merged outputs: sum the entries with the same key, the
+    // cut names and layouts are the same in every worker
+    //
+
+    TTree * _summary = dynamic_cast<TTree *>(dir->Get("RunLumiSummary"));
+    if (!_summary) return;
+
+    int _run = 0;
+    int _lumi = 0;
+    int _layout = 0;
+    Long64_t _nEvents = 0;
+    double _sumGenWeight = 0.0;
+    double _sumGenWeight2 = 0.0;
+    // the vectors are owned here, ROOT fills them through the pointers
+    std::vector<double> _sumWeights;
+    std::vector<Long64_t> _cutFlow;
+    std::vector<double> * _pSumWeights = &_sumWeights;
+    std::vector<Long64_t> * _pCutFlow = &_cutFlow;
+    _summary->SetBranchAddress("run", &_run);
+    _summary->SetBranchAddress("lumi", &_lumi);
+    _summary->SetBranchAddress("layout", &_layout);
+    _summary->SetBranchAddress("nEvents", &_nEvents);
+    _summary->SetBranchAddress("sumGenWeight", &_sumGenWeight);
+    _summary->SetBranchAddress("sumGenWeight2", &_sumGenWeight2);
+    _summary->SetBranchAddress("sumWeights", &_pSumWeights);
+    _summary->SetBranchAddress("cutFlow", &_pCutFlow);
+
+    std::map<Key, Sums> _sums;
+    Long64_t const _nEntries = _summary->GetEntries();
+    for (Long64_t i = 0; i != _nEntries; ++i){
+        _summary->GetEntry(i);
+        Key _key;
+        _key.run = _run;
+        _key.lumi = _lumi;
+        _key.layout = static_cast<unsigned>(_layout);
+        std::map<Key, Sums>::iterator iSums = _sums.find(_key);
+        if (iSums == _sums.end()){
+            Sums _zero;
+            _zero.nEvents = 0;
+            _zero.sumGenWeight = 0.0;
+            _zero.sumGenWeight2 = 0.0;
+            iSums = _sums.insert(std::make_pair(_key, _zero)).first;
+        }
+        iSums->second.nEvents += _nEvents;
+        iSums->second.sumGenWeight += _sumGenWeight;
+        iSums->second.sumGenWeight2 += _sumGenWeight2;
+        addTo(iSums->second.vSumWeights, _sumWeights);
+        addTo(iSums->second.vCutFlow, _cutFlow);
+    }
+    _summary->ResetBranchAddresses();
+
+    std::vector<std::string> _cutNames;
+    TTree * _namesTree = dynamic_cast<TTree *>(dir->Get("RunLumiCutNames"));
+    if (_namesTree && _namesTree->GetEntries() > 0){
+        std::vector<std::string> * _pNames = &_cutNames;
+        _namesTree->SetBranchAddress("cutNames", &_pNames);
+        _namesTree->GetEntry(0);
+        _namesTree->ResetBranchAddresses();
+    }
+
+    std::map<unsigned, GenWeightReader::Layout> _layouts;
+    TTree * _layoutTree = dynamic_cast<TTree *>(dir->Get("GenWeightLayouts"));
+    if (_layoutTree){
+        std::vector<std::string> _ids;
+        std::vector<int> _groups;
+        std::vector<std::string> _groupNames;
+        std::vector<std::string> * _pIds = &_ids;
+        std::vector<int> * _pGroups = &_groups;
+        std::vector<std::string> * _pGroupNames = &_groupNames;
+        _layoutTree->SetBranchAddress("layout", &_layout);
+        _layoutTree->SetBranchAddress("ids", &_pIds);
+        _layoutTree->SetBranchAddress("groups", &_pGroups);
+        _layoutTree->SetBranchAddress("groupNames", &_pGroupNames);
+        for (Long64_t i = 0; i != _layoutTree->GetEntries(); ++i){
+            _layoutTree->GetEntry(i);
+            unsigned const _key = static_cast<unsigned>(_layout);
+            if (_layouts.find(_key) != _layouts.end()) continue;
+            GenWeightReader::Layout & _entry = _layouts[_key];
+            _entry.key = _key;
+            _entry.vId = _ids;
+            _entry.vGroup = _groups;
+            _entry.vGroupName = _groupNames;
+        }
+        _layoutTree->ResetBranchAddresses();
+    }
+
+    std::cout << "[RunLumiSummary]: " << _nEntries << " merged entries summed into " << _sums.size() << std::endl;
+
+    // the merged trees go, with all their cycles, before the sums are written
+    dir->Delete("RunLumiSummary;*");
+    dir->Delete("RunLumiCutNames;*");
+    dir->Delete("GenWeightLayouts;*");
+
+    TDirectory * _previous = gDirectory;
+    dir->cd();
+    writeTrees(_cutNames, _sums, _layouts);
+    dir->Write(0, TObject::kOverwrite);
+    if (_previous) _previous->cd();
+}
+
+
+
+void RunLumiSummary::writeTrees(std::vector<std::string> const & cutNames,
+                                std::map<Key, Sums> const & sums,
+                                std::map<unsigned, GenWeightReader::Layout> const & layouts){
+
+    std::vector<std::string> _cutNames = cutNames;
+    TTree * _namesTree = new TTree("RunLumiCutNames", "names of the RunLumiSummary cut flow counts");
+    _namesTree->Branch("cutNames", &_cutNames);
+    _namesTree->Fill();
+
+    int _run = 0;
+    int _lumi = 0;
+    int _layout = 0;
+    Long64_t _nEvents = 0;
+    double _sumGenWeight = 0.0;
+    double _sumGenWeight2 = 0.0;
+    std::vector<double> _sumWeights;
+    std::vector<Long64_t> _cutFlow;
+
+    TTree * _tree = new TTree("RunLumiSummary", "event counts, weight sums and cut flow per luminosity section");
+    _tree->Branch("run", &_run, "run/I");
+    _tree->Branch("lumi", &_lumi, "lumi/I");
+    _tree->Branch("layout", &_layout, "layout/I");
+    _tree->Branch("nEvents", &_nEvents, "nEvents/L");
+    _tree->Branch("sumGenWeight", &_sumGenWeight, "sumGenWeight/D");
+    _tree->Branch("sumGenWeight2", &_sumGenWeight2, "sumGenWeight2/D");
+    _tree->Branch("sumWeights", &_sumWeights);
+    _tree->Branch("cutFlow", &_cutFlow);
+
+    Long64_t _nTotal = 0;
+    for (std::map<Key, Sums>::const_iterator iSums = sums.begin(); iSums != sums.end(); ++iSums){
+        _run = iSums->first.run;
+        _lumi = iSums->first.lumi;
+        _layout = static_cast<int>(iSums->first.layout);
+        _nEvents = iSums->second.nEvents;
+        _sumGenWeight = iSums->second.sumGenWeight;
+        _sumGenWeight2 = iSums->second.sumGenWeight2;
+        _sumWeights = iSums->second.vSumWeights;
+        _cutFlow = iSums->second.vCutFlow;
+        // without names (e.g. no RunLumiCutNames tree to merge) the counts are kept as they are
+        if (!_cutNames.empty()) _cutFlow.resize(_cutNames.size(), 0);
+        _tree->Fill();
+        _nTotal += _nEvents;
+    }
+
+    std::cout << "[RunLumiSummary]: " << _nTotal << " events in " << sums.size() << " luminosity sections" << std::endl;
+
+    if (layouts.empty()) return;
+
+    std::vector<std::string> _ids;
+    std::vector<int> _groups;
+    std::vector<std::string> _groupNames;
+
+    TTree * _layoutTree = new TTree("GenWeightLayouts", "ids and groups of the generator weights per layout");
+    _layoutTree->Branch("layout", &_layout, "layout/I");
+    _layoutTree->Branch("ids", &_ids);
+    _layoutTree->Branch("groups", &_groups);
+    _layoutTree->Branch("groupNames", &_groupNames);
+
+    for (std::map<unsigned, GenWeightReader::Layout>::const_iterator iLayout = layouts.begin(); iLayout != layouts.end(); ++iLayout){
+        _layout = static_cast<int>(iLayout->first);
+        _ids = iLayout->second.vId;
+        _groups = iLayout->second.vGroup;
+        _groupNames = iLayout->second.vGroupName;
+        _layoutTree->Fill();
+    }
+}
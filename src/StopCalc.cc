@@ -6,14 +6,20 @@
 
 
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 #include <stdio.h>
 #include "TFile.h"
 #include "TMath.h"
 #include "LJMet/Com/interface/BaseCalc.h"
+#include "LJMet/Com/interface/FourVector.h"
 #include "LJMet/Com/interface/LjmetFactory.h"
 #include "LJMet/Com/interface/LjmetEventContent.h"
+#include "LJMet/Com/interface/NeutrinoSolver.h"
+#include "LJMet/Com/interface/TopAngleUtils.h"
+#include "LJMet/Com/interface/TopUtils.h"
+#include "LJMet/Com/interface/TtbarReconstructor.h"
 #include "DataFormats/FWLite/interface/Record.h"
 #include "DataFormats/FWLite/interface/EventSetup.h"
 #include "DataFormats/FWLite/interface/ESHandle.h"
@@ -34,21 +40,26 @@ public:
     virtual int BeginJob();
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
     virtual int EndJob();
+    virtual bool HasSideEffects() const { return false; }
     
     
 private:
     
-    void SetBestCandidateVars(math::XYZTLorentzVector vLep,
-                              math::XYZTLorentzVector vMet,
-                              std::vector<math::XYZTLorentzVector> vLJets,
-                              std::vector<math::XYZTLorentzVector> vBJets,
-                              std::string suffix = "");
-    math::XYZTLorentzVector TlvToXyzt(TLorentzVector tlv);
+    void SetBestCandidateVars(FourVector const & vLep,
+                              FourVector const & vMet,
+                              std::vector<FourVector> const & vLJets,
+                              std::vector<FourVector> const & vBJets,
+                              std::vector<std::string> const & suffixes);
+    
+    void SetHypothesisAngles(FourVector const & vLep,
+                             FourVector const * vNeutrinos,
+                             std::vector<FourVector> const & vJets,
+                             std::vector<std::string> const & suffixes);
     
     double GetLikelihood(double mWlep, double mWhad, double mTlep, double mThad);
     
-    std::vector<double> GetNeutrinoPz(math::XYZTLorentzVector lv_mu,
-                                      math::XYZTLorentzVector lv_met,
+    std::vector<double> GetNeutrinoPz(FourVector const & lv_mu,
+                                      FourVector const & lv_met,
                                       int & success);
     
     
@@ -62,6 +73,11 @@ private:
     double mSigTlep;
     double mMw, mMtop;
     
+    NeutrinoSolver * mpNuSolver;
+    TtbarReconstructor mReco;
+    top_cafe::TopAngleUtils mAngleUtils;
+    top_cafe::TopUtils mTopUtils;
+    
 };
 
 
@@ -70,7 +86,8 @@ private:
 
 
 
-StopCalc::StopCalc(){
+StopCalc::StopCalc():
+mpNuSolver(0){
 }
 
 
@@ -94,36 +111,25 @@ double StopCalc::GetLikelihood(double mWlep, double mWhad,
 
 
 
-std::vector<double> StopCalc::GetNeutrinoPz(math::XYZTLorentzVector lv_mu,
-                                            math::XYZTLorentzVector lv_met,
+std::vector<double> StopCalc::GetNeutrinoPz(FourVector const & lv_mu,
+                                            FourVector const & lv_met,
                                             int & success){
     //
     // reconstruct the neutrino from W
     // returns both solutions or pz=0 if fail
     // failure will set success=0
     //
+    // massless lepton, solved once per event by the shared solver
+    //
     
     
     std::vector<double> pz(2, 0.0);
     
-    // lepton
-    double plx = lv_mu.px();
-    double ply = lv_mu.py();
-    double plz = lv_mu.pz();
-    double el  = lv_mu.E();
-    
-    // neutrino
-    double pnx = lv_met.px();
-    double pny = lv_met.py();
-    
-    double a = mMw*mMw/2.0+plx*pnx+ply*pny;
-    double b = el*el*(pnx*pnx+pny*pny);
-    double c = el*el-plz*plz;
-    double d = 1.0+c*(a*a-b)/a/a/plz/plz;
+    NeutrinoSolver::Solution const & _solution = mpNuSolver->Solve(lv_mu, lv_met, 0.0, mMw);
     
-    if (d>=0){
-        pz[0]  = a*plz/c*(1+sqrt(d));
-        pz[1] = a*plz/c*(1-sqrt(d));
+    if (!_solution.IsComplex()){
+        pz[0] = _solution.GetPz(0);
+        pz[1] = _solution.GetPz(1);
         
         success = 1;
     }
@@ -158,6 +164,14 @@ int StopCalc::BeginJob(){
     mMw      =  80.4;
     mMtop    = 172.5;
     
+    // same terms as GetLikelihood(), the leptonic W is not used
+    mReco.SetMasses(mMw, mMtop);
+    mReco.SetResolutions(mSigWhad, mSigThad, mSigTlep);
+    
+    // hypotheses kept for the angle branches, the best one is the same for any number
+    if (mPset.exists("nHypotheses")) mReco.SetTopK(mPset.getParameter<int>("nHypotheses"));
+    else                             mReco.SetTopK(5);
+    
     return 0;
 }
 
@@ -180,6 +194,8 @@ int StopCalc::AnalyzeEvent(edm::EventBase const & event,
     // compute event variables here
     //
     
+    mpNuSolver = &selector->GetNeutrinoSolver();
+    
     //
     // _____ Get objects from the selector _________________________
     //
@@ -313,38 +329,28 @@ int StopCalc::AnalyzeEvent(edm::EventBase const & event,
     
     
     // m(l,b)
-    math::XYZTLorentzVector lv_mu;
-    math::XYZTLorentzVector lv_b1;
-    math::XYZTLorentzVector lv_b2;
-    math::XYZTLorentzVector lv_lb1;
-    math::XYZTLorentzVector lv_lb2;
+    FourVector lv_mu;
+    FourVector lv_b1;
+    FourVector lv_b2;
+    FourVector lv_lb1;
+    FourVector lv_lb2;
     
     // corrected
-    math::XYZTLorentzVector lv_b1_corr;
-    math::XYZTLorentzVector lv_b2_corr;
-    math::XYZTLorentzVector lv_lb1_corr;
-    math::XYZTLorentzVector lv_lb2_corr;
+    FourVector lv_b1_corr;
+    FourVector lv_b2_corr;
+    FourVector lv_lb1_corr;
+    FourVector lv_lb2_corr;
     
     if (vCorrTaggedJetIndex.size()>0){
-        lv_b1_corr.SetPxPyPzE(
-                              vCorrBtagJets[vCorrTaggedJetIndex[0]].first.Px(),
-                              vCorrBtagJets[vCorrTaggedJetIndex[0]].first.Py(),
-                              vCorrBtagJets[vCorrTaggedJetIndex[0]].first.Pz(),
-                              vCorrBtagJets[vCorrTaggedJetIndex[0]].first.Energy()
-                              );
+        lv_b1_corr = FourVector::FromLorentz(vCorrBtagJets[vCorrTaggedJetIndex[0]].first);
     }
     if (vCorrTaggedJetIndex.size()>1){
-        lv_b2_corr.SetPxPyPzE(
-                              vCorrBtagJets[vCorrTaggedJetIndex[1]].first.Px(),
-                              vCorrBtagJets[vCorrTaggedJetIndex[1]].first.Py(),
-                              vCorrBtagJets[vCorrTaggedJetIndex[1]].first.Pz(),
-                              vCorrBtagJets[vCorrTaggedJetIndex[1]].first.Energy()
-                              );
+        lv_b2_corr = FourVector::FromLorentz(vCorrBtagJets[vCorrTaggedJetIndex[1]].first);
     }
     
-    if (_nSelMuons>0)    lv_mu = vSelMuons[0]->p4();
-    if (_nSelBtagJets>0) lv_b1 = vSelBtagJets[0]->p4();
-    if (_nSelBtagJets>1) lv_b2 = vSelBtagJets[1]->p4();
+    if (_nSelMuons>0)    lv_mu = FourVector::FromCandidate(*vSelMuons[0]);
+    if (_nSelBtagJets>0) lv_b1 = FourVector::FromCandidate(*vSelBtagJets[0]);
+    if (_nSelBtagJets>1) lv_b2 = FourVector::FromCandidate(*vSelBtagJets[1]);
     if (_nSelMuons>0 && _nSelBtagJets>0) lv_lb1 = lv_mu+lv_b1;
     if (_nSelMuons>0 && _nSelBtagJets>1) lv_lb2 = lv_mu+lv_b2;
     
@@ -352,20 +358,20 @@ int StopCalc::AnalyzeEvent(edm::EventBase const & event,
     SetValue("mlb2", sqrt(lv_lb2.M2()));
     
     // b-jet pT
-    SetValue("bjet_1_pt", lv_b1.pt());
-    SetValue("bjet_1_eta", lv_b1.eta());
-    SetValue("bjet_1_phi", lv_b1.phi());
-    SetValue("bjet_2_pt", lv_b2.pt());
-    SetValue("bjet_2_eta", lv_b2.eta());
-    SetValue("bjet_2_phi", lv_b2.phi());
+    SetValue("bjet_1_pt", lv_b1.Pt());
+    SetValue("bjet_1_eta", lv_b1.Eta());
+    SetValue("bjet_1_phi", lv_b1.Phi());
+    SetValue("bjet_2_pt", lv_b2.Pt());
+    SetValue("bjet_2_eta", lv_b2.Eta());
+    SetValue("bjet_2_phi", lv_b2.Phi());
     
     // MET
     double _met = -1.0;
     double _met_phi = -10.0;
-    math::XYZTLorentzVector lv_met;
-    if(pMet.isNonnull() && pMet.isAvailable()) lv_met = pMet->p4();
-    _met = lv_met.pt();
-    _met_phi = lv_met.phi();
+    FourVector lv_met;
+    if(pMet.isNonnull() && pMet.isAvailable()) lv_met = FourVector::FromCandidate(*pMet);
+    _met = lv_met.Pt();
+    _met_phi = lv_met.Phi();
     SetValue("met", _met);
     SetValue("met_phi", _met_phi);
     
@@ -373,11 +379,11 @@ int StopCalc::AnalyzeEvent(edm::EventBase const & event,
     // MET Type 1 Corrected
     double _type1corrmet = -1.0;
     double _type1corrmet_phi = -10.0;
-    math::XYZTLorentzVector lv_type1corrmet;
+    FourVector lv_type1corrmet;
     if(pType1CorrMet.isNonnull() && pType1CorrMet.isAvailable()){
-        lv_type1corrmet = pType1CorrMet->p4();
-        _type1corrmet = lv_type1corrmet.pt();
-        _type1corrmet_phi = lv_type1corrmet.phi();
+        lv_type1corrmet = FourVector::FromCandidate(*pType1CorrMet);
+        _type1corrmet = lv_type1corrmet.Pt();
+        _type1corrmet_phi = lv_type1corrmet.Phi();
     }
     SetValue("met_type1Corr", _type1corrmet);
     SetValue("met_phi_type1Corr", _type1corrmet_phi);
@@ -454,7 +460,7 @@ int StopCalc::AnalyzeEvent(edm::EventBase const & event,
         // only consider first two b jets
         //for (std::vector<edm::Ptr<pat::Jet> >::const_iterator j=vSelBtagJets.begin();
         // j!=vSelBtagJets.begin(); ++j){
-        for (unsigned int j=0; j<2; ++j){
+        for (unsigned int j=0; j<std::min<size_t>(2, vSelBtagJets.size()); ++j){
             
             if ( (*i)==vSelBtagJets[j] ) _isLight=false;
             //if ( (*i)==(*j) ) _isLight=false;
@@ -471,16 +477,16 @@ int StopCalc::AnalyzeEvent(edm::EventBase const & event,
     //
     // _____ best candidate with extra corrected objects ___________
     //
-    math::XYZTLorentzVector lvCorrMet = TlvToXyzt(corrMET);
-    std::vector<math::XYZTLorentzVector> vCorrLJets;
+    FourVector lvCorrMet = FourVector::FromLorentz(corrMET);
+    std::vector<FourVector> vCorrLJets;
     for (std::vector<int>::const_iterator i=vCorrLightJetIndex.begin();
          i!=vCorrLightJetIndex.end();++i){
-        vCorrLJets.push_back(TlvToXyzt(vCorrBtagJets[*i].first));
+        vCorrLJets.push_back(FourVector::FromLorentz(vCorrBtagJets[*i].first));
     }
-    std::vector<math::XYZTLorentzVector> vCorrBJets;
+    std::vector<FourVector> vCorrBJets;
     if (vCorrTaggedJetIndex.size()>1){
-        vCorrBJets.push_back(TlvToXyzt(vCorrBtagJets[vCorrTaggedJetIndex[0]].first));
-        vCorrBJets.push_back(TlvToXyzt(vCorrBtagJets[vCorrTaggedJetIndex[1]].first));
+        vCorrBJets.push_back(lv_b1_corr);
+        vCorrBJets.push_back(lv_b2_corr);
     }
     
     if (vCorrLJets.size()<2 || vCorrBJets.size()<2){
@@ -488,20 +494,20 @@ int StopCalc::AnalyzeEvent(edm::EventBase const & event,
         std::cout << "DEBUG1: b jets " << vCorrBJets.size() << std::endl;
     }
     
-    SetBestCandidateVars(lv_mu, lvCorrMet, vCorrLJets, vCorrBJets, "_corr");
+    SetBestCandidateVars(lv_mu, lvCorrMet, vCorrLJets, vCorrBJets, std::vector<std::string>(1, "_corr"));
     
     
     //
     // _____ best candidate with standard objects __________________
     //
-    std::vector<math::XYZTLorentzVector> vDefLJets;
+    std::vector<FourVector> vDefLJets;
     for (unsigned int i=0; i<vLightJets.size() ;++i){
-        vDefLJets.push_back(vLightJets[i]->p4());
+        vDefLJets.push_back(FourVector::FromCandidate(*vLightJets[i]));
     }
-    std::vector<math::XYZTLorentzVector> vDefBJets;
+    std::vector<FourVector> vDefBJets;
     if (vSelBtagJets.size()>1){
-        vDefBJets.push_back(vSelBtagJets[0]->p4());
-        vDefBJets.push_back(vSelBtagJets[1]->p4());
+        vDefBJets.push_back(FourVector::FromCandidate(*vSelBtagJets[0]));
+        vDefBJets.push_back(FourVector::FromCandidate(*vSelBtagJets[1]));
     }
     
     if (vDefLJets.size()<2 || vDefBJets.size()<2){
@@ -509,334 +515,25 @@ int StopCalc::AnalyzeEvent(edm::EventBase const & event,
         std::cout << "DEBUG2: b jets " << vDefBJets.size() << std::endl;
     }
     
-    SetBestCandidateVars(lv_mu, lv_met, vDefLJets, vDefBJets, "_def");
-    
-    
-    //_____ find best candidate
-    
-    double _bestL = -1.0;
-    
-    double _bestMlb    = -1.0;
-    double _bestMlbhad = -1.0;
-    
-    double _bestSubSmin = -1.0;
-    
-    double _bestNuPz   = -100000.0;
-    double _bestNuPt   = -100.0;
-    double _bestNuE    = -100.0;
-    double _bestNuM2   = -1.0;
-    double _bestNuEta  = -100.0;
-    double _bestNuPhi  = -10.0;
-    
-    double _bestWlepPz = -100000.0;
-    double _bestWlepPt = -100.0;
-    double _bestWlepE  = -100.0;
-    double _bestWlepM  = -1.0;
-    double _bestWlepEta= -100.0;
-    double _bestWlepPhi= -10.0;
-    
-    double _bestWhadPz = -100000.0;
-    double _bestWhadPt = -100.0;
-    double _bestWhadE  = -100.0;
-    double _bestWhadM  = -1.0;
-    double _bestWhadEta= -100.0;
-    double _bestWhadPhi= -10.0;
-    
-    double _bestTlepPz = -100000.0;
-    double _bestTlepPt = -100.0;
-    double _bestTlepE  = -100.0;
-    double _bestTlepM  = -1.0;
-    double _bestTlepEta= -100.0;
-    double _bestTlepPhi= -10.0;
-    
-    double _bestThadPz = -100000.0;
-    double _bestThadPt = -100.0;
-    double _bestThadE  = -100.0;
-    double _bestThadM  = -1.0;
-    double _bestThadEta= -100.0;
-    double _bestThadPhi= -10.0;
-    
-    double _bestBlepPz = -100000.0;
-    double _bestBlepPt = -100.0;
-    double _bestBlepE  = -100.0;
-    double _bestBlepEta= -100.0;
-    double _bestBlepPhi= -10.0;
-    
-    double _bestBhadPz = -100000.0;
-    double _bestBhadPt = -100.0;
-    double _bestBhadE  = -100.0;
-    double _bestBhadEta= -100.0;
-    double _bestBhadPhi= -10.0;
-    
-    double _bestJet1Pz = -100000.0;
-    double _bestJet1Pt = -100.0;
-    double _bestJet1E  = -100.0;
-    double _bestJet1Eta= -100.0;
-    double _bestJet1Phi= -10.0;
-    
-    double _bestJet2Pz = -100000.0;
-    double _bestJet2Pt = -100.0;
-    double _bestJet2E  = -100.0;
-    double _bestJet2Eta= -100.0;
-    double _bestJet2Phi= -10.0;
-    
-    //_____ neutrino solution
-    int _neuSuccess = 0;
-    std::vector<double> pPz = GetNeutrinoPz(lv_mu, lv_met, _neuSuccess);
-    //std::cout << mLegend << "first  solution for neutrino pz: " << pPz[0] << std::endl;
-    //std::cout << mLegend << "second solution for neutrino pz: " << pPz[1] << std::endl;
-    
-    SetValue("neutrinoSuccess", _neuSuccess); // were able to reconstruct neutrino
-    
-    
-    //_____ loop over two neutrino solutions
-    for (unsigned int n=0; n<2; ++n){
-        
-        math::XYZTLorentzVector lv_neu(lv_met);
-        lv_neu.SetPz(pPz[n]);
-        lv_neu.SetE(sqrt(pPz[n]*pPz[n]+lv_met.pt()*lv_met.pt()));
-        //std::cout << mLegend << "neutrino mass squared: " << lv_neu.M2() << std::endl;
-        
-        
-        //_____ leptonic W
-        math::XYZTLorentzVector lv_Wlep = lv_mu+lv_neu;
-        double _mWlep = sqrt(lv_Wlep.M2());
-        
-        
-        //_____ loop over all two-light-jet combinations
-        for (unsigned int i=0; i<vLightJets.size(); ++i){
-            for (unsigned int j=i+1; j<vLightJets.size(); ++j){
-                // i,j make up the hadronic W
-                
-                //std::cout << mLegend << "total/first/second: " << vLightJets.size()
-                //	  << " / " << i << " / " << j << std::endl;
-                
-                math::XYZTLorentzVector lv_jet1 = vLightJets[i]->p4();
-                math::XYZTLorentzVector lv_jet2 = vLightJets[j]->p4();
-                
-                
-                //_____ hadronic W
-                math::XYZTLorentzVector lv_Whad = lv_jet1+lv_jet2;
-                double _mWhad = sqrt(lv_Whad.M2());
-                
-                
-                //_____ loop over two b jets combinations
-                for (unsigned int k=0; k<2; ++k){
-                    // loop over the two b jets
-                    // k - lepton-side b jet
-                    
-                    math::XYZTLorentzVector lv_blep = vSelBtagJets[k]->p4();
-                    math::XYZTLorentzVector lv_bhad = vSelBtagJets[1-k]->p4();
-                    
-                    
-                    //_____ hadronic top
-                    math::XYZTLorentzVector lv_Thad = lv_Whad+lv_bhad;
-                    double _mThad = sqrt(lv_Thad.M2());
-                    
-                    
-                    //_____ leptonic top
-                    math::XYZTLorentzVector lv_Tlep = lv_Wlep+lv_blep;
-                    double _mTlep = sqrt(lv_Tlep.M2());
-                    
-                    
-                    //_____ candidate likelihood
-                    double _candL = GetLikelihood(_mWlep, _mWhad, _mTlep, _mThad);
-                    
-                    //std::cout << mLegend << "lep W mass: " << _mWlep << std::endl;
-                    //std::cout << mLegend << "candidate likelihood: " << _candL << std::endl;
-                    
-                    
-                    //_____ update values if better candidate found
-                    if (_candL>_bestL){
-                        
-                        _bestL = _candL;
-                        
-                        
-                        // lepton+b(lep)
-                        math::XYZTLorentzVector lv_lb = lv_mu+lv_blep;
-                        _bestMlb = sqrt(lv_lb.M2());
-                        
-                        
-                        // lepton+b(had)
-                        math::XYZTLorentzVector lv_lbhad = lv_mu+lv_bhad;
-                        _bestMlbhad = sqrt(lv_lbhad.M2());
-                        
-                        
-                        // "subsmin" variable:
-                        // JHEP 1106 (2011) 041
-                        math::XYZTLorentzVector lv_sub = lv_mu +lv_blep+lv_bhad+lv_jet1+lv_jet2;
-                        math::XYZTLorentzVector lv_tot = lv_sub+lv_neu;
-                        _bestSubSmin = sqrt(
-                                            ( sqrt(lv_sub.M2()+lv_sub.pt()*lv_sub.pt())
-                                             +
-                                             sqrt(lv_neu.M2()+lv_neu.pt()*lv_neu.pt()) )
-                                            *
-                                            ( sqrt(lv_sub.M2()+lv_sub.pt()*lv_sub.pt())
-                                             +
-                                             sqrt(lv_neu.M2()+lv_neu.pt()*lv_neu.pt()) )
-                                            -
-                                            lv_tot.pt()*lv_tot.pt()
-                                            );
-                        
-                        
-                        _bestNuPz   = lv_neu.pz();
-                        _bestNuPt   = lv_neu.pt();
-                        _bestNuE    = lv_neu.E();
-                        _bestNuM2   = lv_neu.M2();
-                        _bestNuEta  = lv_neu.Eta();
-                        _bestNuPhi  = lv_neu.Phi();
-                        
-                        _bestWlepPz = lv_Wlep.pz();
-                        _bestWlepPt = lv_Wlep.pt();
-                        _bestWlepE  = lv_Wlep.E();
-                        _bestWlepM  = _mWlep;
-                        _bestWlepEta= lv_Wlep.Eta();
-                        _bestWlepPhi= lv_Wlep.Phi();
-                        
-                        _bestWhadPz = lv_Whad.pz();
-                        _bestWhadPt = lv_Whad.pt();
-                        _bestWhadE  = lv_Whad.E();
-                        _bestWhadM  = _mWhad;
-                        _bestWhadEta= lv_Whad.Eta();
-                        _bestWhadPhi= lv_Whad.Phi();
-                        
-                        _bestTlepPz = lv_Tlep.pz();
-                        _bestTlepPt = lv_Tlep.pt();
-                        _bestTlepE  = lv_Tlep.E();
-                        _bestTlepM  = _mTlep;
-                        _bestTlepEta= lv_Tlep.Eta();
-                        _bestTlepPhi= lv_Tlep.Phi();
-                        
-                        _bestThadPz = lv_Thad.pz();
-                        _bestThadPt = lv_Thad.pt();
-                        _bestThadE  = lv_Thad.E();
-                        _bestThadM  = _mThad;
-                        _bestThadEta= lv_Thad.Eta();
-                        _bestThadPhi= lv_Thad.Phi();
-                        
-                        _bestBlepPz = lv_blep.pz();
-                        _bestBlepPt = lv_blep.pt();
-                        _bestBlepE  = lv_blep.E();
-                        _bestBlepEta= lv_blep.Eta();
-                        _bestBlepPhi= lv_blep.Phi();
-                        
-                        _bestBhadPz = lv_bhad.pz();
-                        _bestBhadPt = lv_bhad.pt();
-                        _bestBhadE  = lv_bhad.E();
-                        _bestBhadEta= lv_bhad.Eta();
-                        _bestBhadPhi= lv_bhad.Phi();
-                        
-                        _bestJet1Pz = lv_jet1.pz();
-                        _bestJet1Pt = lv_jet1.pt();
-                        _bestJet1E  = lv_jet1.E();
-                        _bestJet1Eta= lv_jet1.Eta();
-                        _bestJet1Phi= lv_jet1.Phi();
-                        
-                        _bestJet2Pz = lv_jet2.pz();
-                        _bestJet2Pt = lv_jet2.pt();
-                        _bestJet2E  = lv_jet2.E();
-                        _bestJet2Eta= lv_jet2.Eta();
-                        _bestJet2Phi= lv_jet2.Phi();
-                        
-                    }
-                    else{ // should never happen
-                        if (_candL<0) std::cout << mLegend << "cand likelihood: " << _candL << std::endl;
-                    }
-                    
-                    
-                } // end of b jet loop
-                
-            } // inner light jet loop
-        } // outer light jet loop
-        
-    } // neutrino loop
-    
-    SetValue("bestL", _bestL);
-    
-    SetValue("bestMlb", _bestMlb);
-    SetValue("bestMlbhad", _bestMlbhad);
-    
-    SetValue("bestSubSmin", _bestSubSmin);
-    
-    SetValue("bestNuPz", _bestNuPz);
-    SetValue("bestNuPt", _bestNuPt);
-    SetValue("bestNuE", _bestNuE);
-    SetValue("bestNuM2", _bestNuM2);
-    SetValue("bestNuEta", _bestNuEta);
-    SetValue("bestNuPhi", _bestNuPhi);
-    
-    SetValue("bestWlepPz", _bestWlepPz);
-    SetValue("bestWlepPt", _bestWlepPt);
-    SetValue("bestWlepE", _bestWlepE);
-    SetValue("bestWlepM", _bestWlepM);
-    SetValue("bestWlepEta", _bestWlepEta);
-    SetValue("bestWlepPhi", _bestWlepPhi);
-    
-    SetValue("bestWhadPz", _bestWhadPz);
-    SetValue("bestWhadPt", _bestWhadPt);
-    SetValue("bestWhadE", _bestWhadE);
-    SetValue("bestWhadM", _bestWhadM);
-    SetValue("bestWhadEta", _bestWhadEta);
-    SetValue("bestWhadPhi", _bestWhadPhi);
-    
-    SetValue("bestTlepPz", _bestTlepPz);
-    SetValue("bestTlepPt", _bestTlepPt);
-    SetValue("bestTlepE", _bestTlepE);
-    SetValue("bestTlepM", _bestTlepM);
-    SetValue("bestTlepEta", _bestTlepEta);
-    SetValue("bestTlepPhi", _bestTlepPhi);
-    
-    SetValue("bestThadPz", _bestThadPz);
-    SetValue("bestThadPt", _bestThadPt);
-    SetValue("bestThadE", _bestThadE);
-    SetValue("bestThadM", _bestThadM);
-    SetValue("bestThadEta", _bestThadEta);
-    SetValue("bestThadPhi", _bestThadPhi);
-    
-    SetValue("bestBlepPz", _bestBlepPz);
-    SetValue("bestBlepPt", _bestBlepPt);
-    SetValue("bestBlepE", _bestBlepE);
-    SetValue("bestBlepEta", _bestBlepEta);
-    SetValue("bestBlepPhi", _bestBlepPhi);
-    
-    SetValue("bestBhadPz", _bestBhadPz);
-    SetValue("bestBhadPt", _bestBhadPt);
-    SetValue("bestBhadE", _bestBhadE);
-    SetValue("bestBhadEta", _bestBhadEta);
-    SetValue("bestBhadPhi", _bestBhadPhi);
-    
-    SetValue("bestJet1Pz", _bestJet1Pz);
-    SetValue("bestJet1Pt", _bestJet1Pt);
-    SetValue("bestJet1E", _bestJet1E);
-    SetValue("bestJet1Eta", _bestJet1Eta);
-    SetValue("bestJet1Phi", _bestJet1Phi);
-    
-    SetValue("bestJet2Pz", _bestJet2Pz);
-    SetValue("bestJet2Pt", _bestJet2Pt);
-    SetValue("bestJet2E", _bestJet2E);
-    SetValue("bestJet2Eta", _bestJet2Eta);
-    SetValue("bestJet2Phi", _bestJet2Phi);
+    // one reconstruction, saved with the _def suffix and without one
+    std::vector<std::string> _defSuffixes;
+    _defSuffixes.push_back("_def");
+    _defSuffixes.push_back("");
+    SetBestCandidateVars(lv_mu, lv_met, vDefLJets, vDefBJets, _defSuffixes);
     
     return 0;
 }
 
 
-math::XYZTLorentzVector StopCalc::TlvToXyzt(TLorentzVector tlv){
-    math::XYZTLorentzVector vec;
-    vec.SetPxPyPzE(tlv.Px(),tlv.Py(),tlv.Pz(),tlv.Energy());
-    return vec;
-}
-
-
-
-void StopCalc::SetBestCandidateVars(math::XYZTLorentzVector vLep,
-                                    math::XYZTLorentzVector vMet,
-                                    std::vector<math::XYZTLorentzVector> vLJets,
-                                    std::vector<math::XYZTLorentzVector> vBJets,
-                                    std::string suffix){
+void StopCalc::SetBestCandidateVars(FourVector const & vLep,
+                                    FourVector const & vMet,
+                                    std::vector<FourVector> const & vLJets,
+                                    std::vector<FourVector> const & vBJets,
+                                    std::vector<std::string> const & suffixes){
     //
     // Reconstructs the best mu+jets ttbar candidate
-    // and saves corresponding quantities to file
+    // and saves corresponding quantities to file,
+    // once for each branch name suffix
     //
     
     double _bestL = -1.0;
@@ -908,8 +605,8 @@ void StopCalc::SetBestCandidateVars(math::XYZTLorentzVector vLep,
     //_____ neutrino solution
     int _neuSuccess = 0;
     
-    math::XYZTLorentzVector lv_mu = vLep;
-    math::XYZTLorentzVector lv_met = vMet;
+    FourVector const & lv_mu = vLep;
+    FourVector const & lv_met = vMet;
     
     std::vector<double> pPz = GetNeutrinoPz(lv_mu, lv_met, _neuSuccess);
     //std::cout << mLegend << "first  solution for neutrino pz: " << pPz[0] << std::endl;
@@ -918,289 +615,358 @@ void StopCalc::SetBestCandidateVars(math::XYZTLorentzVector vLep,
     SetValue("neutrinoSuccess", _neuSuccess); // were able to reconstruct neutrino
     
     
-    //_____ loop over two neutrino solutions
+    //_____ best assignment of light jets, b jets and neutrino solutions
+    // maximal likelihood is minimal chi2 of the same mass terms
+    std::vector<FourVector> _jets;
+    std::vector<int> _roles;
+    _jets.reserve(vLJets.size()+vBJets.size());
+    _roles.reserve(vLJets.size()+vBJets.size());
+    for (unsigned int i=0; i<vLJets.size(); ++i){
+        _jets.push_back(vLJets[i]);
+        _roles.push_back(TtbarReconstructor::kLight);
+    }
+    for (unsigned int k=0; k<vBJets.size(); ++k){
+        _jets.push_back(vBJets[k]);
+        _roles.push_back(TtbarReconstructor::kB);
+    }
+    
+    FourVector _neutrinos[2];
     for (unsigned int n=0; n<2; ++n){
+        _neutrinos[n] = FourVector(lv_met.Px(), lv_met.Py(), pPz[n], sqrt(pPz[n]*pPz[n]+lv_met.Pt2()));
+    }
+    
+    mReco.Reconstruct(lv_mu, _neutrinos, 2, _jets.data(), _roles.data(), _jets.size());
+    TtbarReconstructor::Hypothesis const * _best = mReco.GetBest();
+    
+    SetHypothesisAngles(lv_mu, _neutrinos, _jets, suffixes);
+    
+    if (_best){
         
-        math::XYZTLorentzVector lv_neu(lv_met);
-        lv_neu.SetPz(pPz[n]);
-        lv_neu.SetE(sqrt(pPz[n]*pPz[n]+lv_met.pt()*lv_met.pt()));
-        //std::cout << mLegend << "neutrino mass squared: " << lv_neu.M2() << std::endl;
+        FourVector const & lv_neu = _neutrinos[_best->neutrino];
         
         
         //_____ leptonic W
-        math::XYZTLorentzVector lv_Wlep = lv_mu+lv_neu;
+        FourVector lv_Wlep = lv_mu+lv_neu;
         double _mWlep = sqrt(lv_Wlep.M2());
         
         
-        //_____ loop over all two-light-jet combinations
-        for (unsigned int i=0; i<vLJets.size(); ++i){
-            for (unsigned int j=i+1; j<vLJets.size(); ++j){
-                // i,j make up the hadronic W
-                
-                //std::cout << mLegend << "total/first/second: " << vLightJets.size()
-                //	  << " / " << i << " / " << j << std::endl;
-                
-                math::XYZTLorentzVector lv_jet1 = vLJets[i];
-                math::XYZTLorentzVector lv_jet2 = vLJets[j];
-                
-                
-                //_____ hadronic W
-                math::XYZTLorentzVector lv_Whad = lv_jet1+lv_jet2;
-                double _mWhad = sqrt(lv_Whad.M2());
-                
-                
-                //_____ loop over two b jets combinations
-                for (unsigned int k=0; k<2; ++k){
-                    // loop over the two b jets
-                    // k - lepton-side b jet
-                    
-                    math::XYZTLorentzVector lv_blep = vBJets[k];
-                    math::XYZTLorentzVector lv_bhad = vBJets[1-k];
-                    
-                    
-                    //_____ hadronic top
-                    math::XYZTLorentzVector lv_Thad = lv_Whad+lv_bhad;
-                    double _mThad = sqrt(lv_Thad.M2());
-                    
-                    
-                    //_____ leptonic top
-                    math::XYZTLorentzVector lv_Tlep = lv_Wlep+lv_blep;
-                    double _mTlep = sqrt(lv_Tlep.M2());
-                    
-                    
-                    //_____ candidate likelihood
-                    double _candL = GetLikelihood(_mWlep, _mWhad, _mTlep, _mThad);
-                    
-                    //std::cout << mLegend << "lep W mass: " << _mWlep << std::endl;
-                    //std::cout << mLegend << "candidate likelihood: " << _candL << std::endl;
-                    
-                    
-                    //_____ update values if better candidate found
-                    if (_candL>_bestL){
-                        
-                        _bestL = _candL;
-                        
-                        
-                        // lepton+b(lep)
-                        math::XYZTLorentzVector lv_lb = lv_mu+lv_blep;
-                        _bestMlb = sqrt(lv_lb.M2());
-                        
-                        
-                        // lepton+b(had)
-                        math::XYZTLorentzVector lv_lbhad = lv_mu+lv_bhad;
-                        _bestMlbhad = sqrt(lv_lbhad.M2());
-                        
-                        
-                        // "subsmin" variable:
-                        // JHEP 1106 (2011) 041
-                        math::XYZTLorentzVector lv_sub = lv_mu +lv_blep+lv_bhad+lv_jet1+lv_jet2;
-                        math::XYZTLorentzVector lv_tot = lv_sub+lv_neu;
-                        _bestSubSmin = sqrt(
-                                            ( sqrt(lv_sub.M2()+lv_sub.pt()*lv_sub.pt())
-                                             + 
-                                             sqrt(lv_neu.M2()+lv_neu.pt()*lv_neu.pt()) )
-                                            *
-                                            ( sqrt(lv_sub.M2()+lv_sub.pt()*lv_sub.pt()) 
-                                             + 
-                                             sqrt(lv_neu.M2()+lv_neu.pt()*lv_neu.pt()) )
-                                            -
-                                            lv_tot.pt()*lv_tot.pt() 
-                                            );
-                        
-                        
-                        _bestNuPz   = lv_neu.pz();
-                        _bestNuPt   = lv_neu.pt();
-                        _bestNuE    = lv_neu.E();
-                        _bestNuM2   = lv_neu.M2();
-                        _bestNuEta  = lv_neu.Eta();
-                        _bestNuPhi  = lv_neu.Phi();
-                        
-                        _bestWlepPz = lv_Wlep.pz();
-                        _bestWlepPt = lv_Wlep.pt();
-                        _bestWlepE  = lv_Wlep.E();
-                        _bestWlepM  = _mWlep;
-                        _bestWlepEta= lv_Wlep.Eta();
-                        _bestWlepPhi= lv_Wlep.Phi();
-                        
-                        _bestWhadPz = lv_Whad.pz();
-                        _bestWhadPt = lv_Whad.pt();
-                        _bestWhadE  = lv_Whad.E();
-                        _bestWhadM  = _mWhad;
-                        _bestWhadEta= lv_Whad.Eta();
-                        _bestWhadPhi= lv_Whad.Phi();
-                        
-                        _bestTlepPz = lv_Tlep.pz();	
-                        _bestTlepPt = lv_Tlep.pt();	
-                        _bestTlepE  = lv_Tlep.E();	
-                        _bestTlepM  = _mTlep;	
-                        _bestTlepEta= lv_Tlep.Eta();
-                        _bestTlepPhi= lv_Tlep.Phi();
-                        
-                        _bestThadPz = lv_Thad.pz();	
-                        _bestThadPt = lv_Thad.pt();	
-                        _bestThadE  = lv_Thad.E();	
-                        _bestThadM  = _mThad;	
-                        _bestThadEta= lv_Thad.Eta();
-                        _bestThadPhi= lv_Thad.Phi();
-                        
-                        _bestBlepPz = lv_blep.pz();	
-                        _bestBlepPt = lv_blep.pt();	
-                        _bestBlepE  = lv_blep.E();	
-                        _bestBlepEta= lv_blep.Eta();
-                        _bestBlepPhi= lv_blep.Phi();
-                        
-                        _bestBhadPz = lv_bhad.pz();	
-                        _bestBhadPt = lv_bhad.pt();	
-                        _bestBhadE  = lv_bhad.E();	
-                        _bestBhadEta= lv_bhad.Eta();
-                        _bestBhadPhi= lv_bhad.Phi();
-                        
-                        _bestJet1Pz = lv_jet1.pz();	
-                        _bestJet1Pt = lv_jet1.pt();	
-                        _bestJet1E  = lv_jet1.E();	
-                        _bestJet1Eta= lv_jet1.Eta();
-                        _bestJet1Phi= lv_jet1.Phi();
-                        
-                        _bestJet2Pz = lv_jet2.pz();	
-                        _bestJet2Pt = lv_jet2.pt();	
-                        _bestJet2E  = lv_jet2.E();	
-                        _bestJet2Eta= lv_jet2.Eta();
-                        _bestJet2Phi= lv_jet2.Phi();
-                        
-                    }
-                    else{ // should never happen
-                        if (_candL<0) std::cout << mLegend << "cand likelihood: " << _candL << std::endl;
-                    }
-                    
-                    
-                } // end of b jet loop
-                
-            } // inner light jet loop
-        } // outer light jet loop
+        //_____ hadronic W
+        FourVector lv_jet1 = vLJets[_best->jet1];
+        FourVector lv_jet2 = vLJets[_best->jet2];
+        FourVector lv_Whad = lv_jet1+lv_jet2;
+        double _mWhad = sqrt(lv_Whad.M2());
+        
+        
+        //_____ b jets, after the light jets in _jets
+        FourVector lv_blep = vBJets[_best->bLep - vLJets.size()];
+        FourVector lv_bhad = vBJets[_best->bHad - vLJets.size()];
+        
+        
+        //_____ hadronic top
+        FourVector lv_Thad = lv_Whad+lv_bhad;
+        double _mThad = sqrt(lv_Thad.M2());
+        
+        
+        //_____ leptonic top
+        FourVector lv_Tlep = lv_Wlep+lv_blep;
+        double _mTlep = sqrt(lv_Tlep.M2());
+        
         
-    } // neutrino loop
+        //_____ candidate likelihood
+        _bestL = GetLikelihood(_mWlep, _mWhad, _mTlep, _mThad);
+        
+        
+        // lepton+b(lep)
+        FourVector lv_lb = lv_mu+lv_blep;
+        _bestMlb = sqrt(lv_lb.M2());
+        
+        
+        // lepton+b(had)
+        FourVector lv_lbhad = lv_mu+lv_bhad;
+        _bestMlbhad = sqrt(lv_lbhad.M2());
+        
+        
+        // "subsmin" variable:
+        // JHEP 1106 (2011) 041
+        FourVector lv_sub = lv_mu +lv_blep+lv_bhad+lv_jet1+lv_jet2;
+        FourVector lv_tot = lv_sub+lv_neu;
+        _bestSubSmin = sqrt(
+                            ( sqrt(lv_sub.M2()+lv_sub.Pt()*lv_sub.Pt())
+                             + 
+                             sqrt(lv_neu.M2()+lv_neu.Pt()*lv_neu.Pt()) )
+                            *
+                            ( sqrt(lv_sub.M2()+lv_sub.Pt()*lv_sub.Pt()) 
+                             + 
+                             sqrt(lv_neu.M2()+lv_neu.Pt()*lv_neu.Pt()) )
+                            -
+                            lv_tot.Pt()*lv_tot.Pt() 
+                            );
+        
+        
+        _bestNuPz   = lv_neu.Pz();
+        _bestNuPt   = lv_neu.Pt();
+        _bestNuE    = lv_neu.E();
+        _bestNuM2   = lv_neu.M2();
+        _bestNuEta  = lv_neu.Eta();
+        _bestNuPhi  = lv_neu.Phi();
+        
+        _bestWlepPz = lv_Wlep.Pz();
+        _bestWlepPt = lv_Wlep.Pt();
+        _bestWlepE  = lv_Wlep.E();
+        _bestWlepM  = _mWlep;
+        _bestWlepEta= lv_Wlep.Eta();
+        _bestWlepPhi= lv_Wlep.Phi();
+        
+        _bestWhadPz = lv_Whad.Pz();
+        _bestWhadPt = lv_Whad.Pt();
+        _bestWhadE  = lv_Whad.E();
+        _bestWhadM  = _mWhad;
+        _bestWhadEta= lv_Whad.Eta();
+        _bestWhadPhi= lv_Whad.Phi();
+        
+        _bestTlepPz = lv_Tlep.Pz();	
+        _bestTlepPt = lv_Tlep.Pt();	
+        _bestTlepE  = lv_Tlep.E();	
+        _bestTlepM  = _mTlep;	
+        _bestTlepEta= lv_Tlep.Eta();
+        _bestTlepPhi= lv_Tlep.Phi();
+        
+        _bestThadPz = lv_Thad.Pz();	
+        _bestThadPt = lv_Thad.Pt();	
+        _bestThadE  = lv_Thad.E();	
+        _bestThadM  = _mThad;	
+        _bestThadEta= lv_Thad.Eta();
+        _bestThadPhi= lv_Thad.Phi();
+        
+        _bestBlepPz = lv_blep.Pz();	
+        _bestBlepPt = lv_blep.Pt();	
+        _bestBlepE  = lv_blep.E();	
+        _bestBlepEta= lv_blep.Eta();
+        _bestBlepPhi= lv_blep.Phi();
+        
+        _bestBhadPz = lv_bhad.Pz();	
+        _bestBhadPt = lv_bhad.Pt();	
+        _bestBhadE  = lv_bhad.E();	
+        _bestBhadEta= lv_bhad.Eta();
+        _bestBhadPhi= lv_bhad.Phi();
+        
+        _bestJet1Pz = lv_jet1.Pz();	
+        _bestJet1Pt = lv_jet1.Pt();	
+        _bestJet1E  = lv_jet1.E();	
+        _bestJet1Eta= lv_jet1.Eta();
+        _bestJet1Phi= lv_jet1.Phi();
+        
+        _bestJet2Pz = lv_jet2.Pz();	
+        _bestJet2Pt = lv_jet2.Pt();	
+        _bestJet2E  = lv_jet2.E();	
+        _bestJet2Eta= lv_jet2.Eta();
+        _bestJet2Phi= lv_jet2.Phi();
+        
+    }
     
     char buf[128];
-    sprintf(buf, "bestL%s", suffix.c_str());
-    SetValue(buf, _bestL);
-    //  SetValue("bestL", _bestL);
-    
-    sprintf(buf, "bestMlb%s", suffix.c_str());
-    SetValue(buf, _bestMlb);
-    sprintf(buf, "bestMlbhad%s", suffix.c_str());
-    SetValue(buf, _bestMlbhad);
-    
-    sprintf(buf, "bestSubSmin%s", suffix.c_str());
-    SetValue(buf, _bestSubSmin);
-    
-    sprintf(buf, "bestNuPz%s", suffix.c_str());
-    SetValue(buf, _bestNuPz);
-    sprintf(buf, "bestNuPt%s", suffix.c_str());
-    SetValue(buf, _bestNuPt);
-    sprintf(buf, "bestNuE%s", suffix.c_str());
-    SetValue(buf, _bestNuE);
-    sprintf(buf, "bestNuM2%s", suffix.c_str());
-    SetValue(buf, _bestNuM2);
-    sprintf(buf, "bestNuEta%s", suffix.c_str());
-    SetValue(buf, _bestNuEta);
-    sprintf(buf, "bestNuPhi%s", suffix.c_str());
-    SetValue(buf, _bestNuPhi);
-    
-    sprintf(buf, "bestWlepPz%s", suffix.c_str());
-    SetValue(buf, _bestWlepPz);
-    sprintf(buf, "bestWlepPt%s", suffix.c_str());
-    SetValue(buf, _bestWlepPt);
-    sprintf(buf, "bestWlepE%s", suffix.c_str());
-    SetValue(buf, _bestWlepE);
-    sprintf(buf, "bestWlepM%s", suffix.c_str());
-    SetValue(buf, _bestWlepM);
-    sprintf(buf, "bestWlepEta%s", suffix.c_str());
-    SetValue(buf, _bestWlepEta);
-    sprintf(buf, "bestWlepPhi%s", suffix.c_str());
-    SetValue(buf, _bestWlepPhi);
-    
-    sprintf(buf, "bestWhadPz%s", suffix.c_str());
-    SetValue(buf, _bestWhadPz);
-    sprintf(buf, "bestWhadPt%s", suffix.c_str());
-    SetValue(buf, _bestWhadPt);
-    sprintf(buf, "bestWhadE%s", suffix.c_str());
-    SetValue(buf, _bestWhadE);
-    sprintf(buf, "bestWhadM%s", suffix.c_str());
-    SetValue(buf, _bestWhadM);
-    sprintf(buf, "bestWhadEta%s", suffix.c_str());
-    SetValue(buf, _bestWhadEta);
-    sprintf(buf, "bestWhadPhi%s", suffix.c_str());
-    SetValue(buf, _bestWhadPhi);
-    
-    sprintf(buf, "bestTlepPz%s", suffix.c_str());
-    SetValue(buf, _bestTlepPz);
-    sprintf(buf, "bestTlepPt%s", suffix.c_str());
-    SetValue(buf, _bestTlepPt);
-    sprintf(buf, "bestTlepE%s", suffix.c_str());
-    SetValue(buf, _bestTlepE);
-    sprintf(buf, "bestTlepM%s", suffix.c_str());
-    SetValue(buf, _bestTlepM);
-    sprintf(buf, "bestTlepEta%s", suffix.c_str());
-    SetValue(buf, _bestTlepEta);
-    sprintf(buf, "bestTlepPhi%s", suffix.c_str());
-    SetValue(buf, _bestTlepPhi);
-    
-    sprintf(buf, "bestThadPz%s", suffix.c_str());
-    SetValue(buf, _bestThadPz);
-    sprintf(buf, "bestThadPt%s", suffix.c_str());
-    SetValue(buf, _bestThadPt);
-    sprintf(buf, "bestThadE%s", suffix.c_str());
-    SetValue(buf, _bestThadE);
-    sprintf(buf, "bestThadM%s", suffix.c_str());
-    SetValue(buf, _bestThadM);
-    sprintf(buf, "bestThadEta%s", suffix.c_str());
-    SetValue(buf, _bestThadEta);
-    sprintf(buf, "bestThadPhi%s", suffix.c_str());
-    SetValue(buf, _bestThadPhi);
-    
-    sprintf(buf, "bestBlepPz%s", suffix.c_str());
-    SetValue(buf, _bestBlepPz);
-    sprintf(buf, "bestBlepPt%s", suffix.c_str());
-    SetValue(buf, _bestBlepPt);
-    sprintf(buf, "bestBlepE%s", suffix.c_str());
-    SetValue(buf, _bestBlepE);
-    sprintf(buf, "bestBlepEta%s", suffix.c_str());
-    SetValue(buf, _bestBlepEta);
-    sprintf(buf, "bestBlepPhi%s", suffix.c_str());
-    SetValue(buf, _bestBlepPhi);
-    
-    sprintf(buf, "bestBhadPz%s", suffix.c_str());
-    SetValue(buf, _bestBhadPz);
-    sprintf(buf, "bestBhadPt%s", suffix.c_str());
-    SetValue(buf, _bestBhadPt);
-    sprintf(buf, "bestBhadE%s", suffix.c_str());
-    SetValue(buf, _bestBhadE);
-    sprintf(buf, "bestBhadEta%s", suffix.c_str());
-    SetValue(buf, _bestBhadEta);
-    sprintf(buf, "bestBhadPhi%s", suffix.c_str());
-    SetValue(buf, _bestBhadPhi);
-    
-    sprintf(buf, "bestJet1Pz%s", suffix.c_str());
-    SetValue(buf, _bestJet1Pz);
-    sprintf(buf, "bestJet1Pt%s", suffix.c_str());
-    SetValue(buf, _bestJet1Pt);
-    sprintf(buf, "bestJet1E%s", suffix.c_str());
-    SetValue(buf, _bestJet1E);
-    sprintf(buf, "bestJet1Eta%s", suffix.c_str());
-    SetValue(buf, _bestJet1Eta);
-    sprintf(buf, "bestJet1Phi%s", suffix.c_str());
-    SetValue(buf, _bestJet1Phi);
-    
-    sprintf(buf, "bestJet2Pz%s", suffix.c_str());
-    SetValue(buf, _bestJet2Pz);
-    sprintf(buf, "bestJet2Pt%s", suffix.c_str());
-    SetValue(buf, _bestJet2Pt);
-    sprintf(buf, "bestJet2E%s", suffix.c_str());
-    SetValue(buf, _bestJet2E);
-    sprintf(buf, "bestJet2Eta%s", suffix.c_str());
-    SetValue(buf, _bestJet2Eta);
-    sprintf(buf, "bestJet2Phi%s", suffix.c_str());
-    SetValue(buf, _bestJet2Phi);
+    for (size_t s = 0; s != suffixes.size(); ++s){
+        std::string const & suffix = suffixes[s];
+        
+        sprintf(buf, "bestL%s", suffix.c_str());
+        SetValue(buf, _bestL);
+        //  SetValue("bestL", _bestL);
+    
+        sprintf(buf, "bestMlb%s", suffix.c_str());
+        SetValue(buf, _bestMlb);
+        sprintf(buf, "bestMlbhad%s", suffix.c_str());
+        SetValue(buf, _bestMlbhad);
+    
+        sprintf(buf, "bestSubSmin%s", suffix.c_str());
+        SetValue(buf, _bestSubSmin);
+    
+        sprintf(buf, "bestNuPz%s", suffix.c_str());
+        SetValue(buf, _bestNuPz);
+        sprintf(buf, "bestNuPt%s", suffix.c_str());
+        SetValue(buf, _bestNuPt);
+        sprintf(buf, "bestNuE%s", suffix.c_str());
+        SetValue(buf, _bestNuE);
+        sprintf(buf, "bestNuM2%s", suffix.c_str());
+        SetValue(buf, _bestNuM2);
+        sprintf(buf, "bestNuEta%s", suffix.c_str());
+        SetValue(buf, _bestNuEta);
+        sprintf(buf, "bestNuPhi%s", suffix.c_str());
+        SetValue(buf, _bestNuPhi);
+    
+        sprintf(buf, "bestWlepPz%s", suffix.c_str());
+        SetValue(buf, _bestWlepPz);
+        sprintf(buf, "bestWlepPt%s", suffix.c_str());
+        SetValue(buf, _bestWlepPt);
+        sprintf(buf, "bestWlepE%s", suffix.c_str());
+        SetValue(buf, _bestWlepE);
+        sprintf(buf, "bestWlepM%s", suffix.c_str());
+        SetValue(buf, _bestWlepM);
+        sprintf(buf, "bestWlepEta%s", suffix.c_str());
+        SetValue(buf, _bestWlepEta);
+        sprintf(buf, "bestWlepPhi%s", suffix.c_str());
+        SetValue(buf, _bestWlepPhi);
+    
+        sprintf(buf, "bestWhadPz%s", suffix.c_str());
+        SetValue(buf, _bestWhadPz);
+        sprintf(buf, "bestWhadPt%s", suffix.c_str());
+        SetValue(buf, _bestWhadPt);
+        sprintf(buf, "bestWhadE%s", suffix.c_str());
+        SetValue(buf, _bestWhadE);
+        sprintf(buf, "bestWhadM%s", suffix.c_str());
+        SetValue(buf, _bestWhadM);
+        sprintf(buf, "bestWhadEta%s", suffix.c_str());
+        SetValue(buf, _bestWhadEta);
+        sprintf(buf, "bestWhadPhi%s", suffix.c_str());
+        SetValue(buf, _bestWhadPhi);
+    
+        sprintf(buf, "bestTlepPz%s", suffix.c_str());
+        SetValue(buf, _bestTlepPz);
+        sprintf(buf, "bestTlepPt%s", suffix.c_str());
+        SetValue(buf, _bestTlepPt);
+        sprintf(buf, "bestTlepE%s", suffix.c_str());
+        SetValue(buf, _bestTlepE);
+        sprintf(buf, "bestTlepM%s", suffix.c_str());
+        SetValue(buf, _bestTlepM);
+        sprintf(buf, "bestTlepEta%s", suffix.c_str());
+        SetValue(buf, _bestTlepEta);
+        sprintf(buf, "bestTlepPhi%s", suffix.c_str());
+        SetValue(buf, _bestTlepPhi);
+    
+        sprintf(buf, "bestThadPz%s", suffix.c_str());
+        SetValue(buf, _bestThadPz);
+        sprintf(buf, "bestThadPt%s", suffix.c_str());
+        SetValue(buf, _bestThadPt);
+        sprintf(buf, "bestThadE%s", suffix.c_str());
+        SetValue(buf, _bestThadE);
+        sprintf(buf, "bestThadM%s", suffix.c_str());
+        SetValue(buf, _bestThadM);
+        sprintf(buf, "bestThadEta%s", suffix.c_str());
+        SetValue(buf, _bestThadEta);
+        sprintf(buf, "bestThadPhi%s", suffix.c_str());
+        SetValue(buf, _bestThadPhi);
+    
+        sprintf(buf, "bestBlepPz%s", suffix.c_str());
+        SetValue(buf, _bestBlepPz);
+        sprintf(buf, "bestBlepPt%s", suffix.c_str());
+        SetValue(buf, _bestBlepPt);
+        sprintf(buf, "bestBlepE%s", suffix.c_str());
+        SetValue(buf, _bestBlepE);
+        sprintf(buf, "bestBlepEta%s", suffix.c_str());
+        SetValue(buf, _bestBlepEta);
+        sprintf(buf, "bestBlepPhi%s", suffix.c_str());
+        SetValue(buf, _bestBlepPhi);
+    
+        sprintf(buf, "bestBhadPz%s", suffix.c_str());
+        SetValue(buf, _bestBhadPz);
+        sprintf(buf, "bestBhadPt%s", suffix.c_str());
+        SetValue(buf, _bestBhadPt);
+        sprintf(buf, "bestBhadE%s", suffix.c_str());
+        SetValue(buf, _bestBhadE);
+        sprintf(buf, "bestBhadEta%s", suffix.c_str());
+        SetValue(buf, _bestBhadEta);
+        sprintf(buf, "bestBhadPhi%s", suffix.c_str());
+        SetValue(buf, _bestBhadPhi);
+    
+        sprintf(buf, "bestJet1Pz%s", suffix.c_str());
+        SetValue(buf, _bestJet1Pz);
+        sprintf(buf, "bestJet1Pt%s", suffix.c_str());
+        SetValue(buf, _bestJet1Pt);
+        sprintf(buf, "bestJet1E%s", suffix.c_str());
+        SetValue(buf, _bestJet1E);
+        sprintf(buf, "bestJet1Eta%s", suffix.c_str());
+        SetValue(buf, _bestJet1Eta);
+        sprintf(buf, "bestJet1Phi%s", suffix.c_str());
+        SetValue(buf, _bestJet1Phi);
+    
+        sprintf(buf, "bestJet2Pz%s", suffix.c_str());
+        SetValue(buf, _bestJet2Pz);
+        sprintf(buf, "bestJet2Pt%s", suffix.c_str());
+        SetValue(buf, _bestJet2Pt);
+        sprintf(buf, "bestJet2E%s", suffix.c_str());
+        SetValue(buf, _bestJet2E);
+        sprintf(buf, "bestJet2Eta%s", suffix.c_str());
+        SetValue(buf, _bestJet2Eta);
+        sprintf(buf, "bestJet2Phi%s", suffix.c_str());
+        SetValue(buf, _bestJet2Phi);
+    }
+    
+    return;
+}
+
+
+
+void StopCalc::SetHypothesisAngles(FourVector const & vLep,
+                                   FourVector const * vNeutrinos,
+                                   std::vector<FourVector> const & vJets,
+                                   std::vector<std::string> const & suffixes){
+    //
+    // decay angles of every hypothesis kept by the last Reconstruct,
+    // best first, each batch with its frame boosts set up once:
+    //   hypCosThetaStarLep  lepton against the reversed b(lep) direction
+    //                       in the leptonic W frame (W helicity)
+    //   hypCosThetaStarHad  first W jet against the W direction in the
+    //                       hadronic W frame
+    //   hypLepEStar, hypBEStar  lepton and b(lep) energies in the
+    //                       leptonic top frame
+    //
+    
+    std::vector<TtbarReconstructor::Hypothesis> const & _hyps = mReco.GetHypotheses();
+    size_t const _n = _hyps.size();
+    EventArena & arena = GetArena();
+    
+    ArenaVector<double> _chi2(arena);
+    ArenaVector<FourVector> _bLep(arena);
+    ArenaVector<FourVector> _jet1(arena);
+    ArenaVector<FourVector> _wHad(arena);
+    for (size_t i = 0; i != _n; ++i){
+        _chi2.push_back(_hyps[i].chi2);
+        _bLep.push_back(vJets[_hyps[i].bLep]);
+        _jet1.push_back(vJets[_hyps[i].jet1]);
+        _wHad.push_back(vJets[_hyps[i].jet1]+vJets[_hyps[i].jet2]);
+    }
+    
+    // leptonic W: the lepton and the frame are shared by all
+    // hypotheses with the same neutrino solution
+    ArenaVector<double> _cosLep(_n, -2.0, arena);
+    ArenaVector<FourVector> _bOfNu(arena);
+    ArenaVector<double> _cosOfNu(arena);
+    for (int nu = 0; nu != 2; ++nu){
+        _bOfNu.clear();
+        for (size_t i = 0; i != _n; ++i) if (_hyps[i].neutrino == nu) _bOfNu.push_back(_bLep[i]);
+        if (_bOfNu.empty()) continue;
+        _cosOfNu.resize(_bOfNu.size());
+        mAngleUtils.CosAngles(_bOfNu.data(), vLep, vLep+vNeutrinos[nu], _bOfNu.size(), _cosOfNu.data());
+        for (size_t i = 0, k = 0; i != _n; ++i){
+            if (_hyps[i].neutrino != nu) continue;
+            if (_cosOfNu[k] > -2.0) _cosLep[i] = -_cosOfNu[k];
+            ++k;
+        }
+    }
+    
+    // hadronic W
+    ArenaVector<double> _cosHad(_n, -2.0, arena);
+    if (_n > 0) mAngleUtils.HelicityCosines(_jet1.data(), _wHad.data(), _n, _cosHad.data());
+    
+    // leptonic top: lepton and b boosted together
+    ArenaVector<double> _lepEStar(arena);
+    ArenaVector<double> _bEStar(arena);
+    for (size_t i = 0; i != _n; ++i){
+        FourVector const _tLep = vLep+vNeutrinos[_hyps[i].neutrino]+_bLep[i];
+        FourVector const _objects[2] = {vLep, _bLep[i]};
+        FourVector _boosted[2];
+        mTopUtils.boost_new(_tLep.Px()/_tLep.E(), _tLep.Py()/_tLep.E(), _tLep.Pz()/_tLep.E(), _objects, _boosted, 2);
+        _lepEStar.push_back(_boosted[0].E());
+        _bEStar.push_back(_boosted[1].E());
+    }
+    
+    for (size_t s = 0; s != suffixes.size(); ++s){
+        std::string const & suffix = suffixes[s];
+        SetValue("hypChi2"+suffix, _chi2);
+        SetValue("hypCosThetaStarLep"+suffix, _cosLep);
+        SetValue("hypCosThetaStarHad"+suffix, _cosHad);
+        SetValue("hypLepEStar"+suffix, _lepEStar);
+        SetValue("hypBEStar"+suffix, _bEStar);
+    }
     
     return;
 }
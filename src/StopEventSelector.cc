@@ -31,6 +31,7 @@
 #include "DataFormats/PatCandidates/interface/TriggerObject.h"
 #include "FWCore/Common/interface/TriggerNames.h"
 #include "LJMet/Com/interface/BaseEventSelector.h"
+#include "LJMet/Com/interface/EtaPhiIndex.h"
 #include "LJMet/Com/interface/LjmetFactory.h"
 //#include "PhysicsTools/SelectorUtils/interface/PFElectronSelector.h"
 #include "LJMet/Com/interface/PFElectronSelector.h"
@@ -112,7 +113,7 @@ protected:
     edm::Ptr<pat::Electron> electron0_;
     edm::Ptr<pat::Electron> electron1_;
     
-    map<int,map<int,vector<int> > > mmvBadLaserCalEvents;
+    ConditionsCache::EventList mBadLaserCalEvents;
     
     
     
@@ -122,6 +123,9 @@ private:
     
     bool _mbIsMc;
     
+    // selected jets, for the muon-jet separation
+    EtaPhiIndex mSelJetEtaPhi;
+    
 };
 
 
@@ -343,33 +347,9 @@ void StopEventSelector::BeginJob( std::map<std::string, edm::ParameterSet const>
         
         std::cout << mLegend << "Will apply laser event filter" << std::endl;
         
-        //std::ifstream inFile("../data/badLaserCalFiltEvents.txt");
-        std::ifstream inFile("badLaserCalFiltEvents.txt");
-        string line,subString;
-        int begin,end;
-        int _events = 0;
-        while(inFile.good()){
-            getline(inFile,line);
-            begin=0;
-            end=line.find(":");
-            subString=line.substr(begin,end-begin);
-            int run=atoi(subString.c_str());
-            begin=end+1;
-            end=line.find(":",begin+1);
-            subString=line.substr(begin,end-begin);
-            int lumi=atoi(subString.c_str());
-            begin=end+1;
-            end=line.length();
-            subString=line.substr(begin,end-begin);
-            int event=atoi(subString.c_str());
-            
-            if(mmvBadLaserCalEvents.find(run)==mmvBadLaserCalEvents.end()) mmvBadLaserCalEvents[run]=map<int,vector<int> >();
-            if(mmvBadLaserCalEvents[run].find(lumi)==mmvBadLaserCalEvents[run].end()) mmvBadLaserCalEvents[run][lumi]=vector<int>();
-            mmvBadLaserCalEvents[run][lumi].push_back(event);
-            ++_events;
-        }
+        mBadLaserCalEvents = GetConditionsCache().GetEventList("badLaserCalFiltEvents.txt");
         
-        std::cout << mLegend << "Loaded " << _events << " laser events" << std::endl;
+        std::cout << mLegend << "Loaded " << mBadLaserCalEvents.GetSize() << " laser events" << std::endl;
         
     }
     
@@ -485,17 +465,8 @@ bool StopEventSelector::operator()( edm::EventBase const & event, pat::strbitset
         //_____ Laser Calibration Correction Filter____________
         //
         if ( considerCut("Laser calibration correction filter") ) {
-            bool passLaserCal=true;
             int runNo=event.id().run(), lumiNo=event.id().luminosityBlock(), eventNo=event.id().event();
-            if (mmvBadLaserCalEvents.find(runNo)!=mmvBadLaserCalEvents.end()){
-                if (mmvBadLaserCalEvents[runNo].find(lumiNo)!=mmvBadLaserCalEvents[runNo].end()){
-                    for (unsigned int i=0; i<mmvBadLaserCalEvents[runNo][lumiNo].size(); i++){
-                        if (eventNo==mmvBadLaserCalEvents[runNo][lumiNo][i]){
-                            passLaserCal=false;
-                        }
-                    }
-                }
-            }
+            bool passLaserCal = !mBadLaserCalEvents.Contains(runNo, lumiNo, eventNo);
             SetHistValue("laser_event", (double)(!passLaserCal));
             if(passLaserCal) passCut(ret, "Laser calibration correction filter");
         }
@@ -628,6 +599,12 @@ bool StopEventSelector::operator()( edm::EventBase const & event, pat::strbitset
             mvSelMuons.clear();
             mvLooseMuons.clear();
             
+            mSelJetEtaPhi.Clear();
+            for (size_t _ijet = 0; _ijet != mvSelJets.size(); ++_ijet){
+                mSelJetEtaPhi.Add(mvSelJets[_ijet]->eta(), mvSelJets[_ijet]->phi(), _ijet);
+            }
+            mSelJetEtaPhi.Build();
+            
             for ( std::vector<pat::Muon>::const_iterator _imu = mhMuons->begin();
                  _imu != mhMuons->end(); _imu++){
                 
@@ -652,13 +629,8 @@ bool StopEventSelector::operator()( edm::EventBase const & event, pat::strbitset
                     if ( fabs(_imu->eta())<mdPar["tight_muon_maxeta"] ){ }
                     else break;
                     
-                    // deltaR(mu,jet) cut
-                    double min_deltar = std::numeric_limits<double>::max();
-                    for (std::vector<edm::Ptr<pat::Jet> >::const_iterator _ijet = mvSelJets.begin();
-                         _ijet!=mvSelJets.end(); ++_ijet){
-                        min_deltar = std::min( min_deltar, (double)reco::deltaR(*_imu, *(*_ijet)) );
-                    }
-                    if ( min_deltar>0.3 ){ }
+                    // deltaR(mu,jet) cut: no selected jet within 0.3
+                    if ( mSelJetEtaPhi.Nearest(_imu->eta(), _imu->phi(), 0.3) < 0 ){ }
                     else break;
                     
                     // vertex-pv Z distance
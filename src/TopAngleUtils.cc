@@ -38,20 +38,23 @@ namespace top_cafe {
 				   const TMBLorentzVector & object2, 
 				   const TMBLorentzVector &frame1, 
 				   const TMBLorentzVector &frame2) 
+    {
+	return CosAngle(FourVector::FromLorentz(object1), FourVector::FromLorentz(object2),
+			FourVector::FromLorentz(frame1), FourVector::FromLorentz(frame2));
+    } // CosAngle
+
+    double TopAngleUtils::CosAngle(const FourVector &object1, 
+				   const FourVector &object2, 
+				   const FourVector &frame1, 
+				   const FourVector &frame2) 
     {
 	//
 	// Check input object1 and object2
 	if (!isValid(object1) || !isValid(object2))
 	    return -2.0;
-	//
-	// instantiate TopUtils
-	TopUtils utils;
-	// initialize
-	double cos_value;
-	TMBLorentzVector new_object1;
-	TMBLorentzVector new_object2;
-	new_object1 = object1;
-	new_object2 = object2;
+
+	FourVector new_object1 = object1;
+	FourVector new_object2 = object2;
 
 	// Check if frame1 is specified
 	// if, not, then it is the LAB, by default
@@ -59,21 +62,79 @@ namespace top_cafe {
 	    // check, if frame is same as object1
 	    // if not, boost it in the given frame
 	    if (object1 != frame1)
-		utils.boost_new(frame1.BoostVector(), object1, new_object1); 
+		new_object1 = object1.InRestFrameOf(frame1);
 	    // Check if frame2 is also specified
 	    if (isValid(frame2)) {
 		if (object2 != frame2)
-		    utils.boost_new(frame2.BoostVector(), object2, new_object2); 	
+		    new_object2 = object2.InRestFrameOf(frame2);
 	    } // if (isValid(frame2))
 	    else {  
 		if (object2 != frame1)
-		    utils.boost_new(frame1.BoostVector(), object2, new_object2); 
+		    new_object2 = object2.InRestFrameOf(frame1);
 	    } // if, not, then use frame1 for both object1 and object2, by default
 	} // if (isValid(frame1))
     
-	cos_value = TMath::Cos( new_object1.Angle( new_object2.Vect()) );
-	return cos_value;   
+	return new_object1.CosAngle(new_object2);
     } // CosAngle
+
+
+    void TopAngleUtils::CosAngles(const FourVector *object1,
+				  const FourVector *object2,
+				  const FourVector *frame,
+				  size_t n, double *cosines)
+    {
+	for (size_t i = 0; i != n; ++i) {
+	    if (!isValid(object1[i]) || !isValid(object2[i])) {
+		cosines[i] = -2.0;
+		continue;
+	    }
+	    if (!isValid(frame[i])) {
+		cosines[i] = object1[i].CosAngle(object2[i]);
+		continue;
+	    }
+	    const LorentzBoost boost = LorentzBoost::ToRestFrameOf(frame[i]);
+	    const FourVector new_object1 = (object1[i] != frame[i]) ? boost(object1[i]) : object1[i];
+	    const FourVector new_object2 = (object2[i] != frame[i]) ? boost(object2[i]) : object2[i];
+	    cosines[i] = new_object1.CosAngle(new_object2);
+	}
+    } // CosAngles
+
+    void TopAngleUtils::CosAngles(const FourVector *object1,
+				  const FourVector &object2,
+				  const FourVector &frame,
+				  size_t n, double *cosines)
+    {
+	if (!isValid(object2)) {
+	    for (size_t i = 0; i != n; ++i) cosines[i] = -2.0;
+	    return;
+	}
+	const bool boosted = isValid(frame);
+	const LorentzBoost boost = boosted ? LorentzBoost::ToRestFrameOf(frame) : LorentzBoost();
+	const FourVector new_object2 = (boosted && object2 != frame) ? boost(object2) : object2;
+	for (size_t i = 0; i != n; ++i) {
+	    if (!isValid(object1[i])) {
+		cosines[i] = -2.0;
+		continue;
+	    }
+	    const FourVector new_object1 = (boosted && object1[i] != frame) ? boost(object1[i]) : object1[i];
+	    cosines[i] = new_object1.CosAngle(new_object2);
+	}
+    } // CosAngles
+
+    void TopAngleUtils::HelicityCosines(const FourVector *daughter,
+					const FourVector *parent,
+					size_t n, double *cosines)
+    {
+	// the parent is the frame, so it stays in the lab
+	for (size_t i = 0; i != n; ++i) {
+	    if (!isValid(daughter[i]) || !isValid(parent[i])) {
+		cosines[i] = -2.0;
+		continue;
+	    }
+	    const FourVector new_daughter = (daughter[i] != parent[i]) ? LorentzBoost::ToRestFrameOf(parent[i])(daughter[i]) : daughter[i];
+	    cosines[i] = new_daughter.CosAngle(parent[i]);
+	}
+    } // HelicityCosines
   
   
 } // using namespace top_cafe
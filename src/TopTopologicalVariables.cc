@@ -16,6 +16,7 @@
 #include "TMatrixD.h"
 #include "TVectorD.h"
 #include "TRandom.h"
+#include "TMath.h"
 
 #include "LJMet/Com/interface/TopTopologicalVariables.h"
 #include "LJMet/Com/interface/AnglesUtil.h"
@@ -102,12 +103,13 @@ using namespace std;
     // for each _myobjects:
     for ( unsigned int k=0; k<_myobjects.size(); k++ ) {
       
+      double const p[3] = { _myobjects[k].Px(), _myobjects[k].Py(), _myobjects[k].Pz() };
       for ( int i=0; i<3; i++ ) // px, py, pz
 	for ( int j=0; j<3; j++ ) // px, py, pz
-	  MomentumTensor(i,j) += _myobjects[k][i]*_myobjects[k][j];
+	  MomentumTensor(i,j) += p[i]*p[j];
       
       // add the 3-momentum squared to the sum
-      p2_sum += _myobjects[k].Mag32();
+      p2_sum += _myobjects[k].P2();
     } // Loop over _myobjects
     
       // Divide the sums with the p2 sum
@@ -123,7 +125,7 @@ using namespace std;
   /// this method returns the  Pt of a group of objects
   double TopTopologicalVariables::Pt() const {
     // initialize
-    TMBLorentzVector Sum(0.0,0.0,0.0,0.0);
+    FourVector Sum;
     double pt;
     for (unsigned int i=0; i<_myobjects.size(); i++)
       Sum += _myobjects[i];
@@ -186,11 +188,11 @@ using namespace std;
     /// this method returns the invariant mass: sqrt(E^2 - ThreeVector{P}^2 )
     double TopTopologicalVariables::M() const {
       // initialize
-      TMBLorentzVector Sum(0,0,0,0);
+      FourVector Sum;
       for (unsigned int i=0; i<_myobjects.size(); i++)
 	Sum += _myobjects[i];
     
-      if ( Sum.E()*Sum.E() - Sum.Mag32() < 0 ) {
+      if ( Sum.M2() < 0 ) {
 	std::cout << "Error: Square of Invariant_mass is negative!" << std::endl;
 	return -1.0;
       }
@@ -308,7 +310,11 @@ using namespace std;
 
 	if (i==j) continue;
 
-	double cur = _myobjects[i].Pt(_myobjects[j]);
+	// momentum of i transverse to j
+	double const p2j = _myobjects[j].P2();
+	double const dot = _myobjects[i].Dot3(_myobjects[j]);
+	double const perp2 = p2j > 0 ? _myobjects[i].P2() - dot*dot/p2j : _myobjects[i].P2();
+	double cur = perp2 > 0 ? sqrt(perp2) : 0.0;
 	if (cur < ptmin) ptmin = cur;
       }
     }
@@ -323,14 +329,11 @@ using namespace std;
     if (_myobjects.size() <= 0) return -1;
       
     // initialize
-    TMBLorentzVector Sum(0,0,0,0);
+    FourVector Sum;
     for (unsigned int i=0; i<_myobjects.size(); i++)
       Sum += _myobjects[i];
       
-    TVector3 sumBoost (Sum.BoostVector());
-      
-    TMBLorentzVector lv (_myobjects[0]);
-    lv.Boost (-1 * sumBoost); // boost to Sum's rest frame
+    FourVector lv (_myobjects[0].InRestFrameOf(Sum)); // boost to Sum's rest frame
       
     return cos (lv.Theta());
   } // CosThetaStar()
@@ -343,14 +346,11 @@ using namespace std;
     if (_myobjects.size() <= 0) return -1;
       
     // initialize
-    TMBLorentzVector Sum(0,0,0,0);
+    FourVector Sum;
     for (unsigned int i=0; i<_myobjects.size(); i++)
       Sum += _myobjects[i];
       
-    TVector3 sumBoost (Sum.BoostVector());
-      
-    TMBLorentzVector lv (_myobjects[0]);
-    lv.Boost (0, 0, -sumBoost.Z()); // boost to Sum's rest frame, assuming no x&y boost
+    FourVector lv (_myobjects[0].Boosted (0, 0, -Sum.Pz()/Sum.E())); // boost to Sum's rest frame, assuming no x&y boost
       
     return cos (lv.Theta());
   } // CosThetaStar()
@@ -372,7 +372,7 @@ using namespace std;
     double minDr = 9999;
     for (unsigned int i=0; i<_myobjects.size()-1; ++i) {
       for (unsigned int j=i+1; j<_myobjects.size(); ++j) {
-	double curDr = _myobjects[i].DeltaR (_myobjects[j]);
+	double curDr = fourvector::DeltaR (_myobjects[i], _myobjects[j]);
 	if (curDr < minDr) minDr = curDr;
       }
     }
@@ -385,7 +385,7 @@ using namespace std;
     double maxDr = -1;
     for (unsigned int i=0; i<_myobjects.size()-1; ++i) {
       for (unsigned int j=i+1; j<_myobjects.size(); ++j) {
-	double curDr = _myobjects[i].DeltaR (_myobjects[j]);
+	double curDr = fourvector::DeltaR (_myobjects[i], _myobjects[j]);
 	if (curDr > maxDr) maxDr = curDr;
       }
     }
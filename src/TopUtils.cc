@@ -75,6 +75,24 @@ namespace top_cafe {
 	double pTrel2 = muon.Mag32() - pLrel2;
 	return (pTrel2 > 0)? sqrt(pTrel2): 0;
     }
+
+    void TopUtils::boost_new(double bx, double by, double bz, const FourVector &myobject, FourVector &myBoostedObject)
+    {
+	myBoostedObject = myobject.Boosted(-bx, -by, -bz);
+    }
+
+    void TopUtils::boost_new(double bx, double by, double bz, const FourVector *myobjects, FourVector *myBoostedObjects, size_t n)
+    {
+	fourvector::BoostAll(myobjects, myBoostedObjects, n, -bx, -by, -bz);
+    }
+
+    double TopUtils::PtRel(const FourVector &muon, const FourVector &jet) {
+	FourVector MuonJet = muon + jet;
+	double muonTimesMuonJet = muon.Dot3(MuonJet);
+	double pLrel2 = muonTimesMuonJet * muonTimesMuonJet / MuonJet.P2();
+	double pTrel2 = muon.P2() - pLrel2;
+	return (pTrel2 > 0)? sqrt(pTrel2): 0;
+    }
   
   
 } // namespace top_cafe 
@@ -55,6 +55,7 @@ public:
 
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
     virtual int EndJob(){return 0;}
+    virtual bool HasSideEffects() const { return false; }
 
   
 private:
@@ -867,11 +868,11 @@ int TprimeCalc::AnalyzeEvent(edm::EventBase const & event,
       double higgsWWSf = 1.22012;
       double higgsZZSf = 1.38307;
       
-      edm::Handle<reco::GenParticleCollection> genParticles;
-      event.getByLabel(genParticles_it, genParticles);
+      GenEventIndex const & genIndex = selector->GetGenEventIndex(event, genParticles_it);
+      reco::GenParticleCollection const & genParticles = *genIndex.GetCollection();
       // loop over all gen particles in event
-      for(size_t i = 0; i < genParticles->size(); i++){
-	const reco::GenParticle & p = (*genParticles).at(i);
+      for(size_t i = 0; i < genParticles.size(); i++){
+	const reco::GenParticle & p = genParticles[i];
 	int id = p.pdgId();
 	
 	
@@ -880,11 +881,12 @@ int TprimeCalc::AnalyzeEvent(edm::EventBase const & event,
 	  higgsMassGenerator = p.mass();
 	  std::cout<<higgsMassGenerator<<std::endl;
 	  int absDauIds = 0;
-	  size_t nDaughters = p.numberOfDaughters();
+	  int nDaughters = genIndex.NDaughters(i);
 	  // get all daughters
 	  //std::cout<<"number of daughters "<<nDaughters<<std::endl;
-	  for(size_t j = 0; j < nDaughters; ++ j) {
-	    int dauId = (p.daughter(j))->pdgId();
+	  for(int j = 0; j < nDaughters; ++ j) {
+	    int iDau = genIndex.Daughter(i, j);
+	    int dauId = iDau >= 0 ? genParticles[iDau].pdgId() : (p.daughter(j))->pdgId();
 	    absDauIds += abs(dauId);
 	    ///std::cout<<" daughid "<<dauId<<std::endl;
 	  }// daughters
@@ -942,17 +944,17 @@ int TprimeCalc::AnalyzeEvent(edm::EventBase const & event,
     bool isTTbar_ = false;
     if (isTTbar_){
       // scale factors used to scale BR of 120 GeV higgs -> 125 GeV higgs (i.e. BR(H125->XX)/BR(H120->XX))
-      edm::Handle<reco::GenParticleCollection> genParticles;
-      event.getByLabel(genParticles_it, genParticles);
+      GenEventIndex const & genIndex = selector->GetGenEventIndex(event, genParticles_it);
+      reco::GenParticleCollection const & genParticles = *genIndex.GetCollection();
       // loop over all gen particles in event
-      for(size_t i = 0; i < genParticles->size(); i++){
-	const reco::GenParticle & p = (*genParticles).at(i);
-	reco::Candidate* mother = (reco::Candidate*) p.mother();
+      for(size_t i = 0; i < genParticles.size(); i++){
+	const reco::GenParticle & p = genParticles[i];
+	int iMother = genIndex.Mother(i);
 	int id = p.pdgId();
 	
 	// find bottom (5)
-	if(abs(id) == 5 && p.status() == 3){
-	  int motherId = mother->pdgId();//(p.mother).pdgId();
+	if(abs(id) == 5 && p.status() == 3 && iMother >= 0){
+	  int motherId = genParticles[iMother].pdgId();
 	  if(abs(motherId) != 6){
 	    ttbarWeight += 1;
 	  }
@@ -0,0 +1,144 @@
+/*
+ Lepton+jets ttbar reconstruction with a pruned assignment search
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "LJMet/Com/interface/TtbarReconstructor.h"
+
+
+
+TtbarReconstructor::TtbarReconstructor():
+mMw(80.4),
+mMtop(172.5),
+mSigWhad(0.0),
+mSigThad(0.0),
+mSigTlep(0.0),
+mSigWlep(0.0),
+mMaxChi2(std::numeric_limits<double>::infinity()),
+mTopK(1),
+mNEvaluated(0){
+}
+
+
+
+void TtbarReconstructor::SetResolutions(double sigWhad, double sigThad, double sigTlep, double sigWlep){
+    mSigWhad = sigWhad;
+    mSigThad = sigThad;
+    mSigTlep = sigTlep;
+    mSigWlep = sigWlep;
+}
+
+
+
+double TtbarReconstructor::term(FourVector const & p4, double mass, double sigma) const{
+    if (sigma <= 0.0) return 0.0;
+    double const _m2 = p4.M2();
+    if (!(_m2 >= 0.0)) return std::numeric_limits<double>::infinity();
+    double const _pull = (std::sqrt(_m2) - mass)/sigma;
+    return _pull*_pull;
+}
+
+
+
+void TtbarReconstructor::insert(Hypothesis const & h){
+    // after any equal chi2, so the first one found wins ties
+    std::vector<Hypothesis>::iterator _pos = mvBest.begin();
+    while (_pos != mvBest.end() && _pos->chi2 <= h.chi2) ++_pos;
+    mvBest.insert(_pos, h);
+    if (mvBest.size() > mTopK) mvBest.pop_back();
+}
+
+
+
+void TtbarReconstructor::Reconstruct(FourVector const & lepton,
+                                     FourVector const * neutrinos, size_t nNeutrinos,
+                                     FourVector const * jets, int const * roles, size_t nJets){
+    mvBest.clear();
+    mNEvaluated = 0;
+
+    mvLight.clear();
+    mvB.clear();
+    for (size_t i = 0; i != nJets; ++i){
+        if (roles[i] & kLight) mvLight.push_back(i);
+        if (roles[i] & kB) mvB.push_back(i);
+    }
+    if (mvLight.size() < 2 || mvB.size() < 2 || nNeutrinos == 0) return;
+
+    //
+    // leptonic side, once per neutrino and b jet
+    //
+    double const _inf = std::numeric_limits<double>::infinity();
+    size_t const _nB = mvB.size();
+    mvLep.assign(nNeutrinos*_nB, _inf);
+    double _minLep = _inf;
+    for (size_t n = 0; n != nNeutrinos; ++n){
+        FourVector const _wLep = lepton + neutrinos[n];
+        double const _wTerm = term(_wLep, mMw, mSigWlep);
+        if (!(_wTerm < mMaxChi2)) continue;
+        for (size_t b = 0; b != _nB; ++b){
+            double const _lep = _wTerm + term(_wLep + jets[mvB[b]], mMtop, mSigTlep);
+            if (!(_lep < mMaxChi2)) continue;
+            mvLep[n*_nB+b] = _lep;
+            _minLep = std::min(_minLep, _lep);
+        }
+    }
+    if (!(_minLep < mMaxChi2)) return;
+
+    //
+    // hadronic W candidates, best first
+    //
+    mvPair.clear();
+    for (size_t a = 0; a != mvLight.size(); ++a){
+        for (size_t b = a+1; b != mvLight.size(); ++b){
+            WPair _pair;
+            _pair.jet1 = mvLight[a];
+            _pair.jet2 = mvLight[b];
+            _pair.p4 = jets[_pair.jet1] + jets[_pair.jet2];
+            _pair.chi2 = term(_pair.p4, mMw, mSigWhad);
+            if (_pair.chi2 + _minLep < mMaxChi2) mvPair.push_back(_pair);
+        }
+    }
+    std::sort(mvPair.begin(), mvPair.end());
+
+    //
+    // branch and bound: W pair, hadronic b, then neutrino and leptonic b
+    //
+    for (size_t p = 0; p != mvPair.size(); ++p){
+        WPair const & _pair = mvPair[p];
+        // the pairs are sorted, none of the rest can do better
+        if (!(_pair.chi2 + _minLep < bound())) break;
+
+        for (size_t bh = 0; bh != _nB; ++bh){
+            int const _bHad = mvB[bh];
+            if (_bHad == _pair.jet1 || _bHad == _pair.jet2) continue;
+
+            double const _had = _pair.chi2 + term(_pair.p4 + jets[_bHad], mMtop, mSigThad);
+            if (!(_had + _minLep < bound())) continue;
+
+            for (size_t n = 0; n != nNeutrinos; ++n){
+                for (size_t bl = 0; bl != _nB; ++bl){
+                    int const _bLep = mvB[bl];
+                    if (_bLep == _bHad || _bLep == _pair.jet1 || _bLep == _pair.jet2) continue;
+
+                    ++mNEvaluated;
+                    double const _chi2 = _had + mvLep[n*_nB+bl];
+                    if (!(_chi2 < bound())) continue;
+
+                    Hypothesis _h;
+                    _h.jet1 = _pair.jet1;
+                    _h.jet2 = _pair.jet2;
+                    _h.bHad = _bHad;
+                    _h.bLep = _bLep;
+                    _h.neutrino = n;
+                    _h.chi2 = _chi2;
+                    insert(_h);
+                }
+            }
+        }
+    }
+}
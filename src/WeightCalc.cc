@@ -0,0 +1,590 @@
+/*
+ Calculator for the event weights of all sources, through one WeightEngine
+
+ The providers listed in weightProviders are evaluated once per event
+ into the rows of the weight matrix, nominal weight then variations:
+
+   pileup    data/MC ratio of true interactions, one row entry per
+             data scenario in puScenarios, the first being nominal
+   topPt     product of exp(topPtA - topPtB*pt) over the tops;
+             variations none (1) and squared
+   bFrag     b fragmentation, ratio of the x_B distributions of
+             fragTargetFile and fragSourceFile; one variation per
+             file in fragVariationFiles
+   bSemiLep  semileptonic branching fraction of weakly decaying
+             B hadrons; one variation per nuDecayFractionVariations
+   bTag      scale factors of the selected jets, from the untagged
+             discriminator; variations bcUp, bcDown, lightUp, lightDown
+
+ Branches: weightNominal, weightMatrix (all rows one after the other)
+ and weightCombinations (nominal, every single variation if
+ singleVariations, then the combinations listed in weightCombinations).
+ The layout is printed at the start of the job.
+ */
+
+
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TH1F.h"
+#include "TVector2.h"
+
+#include "LJMet/Com/interface/BaseCalc.h"
+#include "LJMet/Com/interface/BaseEventSelector.h"
+#include "LJMet/Com/interface/LjmetFactory.h"
+#include "LJMet/Com/interface/LjmetEventContent.h"
+#include "LJMet/Com/interface/BtagHardcodedConditions.h"
+#include "LJMet/Com/interface/LabelIndexCache.h"
+#include "LJMet/Com/interface/PileupDistributions2012.h"
+#include "LJMet/Com/interface/WeightEngine.h"
+#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+#include "DataFormats/JetReco/interface/GenJet.h"
+#include "SimDataFormats/PileupSummaryInfo/interface/PileupSummaryInfo.h"
+
+
+
+class LjmetFactory;
+
+
+
+namespace {
+
+    bool isBHadron(int id){ return ((std::abs(id)/100)%10 == 5) || (std::abs(id) >= 5000 && std::abs(id) <= 5999); }
+    bool isNeutrino(int id){ return std::abs(id) == 12 || std::abs(id) == 14 || std::abs(id) == 16; }
+
+    std::string fileStem(std::string const & file){
+        size_t const _slash = file.find_last_of('/');
+        std::string _stem = _slash == std::string::npos ? file : file.substr(_slash + 1);
+        size_t const _dot = _stem.find_last_of('.');
+        if (_dot != std::string::npos) _stem.erase(_dot);
+        return _stem;
+    }
+
+
+
+    class PileupWeightProvider : public WeightProvider {
+        //
+        // flat data/MC tables of the 2012 pileup scenarios, as edm::LumiReWeighting
+        //
+
+    public:
+
+        PileupWeightProvider(edm::ParameterSet const & pset, std::string const & legend);
+
+        virtual size_t GetNVariations() const { return mvScenario.size() - 1; }
+        virtual std::string GetVariationName(size_t i) const { return mvScenario[i+1]; }
+        virtual void Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights);
+
+    private:
+
+        static WeightLookup lumiReWeighting(double const * mc, double const * data, int n);
+
+        edm::InputTag mPuInfoSrc;
+        std::vector<std::string> mvScenario;
+        std::vector<WeightLookup> mvLookup;
+    };
+
+
+
+    class TopPtWeightProvider : public WeightProvider {
+        //
+        // top pt reweighting, product over the tops
+        //
+
+    public:
+
+        TopPtWeightProvider(edm::ParameterSet const & pset);
+
+        virtual size_t GetNVariations() const { return 2; }
+        virtual std::string GetVariationName(size_t i) const { return i == 0 ? "none" : "squared"; }
+        virtual void Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights);
+
+    private:
+
+        edm::InputTag mGenParticlesSrc;
+        int mTopStatus;
+        double mA;
+        double mB;
+    };
+
+
+
+    class BFragmentationWeightProvider : public WeightProvider {
+        //
+        // x_B = pt(B hadron)/pt(gen jet) reweighting of weakly decaying B hadrons
+        //
+
+    public:
+
+        BFragmentationWeightProvider(edm::ParameterSet const & pset, std::string const & legend);
+
+        virtual size_t GetNVariations() const { return mvName.size(); }
+        virtual std::string GetVariationName(size_t i) const { return mvName[i]; }
+        virtual void Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights);
+
+    private:
+
+        static TH1F * readFragmentation(std::string const & file, std::string const & legend);
+        static WeightLookup ratio(TH1F const * source, TH1F const * target);
+
+        edm::InputTag mGenParticlesSrc;
+        edm::InputTag mGenJetsSrc;
+        std::vector<std::string> mvName;
+        std::vector<WeightLookup> mvLookup;     // nominal, then variations
+    };
+
+
+
+    class BSemiLeptonicWeightProvider : public WeightProvider {
+        //
+        // neutrino fraction of weakly decaying B hadrons
+        //
+
+    public:
+
+        BSemiLeptonicWeightProvider(edm::ParameterSet const & pset);
+
+        virtual size_t GetNVariations() const { return mvTarget.size() - 1; }
+        virtual std::string GetVariationName(size_t i) const;
+        virtual void Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights);
+
+    private:
+
+        edm::InputTag mGenParticlesSrc;
+        double mSource;
+        std::vector<double> mvTarget;           // nominal, then variations
+    };
+
+
+
+    class BTagWeightProvider : public WeightProvider {
+        //
+        // b-tag scale factors of the selected jets, tagged or not
+        //
+
+    public:
+
+        BTagWeightProvider(edm::ParameterSet const & pset);
+
+        virtual size_t GetNVariations() const { return 4; }
+        virtual std::string GetVariationName(size_t i) const;
+        virtual void Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights);
+
+    private:
+
+        static double factor(bool tagged, double sf, double eff){
+            if (tagged) return sf;
+            return eff < 1.0 ? (1.0 - sf*eff)/(1.0 - eff) : 1.0;
+        }
+
+        BtagHardcodedConditions mBtagCond;
+        std::string mOP;
+        LabelIndexCache mLabels;
+        int mSlot;
+        double mCut;
+    };
+
+
+
+    //
+    // weakly decaying B hadrons and whether a neutrino is among their daughters
+    //
+    void weakBHadrons(reco::GenParticleCollection const & genParticles,
+                      std::vector<reco::GenParticle const *> & hadrons, std::vector<bool> & hasNu){
+        hadrons.clear();
+        hasNu.clear();
+        for (size_t i = 0; i != genParticles.size(); ++i){
+            reco::GenParticle const & p = genParticles[i];
+            if (p.pt() == 0 || !isBHadron(p.pdgId())) continue;
+            bool _hasB = false;
+            bool _hasNu = false;
+            for (size_t j = 0; j != p.numberOfDaughters(); ++j){
+                int const _id = p.daughter(j)->pdgId();
+                if (isBHadron(_id)){
+                    _hasB = true;
+                    break;
+                }
+                if (isNeutrino(_id)) _hasNu = true;
+            }
+            if (_hasB) continue;
+            hadrons.push_back(&p);
+            hasNu.push_back(_hasNu);
+        }
+    }
+
+
+
+    PileupWeightProvider::PileupWeightProvider(edm::ParameterSet const & pset, std::string const & legend){
+        mPuInfoSrc = pset.getUntrackedParameter<edm::InputTag>("puInfoSrc", edm::InputTag("addPileupInfo"));
+
+        char const * _default[] = {"Oct2012", "2012ABC", "2012ABC735", "2012ABCD", "2012ABCD735"};
+        mvScenario = pset.getUntrackedParameter<std::vector<std::string> >("puScenarios", std::vector<std::string>(_default, _default + 5));
+
+        double const * _mc = PileupDistributions2012::MCDist_Summer2012_S10;
+        for (size_t i = 0; i != mvScenario.size(); ++i){
+            double const * _data = 0;
+            if (mvScenario[i] == "Oct2012")          _data = PileupDistributions2012::DataDist_Oct2012;
+            else if (mvScenario[i] == "2012ABC")     _data = PileupDistributions2012::DataDist_2012ABC;
+            else if (mvScenario[i] == "2012ABC735")  _data = PileupDistributions2012::DataDist_2012ABC735;
+            else if (mvScenario[i] == "2012ABCD")    _data = PileupDistributions2012::DataDist_2012ABCD;
+            else if (mvScenario[i] == "2012ABCD735") _data = PileupDistributions2012::DataDist_2012ABCD735;
+            else {
+                std::cout << legend << "unknown pileup scenario " << mvScenario[i] << std::endl;
+                std::exit(-1);
+            }
+            mvLookup.push_back(lumiReWeighting(_mc, _data, 60));
+        }
+        if (mvScenario.empty()){
+            std::cout << legend << "no pileup scenario given" << std::endl;
+            std::exit(-1);
+        }
+    }
+
+
+
+    WeightLookup PileupWeightProvider::lumiReWeighting(double const * mc, double const * data, int n){
+        //
+        // same float contents as the TH1F of edm::LumiReWeighting: each
+        // distribution normalised unless it already is to 2%, then divided
+        //
+        std::vector<float> _mc(mc, mc + n), _data(data, data + n);
+        double _mcIntegral = 0.0, _dataIntegral = 0.0;
+        for (int i = 0; i != n; ++i){
+            _mcIntegral += _mc[i];
+            _dataIntegral += _data[i];
+        }
+        if (std::fabs(1.0 - float(_dataIntegral)) > 0.02){
+            double const _scale = 1.0/_dataIntegral;
+            for (int i = 0; i != n; ++i) _data[i] = _scale*_data[i];
+        }
+        if (std::fabs(1.0 - float(_mcIntegral)) > 0.02){
+            double const _scale = 1.0/_mcIntegral;
+            for (int i = 0; i != n; ++i) _mc[i] = _scale*_mc[i];
+        }
+
+        std::vector<double> _values(n + 2, 0.0);
+        for (int i = 0; i != n; ++i) _values[i+1] = _mc[i] != 0.0f ? float(double(_data[i])/double(_mc[i])) : 0.0f;
+        return WeightLookup(n, -0.5, float(n) - 0.5, _values);
+    }
+
+
+
+    void PileupWeightProvider::Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights){
+        for (size_t i = 0; i != mvLookup.size(); ++i) weights[i] = 1.0;
+        if (!selector->IsMc()) return;
+
+        edm::Handle<std::vector<PileupSummaryInfo> > hvPuInfo;
+        event.getByLabel(mPuInfoSrc, hvPuInfo);
+        for (std::vector<PileupSummaryInfo>::const_iterator iPu = hvPuInfo->begin(); iPu != hvPuInfo->end(); ++iPu){
+            if (iPu->getBunchCrossing() != 0) continue;
+            float const _nTrue = iPu->getTrueNumInteractions();
+            for (size_t i = 0; i != mvLookup.size(); ++i) weights[i] = mvLookup[i](_nTrue);
+            break;
+        }
+    }
+
+
+
+    TopPtWeightProvider::TopPtWeightProvider(edm::ParameterSet const & pset){
+        mGenParticlesSrc = pset.getUntrackedParameter<edm::InputTag>("genParticles", edm::InputTag("genParticles"));
+        mTopStatus = pset.getUntrackedParameter<int>("topStatus", 3);
+        mA = pset.getUntrackedParameter<double>("topPtA", 0.148);
+        mB = pset.getUntrackedParameter<double>("topPtB", 0.00129);
+    }
+
+
+
+    void TopPtWeightProvider::Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights){
+        double _weight = 1.0;
+        if (selector->IsMc()){
+            edm::Handle<reco::GenParticleCollection> genParticles;
+            event.getByLabel(mGenParticlesSrc, genParticles);
+            for (reco::GenParticleCollection::const_iterator t = genParticles->begin(); t != genParticles->end(); ++t){
+                if (std::abs(t->pdgId()) == 6 && t->status() == mTopStatus) _weight *= std::exp(mA - mB*t->pt());
+            }
+        }
+        weights[0] = _weight;
+        weights[1] = 1.0;
+        weights[2] = _weight*_weight;
+    }
+
+
+
+    BFragmentationWeightProvider::BFragmentationWeightProvider(edm::ParameterSet const & pset, std::string const & legend){
+        mGenParticlesSrc = pset.getUntrackedParameter<edm::InputTag>("genParticles", edm::InputTag("genParticles"));
+        mGenJetsSrc = pset.getUntrackedParameter<edm::InputTag>("genJets", edm::InputTag("selectedPatJetsPFlow", "genJets"));
+
+        std::string const _sourceFile = pset.getParameter<std::string>("fragSourceFile");
+        std::vector<std::string> _targetFiles(1, pset.getParameter<std::string>("fragTargetFile"));
+        std::vector<std::string> const _variationFiles = pset.getUntrackedParameter<std::vector<std::string> >("fragVariationFiles", std::vector<std::string>());
+        _targetFiles.insert(_targetFiles.end(), _variationFiles.begin(), _variationFiles.end());
+        for (size_t i = 0; i != _variationFiles.size(); ++i) mvName.push_back(fileStem(_variationFiles[i]));
+
+        TH1F * _source = readFragmentation(_sourceFile, legend);
+        for (size_t i = 0; i != _targetFiles.size(); ++i){
+            TH1F * _target = readFragmentation(_targetFiles[i], legend);
+            if (_source->GetNbinsX() != _target->GetNbinsX()){
+                std::cout << legend << "Incompatible b-fragmentation histograms: Number of bins not equal" << std::endl;
+            }
+            mvLookup.push_back(ratio(_source, _target));
+            delete _target;
+        }
+        delete _source;
+    }
+
+
+
+    TH1F * BFragmentationWeightProvider::readFragmentation(std::string const & file, std::string const & legend){
+        TH1::AddDirectory(kFALSE);
+        TFile _file(file.c_str(), "READ");
+        TH1F * _hist = _file.IsOpen() ? dynamic_cast<TH1F *>(_file.Get("EventWeightBJES/genBHadronPtFraction")) : 0;
+        if (!_hist){
+            std::cout << legend << "no EventWeightBJES/genBHadronPtFraction in " << file << std::endl;
+            std::exit(-1);
+        }
+        _hist = static_cast<TH1F *>(_hist->Clone());
+        _hist->Scale(1./_hist->Integral());
+        return _hist;
+    }
+
+
+
+    WeightLookup BFragmentationWeightProvider::ratio(TH1F const * source, TH1F const * target){
+        // the TH1F division of TopEventReweightCalc, kept as a flat table
+        TH1F * _weight = static_cast<TH1F *>(target->Clone());
+        _weight->Divide(source);
+
+        int const _n = _weight->GetNbinsX();
+        TAxis const * _axis = _weight->GetXaxis();
+        std::vector<double> _values(_n + 2);
+        for (int i = 0; i != _n + 2; ++i) _values[i] = _weight->GetBinContent(i);
+        std::vector<double> _edges;
+        if (_axis->IsVariableBinSize()){
+            for (int i = 1; i != _n + 2; ++i) _edges.push_back(_axis->GetBinLowEdge(i));
+        }
+        WeightLookup const _lookup = _edges.empty() ?
+            WeightLookup(_n, _axis->GetXmin(), _axis->GetXmax(), _values) :
+            WeightLookup(_edges, _values);
+        delete _weight;
+        return _lookup;
+    }
+
+
+
+    void BFragmentationWeightProvider::Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights){
+        for (size_t i = 0; i != mvLookup.size(); ++i) weights[i] = 1.0;
+        if (!selector->IsMc()) return;
+
+        edm::Handle<reco::GenParticleCollection> genParticles;
+        event.getByLabel(mGenParticlesSrc, genParticles);
+        edm::Handle<std::vector<reco::GenJet> > genJets;
+        event.getByLabel(mGenJetsSrc, genJets);
+
+        std::vector<reco::GenParticle const *> _hadrons;
+        std::vector<bool> _hasNu;
+        weakBHadrons(*genParticles, _hadrons, _hasNu);
+        for (size_t h = 0; h != _hadrons.size(); ++h){
+            reco::GenParticle const & p = *_hadrons[h];
+            for (std::vector<reco::GenJet>::const_iterator ijet = genJets->begin(); ijet != genJets->end(); ++ijet){
+                if (ijet->pt() == 0) continue;
+                double const deta = p.eta() - ijet->eta();
+                double const dphi = TVector2::Phi_mpi_pi(p.phi() - ijet->phi());
+                if (std::sqrt(deta*deta + dphi*dphi) >= 0.5) continue;
+
+                // the first jet within 0.5 only
+                double const xb = p.pt()/ijet->pt();
+                if (xb < 2.){
+                    for (size_t i = 0; i != mvLookup.size(); ++i) weights[i] *= mvLookup[i](xb);
+                }
+                break;
+            }
+        }
+    }
+
+
+
+    BSemiLeptonicWeightProvider::BSemiLeptonicWeightProvider(edm::ParameterSet const & pset){
+        mGenParticlesSrc = pset.getUntrackedParameter<edm::InputTag>("genParticles", edm::InputTag("genParticles"));
+        mSource = pset.getUntrackedParameter<double>("nuDecayFractionSource", 0.25);
+        mvTarget.push_back(pset.getUntrackedParameter<double>("nuDecayFractionTarget", 0.239));
+        std::vector<double> const _variations = pset.getUntrackedParameter<std::vector<double> >("nuDecayFractionVariations", std::vector<double>());
+        mvTarget.insert(mvTarget.end(), _variations.begin(), _variations.end());
+    }
+
+
+
+    std::string BSemiLeptonicWeightProvider::GetVariationName(size_t i) const {
+        std::ostringstream _name;
+        _name << "nuFraction" << mvTarget[i+1];
+        return _name.str();
+    }
+
+
+
+    void BSemiLeptonicWeightProvider::Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights){
+        for (size_t i = 0; i != mvTarget.size(); ++i) weights[i] = 1.0;
+        if (!selector->IsMc()) return;
+
+        edm::Handle<reco::GenParticleCollection> genParticles;
+        event.getByLabel(mGenParticlesSrc, genParticles);
+
+        std::vector<reco::GenParticle const *> _hadrons;
+        std::vector<bool> _hasNu;
+        weakBHadrons(*genParticles, _hadrons, _hasNu);
+        for (size_t h = 0; h != _hadrons.size(); ++h){
+            for (size_t i = 0; i != mvTarget.size(); ++i){
+                weights[i] *= _hasNu[h] ? mvTarget[i]/mSource : (1.-mvTarget[i])/(1.-mSource);
+            }
+        }
+    }
+
+
+
+    BTagWeightProvider::BTagWeightProvider(edm::ParameterSet const & pset){
+        mOP = pset.getUntrackedParameter<std::string>("btagOP", "CSVM");
+        mSlot = mLabels.Add(mBtagCond.getAlgoName(mOP));
+        mCut = mBtagCond.getDiscriminant(mOP);
+    }
+
+
+
+    std::string BTagWeightProvider::GetVariationName(size_t i) const {
+        char const * _names[] = {"bcUp", "bcDown", "lightUp", "lightDown"};
+        return _names[i];
+    }
+
+
+
+    void BTagWeightProvider::Evaluate(edm::EventBase const & event, BaseEventSelector * selector, double * weights){
+        for (size_t i = 0; i != 5; ++i) weights[i] = 1.0;
+        if (!selector->IsMc()) return;
+
+        // corrected jets are those of the selection if it kept them, in the same order
+        std::vector<edm::Ptr<pat::Jet> > const & vSelJets = selector->GetSelectedJets();
+        std::vector<std::pair<TLorentzVector, bool> > const & vCorrJets = selector->GetCorrJetsWithBTags();
+        bool const _haveCorr = vCorrJets.size() == vSelJets.size();
+
+        for (size_t j = 0; j != vSelJets.size(); ++j){
+            pat::Jet const & jet = *vSelJets[j];
+            TLorentzVector const lvjet = _haveCorr ? vCorrJets[j].first : selector->correctJet(jet, event);
+            double const _et = lvjet.Et();
+            double const _eta = lvjet.Eta();
+            bool const _tagged = mLabels.BDiscriminator(jet, mSlot) > mCut;
+            int const _flavor = std::abs(jet.partonFlavour());
+
+            if (_flavor == 5 || _flavor == 4){
+                double const _sf = mBtagCond.GetBtagScaleFactor(_et, _eta, mOP);
+                double const _eff = mBtagCond.GetBtagEfficiency(_et, _eta, mOP);
+                double const _scale = _flavor == 4 ? 2 : 1;
+                double const _nominal = factor(_tagged, _sf, _eff);
+                weights[0] *= _nominal;
+                weights[1] *= factor(_tagged, _sf + _scale*mBtagCond.GetBtagSFUncertUp(_et, _eta, mOP), _eff);
+                weights[2] *= factor(_tagged, _sf - _scale*mBtagCond.GetBtagSFUncertDown(_et, _eta, mOP), _eff);
+                weights[3] *= _nominal;
+                weights[4] *= _nominal;
+            }
+            else {
+                double const _sf = mBtagCond.GetMistagScaleFactor(_et, _eta, mOP);
+                double const _eff = mBtagCond.GetMistagRate(_et, _eta, mOP);
+                double const _nominal = factor(_tagged, _sf, _eff);
+                weights[0] *= _nominal;
+                weights[1] *= _nominal;
+                weights[2] *= _nominal;
+                weights[3] *= factor(_tagged, _sf + mBtagCond.GetMistagSFUncertUp(_et, _eta, mOP), _eff);
+                weights[4] *= factor(_tagged, _sf - mBtagCond.GetMistagSFUncertDown(_et, _eta, mOP), _eff);
+            }
+        }
+    }
+}
+
+
+
+class WeightCalc : public BaseCalc{
+
+public:
+
+    WeightCalc();
+    virtual ~WeightCalc();
+
+    virtual int BeginJob();
+    virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
+    virtual int EndJob(){ return 0; }
+
+
+private:
+
+    WeightEngine mEngine;
+    std::vector<WeightProvider *> mvProvider;
+};
+
+
+
+//static int reg = LjmetFactory::GetInstance()->Register(new WeightCalc(), "WeightCalc");
+
+
+
+WeightCalc::WeightCalc(){
+}
+
+
+
+WeightCalc::~WeightCalc(){
+    for (size_t i = 0; i != mvProvider.size(); ++i) delete mvProvider[i];
+}
+
+
+
+int WeightCalc::BeginJob(){
+
+    std::vector<std::string> const _providers = mPset.getUntrackedParameter<std::vector<std::string> >("weightProviders", std::vector<std::string>(1, "pileup"));
+    for (size_t i = 0; i != _providers.size(); ++i){
+        WeightProvider * _provider = 0;
+        if (_providers[i] == "pileup")        _provider = new PileupWeightProvider(mPset, mLegend);
+        else if (_providers[i] == "topPt")    _provider = new TopPtWeightProvider(mPset);
+        else if (_providers[i] == "bFrag")    _provider = new BFragmentationWeightProvider(mPset, mLegend);
+        else if (_providers[i] == "bSemiLep") _provider = new BSemiLeptonicWeightProvider(mPset);
+        else if (_providers[i] == "bTag")     _provider = new BTagWeightProvider(mPset);
+        else {
+            std::cout << mLegend << "unknown weight provider " << _providers[i] << std::endl;
+            std::exit(-1);
+        }
+        mvProvider.push_back(_provider);
+        mEngine.Register(_providers[i], _provider);
+    }
+
+    if (mPset.getUntrackedParameter<bool>("singleVariations", true)) mEngine.AddSingleVariations();
+    std::vector<std::string> const _combinations = mPset.getUntrackedParameter<std::vector<std::string> >("weightCombinations", std::vector<std::string>());
+    for (size_t i = 0; i != _combinations.size(); ++i){
+        if (!mEngine.AddCombination(_combinations[i])){
+            std::cout << mLegend << mEngine.GetError() << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    std::cout << mLegend << mEngine.Describe() << std::endl;
+
+    return 0;
+}
+
+
+
+int WeightCalc::AnalyzeEvent(edm::EventBase const & event,
+                             BaseEventSelector * selector){
+    //
+    // all providers once, then the products of the combinations
+    //
+
+    mEngine.Evaluate(event, selector);
+
+    SetValue("weightNominal", mEngine.GetNominal());
+    SetValue("weightMatrix", mEngine.GetMatrix());
+    SetValue("weightCombinations", mEngine.GetCombinations());
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ Event weights from several providers, with products for combinations of variations
+ */
+
+
+
+#include <algorithm>
+#include <sstream>
+
+#include "LJMet/Com/interface/WeightEngine.h"
+
+
+
+WeightLookup::WeightLookup(int nBins, double low, double high, std::vector<double> const & values):
+mNBins(nBins),
+mLow(low),
+mHigh(high),
+mvValue(values){
+    mvValue.resize(nBins + 2, 0.0);
+}
+
+
+
+WeightLookup::WeightLookup(std::vector<double> const & edges, std::vector<double> const & values):
+mNBins(edges.empty() ? 0 : edges.size() - 1),
+mLow(edges.empty() ? 0.0 : edges.front()),
+mHigh(edges.empty() ? 0.0 : edges.back()),
+mvEdge(edges),
+mvValue(values){
+    mvValue.resize(mNBins + 2, 0.0);
+}
+
+
+
+int WeightLookup::FindBin(double x) const {
+    if (x < mLow) return 0;
+    if (!(x < mHigh)) return mNBins + 1;
+    if (mvEdge.empty()) return 1 + int(mNBins*(x - mLow)/(mHigh - mLow));
+    return std::upper_bound(mvEdge.begin(), mvEdge.end(), x) - mvEdge.begin();
+}
+
+
+
+void WeightEngine::Register(std::string const & name, WeightProvider * provider){
+    Provider _provider;
+    _provider.name = name;
+    _provider.provider = provider;
+    _provider.row = mvMatrix.size();
+    for (size_t i = 0; i != provider->GetNVariations(); ++i) _provider.vVariation.push_back(provider->GetVariationName(i));
+    mvProvider.push_back(_provider);
+    mvMatrix.resize(mvMatrix.size() + 1 + _provider.vVariation.size(), 1.0);
+
+    // the nominal combination always comes first, the new provider is
+    // nominal in the combinations set up before
+    if (mvCombinationName.empty()) addCombination("nominal", std::vector<size_t>(1, _provider.row));
+    else {
+        std::vector<size_t> _columns(mvColumn.begin(), mvColumn.end());
+        mvColumn.clear();
+        size_t const _nOld = mvProvider.size() - 1;
+        for (size_t c = 0; c != mvCombinationName.size(); ++c){
+            mvColumn.insert(mvColumn.end(), _columns.begin() + c*_nOld, _columns.begin() + (c + 1)*_nOld);
+            mvColumn.push_back(_provider.row);
+        }
+    }
+}
+
+
+
+void WeightEngine::addCombination(std::string const & name, std::vector<size_t> const & columns){
+    mvCombinationName.push_back(name);
+    mvColumn.insert(mvColumn.end(), columns.begin(), columns.end());
+    mvCombination.resize(mvCombinationName.size(), 1.0);
+}
+
+
+
+void WeightEngine::AddSingleVariations(){
+    for (size_t p = 0; p != mvProvider.size(); ++p){
+        for (size_t v = 0; v != mvProvider[p].vVariation.size(); ++v){
+            std::vector<size_t> _columns;
+            for (size_t i = 0; i != mvProvider.size(); ++i) _columns.push_back(mvProvider[i].row);
+            _columns[p] = mvProvider[p].row + 1 + v;
+            addCombination(mvProvider[p].name + ":" + mvProvider[p].vVariation[v], _columns);
+        }
+    }
+}
+
+
+
+bool WeightEngine::AddCombination(std::string const & spec){
+    std::vector<size_t> _columns;
+    for (size_t i = 0; i != mvProvider.size(); ++i) _columns.push_back(mvProvider[i].row);
+
+    std::istringstream _in(spec);
+    std::string _item;
+    while (std::getline(_in, _item, ',')){
+        size_t const _colon = _item.find(':');
+        std::string const _name = _item.substr(0, _colon);
+        std::string const _variation = _colon == std::string::npos ? "" : _item.substr(_colon + 1);
+        size_t p = 0;
+        while (p != mvProvider.size() && mvProvider[p].name != _name) ++p;
+        if (p == mvProvider.size()){
+            mError += "unknown weight provider " + _name + " in " + spec + "\n";
+            return false;
+        }
+        std::vector<std::string> const & _names = mvProvider[p].vVariation;
+        size_t const v = std::find(_names.begin(), _names.end(), _variation) - _names.begin();
+        if (v == _names.size()){
+            mError += "unknown variation " + _variation + " of " + _name + " in " + spec + "\n";
+            return false;
+        }
+        _columns[p] = mvProvider[p].row + 1 + v;
+    }
+    addCombination(spec, _columns);
+    return true;
+}
+
+
+
+std::string WeightEngine::Describe() const {
+    std::ostringstream _out;
+    _out << "weight matrix:";
+    for (size_t p = 0; p != mvProvider.size(); ++p){
+        _out << " [" << mvProvider[p].row << "] " << mvProvider[p].name;
+        for (size_t v = 0; v != mvProvider[p].vVariation.size(); ++v) _out << " [" << mvProvider[p].row + 1 + v << "] " << mvProvider[p].vVariation[v];
+    }
+    _out << "\nweight combinations:";
+    for (size_t c = 0; c != mvCombinationName.size(); ++c) _out << " [" << c << "] " << mvCombinationName[c];
+    return _out.str();
+}
+
+
+
+void WeightEngine::Evaluate(edm::EventBase const & event, BaseEventSelector * selector){
+    for (size_t p = 0; p != mvProvider.size(); ++p){
+        mvProvider[p].provider->Evaluate(event, selector, &mvMatrix[mvProvider[p].row]);
+    }
+
+    // one row of matrix positions per combination
+    size_t const _nProviders = mvProvider.size();
+    double const * const _matrix = mvMatrix.empty() ? 0 : &mvMatrix[0];
+    size_t const * _column = mvColumn.empty() ? 0 : &mvColumn[0];
+    for (size_t c = 0; c != mvCombination.size(); ++c, _column += _nProviders){
+        double _weight = 1.0;
+        for (size_t p = 0; p != _nProviders; ++p) _weight *= _matrix[_column[p]];
+        mvCombination[c] = _weight;
+    }
+}
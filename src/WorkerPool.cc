@@ -0,0 +1,94 @@
+/*
+ Fixed set of threads for running the independent tasks of one event
+ */
+
+
+
+#include "LJMet/Com/interface/WorkerPool.h"
+
+
+
+WorkerPool::WorkerPool(size_t nWorkers):
+mpTask(0),
+mNTasks(0),
+mNext(0),
+mGeneration(0),
+mNBusy(0),
+mStop(false){
+    for (size_t i = 1; i < nWorkers; ++i){
+        mvThread.push_back(std::thread(&WorkerPool::workerLoop, this, i));
+    }
+}
+
+
+
+WorkerPool::~WorkerPool(){
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mStartCond.notify_all();
+    for (size_t i = 0; i != mvThread.size(); ++i) mvThread[i].join();
+}
+
+
+
+void WorkerPool::work(size_t worker){
+    while (true){
+        size_t const _i = mNext.fetch_add(1);
+        if (_i >= mNTasks) break;
+        (*mpTask)(_i, worker);
+    }
+}
+
+
+
+void WorkerPool::Run(size_t nTasks, Task const & task){
+    if (nTasks == 0) return;
+
+    // nothing to share, skip the synchronisation
+    if (mvThread.empty() || nTasks == 1){
+        for (size_t i = 0; i != nTasks; ++i) task(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mpTask = &task;
+        mNTasks = nTasks;
+        mNext = 0;
+        mNBusy = mvThread.size();
+        ++mGeneration;
+    }
+    mStartCond.notify_all();
+
+    work(0);
+
+    // the task must stay alive until every thread has let go of it
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (mNBusy != 0) mDoneCond.wait(lock);
+    mpTask = 0;
+}
+
+
+
+void WorkerPool::workerLoop(size_t worker){
+    unsigned long _seen = 0;
+    while (true){
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (!mStop && mGeneration == _seen) mStartCond.wait(lock);
+            if (mStop) return;
+            _seen = mGeneration;
+        }
+
+        work(worker);
+
+        bool _last = false;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            _last = (--mNBusy == 0);
+        }
+        if (_last) mDoneCond.notify_one();
+    }
+}
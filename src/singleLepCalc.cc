@@ -10,6 +10,8 @@
 #include "LJMet/Com/interface/BaseCalc.h"
 #include "LJMet/Com/interface/LjmetFactory.h"
 #include "LJMet/Com/interface/LjmetEventContent.h"
+#include "LJMet/Com/interface/EtaPhiIndex.h"
+#include "LJMet/Com/interface/LabelIndexCache.h"
 #include "TLorentzVector.h"
 
 #include "DataFormats/HLTReco/interface/TriggerEvent.h"
@@ -34,6 +36,7 @@ public:
     virtual int BeginJob();
     virtual int AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector);
     virtual int EndJob(){return 0;};
+    virtual bool HasSideEffects() const { return false; }
     
 private:
     edm::InputTag rhoSrc_;
@@ -48,6 +51,7 @@ private:
     edm::InputTag             triggerCollection_;
     edm::InputTag             pvCollection_it;
     edm::InputTag             genParticles_it;
+    edm::InputTag             genPackedParticles_it;
     std::vector<unsigned int> keepPDGID;
     std::vector<unsigned int> keepMomPDGID;
     bool keepFullMChistory;
@@ -56,16 +60,27 @@ private:
 
     std::vector<reco::Vertex> goodPVs;
     int findMatch(const reco::GenParticleCollection & genParticles, int idToMatch, double eta, double phi);
+    // eta-phi index of the gen particles, built on the first match in an event
+    EtaPhiIndex genEtaPhi;
+    reco::GenParticleCollection const * genEtaPhiSource;
+    // discriminator position in the AK8 jet label list
+    LabelIndexCache ak8Labels;
+    int ak8CsvSlot;
     double mdeltaR(double eta1, double phi1, double eta2, double phi2);
-    void fillMotherInfo(const reco::Candidate *mother, int i, vector <int> & momid, vector <int> & momstatus, vector<double> & mompt, vector<double> & mometa, vector<double> & momphi, vector<double> & momenergy);
+    /// Top decay chain whose W gave the gen lepton iGen, or -1
+    int findTopChain(GenEventIndex const & genIndex, int iGen);
+    /// Up to 11 generations of first mothers of the gen particle iGen
+    void fillMotherInfo(GenEventIndex const & genIndex, int iGen, ArenaVector<int> & momid, ArenaVector<int> & momstatus, ArenaVector<double> & mompt, ArenaVector<double> & mometa, ArenaVector<double> & momphi, ArenaVector<double> & momenergy);
 
 
 };
 
 static int reg = LjmetFactory::GetInstance()->Register(new singleLepCalc(), "singleLepCalc");
 
-singleLepCalc::singleLepCalc()
+singleLepCalc::singleLepCalc():
+genEtaPhiSource(0)
 {
+    ak8CsvSlot = ak8Labels.Add("combinedInclusiveSecondaryVertexV2BJetTags");
 }
 
 singleLepCalc::~singleLepCalc()
@@ -104,6 +119,10 @@ int singleLepCalc::BeginJob()
     if (mPset.exists("genParticles")) genParticles_it = mPset.getParameter<edm::InputTag>("genParticles");
     else                              genParticles_it = edm::InputTag("prunedGenParticles");
 
+    // packed gen particles give the final-state leptons of the top decays; empty: pruned only
+    if (mPset.exists("genPackedParticles")) genPackedParticles_it = mPset.getParameter<edm::InputTag>("genPackedParticles");
+    else                                    genPackedParticles_it = edm::InputTag();
+
     if (mPset.exists("keepPDGID"))    keepPDGID = mPset.getParameter<std::vector<unsigned int> >("keepPDGID");
     else                              keepPDGID.clear();
 
@@ -118,7 +137,13 @@ int singleLepCalc::BeginJob()
 }
 
 int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector * selector)
-{     // ----- Get objects from the selector -----
+{
+    // output vectors live in the event scratch memory
+    EventArena & arena = GetArena();
+    
+    genEtaPhiSource = 0;
+
+    // ----- Get objects from the selector -----
     std::vector<edm::Ptr<pat::Jet> >            const & vSelJets = selector->GetSelectedJets();
     std::vector<edm::Ptr<pat::Jet> >            const & vSelBtagJets = selector->GetSelectedBtagJets();
     std::vector<edm::Ptr<pat::Jet> >            const & vAllJets = selector->GetAllJets();
@@ -173,49 +198,50 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
    
     
     
-    std::vector <int> muCharge;
-    std::vector <int> muGlobal;
+    ArenaVector<int> muCharge(arena);
+    ArenaVector<int> muGlobal(arena);
     //Four vector
-    std::vector <double> muPt;
-    std::vector <double> muEta;
-    std::vector <double> muPhi;
-    std::vector <double> muEnergy;
+    ArenaVector<double> muPt(arena);
+    ArenaVector<double> muEta(arena);
+    ArenaVector<double> muPhi(arena);
+    ArenaVector<double> muEnergy(arena);
     //Quality criteria
-    std::vector <double> muChi2;
-    std::vector <double> muDxy;
-    std::vector <double> muDz;
-    std::vector <double> muRelIso;
-
-    std::vector <int> muNValMuHits;
-    std::vector <int> muNMatchedStations;
-    std::vector <int> muNValPixelHits;
-    std::vector <int> muNTrackerLayers;
+    ArenaVector<double> muChi2(arena);
+    ArenaVector<double> muDxy(arena);
+    ArenaVector<double> muDz(arena);
+    ArenaVector<double> muRelIso(arena);
+
+    ArenaVector<int> muNValMuHits(arena);
+    ArenaVector<int> muNMatchedStations(arena);
+    ArenaVector<int> muNValPixelHits(arena);
+    ArenaVector<int> muNTrackerLayers(arena);
     //Extra info about isolation
-    std::vector <double> muChIso;
-    std::vector <double> muNhIso;
-    std::vector <double> muGIso;
-    std::vector <double> muPuIso;
+    ArenaVector<double> muChIso(arena);
+    ArenaVector<double> muNhIso(arena);
+    ArenaVector<double> muGIso(arena);
+    ArenaVector<double> muPuIso(arena);
     //ID info
-    std::vector <int> muIsTight;
-    std::vector<int> muIsLoose;
+    ArenaVector<int> muIsTight(arena);
+    ArenaVector<int> muIsLoose(arena);
 
     //Generator level information -- MC matching
-    vector<double> muGen_Reco_dr;
-    vector<int> muPdgId;
-    vector<int> muStatus;
-    vector<int> muMatched;
-    vector<int> muNumberOfMothers;
-    vector<double> muMother_pt;
-    vector<double> muMother_eta;
-    vector<double> muMother_phi;
-    vector<double> muMother_energy;
-    vector<int> muMother_id;
-    vector<int> muMother_status;
+    ArenaVector<double> muGen_Reco_dr(arena);
+    ArenaVector<int> muPdgId(arena);
+    ArenaVector<int> muStatus(arena);
+    ArenaVector<int> muMatched(arena);
+    ArenaVector<int> muNumberOfMothers(arena);
+    ArenaVector<double> muMother_pt(arena);
+    ArenaVector<double> muMother_eta(arena);
+    ArenaVector<double> muMother_phi(arena);
+    ArenaVector<double> muMother_energy(arena);
+    ArenaVector<int> muMother_id(arena);
+    ArenaVector<int> muMother_status(arena);
     //Matched gen muon information:
-    vector<double> muMatchedPt;
-    vector<double> muMatchedEta;
-    vector<double> muMatchedPhi;
-    vector<double> muMatchedEnergy;
+    ArenaVector<double> muMatchedPt(arena);
+    ArenaVector<double> muMatchedEta(arena);
+    ArenaVector<double> muMatchedPhi(arena);
+    ArenaVector<double> muMatchedEnergy(arena);
+    ArenaVector<int> muMatchedTopChain(arena);
 
     for (std::vector<edm::Ptr<pat::Muon> >::const_iterator imu = vSelMuons.begin(); imu != vSelMuons.end(); imu++) 
         //Protect against muons without tracks (should never happen, but just in case)
@@ -279,8 +305,10 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
                         muMatchedEta.push_back(p.eta());
                         muMatchedPhi.push_back(p.phi());
                         muMatchedEnergy.push_back(p.energy());
+                        GenEventIndex const & genIndex = selector->GetGenEventIndex(event, genParticles_it, genPackedParticles_it);
+                        muMatchedTopChain.push_back(findTopChain(genIndex, matchId));
                         int oldSize = muMother_id.size();
-                        fillMotherInfo(p.mother(), 0, muMother_id, muMother_status, muMother_pt, muMother_eta, muMother_phi, muMother_energy);
+                        fillMotherInfo(genIndex, matchId, muMother_id, muMother_status, muMother_pt, muMother_eta, muMother_phi, muMother_energy);
                         muNumberOfMothers.push_back(muMother_id.size()-oldSize);
                     }
                 }
@@ -294,6 +322,7 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
                     muMatchedEta.push_back(-1000.0);
                     muMatchedPhi.push_back(-1000.0);
                     muMatchedEnergy.push_back(-1000.0);
+                    muMatchedTopChain.push_back(-1);
                 }
             }
         }
@@ -337,61 +366,63 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
     SetValue("muMatchedEta", muMatchedEta);
     SetValue("muMatchedPhi", muMatchedPhi);
     SetValue("muMatchedEnergy", muMatchedEnergy);
+    SetValue("muMatchedTopChain", muMatchedTopChain);
 
 
 
 
     // Electron
     //Four vector
-    std::vector <double> elPt;
-    std::vector <double> elEta;
-    std::vector <double> elPhi;
-    std::vector <double> elEnergy;
+    ArenaVector<double> elPt(arena);
+    ArenaVector<double> elEta(arena);
+    ArenaVector<double> elPhi(arena);
+    ArenaVector<double> elEnergy(arena);
 
     //Quality criteria
-    std::vector <double> elRelIso;
-    std::vector <double> elDxy;
-    std::vector <int>    elNotConversion;
-    std::vector <int>    elChargeConsistent;
-    std::vector <int>    elIsEBEE;
-    std::vector <int>    elCharge;
+    ArenaVector<double> elRelIso(arena);
+    ArenaVector<double> elDxy(arena);
+    ArenaVector<int>    elNotConversion(arena);
+    ArenaVector<int>    elChargeConsistent(arena);
+    ArenaVector<int>    elIsEBEE(arena);
+    ArenaVector<int>    elCharge(arena);
 
     //ID requirement
-    std::vector <double> elDeta;
-    std::vector <double> elDphi;
-    std::vector <double> elSihih;
-    std::vector <double> elHoE;
-    std::vector <double> elD0;
-    std::vector <double> elDZ;
-    std::vector <double> elOoemoop;
-    std::vector <int>    elMHits;
-    std::vector <int>    elVtxFitConv;    
+    ArenaVector<double> elDeta(arena);
+    ArenaVector<double> elDphi(arena);
+    ArenaVector<double> elSihih(arena);
+    ArenaVector<double> elHoE(arena);
+    ArenaVector<double> elD0(arena);
+    ArenaVector<double> elDZ(arena);
+    ArenaVector<double> elOoemoop(arena);
+    ArenaVector<int>    elMHits(arena);
+    ArenaVector<int>    elVtxFitConv(arena);    
 
     //Extra info about isolation
-    std::vector <double> elChIso;
-    std::vector <double> elNhIso;
-    std::vector <double> elPhIso;
-    std::vector <double> elAEff;
-    std::vector <double> elRhoIso;
+    ArenaVector<double> elChIso(arena);
+    ArenaVector<double> elNhIso(arena);
+    ArenaVector<double> elPhIso(arena);
+    ArenaVector<double> elAEff(arena);
+    ArenaVector<double> elRhoIso(arena);
 
     //mother-information
     //Generator level information -- MC matching
-    vector<double> elGen_Reco_dr;
-    vector<int> elPdgId;
-    vector<int> elStatus;
-    vector<int> elMatched;
-    vector<int> elNumberOfMothers;
-    vector<double> elMother_pt;
-    vector<double> elMother_eta;
-    vector<double> elMother_phi;
-    vector<double> elMother_energy;
-    vector<int> elMother_id;
-    vector<int> elMother_status;
+    ArenaVector<double> elGen_Reco_dr(arena);
+    ArenaVector<int> elPdgId(arena);
+    ArenaVector<int> elStatus(arena);
+    ArenaVector<int> elMatched(arena);
+    ArenaVector<int> elNumberOfMothers(arena);
+    ArenaVector<double> elMother_pt(arena);
+    ArenaVector<double> elMother_eta(arena);
+    ArenaVector<double> elMother_phi(arena);
+    ArenaVector<double> elMother_energy(arena);
+    ArenaVector<int> elMother_id(arena);
+    ArenaVector<int> elMother_status(arena);
     //Matched gen electron information:
-    vector<double> elMatchedPt;
-    vector<double> elMatchedEta;
-    vector<double> elMatchedPhi;
-    vector<double> elMatchedEnergy;
+    ArenaVector<double> elMatchedPt(arena);
+    ArenaVector<double> elMatchedEta(arena);
+    ArenaVector<double> elMatchedPhi(arena);
+    ArenaVector<double> elMatchedEnergy(arena);
+    ArenaVector<int> elMatchedTopChain(arena);
 
  
     edm::Handle<double> rhoHandle;
@@ -472,8 +503,10 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
                         elMatchedEta.push_back(p.eta());
                         elMatchedPhi.push_back(p.phi());
                         elMatchedEnergy.push_back(p.energy());
+                        GenEventIndex const & genIndex = selector->GetGenEventIndex(event, genParticles_it, genPackedParticles_it);
+                        elMatchedTopChain.push_back(findTopChain(genIndex, matchId));
                         int oldSize = elMother_id.size();
-                        fillMotherInfo(p.mother(), 0, elMother_id, elMother_status, elMother_pt, elMother_eta, elMother_phi, elMother_energy);
+                        fillMotherInfo(genIndex, matchId, elMother_id, elMother_status, elMother_pt, elMother_eta, elMother_phi, elMother_energy);
                         elNumberOfMothers.push_back(elMother_id.size()-oldSize);
                     }
                 }
@@ -487,6 +520,7 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
                     elMatchedEta.push_back(-1000.0);
                     elMatchedPhi.push_back(-1000.0);
                     elMatchedEnergy.push_back(-1000.0);
+                    elMatchedTopChain.push_back(-1);
 
                 }
             }//closing the isMC checking criteria
@@ -542,6 +576,7 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
     SetValue("elMatchedEta", elMatchedEta);
     SetValue("elMatchedPhi", elMatchedPhi);
     SetValue("elMatchedEnergy", elMatchedEnergy);
+    SetValue("elMatchedTopChain", elMatchedTopChain);
 
     //
     //______Trigger Matching __________________
@@ -557,7 +592,9 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
     int _electron_1_hltmatched =0;
     int _muon_1_hltmatched =0;
 
-    if (_nSelElectrons>0 || _nSelMuons>0) {
+    bool const _doHltMatching = IsRequested("electron_1_hltmatched") || IsRequested("muon_1_hltmatched");
+
+    if (_doHltMatching && (_nSelElectrons>0 || _nSelMuons>0)) {
         for(pat::TriggerObjectStandAlone obj : *mhEdmTriggerObjectColl){       
             obj.unpackPathNames(names);
             for(unsigned h = 0; h < obj.filterLabels().size(); ++h){
@@ -588,12 +625,12 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
     event.getByLabel(AK8JetColl, AK8Jets);
 
     //Four vector
-    std::vector <double> AK8JetPt;
-    std::vector <double> AK8JetEta;
-    std::vector <double> AK8JetPhi;
-    std::vector <double> AK8JetEnergy;
+    ArenaVector<double> AK8JetPt(arena);
+    ArenaVector<double> AK8JetEta(arena);
+    ArenaVector<double> AK8JetPhi(arena);
+    ArenaVector<double> AK8JetEnergy(arena);
 
-    std::vector <double> AK8JetCSV;
+    ArenaVector<double> AK8JetCSV(arena);
     //   std::vector <double> AK8JetRCN;       
     for (std::vector<pat::Jet>::const_iterator ijet = AK8Jets->begin(); ijet != AK8Jets->end(); ijet++){
 
@@ -604,7 +641,7 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
         AK8JetPhi    . push_back(lvak8.Phi());
         AK8JetEnergy . push_back(lvak8.Energy());
 
-        AK8JetCSV    . push_back(ijet->bDiscriminator( "combinedInclusiveSecondaryVertexV2BJetTags"));
+        AK8JetCSV    . push_back(ak8Labels.BDiscriminator(*ijet, ak8CsvSlot));
         //     AK8JetRCN    . push_back((ijet->chargedEmEnergy()+ijet->chargedHadronEnergy()) / (ijet->neutralEmEnergy()+ijet->neutralHadronEnergy()));
     }
  
@@ -618,13 +655,13 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
     //   SetValue("AK8JetRCN"    , AK8JetRCN);
     //Get AK4 Jets
     //Four vector
-    std::vector <double> AK4JetPt;
-    std::vector <double> AK4JetEta;
-    std::vector <double> AK4JetPhi;
-    std::vector <double> AK4JetEnergy;
+    ArenaVector<double> AK4JetPt(arena);
+    ArenaVector<double> AK4JetEta(arena);
+    ArenaVector<double> AK4JetPhi(arena);
+    ArenaVector<double> AK4JetEnergy(arena);
 
-    std::vector <int>    AK4JetBTag;
-    std::vector <double> AK4JetRCN;   
+    ArenaVector<int>    AK4JetBTag(arena);
+    ArenaVector<double> AK4JetRCN(arena);   
     double AK4HT =.0;
     for (std::vector<edm::Ptr<pat::Jet> >::const_iterator ijet = vSelJets.begin();
          ijet != vSelJets.end(); ijet++){
@@ -680,21 +717,114 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
     //
 
     //Four vector
-    std::vector <double> genPt;
-    std::vector <double> genEta;
-    std::vector <double> genPhi;
-    std::vector <double> genEnergy;
+    ArenaVector<double> genPt(arena);
+    ArenaVector<double> genEta(arena);
+    ArenaVector<double> genPhi(arena);
+    ArenaVector<double> genEnergy(arena);
 
     //Identity
-    std::vector <int> genID;
-    std::vector <int> genIndex;
-    std::vector <int> genStatus;
-    std::vector <int> genMotherID;
-    std::vector <int> genMotherIndex;
+    ArenaVector<int> genID(arena);
+    ArenaVector<int> genIndex(arena);
+    ArenaVector<int> genStatus(arena);
+    ArenaVector<int> genMotherID(arena);
+    ArenaVector<int> genMotherIndex(arena);
+
+    //Top decay chains: last copies of the top, its W and b, and for
+    //leptonic decays the final-state charged lepton
+    ArenaVector<double> genTopPt(arena);
+    ArenaVector<double> genTopEta(arena);
+    ArenaVector<double> genTopPhi(arena);
+    ArenaVector<double> genTopEnergy(arena);
+    ArenaVector<int> genTopID(arena);
+    ArenaVector<int> genTopDecay(arena);
+    ArenaVector<double> genTopWPt(arena);
+    ArenaVector<double> genTopWEta(arena);
+    ArenaVector<double> genTopWPhi(arena);
+    ArenaVector<double> genTopWEnergy(arena);
+    ArenaVector<double> genTopBPt(arena);
+    ArenaVector<double> genTopBEta(arena);
+    ArenaVector<double> genTopBPhi(arena);
+    ArenaVector<double> genTopBEnergy(arena);
+    ArenaVector<double> genTopLepPt(arena);
+    ArenaVector<double> genTopLepEta(arena);
+    ArenaVector<double> genTopLepPhi(arena);
+    ArenaVector<double> genTopLepEnergy(arena);
+    ArenaVector<int> genTopLepID(arena);
 
     if (isMc){
         edm::Handle<reco::GenParticleCollection> genParticles;
         event.getByLabel(genParticles_it, genParticles);
+        GenEventIndex const & genTables = selector->GetGenEventIndex(event, genParticles_it, genPackedParticles_it);
+
+        edm::Handle<std::vector<pat::PackedGenParticle> > genPacked;
+        if (!genPackedParticles_it.label().empty()) event.getByLabel(genPackedParticles_it, genPacked);
+
+        std::vector<GenEventIndex::TopChain> const & topChains = genTables.GetTopChains();
+        for (size_t c = 0; c < topChains.size(); c++){
+            GenEventIndex::TopChain const & chain = topChains[c];
+            const reco::GenParticle & top = (*genParticles)[chain.top];
+            genTopPt     . push_back(top.pt());
+            genTopEta    . push_back(top.eta());
+            genTopPhi    . push_back(top.phi());
+            genTopEnergy . push_back(top.energy());
+            genTopID     . push_back(top.pdgId());
+            genTopDecay  . push_back(chain.decay);
+
+            if (chain.w >= 0){
+                const reco::GenParticle & w = (*genParticles)[chain.w];
+                genTopWPt     . push_back(w.pt());
+                genTopWEta    . push_back(w.eta());
+                genTopWPhi    . push_back(w.phi());
+                genTopWEnergy . push_back(w.energy());
+            } else {
+                genTopWPt     . push_back(-1000.0);
+                genTopWEta    . push_back(-1000.0);
+                genTopWPhi    . push_back(-1000.0);
+                genTopWEnergy . push_back(-1000.0);
+            }
+            if (chain.b >= 0){
+                const reco::GenParticle & b = (*genParticles)[genTables.LastCopy(chain.b)];
+                genTopBPt     . push_back(b.pt());
+                genTopBEta    . push_back(b.eta());
+                genTopBPhi    . push_back(b.phi());
+                genTopBEnergy . push_back(b.energy());
+            } else {
+                genTopBPt     . push_back(-1000.0);
+                genTopBEta    . push_back(-1000.0);
+                genTopBPhi    . push_back(-1000.0);
+                genTopBEnergy . push_back(-1000.0);
+            }
+
+            //Final-state lepton: the hardest packed one of the same flavour
+            //whose pruned mother is a copy of the W lepton or the W itself,
+            //else the last pruned copy of the W lepton
+            const reco::Candidate * lep = 0;
+            bool leptonic = chain.decay != GenEventIndex::kUnknown && chain.decay != GenEventIndex::kHadronic;
+            if (leptonic && genPacked.isValid()){
+                int lepId = (*genParticles)[chain.wDau1].pdgId();
+                for (size_t k = 0; k < genPacked->size(); k++){
+                    const pat::PackedGenParticle & q = (*genPacked)[k];
+                    int m = genTables.PackedMother(k);
+                    if (q.pdgId() != lepId || m < 0) continue;
+                    if (genTables.LastCopy(m) != genTables.LastCopy(chain.wDau1) && genTables.LastCopy(m) != chain.w) continue;
+                    if (!lep || q.pt() > lep->pt()) lep = &q;
+                }
+            }
+            if (leptonic && !lep) lep = &(*genParticles)[genTables.LastCopy(chain.wDau1)];
+            if (lep){
+                genTopLepPt     . push_back(lep->pt());
+                genTopLepEta    . push_back(lep->eta());
+                genTopLepPhi    . push_back(lep->phi());
+                genTopLepEnergy . push_back(lep->energy());
+                genTopLepID     . push_back(lep->pdgId());
+            } else {
+                genTopLepPt     . push_back(-1000.0);
+                genTopLepEta    . push_back(-1000.0);
+                genTopLepPhi    . push_back(-1000.0);
+                genTopLepEnergy . push_back(-1000.0);
+                genTopLepID     . push_back(0);
+            }
+        }
 
         for(size_t i = 0; i < genParticles->size(); i++){
             const reco::GenParticle & p = (*genParticles).at(i);
@@ -723,16 +853,8 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
 
                 if (not bKeep) continue;
 
-                //Find index of mother
-                int mInd = 0;
-                for(size_t j = 0; j < genParticles->size(); j++){
-                    const reco::GenParticle & q = (*genParticles).at(j);
-                    if (q.status() != 3) continue;
-                    if (mother->pdgId() == q.pdgId() and fabs(mother->eta() - q.eta()) < 0.01 and fabs(mother->pt() - q.pt()) < 0.01){
-                        mInd = (int) j;
-                        break;
-                    }
-                }
+                //Index of mother, -1 if it is not in the collection
+                int mInd = genTables.Mother(i);
 
                 //Four vector
                 genPt     . push_back(p.pt());
@@ -762,6 +884,27 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
     SetValue("genMotherID"   , genMotherID);
     SetValue("genMotherIndex", genMotherIndex);
 
+    // Top decay chains
+    SetValue("genTopPt"       , genTopPt);
+    SetValue("genTopEta"      , genTopEta);
+    SetValue("genTopPhi"      , genTopPhi);
+    SetValue("genTopEnergy"   , genTopEnergy);
+    SetValue("genTopID"       , genTopID);
+    SetValue("genTopDecay"    , genTopDecay);
+    SetValue("genTopWPt"      , genTopWPt);
+    SetValue("genTopWEta"     , genTopWEta);
+    SetValue("genTopWPhi"     , genTopWPhi);
+    SetValue("genTopWEnergy"  , genTopWEnergy);
+    SetValue("genTopBPt"      , genTopBPt);
+    SetValue("genTopBEta"     , genTopBEta);
+    SetValue("genTopBPhi"     , genTopBPhi);
+    SetValue("genTopBEnergy"  , genTopBEnergy);
+    SetValue("genTopLepPt"    , genTopLepPt);
+    SetValue("genTopLepEta"   , genTopLepEta);
+    SetValue("genTopLepPhi"   , genTopLepPhi);
+    SetValue("genTopLepEnergy", genTopLepEnergy);
+    SetValue("genTopLepID"    , genTopLepID);
+
 
 
     return 0;
@@ -769,19 +912,17 @@ int singleLepCalc::AnalyzeEvent(edm::EventBase const & event, BaseEventSelector
 
 int singleLepCalc::findMatch(const reco::GenParticleCollection & genParticles, int idToMatch, double eta, double phi)
 {
-    float dRtmp = 1000;
-    float closestDR = 10000.;
-    int closestGenPart = -1;
-
-    for(size_t j = 0; j < genParticles.size(); ++ j) {
-        const reco::GenParticle & p = (genParticles).at(j);
-        dRtmp = mdeltaR( eta, phi, p.eta(), p.phi());
-        if ( dRtmp < closestDR && abs(p.pdgId()) == idToMatch){// && dRtmp < 0.3) {
-            closestDR = dRtmp;
-            closestGenPart = j;
-        }//end of requirement for matching
-    }//end of gen particle loop 
-    return closestGenPart;
+    //
+    // closest gen particle with |pdgId| == idToMatch; only matches
+    // within deltaR 0.3 are used, so the index is searched up to there
+    //
+    if (genEtaPhiSource != &genParticles){
+        genEtaPhi.Build(genParticles);
+        genEtaPhiSource = &genParticles;
+    }
+    
+    return genEtaPhi.Nearest(eta, phi, 0.3,
+                             [&genParticles, idToMatch](int j){ return abs(genParticles[j].pdgId()) == idToMatch; });
 }
 
 
@@ -789,19 +930,37 @@ double singleLepCalc::mdeltaR(double eta1, double phi1, double eta2, double phi2
     return std::sqrt(deltaR2 (eta1, phi1, eta2, phi2));
 }
 
-void singleLepCalc::fillMotherInfo(const reco::Candidate *mother, int i, vector <int> & momid, vector <int> & momstatus, vector<double> & mompt, vector<double> & mometa, vector<double> & momphi, vector<double> & momenergy)
+int singleLepCalc::findTopChain(GenEventIndex const & genIndex, int iGen)
 {
-    if(mother) {
-        momid.push_back(mother->pdgId());
-        momstatus.push_back(mother->status());
-        mompt.push_back(mother->pt());
-        mometa.push_back(mother->eta());
-        momphi.push_back(mother->phi());
-        momenergy.push_back(mother->energy());
-        if(i<10)fillMotherInfo(mother->mother(), i+1, momid, momstatus, mompt, mometa, momphi, momenergy);
+    //
+    // the gen lepton, or an earlier copy of it, is the charged
+    // lepton of the W of a leptonic top decay
+    //
+    std::vector<GenEventIndex::TopChain> const & topChains = genIndex.GetTopChains();
+    int first = genIndex.FirstCopy(iGen);
+    for (size_t c = 0; c < topChains.size(); ++c) {
+        if (topChains[c].decay == GenEventIndex::kUnknown || topChains[c].decay == GenEventIndex::kHadronic) continue;
+        if (genIndex.FirstCopy(topChains[c].wDau1) == first) return c;
     }
+    return -1;
+}
 
-
+void singleLepCalc::fillMotherInfo(GenEventIndex const & genIndex, int iGen, ArenaVector<int> & momid, ArenaVector<int> & momstatus, ArenaVector<double> & mompt, ArenaVector<double> & mometa, ArenaVector<double> & momphi, ArenaVector<double> & momenergy)
+{
+    //
+    // mothers from the genealogy tables, closest first
+    //
+    std::vector<int> ancestors;
+    genIndex.Ancestors(iGen, 11, ancestors);
+    for (size_t k = 0; k < ancestors.size(); ++k) {
+        const reco::GenParticle & mother = (*genIndex.GetCollection())[ancestors[k]];
+        momid.push_back(mother.pdgId());
+        momstatus.push_back(mother.status());
+        mompt.push_back(mother.pt());
+        mometa.push_back(mother.eta());
+        momphi.push_back(mother.phi());
+        momenergy.push_back(mother.energy());
+    }
 }
 
 
@@ -483,6 +483,9 @@ bool singleLepEventSelector::operator()( edm::EventBase const & event, pat::strb
         // try to get earlier produced data (in a calc)
         //std::cout << "Must be 2.34: " << GetTestValue() << std::endl;
 
+        // JES factors of all jets evaluated together
+        CorrectJets(*mhJets, event);
+
         for (std::vector<pat::Jet>::const_iterator _ijet = mhJets->begin();
              _ijet != mhJets->end(); ++_ijet){
       
@@ -0,0 +1,135 @@
+//
+// Checks the structure-of-arrays axes update of Njettiness against the
+// scalar reference UpdateAxes(), one step at a time and through the
+// seeded multi-pass minimization, on random jets. The two must agree
+// bitwise. Returns nonzero on a mismatch.
+//
+//   testNjettiness [number of jets]
+//
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "LJMet/Com/interface/Njettiness.hh"
+
+
+
+static fastjet::PseudoJet RandomParticle(std::mt19937 & rng, double rap0, double phi0)
+{
+    std::exponential_distribution<double> _pt(0.1);
+    std::normal_distribution<double> _spread(0.0, 0.4);
+    double const _pT = 0.5+_pt(rng);
+    double const _rap = rap0+_spread(rng);
+    double const _phi = phi0+_spread(rng);
+    return fastjet::PseudoJet(_pT*std::cos(_phi), _pT*std::sin(_phi), _pT*std::sinh(_rap), _pT*std::cosh(_rap));
+}
+
+
+
+static std::vector<fastjet::PseudoJet> RandomJet(std::mt19937 & rng, unsigned nProngs)
+{
+    std::uniform_real_distribution<double> _rap(-2.0, 2.0);
+    std::uniform_real_distribution<double> _phi(-M_PI, M_PI);
+    std::uniform_int_distribution<int> _n(5, 40);
+    double const _jetRap = _rap(rng);
+    double const _jetPhi = _phi(rng);
+    std::vector<fastjet::PseudoJet> _particles;
+    for (unsigned p = 0; p != nProngs; ++p){
+        double const _prongRap = _jetRap+0.3*_rap(rng)/2.0;
+        double const _prongPhi = _jetPhi+0.3*_phi(rng)/M_PI;
+        for (int i = _n(rng); i != 0; --i) _particles.push_back(RandomParticle(rng, _prongRap, _prongPhi));
+    }
+    return _particles;
+}
+
+
+
+static bool Same(LightLikeAxis const & a, LightLikeAxis const & b)
+{
+    return a.rap() == b.rap() && a.phi() == b.phi() && a.weight() == b.weight() && a.mom() == b.mom();
+}
+
+
+
+static bool Same(fastjet::PseudoJet const & a, fastjet::PseudoJet const & b)
+{
+    return a.px() == b.px() && a.py() == b.py() && a.pz() == b.pz() && a.E() == b.E();
+}
+
+
+
+int main(int argc, char ** argv)
+{
+    size_t const _nJets = argc > 1 ? std::atoi(argv[1]) : 500;
+    double const _betas[] = {0.0, 0.5, 1.0, 2.0};
+    double const _cutoffs[] = {0.8, 10000.0};
+    double const _precision = 0.0001;
+
+    std::mt19937 rng(12345);
+    NsubWorkspace ws;
+
+    size_t _nFailed = 0;
+
+    for (size_t j = 0; j != _nJets; ++j){
+        unsigned const _nAxes = 1+j%4;
+        std::vector<fastjet::PseudoJet> const _particles = RandomJet(rng, _nAxes);
+
+        // seeds: the first particle of each prong
+        std::vector<fastjet::PseudoJet> _seeds;
+        std::vector<LightLikeAxis> _axes;
+        for (unsigned k = 0; k != _nAxes; ++k){
+            _seeds.push_back(_particles[k*_particles.size()/_nAxes]);
+            _axes.push_back(LightLikeAxis(_seeds[k].rap(), _seeds[k].phi(), 0.0, 0.0));
+        }
+
+        for (unsigned b = 0; b != sizeof(_betas)/sizeof(_betas[0]); ++b){
+            for (unsigned c = 0; c != sizeof(_cutoffs)/sizeof(_cutoffs[0]); ++c){
+                NsubParameters const _paraNsub(_betas[b], 0.8, _cutoffs[c]);
+
+                // single update step
+                std::vector<LightLikeAxis> const _scalar = UpdateAxes(_axes, _particles, _paraNsub, _precision);
+                std::vector<LightLikeAxis> _soa;
+                ws.setInputs(_particles);
+                UpdateAxesSoA(_axes, _soa, ws, _paraNsub, _precision);
+                for (unsigned k = 0; k != _nAxes; ++k){
+                    if (!Same(_scalar[k], _soa[k])){
+                        std::cout << "UpdateAxesSoA, jet " << j << ", beta " << _betas[b] << ", Rcutoff " << _cutoffs[c]
+                                  << ", axis " << k << ": (" << _soa[k].rap() << ", " << _soa[k].phi() << ") != ("
+                                  << _scalar[k].rap() << ", " << _scalar[k].phi() << ")" << std::endl;
+                        ++_nFailed;
+                    }
+                }
+
+                // full minimization with noisy passes, same seed on both paths
+                Njettiness _nsubScalar(Njettiness::onepass_manual_axes, _paraNsub);
+                Njettiness _nsubSoA(Njettiness::onepass_manual_axes, _paraNsub);
+                KmeansParameters const _paraKmeans(10, _precision, 1000, 0.8);
+                _nsubScalar.setParaKmeans(_paraKmeans);
+                _nsubSoA.setParaKmeans(_paraKmeans);
+                _nsubScalar.setSeed(j);
+                _nsubSoA.setSeed(j);
+                _nsubScalar.setScalarUpdate(true);
+                _nsubScalar.setAxes(_seeds);
+                _nsubSoA.setAxes(_seeds);
+                double const _tauScalar = _nsubScalar.getTau(_nAxes, _particles);
+                double const _tauSoA = _nsubSoA.getTau(_nAxes, _particles);
+                std::vector<fastjet::PseudoJet> const _minScalar = _nsubScalar.currentAxes();
+                std::vector<fastjet::PseudoJet> const _minSoA = _nsubSoA.currentAxes();
+                bool _same = _tauScalar == _tauSoA && _minScalar.size() == _minSoA.size();
+                for (unsigned k = 0; _same && k != _minScalar.size(); ++k) _same = Same(_minScalar[k], _minSoA[k]);
+                if (!_same){
+                    std::cout << "GetMinimumAxes, jet " << j << ", beta " << _betas[b] << ", Rcutoff " << _cutoffs[c]
+                              << ": tau " << _tauSoA << " != " << _tauScalar << std::endl;
+                    ++_nFailed;
+                }
+            }
+        }
+    }
+
+    std::cout << "testNjettiness: " << _nJets << " jets, " << _nFailed << " mismatches" << std::endl;
+
+    return _nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+//
+// Checks the batch angle and boost functions of TopAngleUtils and
+// TopUtils against the one-vector CosAngle and boost_new on random
+// top-like kinematics. Returns nonzero on a mismatch.
+//
+//   testTopAngleUtils [number of trials]
+//
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "LJMet/Com/interface/FourVector.h"
+#include "LJMet/Com/interface/TopAngleUtils.h"
+#include "LJMet/Com/interface/TopUtils.h"
+
+
+
+static const double kTolerance = 1.0e-9;
+
+
+
+static FourVector RandomVector(std::mt19937 & rng, double mass)
+{
+    std::uniform_real_distribution<double> _pt(5.0, 300.0);
+    std::uniform_real_distribution<double> _eta(-2.5, 2.5);
+    std::uniform_real_distribution<double> _phi(-M_PI, M_PI);
+    return FourVector::FromPtEtaPhiM(_pt(rng), _eta(rng), _phi(rng), mass);
+}
+
+
+
+static bool Close(double a, double b)
+{
+    return std::fabs(a-b) <= kTolerance*(1.0+std::fabs(a)+std::fabs(b));
+}
+
+
+
+static bool Close(FourVector const & a, FourVector const & b)
+{
+    return Close(a.Px(), b.Px()) && Close(a.Py(), b.Py()) && Close(a.Pz(), b.Pz()) && Close(a.E(), b.E());
+}
+
+
+
+int main(int argc, char ** argv)
+{
+    size_t const _nTrials = argc > 1 ? std::atoi(argv[1]) : 1000;
+    size_t const _n = 12; // a typical number of jet assignments per event
+
+    top_cafe::TopAngleUtils angleutils;
+    top_cafe::TopUtils toputils;
+    std::mt19937 rng(12345);
+
+    size_t _nFailed = 0;
+
+    std::vector<FourVector> _jets(_n);
+    std::vector<FourVector> _parents(_n);
+    std::vector<FourVector> _boosted(_n);
+    std::vector<double> _cosines(_n);
+
+    for (size_t t = 0; t != _nTrials; ++t){
+        FourVector const _lepton = RandomVector(rng, 0.0);
+        FourVector const _frame = _lepton+RandomVector(rng, 0.0);
+        for (size_t i = 0; i != _n; ++i){
+            _jets[i] = RandomVector(rng, 5.0);
+            _parents[i] = _jets[i]+RandomVector(rng, 5.0);
+        }
+        // the frame itself is passed through unboosted
+        _jets[_n-1] = _frame;
+
+        // shared object and frame
+        angleutils.CosAngles(_jets.data(), _lepton, _frame, _n, _cosines.data());
+        for (size_t i = 0; i != _n; ++i){
+            double const _expected = angleutils.CosAngle(_jets[i], _lepton, _frame);
+            if (!Close(_cosines[i], _expected)){
+                std::cout << "CosAngles, trial " << t << ", vector " << i << ": "
+                          << _cosines[i] << " != " << _expected << std::endl;
+                ++_nFailed;
+            }
+        }
+
+        // helicity angles
+        angleutils.HelicityCosines(_jets.data(), _parents.data(), _n, _cosines.data());
+        for (size_t i = 0; i != _n; ++i){
+            double const _expected = angleutils.CosAngle(_jets[i], _parents[i], _parents[i]);
+            if (!Close(_cosines[i], _expected)){
+                std::cout << "HelicityCosines, trial " << t << ", vector " << i << ": "
+                          << _cosines[i] << " != " << _expected << std::endl;
+                ++_nFailed;
+            }
+        }
+
+        // boost into the frame
+        double const _bx = _frame.Px()/_frame.E();
+        double const _by = _frame.Py()/_frame.E();
+        double const _bz = _frame.Pz()/_frame.E();
+        toputils.boost_new(_bx, _by, _bz, _jets.data(), _boosted.data(), _n);
+        for (size_t i = 0; i != _n; ++i){
+            FourVector _expected;
+            toputils.boost_new(_bx, _by, _bz, _jets[i], _expected);
+            if (!Close(_boosted[i], _expected)){
+                std::cout << "boost_new, trial " << t << ", vector " << i << ": ("
+                          << _boosted[i].Px() << ", " << _boosted[i].Py() << ", " << _boosted[i].Pz() << ", " << _boosted[i].E() << ") != ("
+                          << _expected.Px() << ", " << _expected.Py() << ", " << _expected.Pz() << ", " << _expected.E() << ")" << std::endl;
+                ++_nFailed;
+            }
+        }
+    }
+
+    std::cout << "testTopAngleUtils: " << _nTrials << " trials, " << _nFailed << " mismatches" << std::endl;
+
+    return _nFailed == 0 ? 0 : 1;
+}